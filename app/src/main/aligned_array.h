@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Heap array of trivially copyable T with cache-line aligned storage.
+// Used for the SoA planes of the splat store so every plane can be read with
+// aligned SIMD loads and handed to a GPU upload as a single block.
+template <typename T, size_t Alignment = 64>
+class AlignedArray {
+    static_assert(std::is_trivially_copyable<T>::value, "AlignedArray needs trivially copyable T");
+    static_assert((Alignment & (Alignment - 1)) == 0, "Alignment must be a power of two");
+
+public:
+    AlignedArray() = default;
+    explicit AlignedArray(size_t n) { resize(n); }
+    ~AlignedArray() { std::free(data_); }
+
+    AlignedArray(const AlignedArray&) = delete;
+    AlignedArray& operator=(const AlignedArray&) = delete;
+
+    AlignedArray(AlignedArray&& other) noexcept
+        : data_(other.data_), size_(other.size_), capacity_(other.capacity_) {
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.capacity_ = 0;
+    }
+
+    AlignedArray& operator=(AlignedArray&& other) noexcept {
+        if (this != &other) {
+            std::free(data_);
+            data_ = other.data_;
+            size_ = other.size_;
+            capacity_ = other.capacity_;
+            other.data_ = nullptr;
+            other.size_ = 0;
+            other.capacity_ = 0;
+        }
+        return *this;
+    }
+
+    // Contents are preserved up to min(old, new) size; new elements are
+    // left uninitialized.
+    void resize(size_t n) {
+        if (n > capacity_) {
+            T* p = allocate(n);
+            if (data_ && size_) std::memcpy(p, data_, size_ * sizeof(T));
+            std::free(data_);
+            data_ = p;
+            capacity_ = n;
+        }
+        size_ = n;
+    }
+
+    void fill(const T& v) {
+        for (size_t i = 0; i < size_; i++) data_[i] = v;
+    }
+
+    // Releases the storage.
+    void reset() {
+        std::free(data_);
+        data_ = nullptr;
+        size_ = 0;
+        capacity_ = 0;
+    }
+
+    T* data() { return data_; }
+    const T* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t bytes() const { return capacity_ * sizeof(T); }
+
+    T& operator[](size_t i) { return data_[i]; }
+    const T& operator[](size_t i) const { return data_[i]; }
+
+    T* begin() { return data_; }
+    T* end() { return data_ + size_; }
+    const T* begin() const { return data_; }
+    const T* end() const { return data_ + size_; }
+
+    void swap(AlignedArray& other) noexcept {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        std::swap(capacity_, other.capacity_);
+    }
+
+private:
+    static T* allocate(size_t n) {
+        // Round up so a trailing partial SIMD block can always be loaded.
+        size_t bytes = (n * sizeof(T) + Alignment - 1) & ~(Alignment - 1);
+        void* p = nullptr;
+        if (posix_memalign(&p, Alignment, bytes) != 0) throw std::bad_alloc();
+        return static_cast<T*>(p);
+    }
+
+    T* data_ = nullptr;
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+};
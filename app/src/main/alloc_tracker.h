@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+// Heap allocation counting for checking that steady-state frames stay off
+// the heap.
+//
+// Built with GS_TRACK_ALLOCATIONS (the CMake option of the same name),
+// alloc_tracker.cpp replaces the global operator new and delete and counts
+// every operator new on the calling thread. Without it the counter stays
+// at zero and nothing is replaced. malloc() calls, e.g. inside a graphics
+// driver, are not seen either way.
+
+// True when operator new is being counted.
+bool allocationTrackingEnabled();
+
+// operator new calls made by this thread so far.
+uint64_t threadAllocationCount();
+
+// Allocations made by this thread since construction.
+class AllocationWatch {
+public:
+    AllocationWatch() : start_(threadAllocationCount()) {}
+
+    uint64_t count() const { return threadAllocationCount() - start_; }
+
+private:
+    uint64_t start_;
+};
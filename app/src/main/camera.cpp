@@ -0,0 +1,107 @@
+#include "camera.h"
+
+#include <cmath>
+
+namespace {
+
+static void cross(const float a[3], const float b[3], float out[3]) {
+    out[0] = a[1] * b[2] - a[2] * b[1];
+    out[1] = a[2] * b[0] - a[0] * b[2];
+    out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+static void normalize(float v[3]) {
+    float n = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    if (n > 0.f) {
+        v[0] /= n;
+        v[1] /= n;
+        v[2] /= n;
+    }
+}
+
+} // namespace
+
+void Camera::position(float out[3]) const {
+    // c = -R^T t
+    out[0] = -(rot[0] * trans[0] + rot[3] * trans[1] + rot[6] * trans[2]);
+    out[1] = -(rot[1] * trans[0] + rot[4] * trans[1] + rot[7] * trans[2]);
+    out[2] = -(rot[2] * trans[0] + rot[5] * trans[1] + rot[8] * trans[2]);
+}
+
+Frustum Camera::frustum() const {
+    // Camera-space planes through the origin and the image edges, e.g. the
+    // left plane keeps fx * x + cx * z >= 0 (pixel x >= 0).
+    const float w = (float)width, h = (float)height;
+    const float view[6][4] = {
+        { fx, 0.f, cx, 0.f },
+        { -fx, 0.f, w - cx, 0.f },
+        { 0.f, fy, cy, 0.f },
+        { 0.f, -fy, h - cy, 0.f },
+        { 0.f, 0.f, 1.f, -znear },
+        { 0.f, 0.f, -1.f, zfar },
+    };
+
+    // A view plane n.v + d maps to world space as (R^T n).p + (n.t + d).
+    Frustum f;
+    for (int i = 0; i < 6; i++) {
+        const float* n = view[i];
+        float* out = f.planes[i];
+        for (int c = 0; c < 3; c++) out[c] = rot[c] * n[0] + rot[3 + c] * n[1] + rot[6 + c] * n[2];
+        out[3] = n[0] * trans[0] + n[1] * trans[1] + n[2] * trans[2] + n[3];
+        float len = std::sqrt(out[0] * out[0] + out[1] * out[1] + out[2] * out[2]);
+        if (len > 0.f) {
+            for (int c = 0; c < 4; c++) out[c] /= len;
+        }
+    }
+    return f;
+}
+
+bool Frustum::intersects(const float boxMin[3], const float boxMax[3]) const {
+    for (const auto& p : planes) {
+        // Box corner furthest along the plane normal.
+        const float x = p[0] >= 0.f ? boxMax[0] : boxMin[0];
+        const float y = p[1] >= 0.f ? boxMax[1] : boxMin[1];
+        const float z = p[2] >= 0.f ? boxMax[2] : boxMin[2];
+        if (p[0] * x + p[1] * y + p[2] * z + p[3] < 0.f) return false;
+    }
+    return true;
+}
+
+bool Frustum::contains(const float boxMin[3], const float boxMax[3]) const {
+    for (const auto& p : planes) {
+        const float x = p[0] >= 0.f ? boxMin[0] : boxMax[0];
+        const float y = p[1] >= 0.f ? boxMin[1] : boxMax[1];
+        const float z = p[2] >= 0.f ? boxMin[2] : boxMax[2];
+        if (p[0] * x + p[1] * y + p[2] * z + p[3] < 0.f) return false;
+    }
+    return true;
+}
+
+Camera makeLookAtCamera(const float eye[3], const float target[3], const float up[3],
+                        float fovYRadians, uint32_t width, uint32_t height) {
+    float fwd[3] = { target[0] - eye[0], target[1] - eye[1], target[2] - eye[2] };
+    normalize(fwd);
+    float right[3];
+    cross(fwd, up, right);
+    normalize(right);
+    float down[3];
+    cross(fwd, right, down);
+
+    Camera cam;
+    for (int i = 0; i < 3; i++) {
+        cam.rot[0 + i] = right[i];
+        cam.rot[3 + i] = down[i];
+        cam.rot[6 + i] = fwd[i];
+    }
+    for (int r = 0; r < 3; r++) {
+        cam.trans[r] = -(cam.rot[r * 3 + 0] * eye[0] + cam.rot[r * 3 + 1] * eye[1] + cam.rot[r * 3 + 2] * eye[2]);
+    }
+
+    cam.width = width;
+    cam.height = height;
+    cam.fy = 0.5f * (float)height / std::tan(0.5f * fovYRadians);
+    cam.fx = cam.fy;
+    cam.cx = 0.5f * (float)width;
+    cam.cy = 0.5f * (float)height;
+    return cam;
+}
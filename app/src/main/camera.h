@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+// View frustum as six planes (a, b, c, d) with a*x + b*y + c*z + d >= 0 on
+// the inside, in world space: left, right, top, bottom, near, far.
+struct Frustum {
+    float planes[6][4];
+
+    // Conservative box test: false only if the box is fully outside a plane.
+    bool intersects(const float boxMin[3], const float boxMax[3]) const;
+    // True if the box is fully inside every plane.
+    bool contains(const float boxMin[3], const float boxMax[3]) const;
+};
+
+// Pinhole camera in the 3DGS / OpenCV convention: camera space has +x right,
+// +y down and +z forward; pixel = (fx * x / z + cx, fy * y / z + cy).
+struct Camera {
+    float rot[9] = { 1, 0, 0, 0, 1, 0, 0, 0, 1 }; // world -> camera, row-major
+    float trans[3] = { 0, 0, 0 };
+    float fx = 1.f;
+    float fy = 1.f;
+    float cx = 0.f;
+    float cy = 0.f;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    float znear = 0.01f;
+    float zfar = 1000.f;
+
+    // Camera centre in world space.
+    void position(float out[3]) const;
+
+    // World-space frustum of the image rectangle between znear and zfar.
+    Frustum frustum() const;
+
+    // World -> camera space.
+    void toView(const float p[3], float out[3]) const {
+        out[0] = rot[0] * p[0] + rot[1] * p[1] + rot[2] * p[2] + trans[0];
+        out[1] = rot[3] * p[0] + rot[4] * p[1] + rot[5] * p[2] + trans[1];
+        out[2] = rot[6] * p[0] + rot[7] * p[1] + rot[8] * p[2] + trans[2];
+    }
+};
+
+// Camera at `eye` looking at `target`; `up` is the world up direction.
+Camera makeLookAtCamera(const float eye[3], const float target[3], const float up[3],
+                        float fovYRadians, uint32_t width, uint32_t height);
@@ -0,0 +1,288 @@
+#include "chunk_residency.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+// Velocity smoothing per update(); camera input is jittery.
+constexpr float kVelocityBlend = 0.3f;
+
+// Visible before prefetched, nearest first.
+template <typename Chunk>
+static bool loadsBefore(const Chunk& a, const Chunk& b) {
+    if (a.prefetch != b.prefetch) return !a.prefetch;
+    return a.priority < b.priority;
+}
+
+static float boxDistance2(const float p[3], const float lo[3], const float hi[3]) {
+    float d2 = 0.f;
+    for (int k = 0; k < 3; k++) {
+        const float d = std::max(std::max(lo[k] - p[k], 0.f), p[k] - hi[k]);
+        d2 += d * d;
+    }
+    return d2;
+}
+
+} // namespace
+
+ChunkResidency::~ChunkResidency() {
+    close();
+}
+
+bool ChunkResidency::open(const std::string& path, std::string* error) {
+    close();
+
+    auto fail = [&](const char* what) {
+        if (error) *error = what;
+        reader_.close();
+        return false;
+    };
+
+    if (!reader_.open(path, error)) return false;
+    const CompactSplatHeader& h = reader_.header();
+    if (h.chunkCount == 0 || h.chunkSize == 0) return fail("scene has no chunks");
+
+    slotSize_ = h.chunkSize;
+    const uint64_t slotBytes = splatDataBytes(slotSize_, reader_.shRestCoeffs());
+    uint32_t slots = (uint32_t)std::min<uint64_t>(options.budgetBytes / slotBytes, h.chunkCount);
+    if (slots == 0) return fail("memory budget is smaller than one chunk");
+    pool_.resize((size_t)slots * slotSize_, reader_.shRestCoeffs());
+
+    chunks_.resize(h.chunkCount);
+    for (size_t c = 0; c < chunks_.size(); c++) {
+        const CompactChunk& src = reader_.chunks()[c];
+        const float pad = 3.f * std::exp(src.logScaleMax);
+        for (int k = 0; k < 3; k++) {
+            chunks_[c].min[k] = src.posMin[k] - pad;
+            chunks_[c].max[k] = src.posMax[k] + pad;
+        }
+    }
+    slotChunk_.assign(slots, UINT32_MAX);
+    stats_ = Stats{};
+    stats_.slots = slots;
+    loaders_ = std::make_unique<ThreadPool>(std::max(1u, options.loaders));
+    return true;
+}
+
+void ChunkResidency::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (uint32_t c : queue_) chunks_[c].state = ChunkState::Absent;
+        queue_.clear();
+    }
+    // Joins after the chunks being decoded are done; the remaining tasks
+    // find the queue empty.
+    loaders_.reset();
+
+    chunks_.clear();
+    slotChunk_.clear();
+    ranges_.clear();
+    wanted_.clear();
+    pool_.clear();
+    reader_.close();
+    frame_ = 0;
+    haveEye_ = false;
+    for (float& v : velocity_) v = 0.f;
+}
+
+uint64_t ChunkResidency::sceneBytes() const {
+    return isOpen() ? splatDataBytes(reader_.header().count, reader_.shRestCoeffs()) : 0;
+}
+
+void ChunkResidency::bounds(float min[3], float max[3]) const {
+    for (int k = 0; k < 3; k++) {
+        min[k] = chunks_.empty() ? 0.f : INFINITY;
+        max[k] = chunks_.empty() ? 0.f : -INFINITY;
+    }
+    for (const CompactChunk& c : reader_.chunks()) {
+        if (c.count == 0) continue;
+        for (int k = 0; k < 3; k++) {
+            min[k] = std::min(min[k], c.posMin[k]);
+            max[k] = std::max(max[k], c.posMax[k]);
+        }
+    }
+}
+
+bool ChunkResidency::reserveSlot(uint32_t chunk) {
+    // A free slot, else the least recently used chunk, else (when this
+    // frame wants more than fits) the needed chunk that loads last.
+    uint32_t slot = UINT32_MAX, needed = UINT32_MAX;
+    uint64_t oldest = UINT64_MAX;
+    for (uint32_t s = 0; s < (uint32_t)slotChunk_.size(); s++) {
+        const uint32_t c = slotChunk_[s];
+        if (c == UINT32_MAX) {
+            slot = s;
+            break;
+        }
+        const Chunk& ch = chunks_[c];
+        if (ch.state != ChunkState::Resident) continue;
+        if (ch.lastUsed < frame_) {
+            if (ch.lastUsed < oldest) {
+                oldest = ch.lastUsed;
+                slot = s;
+            }
+        } else if (needed == UINT32_MAX || loadsBefore(chunks_[slotChunk_[needed]], ch)) {
+            needed = s;
+        }
+    }
+    if (slot == UINT32_MAX && needed != UINT32_MAX && loadsBefore(chunks_[chunk], chunks_[slotChunk_[needed]])) {
+        slot = needed;
+    }
+    if (slot == UINT32_MAX) return false;
+
+    const uint32_t previous = slotChunk_[slot];
+    if (previous != UINT32_MAX) {
+        chunks_[previous].state = ChunkState::Absent;
+        chunks_[previous].slot = UINT32_MAX;
+        stats_.evictions++;
+    }
+    slotChunk_[slot] = chunk;
+    chunks_[chunk].slot = slot;
+    return true;
+}
+
+void ChunkResidency::update(const Camera& camera, float dtSeconds) {
+    GS_TRACE_SCOPE("ChunkResidency::update");
+    if (!isOpen()) return;
+    frame_++;
+
+    float eye[3];
+    camera.position(eye);
+    if (haveEye_ && dtSeconds > 0.f) {
+        for (int k = 0; k < 3; k++) {
+            const float v = (eye[k] - lastEye_[k]) / dtSeconds;
+            velocity_[k] += kVelocityBlend * (v - velocity_[k]);
+        }
+    }
+    for (int k = 0; k < 3; k++) lastEye_[k] = eye[k];
+    haveEye_ = true;
+
+    // The same view from where the camera will be.
+    Camera ahead = camera;
+    float p[3];
+    for (int k = 0; k < 3; k++) p[k] = eye[k] + velocity_[k] * options.prefetchSeconds;
+    for (int r = 0; r < 3; r++) {
+        ahead.trans[r] = -(camera.rot[r * 3 + 0] * p[0] + camera.rot[r * 3 + 1] * p[1] + camera.rot[r * 3 + 2] * p[2]);
+    }
+    const bool moving = velocity_[0] != 0.f || velocity_[1] != 0.f || velocity_[2] != 0.f;
+    const Frustum now = camera.frustum();
+    const Frustum later = ahead.frustum();
+
+    ranges_.clear();
+    wanted_.clear();
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.frames++;
+
+    bool stall = false;
+    for (uint32_t c = 0; c < (uint32_t)chunks_.size(); c++) {
+        Chunk& ch = chunks_[c];
+        const bool visible = now.intersects(ch.min, ch.max);
+        if (!visible && !(moving && later.intersects(ch.min, ch.max))) continue;
+
+        ch.lastUsed = frame_;
+        ch.prefetch = !visible;
+        ch.priority = boxDistance2(visible ? eye : p, ch.min, ch.max);
+        if (visible) {
+            stats_.lookups++;
+            if (ch.state != ChunkState::Resident) stall = true;
+        }
+        if (ch.state == ChunkState::Absent) wanted_.push_back(c);
+    }
+    if (stall) stats_.stallFrames++;
+
+    // Queued requests the camera has moved away from give their slot back.
+    auto stale = std::remove_if(queue_.begin(), queue_.end(), [&](uint32_t c) {
+        Chunk& ch = chunks_[c];
+        if (ch.lastUsed == frame_) return false;
+        slotChunk_[ch.slot] = UINT32_MAX;
+        ch.slot = UINT32_MAX;
+        ch.state = ChunkState::Absent;
+        stats_.dropped++;
+        return true;
+    });
+    queue_.erase(stale, queue_.end());
+
+    std::sort(wanted_.begin(), wanted_.end(), [&](uint32_t a, uint32_t b) { return loadsBefore(chunks_[a], chunks_[b]); });
+    for (uint32_t c : wanted_) {
+        if (queue_.size() + stats_.inFlight >= options.maxInFlight) break;
+        if (!reserveSlot(c)) break;
+        chunks_[c].state = ChunkState::Queued;
+        queue_.push_back(c);
+        stats_.loads++;
+        if (chunks_[c].prefetch) stats_.prefetches++;
+        loaders_->submit([this] { loadNext(); });
+    }
+
+    // After the requests, which may have evicted visible chunks.
+    for (uint32_t s = 0; s < (uint32_t)slotChunk_.size(); s++) {
+        const uint32_t c = slotChunk_[s];
+        if (c == UINT32_MAX) continue;
+        const Chunk& ch = chunks_[c];
+        if (ch.state != ChunkState::Resident || ch.lastUsed != frame_ || ch.prefetch) continue;
+        const uint32_t begin = s * slotSize_;
+        stats_.hits++;
+        ranges_.push_back(SplatRange{ begin, begin + reader_.chunks()[c].count });
+    }
+}
+
+void ChunkResidency::loadNext() {
+    GS_TRACE_SCOPE("ChunkResidency::loadNext");
+    uint32_t chunk = UINT32_MAX;
+    size_t offset = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.empty()) return;
+        // Priorities change every frame, so pick at start time.
+        auto best = queue_.begin();
+        for (auto it = queue_.begin() + 1; it != queue_.end(); ++it) {
+            if (loadsBefore(chunks_[*it], chunks_[*best])) best = it;
+        }
+        chunk = *best;
+        *best = queue_.back();
+        queue_.pop_back();
+        // open() rejects these; never decode past the slot.
+        if (reader_.chunks()[chunk].count > slotSize_) {
+            Chunk& ch = chunks_[chunk];
+            slotChunk_[ch.slot] = UINT32_MAX;
+            ch.slot = UINT32_MAX;
+            ch.state = ChunkState::Absent;
+            return;
+        }
+        chunks_[chunk].state = ChunkState::Loading;
+        offset = (size_t)chunks_[chunk].slot * slotSize_;
+        stats_.inFlight++;
+    }
+
+    // Other slots are read by the renderer meanwhile; this one is ours
+    // until it turns Resident.
+    auto t0 = Clock::now();
+    reader_.decodeChunk(chunk, pool_, offset);
+    const double ms = msSince(t0);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    chunks_[chunk].state = ChunkState::Resident;
+    stats_.inFlight--;
+    stats_.loadMs += ms;
+    stats_.loadedBytes += splatDataBytes(reader_.chunks()[chunk].count, reader_.shRestCoeffs());
+}
+
+ChunkResidency::Stats ChunkResidency::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats s = stats_;
+    for (uint32_t c : slotChunk_) {
+        if (c == UINT32_MAX || chunks_[c].state != ChunkState::Resident) continue;
+        s.residentChunks++;
+        s.residentBytes += splatDataBytes(reader_.chunks()[c].count, reader_.shRestCoeffs());
+    }
+    s.inFlight += (uint32_t)queue_.size();
+    return s;
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "camera.h"
+#include "compact_splat.h"
+#include "splat_cloud.h"
+#include "thread_pool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Out-of-core rendering of .gsc scenes larger than memory.
+//
+// The file's chunks are the unit of residency: a fixed pool of chunk-sized
+// slots, sized by the memory budget, holds the decoded chunks currently
+// needed. Every frame update() culls the chunk bounds against the camera,
+// requests visible chunks that are missing (nearest first) and prefetches
+// those in the frustum the camera will have after Options::prefetchSeconds
+// at its current velocity. When the pool is full the least recently used
+// chunk not needed this frame is evicted; when a frame needs more chunks
+// than fit, the farthest visible ones are left out.
+//
+// Chunks decode on loader threads straight into their slot; requests wait
+// in a queue that is re-prioritized every frame, and requests that are no
+// longer wanted are dropped before they start. The pool is a SplatCloud, so
+// rendering is CpuRasterizer::render(cloud(), camera, ranges()).
+//
+// Files written by splat_convert are in Morton order, which makes chunks
+// compact in space; chunks of a file in training order overlap heavily and
+// cull poorly.
+class ChunkResidency {
+public:
+    struct Options {
+        uint64_t budgetBytes = 256ull << 20; // decoded splat data
+        unsigned loaders = 2;
+        uint32_t maxInFlight = 8;            // queued or decoding
+        float prefetchSeconds = 0.5f;        // look-ahead along camera velocity
+    };
+
+    struct Stats {
+        uint32_t slots = 0;
+        uint32_t residentChunks = 0;
+        uint64_t residentBytes = 0;
+        uint32_t inFlight = 0;    // queued or decoding
+        uint32_t frames = 0;
+        uint32_t stallFrames = 0; // frames with a visible chunk missing
+        uint64_t lookups = 0;     // visible chunks over all frames
+        uint64_t hits = 0;        // ... that were resident
+        uint64_t loads = 0;
+        uint64_t prefetches = 0;  // loads requested ahead of visibility
+        uint64_t evictions = 0;
+        uint64_t dropped = 0;     // requests abandoned before they started
+        uint64_t loadedBytes = 0;
+        double loadMs = 0.0;      // decode time summed over loader threads
+
+        float hitRate() const { return lookups ? (float)((double)hits / (double)lookups) : 1.f; }
+    };
+
+    Options options; // read by open()
+
+    ChunkResidency() = default;
+    ~ChunkResidency();
+
+    ChunkResidency(const ChunkResidency&) = delete;
+    ChunkResidency& operator=(const ChunkResidency&) = delete;
+
+    bool open(const std::string& path, std::string* error = nullptr);
+    void close();
+    bool isOpen() const { return !chunks_.empty(); }
+
+    // Bytes of decoded splat data for the whole scene.
+    uint64_t sceneBytes() const;
+    // Bounds of the splat centres of the whole scene.
+    void bounds(float min[3], float max[3]) const;
+
+    // Once per frame, before reading cloud() and ranges().
+    void update(const Camera& camera, float dtSeconds);
+
+    const SplatCloud& cloud() const { return pool_; }
+    // Slots of the resident visible chunks at the last update(), ascending.
+    const std::vector<SplatRange>& ranges() const { return ranges_; }
+    const CompactSplatHeader& header() const { return reader_.header(); }
+    Stats stats() const;
+
+private:
+    enum class ChunkState : uint8_t {
+        Absent,
+        Queued,
+        Loading,
+        Resident,
+    };
+
+    struct Chunk {
+        float min[3];
+        float max[3];           // splat centres widened by 3 sigma
+        uint32_t slot = UINT32_MAX;
+        ChunkState state = ChunkState::Absent;
+        bool prefetch = false;  // queued ahead of visibility
+        uint64_t lastUsed = 0;  // frame
+        float priority = 0.f;   // lower loads first
+    };
+
+    // Reserves a slot for `chunk`, evicting if needed; false if every slot
+    // is busy or holds a chunk needed more this frame.
+    bool reserveSlot(uint32_t chunk);
+    void loadNext();
+
+    CompactSplatReader reader_;
+    SplatCloud pool_;
+    uint32_t slotSize_ = 0;
+    std::unique_ptr<ThreadPool> loaders_;
+
+    mutable std::mutex mutex_; // chunk states, slots, queue, stats
+    std::vector<Chunk> chunks_;
+    std::vector<uint32_t> slotChunk_; // slot -> chunk, UINT32_MAX if free
+    std::vector<uint32_t> queue_;     // Queued chunks
+    Stats stats_;
+
+    // Render thread only.
+    std::vector<SplatRange> ranges_;
+    std::vector<uint32_t> wanted_;
+    uint64_t frame_ = 0;
+    float lastEye_[3] = { 0.f, 0.f, 0.f };
+    float velocity_[3] = { 0.f, 0.f, 0.f };
+    bool haveEye_ = false;
+};
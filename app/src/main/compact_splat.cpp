@@ -0,0 +1,378 @@
+#include "compact_splat.h"
+#include "half.h"
+#include "splat_cloud.h"
+#include "thread_pool.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+static_assert(sizeof(CompactSplatHeader) == 36, "CompactSplatHeader is written as-is");
+static_assert(sizeof(CompactChunk) == 48, "CompactChunk is written as-is");
+
+namespace {
+
+constexpr float kInvSqrt2 = 0.70710678118654752f;
+
+// Byte offsets of the sections inside one chunk.
+struct ChunkLayout {
+    size_t pos = 0;
+    size_t rot = 0;
+    size_t scale = 0;
+    size_t opacity = 0;
+    size_t dc = 0;
+    size_t rest = 0;
+    size_t bytes = 0;
+};
+
+static ChunkLayout chunkLayout(size_t count, uint32_t restCoeffs, CompactShEncoding enc) {
+    const size_t shBytes = enc == CompactShEncoding::Half ? 2 : 1;
+    ChunkLayout l;
+    l.pos = 0;
+    l.rot = l.pos + count * 3 * sizeof(uint16_t);
+    l.scale = l.rot + count * sizeof(uint32_t);
+    l.opacity = l.scale + count * 3;
+    l.dc = l.opacity + count;
+    l.rest = l.dc + count * 3 * shBytes;
+    l.bytes = l.rest + count * 3 * restCoeffs * shBytes;
+    return l;
+}
+
+static inline uint32_t quantize(float v, float lo, float hi, uint32_t maxQ) {
+    if (!(hi > lo)) return 0;
+    float t = (v - lo) / (hi - lo);
+    t = std::min(1.f, std::max(0.f, t));
+    return (uint32_t)std::lround(t * (float)maxQ);
+}
+
+static inline float dequantize(uint32_t q, float lo, float hi, uint32_t maxQ) {
+    return lo + (hi - lo) * ((float)q / (float)maxQ);
+}
+
+static uint32_t packQuaternion(float w, float x, float y, float z) {
+    float c[4] = { w, x, y, z };
+    uint32_t largest = 0;
+    for (uint32_t i = 1; i < 4; i++) {
+        if (std::fabs(c[i]) > std::fabs(c[largest])) largest = i;
+    }
+    // q and -q are the same rotation; make the dropped component positive.
+    float sign = c[largest] < 0.f ? -1.f : 1.f;
+
+    uint32_t packed = largest << 30;
+    uint32_t shift = 20;
+    for (uint32_t i = 0; i < 4; i++) {
+        if (i == largest) continue;
+        packed |= quantize(c[i] * sign, -kInvSqrt2, kInvSqrt2, 1023) << shift;
+        shift -= 10;
+    }
+    return packed;
+}
+
+static void unpackQuaternion(uint32_t packed, float& w, float& x, float& y, float& z) {
+    float c[4];
+    uint32_t largest = packed >> 30;
+    uint32_t shift = 20;
+    float sum = 0.f;
+    for (uint32_t i = 0; i < 4; i++) {
+        if (i == largest) continue;
+        c[i] = dequantize((packed >> shift) & 1023u, -kInvSqrt2, kInvSqrt2, 1023);
+        sum += c[i] * c[i];
+        shift -= 10;
+    }
+    c[largest] = std::sqrt(std::max(0.f, 1.f - sum));
+    w = c[0];
+    x = c[1];
+    y = c[2];
+    z = c[3];
+}
+
+template <typename T>
+static void putPlane(uint8_t* dst, size_t plane, size_t count, size_t i, T v) {
+    std::memcpy(dst + (plane * count + i) * sizeof(T), &v, sizeof(T));
+}
+
+template <typename T>
+static T getPlane(const uint8_t* src, size_t plane, size_t count, size_t i) {
+    T v;
+    std::memcpy(&v, src + (plane * count + i) * sizeof(T), sizeof(T));
+    return v;
+}
+
+struct ShRanges {
+    float dcMin = 0.f;
+    float dcMax = 0.f;
+    float restMax = 0.f;
+};
+
+static void encodeSh(uint8_t* dst, size_t plane, size_t count, size_t i, float v, bool isDc,
+                     CompactShEncoding enc, const ShRanges& r) {
+    if (enc == CompactShEncoding::Half) {
+        putPlane<uint16_t>(dst, plane, count, i, floatToHalf(v));
+    } else if (isDc) {
+        putPlane<uint8_t>(dst, plane, count, i, (uint8_t)quantize(v, r.dcMin, r.dcMax, 255));
+    } else {
+        putPlane<uint8_t>(dst, plane, count, i, (uint8_t)quantize(v, -r.restMax, r.restMax, 255));
+    }
+}
+
+// Decodes one SH plane of n values.
+static void decodeShPlane(const uint8_t* src, size_t plane, size_t n, bool isDc,
+                          CompactShEncoding enc, const ShRanges& r, float* dst) {
+    if (enc == CompactShEncoding::Half) {
+        const uint8_t* p = src + plane * n * sizeof(uint16_t);
+        for (size_t j = 0; j < n; j++) {
+            uint16_t h;
+            std::memcpy(&h, p + j * sizeof(uint16_t), sizeof(h));
+            dst[j] = halfToFloat(h);
+        }
+        return;
+    }
+    const uint8_t* p = src + plane * n;
+    const float lo = isDc ? r.dcMin : -r.restMax;
+    const float step = ((isDc ? r.dcMax : r.restMax) - lo) / 255.f;
+    for (size_t j = 0; j < n; j++) dst[j] = lo + step * (float)p[j];
+}
+
+static void encodeChunk(const SplatCloud& cloud, size_t first, uint32_t restCoeffs,
+                        CompactShEncoding enc, const ShRanges& ranges,
+                        CompactChunk& chunk, std::vector<uint8_t>& data) {
+    const size_t n = chunk.count;
+    const ChunkLayout l = chunkLayout(n, restCoeffs, enc);
+    data.assign(l.bytes, 0);
+    chunk.bytes = (uint32_t)l.bytes;
+
+    for (int a = 0; a < 3; a++) {
+        chunk.posMin[a] = chunk.posMax[a] = cloud.pos[a][first];
+    }
+    chunk.logScaleMin = chunk.logScaleMax = std::log(std::max(cloud.scale[0][first], 1e-30f));
+    for (size_t i = first; i < first + n; i++) {
+        for (int a = 0; a < 3; a++) {
+            chunk.posMin[a] = std::min(chunk.posMin[a], cloud.pos[a][i]);
+            chunk.posMax[a] = std::max(chunk.posMax[a], cloud.pos[a][i]);
+            float ls = std::log(std::max(cloud.scale[a][i], 1e-30f));
+            chunk.logScaleMin = std::min(chunk.logScaleMin, ls);
+            chunk.logScaleMax = std::max(chunk.logScaleMax, ls);
+        }
+    }
+
+    uint8_t* d = data.data();
+    for (size_t j = 0; j < n; j++) {
+        const size_t i = first + j;
+        for (int a = 0; a < 3; a++) {
+            putPlane<uint16_t>(d + l.pos, a, n, j,
+                               (uint16_t)quantize(cloud.pos[a][i], chunk.posMin[a], chunk.posMax[a], 65535));
+            float ls = std::log(std::max(cloud.scale[a][i], 1e-30f));
+            putPlane<uint8_t>(d + l.scale, a, n, j,
+                              (uint8_t)quantize(ls, chunk.logScaleMin, chunk.logScaleMax, 255));
+            encodeSh(d + l.dc, a, n, j, cloud.shDc[a][i], true, enc, ranges);
+        }
+        putPlane<uint32_t>(d + l.rot, 0, n, j,
+                           packQuaternion(cloud.rot[0][i], cloud.rot[1][i], cloud.rot[2][i], cloud.rot[3][i]));
+        putPlane<uint8_t>(d + l.opacity, 0, n, j, (uint8_t)quantize(cloud.opacity[i], 0.f, 1.f, 255));
+
+        for (uint32_t c = 0; c < 3; c++) {
+            for (uint32_t k = 0; k < restCoeffs; k++) {
+                encodeSh(d + l.rest, c * restCoeffs + k, n, j, cloud.shRestPlane(c, k)[i], false, enc, ranges);
+            }
+        }
+    }
+}
+
+} // namespace
+
+bool writeCompactSplats(const std::string& path, const SplatCloud& cloud,
+                        const CompactSplatOptions& options, std::string* error) {
+    auto fail = [&](const char* what) {
+        if (error) *error = what;
+        return false;
+    };
+
+    if (options.chunkSize == 0) return fail("chunk size must be positive");
+    if (!cloud.hasShape()) return fail("cloud has no scale or rotation");
+
+    const uint32_t degree = std::min(cloud.shDegree(), options.maxShDegree);
+    const uint32_t restCoeffs = shRestCoeffsForDegree(degree);
+
+    CompactSplatHeader header;
+    header.count = (uint32_t)cloud.count;
+    header.chunkSize = options.chunkSize;
+    header.chunkCount = (uint32_t)((cloud.count + options.chunkSize - 1) / options.chunkSize);
+    header.shDegree = (uint8_t)degree;
+    header.shEncoding = options.shEncoding;
+
+    ShRanges ranges;
+    if (options.shEncoding == CompactShEncoding::UInt8 && cloud.count > 0) {
+        ranges.dcMin = ranges.dcMax = cloud.shDc[0][0];
+        for (const auto& ch : cloud.shDc) {
+            for (size_t i = 0; i < cloud.count; i++) {
+                ranges.dcMin = std::min(ranges.dcMin, ch[i]);
+                ranges.dcMax = std::max(ranges.dcMax, ch[i]);
+            }
+        }
+        for (uint32_t c = 0; c < 3; c++) {
+            for (uint32_t k = 0; k < restCoeffs; k++) {
+                const float* p = cloud.shRestPlane(c, k);
+                for (size_t i = 0; i < cloud.count; i++) ranges.restMax = std::max(ranges.restMax, std::fabs(p[i]));
+            }
+        }
+        header.dcMin = ranges.dcMin;
+        header.dcMax = ranges.dcMax;
+        header.restMax = ranges.restMax;
+    }
+
+    std::vector<CompactChunk> chunks(header.chunkCount);
+    std::vector<std::vector<uint8_t>> data(header.chunkCount);
+
+    ThreadPool::shared().run(header.chunkCount, [&](size_t c) {
+        size_t first = c * (size_t)options.chunkSize;
+        chunks[c].count = (uint32_t)std::min<size_t>(options.chunkSize, cloud.count - first);
+        encodeChunk(cloud, first, restCoeffs, options.shEncoding, ranges, chunks[c], data[c]);
+    });
+
+    uint64_t offset = sizeof(CompactSplatHeader) + (uint64_t)chunks.size() * sizeof(CompactChunk);
+    for (auto& ch : chunks) {
+        ch.offset = offset;
+        offset += ch.bytes;
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) return fail("cannot create file");
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!chunks.empty()) {
+        out.write(reinterpret_cast<const char*>(chunks.data()), (std::streamsize)(chunks.size() * sizeof(CompactChunk)));
+    }
+    for (const auto& d : data) {
+        out.write(reinterpret_cast<const char*>(d.data()), (std::streamsize)d.size());
+    }
+    if (!out) return fail("write failed");
+    return true;
+}
+
+uint32_t CompactSplatReader::shRestCoeffs() const {
+    return shRestCoeffsForDegree(header_.shDegree);
+}
+
+bool CompactSplatReader::open(const std::string& path, std::string* error) {
+    close();
+
+    auto fail = [&](const char* what) {
+        if (error) *error = what;
+        file_.close();
+        return false;
+    };
+
+    if (!file_.open(path)) return fail("cannot open file");
+    if (file_.size() < sizeof(CompactSplatHeader)) return fail("truncated header");
+
+    std::memcpy(&header_, file_.data(), sizeof(header_));
+    const CompactSplatHeader ref;
+    if (std::memcmp(header_.magic, ref.magic, sizeof(ref.magic)) != 0) return fail("not a compact splat file");
+    if (header_.version != ref.version) return fail("unsupported compact splat version");
+    if (header_.shDegree > 3) return fail("bad SH degree");
+    if (header_.shEncoding != CompactShEncoding::Half && header_.shEncoding != CompactShEncoding::UInt8) {
+        return fail("bad SH encoding");
+    }
+
+    const size_t tableEnd = sizeof(CompactSplatHeader) + (size_t)header_.chunkCount * sizeof(CompactChunk);
+    if (file_.size() < tableEnd) return fail("truncated chunk table");
+
+    chunks_.resize(header_.chunkCount);
+    if (!chunks_.empty()) {
+        std::memcpy(chunks_.data(), file_.data() + sizeof(CompactSplatHeader), chunks_.size() * sizeof(CompactChunk));
+    }
+
+    uint64_t total = 0;
+    for (const auto& ch : chunks_) {
+        ChunkLayout l = chunkLayout(ch.count, shRestCoeffs(), header_.shEncoding);
+        // Written so that a corrupt offset cannot wrap past the check.
+        const bool inFile = ch.offset <= file_.size() && ch.bytes <= file_.size() - ch.offset;
+        if (ch.bytes != l.bytes || !inFile) return fail("corrupt chunk table");
+        // Readers decode a chunk into a chunkSize slot.
+        if (ch.count == 0 || ch.count > header_.chunkSize) return fail("corrupt chunk table");
+        total += ch.count;
+    }
+    if (total != header_.count) return fail("chunk counts do not add up");
+    return true;
+}
+
+void CompactSplatReader::close() {
+    file_.close();
+    header_ = CompactSplatHeader{};
+    chunks_.clear();
+}
+
+void CompactSplatReader::decodeChunk(size_t index, SplatCloud& dst, size_t dstOffset) const {
+    GS_TRACE_SCOPE("decodeChunk");
+    const CompactChunk& ch = chunks_[index];
+    const size_t n = ch.count;
+    const uint32_t restCoeffs = shRestCoeffs();
+    const CompactShEncoding enc = header_.shEncoding;
+    const ChunkLayout l = chunkLayout(n, restCoeffs, enc);
+    const uint8_t* d = file_.data() + ch.offset;
+
+    ShRanges ranges;
+    ranges.dcMin = header_.dcMin;
+    ranges.dcMax = header_.dcMax;
+    ranges.restMax = header_.restMax;
+
+    for (int a = 0; a < 3; a++) {
+        float* pos = dst.pos[a].data() + dstOffset;
+        float* scale = dst.scale[a].data() + dstOffset;
+        float* dc = dst.shDc[a].data() + dstOffset;
+        for (size_t j = 0; j < n; j++) {
+            pos[j] = dequantize(getPlane<uint16_t>(d + l.pos, a, n, j), ch.posMin[a], ch.posMax[a], 65535);
+            scale[j] = std::exp(dequantize(getPlane<uint8_t>(d + l.scale, a, n, j),
+                                           ch.logScaleMin, ch.logScaleMax, 255));
+        }
+        decodeShPlane(d + l.dc, a, n, true, enc, ranges, dc);
+    }
+
+    float* op = dst.opacity.data() + dstOffset;
+    for (size_t j = 0; j < n; j++) {
+        op[j] = getPlane<uint8_t>(d + l.opacity, 0, n, j) * (1.f / 255.f);
+        unpackQuaternion(getPlane<uint32_t>(d + l.rot, 0, n, j),
+                         dst.rot[0][dstOffset + j], dst.rot[1][dstOffset + j],
+                         dst.rot[2][dstOffset + j], dst.rot[3][dstOffset + j]);
+    }
+
+    for (uint32_t c = 0; c < 3; c++) {
+        for (uint32_t k = 0; k < restCoeffs; k++) {
+            decodeShPlane(d + l.rest, c * restCoeffs + k, n, false, enc, ranges,
+                          dst.shRestPlane(c, k) + dstOffset);
+        }
+    }
+}
+
+bool loadCompactSplats(const std::string& path, SplatCloud& out, std::string* error) {
+    GS_TRACE_SCOPE("loadCompactSplats");
+    out.clear();
+
+    CompactSplatReader reader;
+    if (!reader.open(path, error)) return false;
+
+    out.resize(reader.header().count, reader.shRestCoeffs());
+
+    const auto& chunks = reader.chunks();
+    std::vector<size_t> first(chunks.size());
+    size_t total = 0;
+    for (size_t c = 0; c < chunks.size(); c++) {
+        first[c] = total;
+        total += chunks[c].count;
+    }
+
+    ThreadPool::shared().run(chunks.size(), [&](size_t c) {
+        reader.decodeChunk(c, out, first[c]);
+    });
+    return true;
+}
+
+bool isCompactSplatFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[4] = {};
+    if (!in.read(magic, sizeof(magic))) return false;
+    const CompactSplatHeader ref;
+    return std::memcmp(magic, ref.magic, sizeof(magic)) == 0;
+}
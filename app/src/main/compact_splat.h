@@ -0,0 +1,95 @@
+#pragma once
+
+#include "mapped_file.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct SplatCloud;
+
+// Compact splat container (.gsc).
+//
+// Splats are stored in chunks of `chunkSize`; a chunk table after the file
+// header gives every chunk's byte offset and bounds so readers can seek to,
+// or skip, any chunk. Inside a chunk every attribute is a separate section:
+//
+//   positions  3 x uint16 planes, quantized to the chunk's position bounds
+//   rotation   uint32, "smallest three" quaternion (2 bit index + 3 x 10 bit)
+//   scale      3 x uint8 planes, log scale quantized to the chunk's range
+//   opacity    uint8
+//   SH DC      3 planes, fp16 or uint8
+//   SH rest    3 * coeffs planes, fp16 or uint8
+//
+// That is 62 bytes per splat at degree 3 with 8-bit SH and 110 bytes with
+// fp16 SH, against 248 bytes for the usual float PLY export.
+
+enum class CompactShEncoding : uint8_t {
+    Half = 0,
+    UInt8 = 1,
+};
+
+struct CompactSplatHeader {
+    char magic[4] = { 'G', 'S', 'C', '1' };
+    uint32_t version = 1;
+    uint32_t count = 0;
+    uint32_t chunkSize = 0;
+    uint32_t chunkCount = 0;
+    uint8_t shDegree = 0;
+    CompactShEncoding shEncoding = CompactShEncoding::Half;
+    uint16_t reserved = 0;
+    // Ranges used by CompactShEncoding::UInt8.
+    float dcMin = 0.f;
+    float dcMax = 0.f;
+    float restMax = 0.f; // rest coefficients live in [-restMax, restMax]
+};
+
+struct CompactChunk {
+    uint64_t offset = 0; // absolute byte offset of the chunk data
+    uint32_t count = 0;
+    uint32_t bytes = 0;
+    float posMin[3] = {};
+    float posMax[3] = {};
+    float logScaleMin = 0.f;
+    float logScaleMax = 0.f;
+};
+
+struct CompactSplatOptions {
+    uint32_t chunkSize = 4096;
+    CompactShEncoding shEncoding = CompactShEncoding::Half;
+    uint32_t maxShDegree = 3;
+};
+
+bool writeCompactSplats(const std::string& path, const SplatCloud& cloud,
+                        const CompactSplatOptions& options = CompactSplatOptions{},
+                        std::string* error = nullptr);
+
+// Random access reader over a mapped .gsc file.
+class CompactSplatReader {
+public:
+    bool open(const std::string& path, std::string* error = nullptr);
+    void close();
+
+    const CompactSplatHeader& header() const { return header_; }
+    const std::vector<CompactChunk>& chunks() const { return chunks_; }
+    uint32_t shRestCoeffs() const;
+
+    // Decodes chunk `index` into dst[dstOffset, dstOffset + chunk.count).
+    // dst must already be sized for it with shRestCoeffs() coefficients.
+    void decodeChunk(size_t index, SplatCloud& dst, size_t dstOffset) const;
+
+    // Byte size of the whole file.
+    size_t fileBytes() const { return file_.size(); }
+
+private:
+    MappedFile file_;
+    CompactSplatHeader header_;
+    std::vector<CompactChunk> chunks_;
+};
+
+// Decodes every chunk (in parallel) into `out`.
+bool loadCompactSplats(const std::string& path, SplatCloud& out, std::string* error = nullptr);
+
+// True if the file starts with the compact splat magic.
+bool isCompactSplatFile(const std::string& path);
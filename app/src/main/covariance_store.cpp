@@ -0,0 +1,82 @@
+#include "covariance_store.h"
+#include "thread_pool.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+} // namespace
+
+void splatCovariance(float sx, float sy, float sz, float qw, float qx, float qy, float qz, float out[6]) {
+    const float r00 = 1.f - 2.f * (qy * qy + qz * qz);
+    const float r01 = 2.f * (qx * qy - qw * qz);
+    const float r02 = 2.f * (qx * qz + qw * qy);
+    const float r10 = 2.f * (qx * qy + qw * qz);
+    const float r11 = 1.f - 2.f * (qx * qx + qz * qz);
+    const float r12 = 2.f * (qy * qz - qw * qx);
+    const float r20 = 2.f * (qx * qz - qw * qy);
+    const float r21 = 2.f * (qy * qz + qw * qx);
+    const float r22 = 1.f - 2.f * (qx * qx + qy * qy);
+
+    // M = R S
+    const float m00 = r00 * sx, m01 = r01 * sy, m02 = r02 * sz;
+    const float m10 = r10 * sx, m11 = r11 * sy, m12 = r12 * sz;
+    const float m20 = r20 * sx, m21 = r21 * sy, m22 = r22 * sz;
+
+    out[0] = m00 * m00 + m01 * m01 + m02 * m02;
+    out[1] = m00 * m10 + m01 * m11 + m02 * m12;
+    out[2] = m00 * m20 + m01 * m21 + m02 * m22;
+    out[3] = m10 * m10 + m11 * m11 + m12 * m12;
+    out[4] = m10 * m20 + m11 * m21 + m12 * m22;
+    out[5] = m20 * m20 + m21 * m21 + m22 * m22;
+}
+
+void CovarianceStore::clear() {
+    std::vector<uint8_t>().swap(data_);
+    count_ = 0;
+    buildMs_ = 0.0;
+}
+
+bool CovarianceStore::build(const SplatCloud& cloud, CovariancePrecision precision, std::string* error) {
+    GS_TRACE_SCOPE("CovarianceStore::build");
+    auto t0 = Clock::now();
+    if (!cloud.hasShape()) {
+        clear();
+        if (error) *error = "cloud has no scale or rotation";
+        return false;
+    }
+    precision_ = precision;
+    count_ = cloud.count;
+    data_.resize(count_ * stride());
+
+    uint8_t* base = data_.data();
+    const size_t step = stride();
+    ThreadPool::shared().parallelFor(count_, 1 << 14, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            float cov[6];
+            splatCovariance(cloud.scale[0][i], cloud.scale[1][i], cloud.scale[2][i],
+                            cloud.rot[0][i], cloud.rot[1][i], cloud.rot[2][i], cloud.rot[3][i], cov);
+            uint8_t* dst = base + i * step;
+            if (precision == CovariancePrecision::Float32) {
+                std::memcpy(dst, cov, sizeof(cov));
+                continue;
+            }
+
+            // |off-diagonal| <= max diagonal, so every entry lands in [-1, 1].
+            const float s = std::max(cov[0], std::max(cov[3], cov[5]));
+            const float inv = s > 0.f ? 1.f / s : 0.f;
+            uint16_t h[6];
+            for (int k = 0; k < 6; k++) h[k] = floatToHalf(cov[k] * inv);
+            std::memcpy(dst, h, sizeof(h));
+            std::memcpy(dst + sizeof(h), &s, sizeof(s));
+        }
+    });
+    buildMs_ = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    return true;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "half.h"
+#include "splat_cloud.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Upper triangle of R S S^T R^T (xx, xy, xz, yy, yz, zz) for scale s and
+// unit quaternion (w, x, y, z).
+void splatCovariance(float sx, float sy, float sz, float qw, float qx, float qy, float qz, float out[6]);
+
+enum class CovariancePrecision : uint32_t {
+    Float32, // 6 floats, 24 bytes per splat
+    Float16, // 6 halves + float scale, 16 bytes per splat
+};
+
+// Per-splat 3D covariances computed once after loading, for static scenes.
+//
+// Entries are packed per splat, so the buffer can be uploaded as-is and
+// indexed by splat. Float16 entries are stored relative to the largest
+// diagonal entry, which goes in a trailing float, so tiny Gaussians keep
+// their precision:
+//
+//   Float32: float cov[6]
+//   Float16: uint16_t cov[6] (cov / s), float s
+//
+// Once built, projection needs no scale or rotation; a cloud that is only
+// rendered can drop them with SplatCloud::releaseShape().
+class CovarianceStore {
+public:
+    // Needs the cloud's scale and rotation; fails (leaving the store empty)
+    // when they have been released.
+    bool build(const SplatCloud& cloud, CovariancePrecision precision = CovariancePrecision::Float32,
+               std::string* error = nullptr);
+    void clear();
+
+    size_t count() const { return count_; }
+    CovariancePrecision precision() const { return precision_; }
+    size_t stride() const { return precision_ == CovariancePrecision::Float32 ? 24 : 16; }
+
+    const uint8_t* data() const { return data_.data(); }
+    size_t bytes() const { return data_.size(); }
+    double buildMs() const { return buildMs_; }
+
+    // Unpacks splat i.
+    void get(size_t i, float out[6]) const {
+        const uint8_t* src = data_.data() + i * stride();
+        if (precision_ == CovariancePrecision::Float32) {
+            std::memcpy(out, src, 6 * sizeof(float));
+            return;
+        }
+        uint16_t h[6];
+        float s;
+        std::memcpy(h, src, sizeof(h));
+        std::memcpy(&s, src + sizeof(h), sizeof(s));
+        for (int k = 0; k < 6; k++) out[k] = halfToFloat(h[k]) * s;
+    }
+
+private:
+    std::vector<uint8_t> data_;
+    size_t count_ = 0;
+    CovariancePrecision precision_ = CovariancePrecision::Float32;
+    double buildMs_ = 0.0;
+};
@@ -0,0 +1,332 @@
+#include "cpu_rasterizer.h"
+#include "covariance_store.h"
+#include "sh_eval.h"
+#include "simd.h"
+#include "splat_cloud.h"
+#include "thread_pool.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+constexpr uint32_t kTile = CpuRasterizer::kTileSize;
+constexpr uint32_t kTilePixels = kTile * kTile;
+constexpr uint32_t kGroupsPerRow = kTile / 4;
+
+// Blending stops for a pixel once its transmittance would drop below this.
+constexpr float kMinTransmittance = 1e-4f;
+constexpr float kMinAlpha = 1.f / 255.f;
+constexpr float kMaxAlpha = 0.99f;
+
+// Splats per projection block.
+constexpr size_t kProjectBlock = 4096;
+
+} // namespace
+
+void CpuRasterizer::render(const SplatCloud& cloud, const Camera& camera, uint8_t* rgba, size_t rowStride) {
+    ranges_.assign(1, SplatRange{ 0, (uint32_t)cloud.count });
+    render(cloud, camera, ranges_, rgba, rowStride);
+}
+
+void CpuRasterizer::render(const SplatCloud& cloud, const Camera& camera, const std::vector<SplatRange>& ranges,
+                           uint8_t* rgba, size_t rowStride) {
+    GS_TRACE_SCOPE("CpuRasterizer::render");
+    if (&ranges != &ranges_) ranges_ = ranges;
+    rangeStart_.resize(ranges_.size() + 1);
+    rangeStart_[0] = 0;
+    for (size_t r = 0; r < ranges_.size(); r++) {
+        rangeStart_[r + 1] = rangeStart_[r] + (ranges_[r].end - ranges_[r].begin);
+    }
+
+    width_ = camera.width;
+    height_ = camera.height;
+    tilesX_ = (width_ + kTile - 1) / kTile;
+    tilesY_ = (height_ + kTile - 1) / kTile;
+
+    stats_ = Stats{};
+
+    auto t0 = Clock::now();
+    project(cloud, camera);
+    stats_.projectMs = msSince(t0);
+
+    if (options.depthPresort) {
+        t0 = Clock::now();
+        presort(cloud, camera);
+        stats_.presortMs = msSince(t0);
+    }
+
+    t0 = Clock::now();
+    bin();
+    stats_.binMs = msSince(t0);
+
+    t0 = Clock::now();
+    blend(rgba, rowStride);
+    stats_.blendMs = msSince(t0);
+}
+
+void CpuRasterizer::project(const SplatCloud& cloud, const Camera& cam) {
+    GS_TRACE_SCOPE("project");
+    const size_t n = rangeStart_.back();
+    stats_.projected = n;
+    proj_.index.resize(n);
+    proj_.meanX.resize(n);
+    proj_.meanY.resize(n);
+    proj_.conicA.resize(n);
+    proj_.conicB.resize(n);
+    proj_.conicC.resize(n);
+    proj_.depth.resize(n);
+    proj_.colorR.resize(n);
+    proj_.colorG.resize(n);
+    proj_.colorB.resize(n);
+    proj_.opacity.resize(n);
+    proj_.radius.resize(n);
+
+    // Cull against the tile grid so partly covered edge tiles still count.
+    const ProjectionView view = makeProjectionView(cam, (float)(tilesX_ * kTile), (float)(tilesY_ * kTile));
+    ProjectionInput in;
+    for (int k = 0; k < 3; k++) in.pos[k] = cloud.pos[k].data();
+    if (!options.covariances) {
+        for (int k = 0; k < 3; k++) in.scale[k] = cloud.scale[k].data();
+        for (int k = 0; k < 4; k++) in.rot[k] = cloud.rot[k].data();
+    }
+    in.opacity = cloud.opacity.data();
+    in.covariances = options.covariances;
+    float eye[3];
+    cam.position(eye);
+
+    // Each block writes its visible splats compactly from its own start;
+    // the gaps are closed afterwards.
+    const size_t blocks = (n + kProjectBlock - 1) / kProjectBlock;
+    blockCounts_.assign(blocks, 0);
+    ThreadPool::shared().run(blocks, [&](size_t blk) {
+        GS_TRACE_SCOPE("projectBlock");
+        const size_t begin = blk * kProjectBlock, end = std::min(n, begin + kProjectBlock);
+        size_t r = std::upper_bound(rangeStart_.begin(), rangeStart_.end(), (uint32_t)begin) - rangeStart_.begin() - 1;
+        size_t written = 0;
+        for (size_t i = begin; i < end; r++) {
+            const size_t runEnd = std::min<size_t>(end, rangeStart_[r + 1]);
+            if (runEnd <= i) continue;
+            const size_t s = ranges_[r].begin + (i - rangeStart_[r]);
+            const size_t k = begin + written;
+            ProjectionOutput out;
+            out.index = &proj_.index[k];
+            out.meanX = &proj_.meanX[k];
+            out.meanY = &proj_.meanY[k];
+            out.conicA = &proj_.conicA[k];
+            out.conicB = &proj_.conicB[k];
+            out.conicC = &proj_.conicC[k];
+            out.depth = &proj_.depth[k];
+            out.opacity = &proj_.opacity[k];
+            out.radius = &proj_.radius[k];
+            written += projectSplats(view, in, s, s + (runEnd - i), out, options.projectionKernel);
+            i = runEnd;
+        }
+
+        // View-dependent colour for the survivors, one consecutive run of
+        // cloud indices at a time.
+        for (size_t k = begin, stop = begin + written; k < stop;) {
+            size_t e = k + 1;
+            while (e < stop && proj_.index[e] == proj_.index[e - 1] + 1) e++;
+            evalShColors(cloud, eye, options.shDegree, proj_.index[k], proj_.index[k] + (e - k),
+                         &proj_.colorR[k], &proj_.colorG[k], &proj_.colorB[k]);
+            k = e;
+        }
+        blockCounts_[blk] = written;
+    });
+
+    size_t count = blocks ? blockCounts_[0] : 0;
+    for (size_t blk = 1; blk < blocks; blk++) {
+        const size_t src = blk * kProjectBlock, len = blockCounts_[blk];
+        auto close = [&](auto& v) { std::memmove(&v[count], &v[src], len * sizeof(v[0])); };
+        if (len && src != count) {
+            close(proj_.index);
+            close(proj_.meanX);
+            close(proj_.meanY);
+            close(proj_.conicA);
+            close(proj_.conicB);
+            close(proj_.conicC);
+            close(proj_.depth);
+            close(proj_.colorR);
+            close(proj_.colorG);
+            close(proj_.colorB);
+            close(proj_.opacity);
+            close(proj_.radius);
+        }
+        count += len;
+    }
+    projectedCount_ = count;
+}
+
+void CpuRasterizer::presort(const SplatCloud& cloud, const Camera& camera) {
+    GS_TRACE_SCOPE("presort");
+    const std::vector<uint32_t>& order = sorter_.sort(cloud, camera);
+
+    ThreadPool& pool = ThreadPool::shared();
+    slotOf_.resize(cloud.count);
+    pool.parallelFor(cloud.count, 1 << 16, [&](size_t begin, size_t end) {
+        std::fill(slotOf_.begin() + (ptrdiff_t)begin, slotOf_.begin() + (ptrdiff_t)end, UINT32_MAX);
+    });
+    pool.parallelFor(projectedCount_, 1 << 16, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; k++) slotOf_[proj_.index[k]] = (uint32_t)k;
+    });
+
+    // Projected slots in sorted order; as in project(), each block writes
+    // compactly from its own start and the gaps are closed afterwards.
+    const size_t n = order.size();
+    const size_t blocks = (n + kProjectBlock - 1) / kProjectBlock;
+    depthOrder_.resize(n);
+    blockCounts_.assign(blocks, 0);
+    pool.run(blocks, [&](size_t blk) {
+        const size_t begin = blk * kProjectBlock, end = std::min(n, begin + kProjectBlock);
+        size_t written = 0;
+        for (size_t i = begin; i < end; i++) {
+            const uint32_t slot = slotOf_[order[i]];
+            if (slot != UINT32_MAX) depthOrder_[begin + written++] = slot;
+        }
+        blockCounts_[blk] = written;
+    });
+    size_t count = blocks ? blockCounts_[0] : 0;
+    for (size_t blk = 1; blk < blocks; blk++) {
+        const size_t len = blockCounts_[blk];
+        if (len) std::memmove(&depthOrder_[count], &depthOrder_[blk * kProjectBlock], len * sizeof(uint32_t));
+        count += len;
+    }
+}
+
+void CpuRasterizer::bin() {
+    GS_TRACE_SCOPE("bin");
+    TileBinInput in;
+    in.count = projectedCount_;
+    in.meanX = proj_.meanX.data();
+    in.meanY = proj_.meanY.data();
+    in.conicA = proj_.conicA.data();
+    in.conicB = proj_.conicB.data();
+    in.conicC = proj_.conicC.data();
+    in.depth = proj_.depth.data();
+    in.opacity = proj_.opacity.data();
+    in.radius = proj_.radius.data();
+    in.order = options.depthPresort ? depthOrder_.data() : nullptr;
+
+    binner_.options.tileSize = kTile;
+    binner_.options.minAlpha = kMinAlpha;
+    binner_.options.conicFootprint = options.conicFootprint;
+    binner_.bin(in, width_, height_, ThreadPool::shared());
+    stats_.visible = binner_.stats().visible;
+    stats_.tileEntries = binner_.stats().entries;
+    GS_TRACE_COUNTER("visible splats", stats_.visible);
+    GS_TRACE_COUNTER("tile entries", stats_.tileEntries);
+}
+
+void CpuRasterizer::blend(uint8_t* rgba, size_t rowStride) {
+    GS_TRACE_SCOPE("blend");
+    using namespace simd;
+
+    const uint32_t tiles = tilesX_ * tilesY_;
+    const std::vector<uint32_t>& entries = binner_.values();
+    const f32x4 lanes = set(0.5f, 1.5f, 2.5f, 3.5f); // pixel centres within a group
+    const float* bg = options.background;
+
+    ThreadPool::shared().run(tiles, [&](size_t tile) {
+        const uint32_t tileX = (uint32_t)(tile % tilesX_) * kTile;
+        const uint32_t tileY = (uint32_t)(tile / tilesX_) * kTile;
+
+        alignas(16) float T[kTilePixels];
+        alignas(16) float R[kTilePixels];
+        alignas(16) float G[kTilePixels];
+        alignas(16) float B[kTilePixels];
+        alignas(16) float active[kTilePixels];
+        const f32x4 allOnes = cmpLe(set1(0.f), set1(0.f));
+        for (uint32_t p = 0; p < kTilePixels; p += 4) {
+            store(T + p, set1(1.f));
+            store(R + p, set1(0.f));
+            store(G + p, set1(0.f));
+            store(B + p, set1(0.f));
+            store(active + p, allOnes);
+        }
+
+        const uint32_t begin = binner_.ranges()[tile].begin;
+        const uint32_t end = binner_.ranges()[tile].end;
+        for (uint32_t e = begin; e < end; e++) {
+            // Early out once every pixel in the tile is saturated.
+            if (((e - begin) & 7) == 0 && e != begin) {
+                bool any_ = false;
+                for (uint32_t p = 0; p < kTilePixels && !any_; p += 4) any_ = any(load(active + p));
+                if (!any_) break;
+            }
+
+            const uint32_t s = entries[e];
+            const float mx = proj_.meanX[s];
+            const float my = proj_.meanY[s];
+            const float rad = (float)proj_.radius[s];
+
+            // Rows and 4-pixel column groups of this tile the splat can touch.
+            const int ry0 = std::max(0, (int)std::floor(my - rad) - (int)tileY);
+            const int ry1 = std::min((int)kTile, (int)std::ceil(my + rad) + 1 - (int)tileY);
+            const int gx0 = std::max(0, ((int)std::floor(mx - rad) - (int)tileX) / 4);
+            const int gx1 = std::min((int)kGroupsPerRow, ((int)std::ceil(mx + rad) - (int)tileX) / 4 + 1);
+            if (ry0 >= ry1 || gx0 >= gx1) continue;
+
+            const f32x4 cA = set1(-0.5f * proj_.conicA[s]);
+            const f32x4 cB = set1(-proj_.conicB[s]);
+            const f32x4 cC = set1(-0.5f * proj_.conicC[s]);
+            const f32x4 op = set1(proj_.opacity[s]);
+            const f32x4 colR = set1(proj_.colorR[s]);
+            const f32x4 colG = set1(proj_.colorG[s]);
+            const f32x4 colB = set1(proj_.colorB[s]);
+
+            for (int y = ry0; y < ry1; y++) {
+                const f32x4 dy = set1(my - ((float)(tileY + y) + 0.5f));
+                const f32x4 dyTerm = cC * dy * dy;
+                for (int g = gx0; g < gx1; g++) {
+                    const uint32_t p = (uint32_t)y * kTile + (uint32_t)g * 4;
+                    const f32x4 act = load(active + p);
+                    if (!any(act)) continue;
+
+                    const f32x4 dx = set1(mx - (float)(tileX + g * 4)) - lanes;
+                    const f32x4 power = cA * dx * dx + dyTerm + cB * dx * dy;
+                    const f32x4 alpha = min(set1(kMaxAlpha), op * expNeg(power));
+
+                    const f32x4 valid = maskAnd(act, maskAnd(cmpLe(power, set1(0.f)), cmpGe(alpha, set1(kMinAlpha))));
+                    if (!any(valid)) continue;
+
+                    const f32x4 t = load(T + p);
+                    const f32x4 testT = t * (set1(1.f) - alpha);
+                    const f32x4 saturated = maskAnd(valid, cmpLt(testT, set1(kMinTransmittance)));
+                    const f32x4 contrib = maskAndNot(valid, saturated);
+
+                    const f32x4 w = alpha * t;
+                    store(R + p, select(contrib, load(R + p) + colR * w, load(R + p)));
+                    store(G + p, select(contrib, load(G + p) + colG * w, load(G + p)));
+                    store(B + p, select(contrib, load(B + p) + colB * w, load(B + p)));
+                    store(T + p, select(contrib, testT, t));
+                    store(active + p, maskAndNot(act, saturated));
+                }
+            }
+        }
+
+        // Resolve with the background behind the remaining transmittance.
+        const uint32_t w = std::min(kTile, width_ - tileX);
+        const uint32_t h = std::min(kTile, height_ - tileY);
+        for (uint32_t y = 0; y < h; y++) {
+            uint8_t* dst = rgba + (size_t)(tileY + y) * rowStride + (size_t)tileX * 4;
+            for (uint32_t x = 0; x < w; x++) {
+                const uint32_t p = y * kTile + x;
+                const float c[3] = { R[p] + T[p] * bg[0], G[p] + T[p] * bg[1], B[p] + T[p] * bg[2] };
+                for (int ch = 0; ch < 3; ch++) {
+                    dst[x * 4 + ch] = (uint8_t)std::lround(std::min(1.f, std::max(0.f, c[ch])) * 255.f);
+                }
+                dst[x * 4 + 3] = 255;
+            }
+        }
+    });
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "camera.h"
+#include "depth_sorter.h"
+#include "splat_cloud.h"
+#include "splat_projection.h"
+#include "tile_binning.h"
+
+class CovarianceStore;
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Portable tile-based Gaussian splat rasterizer.
+//
+// Pipeline per frame: project every splat in SIMD batches (EWA 2D
+// covariance, see projectSplats) keeping only the visible ones, bin them
+// into 16x16 pixel tiles with TileBinner (one copy per overlapped tile,
+// sorted by tile and depth, or by tile alone after a global depth presort),
+// then blend front to back per tile with
+// early termination once a pixel's transmittance saturates. The blend inner
+// loop works on 4 pixels at a time through simd.h.
+//
+// It is the reference for the GPU path and the fallback when Vulkan is
+// unusable. Scratch buffers are kept between frames.
+class CpuRasterizer {
+public:
+    static constexpr uint32_t kTileSize = 16;
+
+    struct Options {
+        float background[3] = { 0.f, 0.f, 0.f };
+        // SH degree evaluated for view-dependent colour, clamped to what the
+        // cloud stores (see ShDegreeController for adjusting it under load).
+        uint32_t shDegree = 3;
+        // Precomputed covariances matching the rendered cloud; when null
+        // they are derived from scale and rotation every frame.
+        const CovarianceStore* covariances = nullptr;
+        // Bin by each splat's alpha ellipse rather than its radius square;
+        // the image is the same, with fewer tile entries.
+        bool conicFootprint = true;
+        // Reference is for checking the SIMD kernels, not for shipping.
+        ProjectionKernel projectionKernel = ProjectionKernel::Simd8;
+        // Depth sort the whole cloud first (coherently across frames, see
+        // DepthSorter) so binning only sorts by tile.
+        bool depthPresort = false;
+    };
+
+    struct Stats {
+        double projectMs = 0.0;
+        double presortMs = 0.0; // depth sort and mapping to projected splats
+        double binMs = 0.0;
+        double blendMs = 0.0;
+        size_t projected = 0;   // splats handed to projection (after culling)
+        size_t visible = 0;     // splats that touch at least one tile
+        size_t tileEntries = 0; // (tile, splat) pairs after duplication
+    };
+
+    Options options;
+
+    // Renders into `rgba` (camera.width x camera.height RGBA8, top row first,
+    // `rowStride` bytes per row).
+    void render(const SplatCloud& cloud, const Camera& camera, uint8_t* rgba, size_t rowStride);
+
+    // Same, but only splats inside `ranges` (ascending, e.g. from a
+    // SplatBvh frustum query) are projected; the rest are skipped entirely.
+    void render(const SplatCloud& cloud, const Camera& camera, const std::vector<SplatRange>& ranges,
+                uint8_t* rgba, size_t rowStride);
+
+    const Stats& stats() const { return stats_; }
+    const TileBinner::Stats& binStats() const { return binner_.stats(); }
+    const DepthSorter::Stats& sortStats() const { return sorter_.stats(); }
+
+private:
+    void project(const SplatCloud& cloud, const Camera& camera);
+    void presort(const SplatCloud& cloud, const Camera& camera);
+    void bin();
+    void blend(uint8_t* rgba, size_t rowStride);
+
+    // Splats that survived projection, compacted; index is the cloud index.
+    struct Projected {
+        std::vector<uint32_t> index;
+        std::vector<float> meanX, meanY;
+        std::vector<float> conicA, conicB, conicC;
+        std::vector<float> depth;
+        std::vector<float> colorR, colorG, colorB;
+        std::vector<float> opacity;
+        std::vector<uint32_t> radius;
+    } proj_;
+    size_t projectedCount_ = 0;
+    std::vector<size_t> blockCounts_;
+
+    std::vector<SplatRange> ranges_;
+    std::vector<uint32_t> rangeStart_; // prefix sum of range sizes
+
+    uint32_t width_ = 0;
+    uint32_t height_ = 0;
+    uint32_t tilesX_ = 0;
+    uint32_t tilesY_ = 0;
+
+    DepthSorter sorter_;
+    std::vector<uint32_t> slotOf_;     // cloud index -> projected slot
+    std::vector<uint32_t> depthOrder_; // projected slots, front to back
+
+    TileBinner binner_;
+
+    Stats stats_;
+};
@@ -0,0 +1,152 @@
+#include "depth_sorter.h"
+#include "radix_sort.h"
+#include "splat_cloud.h"
+#include "thread_pool.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Adjacent pairs checked before attempting the coherent fix-up.
+constexpr size_t kDisorderSamples = 4096;
+// How far back a slightly late splat may be insertion sorted.
+constexpr size_t kInsertionWindow = 16;
+
+} // namespace
+
+const std::vector<uint32_t>& DepthSorter::sort(const SplatCloud& cloud, const Camera& camera) {
+    GS_TRACE_SCOPE("DepthSorter::sort");
+    auto t0 = Clock::now();
+    stats_ = Stats{};
+
+    const size_t n = cloud.count;
+    depth_.resize(n);
+
+    const float r0 = camera.rot[6], r1 = camera.rot[7], r2 = camera.rot[8], tz = camera.trans[2];
+    const float* px = cloud.pos[0].data();
+    const float* py = cloud.pos[1].data();
+    const float* pz = cloud.pos[2].data();
+    ThreadPool::shared().parallelFor(n, 1 << 16, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            depth_[i] = packDepthKey(r0 * px[i] + r1 * py[i] + r2 * pz[i] + tz);
+        }
+    });
+
+    bool reused = options.mode == Mode::Coherent && order_.size() == n && coherentFixup(n);
+    if (!reused) fullSort(n);
+
+    stats_.reusedOrder = reused;
+    stats_.ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    return order_;
+}
+
+void DepthSorter::fullSort(size_t n) {
+    order_.resize(n);
+    keys_.resize(n);
+    keysTmp_.resize(n);
+    valuesTmp_.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        order_[i] = (uint32_t)i;
+        keys_[i] = depth_[i];
+    }
+    radixSortPairs(keys_.data(), order_.data(), n, keysTmp_.data(), valuesTmp_.data(), ThreadPool::shared());
+}
+
+bool DepthSorter::coherentFixup(size_t n) {
+    const size_t maxMoved = (size_t)((float)n * options.maxDisplacedFraction);
+
+    // Cheap disorder estimate on a sample of adjacent pairs first, so a
+    // camera cut costs a few thousand loads before falling back.
+    const size_t samples = std::min<size_t>(n - 1, kDisorderSamples);
+    if (samples > 0) {
+        size_t inversions = 0;
+        const size_t step = (n - 1) / samples;
+        for (size_t s = 0; s < samples; s++) {
+            size_t i = s * step;
+            if (depth_[order_[i]] > depth_[order_[i + 1]]) inversions++;
+        }
+        if ((float)inversions > (float)samples * options.maxDisplacedFraction) return false;
+    }
+
+    // Walk last frame's order building a sorted run. A splat slightly out of
+    // order is insertion-sorted a few slots back; anything further away is
+    // set aside and merged back at the end.
+    keysTmp_.resize(n);
+    valuesTmp_.resize(n);
+    movedKeys_.clear();
+    movedValues_.clear();
+
+    size_t kept = 0;
+    for (size_t i = 0; i < n; i++) {
+        const uint32_t idx = order_[i];
+        const uint32_t key = depth_[idx];
+        const uint32_t last = kept ? keysTmp_[kept - 1] : 0;
+
+        // A splat that jumped ahead is displaced at its own slot rather than
+        // displacing every splat after it.
+        const bool jumped = i + 1 < n && key > depth_[order_[i + 1]] && depth_[order_[i + 1]] >= last;
+        if (key >= last && !jumped) {
+            keysTmp_[kept] = key;
+            valuesTmp_[kept] = idx;
+            kept++;
+            continue;
+        }
+
+        if (!jumped) {
+            size_t j = kept;
+            while (j > 0 && kept - j < kInsertionWindow && keysTmp_[j - 1] > key) j--;
+            if (j == 0 || keysTmp_[j - 1] <= key) {
+                std::memmove(&keysTmp_[j + 1], &keysTmp_[j], (kept - j) * sizeof(uint32_t));
+                std::memmove(&valuesTmp_[j + 1], &valuesTmp_[j], (kept - j) * sizeof(uint32_t));
+                keysTmp_[j] = key;
+                valuesTmp_[j] = idx;
+                kept++;
+                continue;
+            }
+        }
+
+        if (movedKeys_.size() >= maxMoved) return false;
+        movedKeys_.push_back(key);
+        movedValues_.push_back(idx);
+    }
+
+    const size_t moved = movedKeys_.size();
+    stats_.displaced = moved;
+    if (moved == 0) {
+        keys_.swap(keysTmp_);
+        order_.swap(valuesTmp_);
+        return true;
+    }
+
+    // Sort the displaced splats; order_/keys_ serve as scratch here since
+    // they are rebuilt by the merge below.
+    keys_.resize(n);
+    radixSortPairs(movedKeys_.data(), movedValues_.data(), moved, keys_.data(), order_.data(),
+                   ThreadPool::shared());
+
+    // Merge kept run and displaced list into order_.
+    size_t a = 0, b = 0, o = 0;
+    while (a < kept && b < moved) {
+        if (movedKeys_[b] < keysTmp_[a]) {
+            keys_[o] = movedKeys_[b];
+            order_[o++] = movedValues_[b++];
+        } else {
+            keys_[o] = keysTmp_[a];
+            order_[o++] = valuesTmp_[a++];
+        }
+    }
+    for (; a < kept; a++, o++) {
+        keys_[o] = keysTmp_[a];
+        order_[o] = valuesTmp_[a];
+    }
+    for (; b < moved; b++, o++) {
+        keys_[o] = movedKeys_[b];
+        order_[o] = movedValues_[b];
+    }
+    return true;
+}
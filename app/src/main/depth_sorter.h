@@ -0,0 +1,65 @@
+#pragma once
+
+#include "camera.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct SplatCloud;
+
+// Per-frame view depth sort of a splat cloud (front to back).
+//
+// Full mode packs depths into 32-bit keys and radix sorts them. Coherent
+// mode starts from last frame's order instead: splats that are still in
+// order are kept in place, the few that moved are pulled out, sorted and
+// merged back. When too many splats moved (a camera cut) it falls back to
+// the full sort, so the result is always exactly sorted.
+//
+// CpuRasterizer's depth presort is built on it; `splat_bench --sort`
+// compares the modes along static, orbiting and cutting cameras.
+class DepthSorter {
+public:
+    enum class Mode {
+        Full,
+        Coherent,
+    };
+
+    struct Options {
+        Mode mode = Mode::Coherent;
+        // Coherent mode gives up once more than this fraction moved.
+        float maxDisplacedFraction = 0.05f;
+    };
+
+    struct Stats {
+        double ms = 0.0;
+        bool reusedOrder = false; // coherent fix-up succeeded
+        size_t displaced = 0;     // splats re-inserted by the fix-up
+    };
+
+    Options options;
+
+    // Sorts every splat of `cloud` by view depth for `camera`.
+    const std::vector<uint32_t>& sort(const SplatCloud& cloud, const Camera& camera);
+
+    // Forget the previous order (scene changed).
+    void invalidate() { order_.clear(); }
+
+    const std::vector<uint32_t>& order() const { return order_; }
+    const Stats& stats() const { return stats_; }
+
+private:
+    void fullSort(size_t n);
+    bool coherentFixup(size_t n);
+
+    std::vector<uint32_t> order_;
+    std::vector<uint32_t> keys_;  // keys_[i] belongs to order_[i]
+    std::vector<uint32_t> depth_; // key per splat index
+
+    std::vector<uint32_t> keysTmp_;
+    std::vector<uint32_t> valuesTmp_;
+    std::vector<uint32_t> movedKeys_;
+    std::vector<uint32_t> movedValues_;
+
+    Stats stats_;
+};
@@ -0,0 +1,66 @@
+#include "frame_arena.h"
+
+#include <algorithm>
+#include <new>
+
+namespace {
+
+// Blocks start cache-line aligned and at least this large.
+constexpr size_t kBlockAlignment = 64;
+constexpr size_t kMinBlockBytes = 64 * 1024;
+
+} // namespace
+
+FrameArena::FrameArena(size_t initialBytes) {
+    if (initialBytes) addBlock(initialBytes);
+}
+
+FrameArena::~FrameArena() {
+    for (Block& b : blocks_) ::operator delete(b.data, std::align_val_t(kBlockAlignment));
+}
+
+void FrameArena::addBlock(size_t minBytes) {
+    // Doubling keeps the number of blocks in a growing frame logarithmic.
+    const size_t size = std::max({ minBytes, kMinBlockBytes, stats_.capacity });
+    Block b;
+    b.data = static_cast<uint8_t*>(::operator new(size, std::align_val_t(kBlockAlignment)));
+    b.size = size;
+    blocks_.push_back(b);
+    offset_ = 0;
+    stats_.capacity += size;
+    stats_.blocks = (uint32_t)blocks_.size();
+    stats_.blockAllocations++;
+}
+
+void* FrameArena::allocate(size_t bytes, size_t alignment) {
+    if (bytes == 0) bytes = 1;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (!blocks_.empty()) {
+            const Block& b = blocks_.back();
+            const uintptr_t base = reinterpret_cast<uintptr_t>(b.data);
+            const uintptr_t start = (base + offset_ + alignment - 1) & ~(uintptr_t)(alignment - 1);
+            const size_t end = (size_t)(start - base) + bytes;
+            if (end <= b.size) {
+                stats_.used += end - offset_;
+                stats_.peak = std::max(stats_.peak, stats_.used);
+                offset_ = end;
+                return reinterpret_cast<void*>(start);
+            }
+        }
+        addBlock(bytes + alignment);
+    }
+    return nullptr; // not reached: a fresh block always fits
+}
+
+void FrameArena::reset() {
+    if (blocks_.size() > 1) {
+        // Coalesce into one block that holds the whole peak.
+        const size_t total = stats_.capacity;
+        for (Block& b : blocks_) ::operator delete(b.data, std::align_val_t(kBlockAlignment));
+        blocks_.clear();
+        stats_.capacity = 0;
+        addBlock(total);
+    }
+    offset_ = 0;
+    stats_.used = 0;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Linear allocator for data that lives for one frame.
+//
+// allocate() bumps an offset through a block and reset() makes all of it
+// reusable at once; nothing is freed individually. When a frame needs more
+// than the block holds, the excess comes from extra blocks, and the next
+// reset() replaces them with a single block of the combined size, so a
+// steady workload stops touching the heap after a frame or two.
+//
+// The renderer keeps one arena per frame in flight and resets it once that
+// frame's fence has signaled, so GPU-visible data recorded from it stays
+// valid for as long as the frame can read it.
+class FrameArena {
+public:
+    struct Stats {
+        size_t capacity = 0;   // bytes in all blocks
+        size_t used = 0;       // since the last reset, including padding
+        size_t peak = 0;       // largest `used` so far
+        uint32_t blocks = 0;
+        uint32_t blockAllocations = 0; // heap allocations made for blocks
+    };
+
+    explicit FrameArena(size_t initialBytes = 0);
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // `alignment` must be a power of two. Never fails short of the heap
+    // itself running out.
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+    template <typename T>
+    T* allocateArray(size_t count) {
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void reset();
+
+    const Stats& stats() const { return stats_; }
+
+private:
+    struct Block {
+        uint8_t* data = nullptr;
+        size_t size = 0;
+    };
+
+    void addBlock(size_t minBytes);
+
+    std::vector<Block> blocks_;
+    size_t offset_ = 0; // into blocks_.back()
+    Stats stats_;
+};
+
+// STL allocator drawing from a FrameArena; deallocate() is a no-op. A
+// growing container leaves its old storage behind until reset(), so
+// reserve() up front where the size is known.
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(FrameArena& arena) : arena_(&arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena()) {}
+
+    T* allocate(size_t n) { return arena_->allocateArray<T>(n); }
+    void deallocate(T*, size_t) {}
+
+    FrameArena* arena() const { return arena_; }
+
+private:
+    FrameArena* arena_;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+    return a.arena() == b.arena();
+}
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+    return a.arena() != b.arena();
+}
+
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
@@ -0,0 +1,207 @@
+#include "frame_profiler.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+// An interval this many display periods long missed at least one vsync.
+constexpr float kDroppedFactor = 1.5f;
+
+// Nearest-rank percentiles of `values`, which are reordered.
+static FramePercentiles percentiles(std::vector<float>& values) {
+    FramePercentiles p;
+    if (values.empty()) return p;
+    auto rank = [&](float q) {
+        const size_t k = std::min(values.size() - 1, (size_t)(q * (float)values.size()));
+        std::nth_element(values.begin(), values.begin() + (ptrdiff_t)k, values.end());
+        return values[k];
+    };
+    p.p50 = rank(0.50f);
+    p.p95 = rank(0.95f);
+    p.p99 = rank(0.99f);
+    return p;
+}
+
+} // namespace
+
+const char* cpuStageName(CpuStage stage) {
+    switch (stage) {
+    case CpuStage::FenceWait:
+        return "fence";
+    case CpuStage::Acquire:
+        return "acquire";
+    case CpuStage::Record:
+        return "record";
+    case CpuStage::Submit:
+        return "submit";
+    case CpuStage::Present:
+        return "present";
+    case CpuStage::Count:
+        break;
+    }
+    return "?";
+}
+
+const char* gpuStageName(GpuStage stage) {
+    switch (stage) {
+    case GpuStage::Upload:
+        return "upload";
+    case GpuStage::Image:
+        return "image";
+    case GpuStage::RenderPass:
+        return "pass";
+    case GpuStage::Readback:
+        return "readback";
+    case GpuStage::Count:
+        break;
+    }
+    return "?";
+}
+
+void formatFrameStats(const FrameStats& s, char* out, size_t size) {
+    size_t used = 0;
+    auto append = [&](const char* fmt, auto... args) {
+        if (used >= size) return;
+        const int n = std::snprintf(out + used, size - used, fmt, args...);
+        if (n > 0) used += (size_t)n;
+    };
+    auto triple = [&](const char* name, const FramePercentiles& p) {
+        append(" %s %.2f/%.2f/%.2f", name, p.p50, p.p95, p.p99);
+    };
+    append("frames %u (%llu total, %llu dropped at %.2f ms, %llu lost), p50/p95/p99 ms:", s.frames,
+           (unsigned long long)s.totalFrames, (unsigned long long)s.droppedFrames, s.displayPeriodMs,
+           (unsigned long long)s.lostRecords);
+    triple("interval", s.interval);
+    append(" | cpu");
+    triple("total", s.cpuTotal);
+    for (size_t k = 0; k < kCpuStageCount; k++) triple(cpuStageName((CpuStage)k), s.cpu[k]);
+    append(" | gpu");
+    triple("total", s.gpuTotal);
+    for (size_t k = 0; k < kGpuStageCount; k++) triple(gpuStageName((GpuStage)k), s.gpu[k]);
+}
+
+size_t flattenFrameStats(const FrameStats& s, float* out, size_t capacity) {
+    float v[kFrameStatsValues];
+    size_t n = 0;
+    v[n++] = (float)s.frames;
+    v[n++] = (float)s.totalFrames;
+    v[n++] = (float)s.droppedFrames;
+    v[n++] = (float)s.lostRecords;
+    v[n++] = s.displayPeriodMs;
+    auto triple = [&](const FramePercentiles& p) {
+        v[n++] = p.p50;
+        v[n++] = p.p95;
+        v[n++] = p.p99;
+    };
+    triple(s.interval);
+    triple(s.cpuTotal);
+    for (const FramePercentiles& p : s.cpu) triple(p);
+    triple(s.gpuTotal);
+    for (const FramePercentiles& p : s.gpu) triple(p);
+    n = std::min(n, capacity);
+    std::copy(v, v + n, out);
+    return n;
+}
+
+FrameProfiler::FrameProfiler(size_t ringCapacity) : ring_(ringCapacity) {}
+
+bool FrameProfiler::push(const FrameRecord& record) {
+    FrameRecord copy = record;
+    if (ring_.tryPush(std::move(copy))) return true;
+    lost_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void FrameProfiler::noteVsync(int64_t frameTimeNanos) {
+    if (lastVsync_) {
+        const float ms = (float)(frameTimeNanos - lastVsync_) * 1e-6f;
+        // Ignore stalls and duplicate ticks.
+        if (ms > 2.f && ms < 100.f && (shortestVsyncMs_ == 0.f || ms < shortestVsyncMs_)) shortestVsyncMs_ = ms;
+    }
+    lastVsync_ = frameTimeNanos;
+}
+
+void FrameProfiler::collect() {
+    const size_t window = std::max<uint32_t>(1, options.window);
+    if (window_.size() > window) {
+        window_.clear();
+        windowNext_ = 0;
+    }
+    FrameRecord r;
+    while (ring_.tryPop(r)) {
+        totalFrames_++;
+        if (r.intervalMs > kDroppedFactor * options.displayPeriodMs) droppedFrames_++;
+        if (window_.size() < window) {
+            window_.push_back(r);
+        } else {
+            window_[windowNext_] = r;
+            windowNext_ = (windowNext_ + 1) % window;
+        }
+    }
+
+    if (options.logSeconds <= 0.0) return;
+    const auto now = Clock::now();
+    if (std::chrono::duration<double>(now - lastLog_).count() < options.logSeconds) return;
+    lastLog_ = now;
+    if (shortestVsyncMs_ > 0.f) {
+        options.displayPeriodMs = shortestVsyncMs_;
+        shortestVsyncMs_ = 0.f;
+    }
+    if (window_.empty()) return;
+    char line[1024];
+    formatFrameStats(stats(), line, sizeof(line));
+    LOGI("Frame stats: %s", line);
+}
+
+FrameStats FrameProfiler::stats() {
+    const double logSeconds = options.logSeconds;
+    options.logSeconds = 0.0; // no recursion through the log line
+    collect();
+    options.logSeconds = logSeconds;
+
+    FrameStats s;
+    s.frames = (uint32_t)window_.size();
+    s.totalFrames = totalFrames_;
+    s.droppedFrames = droppedFrames_;
+    s.lostRecords = lost_.load(std::memory_order_relaxed);
+    s.displayPeriodMs = options.displayPeriodMs;
+
+    // One series at a time through the scratch buffer.
+    auto series = [&](auto&& value, bool gpuOnly) {
+        scratch_.clear();
+        for (const FrameRecord& r : window_) {
+            if (gpuOnly && !r.gpuValid) continue;
+            scratch_.push_back(value(r));
+        }
+        return percentiles(scratch_);
+    };
+    scratch_.clear();
+    for (const FrameRecord& r : window_) {
+        if (r.intervalMs > 0.f) scratch_.push_back(r.intervalMs);
+    }
+    s.interval = percentiles(scratch_);
+    for (size_t k = 0; k < kCpuStageCount; k++) {
+        s.cpu[k] = series([k](const FrameRecord& r) { return r.cpuMs[k]; }, false);
+    }
+    s.cpuTotal = series([](const FrameRecord& r) {
+        float sum = 0.f;
+        for (float ms : r.cpuMs) sum += ms;
+        return sum;
+    }, false);
+    for (size_t k = 0; k < kGpuStageCount; k++) {
+        s.gpu[k] = series([k](const FrameRecord& r) { return r.gpuMs[k]; }, true);
+    }
+    s.gpuTotal = series([](const FrameRecord& r) { return r.gpuTotalMs; }, true);
+    return s;
+}
+
+void FrameProfiler::reset() {
+    collect();
+    window_.clear();
+    windowNext_ = 0;
+    totalFrames_ = 0;
+    droppedFrames_ = 0;
+    lost_.store(0, std::memory_order_relaxed);
+}
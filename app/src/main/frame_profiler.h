@@ -0,0 +1,134 @@
+#pragma once
+
+#include "spsc_queue.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Per-frame timing records and their percentiles.
+//
+// The render thread (producer) measures each frame: CPU time spent in the
+// fence wait, acquire, record, submit and present calls, plus GPU stage
+// times from timestamp queries once the frame's fence has signaled. The
+// finished record goes into a lock-free SPSC ring.
+//
+// One other thread (consumer, the UI thread on Android) drains the ring
+// into a sliding window with collect(), which also logs a summary line
+// every Options::logSeconds, and turns the window into p50/p95/p99 stats
+// on demand. Sorting happens there, never on the render thread.
+//
+// Profiling is off by default; while off the renderer skips every timer and
+// query, so the cost is one relaxed atomic load per frame.
+
+enum class CpuStage : uint32_t {
+    FenceWait, // until the frame slot's previous submission completed
+    Acquire,
+    Record,
+    Submit,
+    Present,
+    Count,
+};
+
+enum class GpuStage : uint32_t {
+    Upload,     // streamed buffer copies
+    Image,      // clear or copy of the CPU image
+    RenderPass,
+    Readback,   // headless only
+    Count,
+};
+
+constexpr size_t kCpuStageCount = (size_t)CpuStage::Count;
+constexpr size_t kGpuStageCount = (size_t)GpuStage::Count;
+
+const char* cpuStageName(CpuStage stage);
+const char* gpuStageName(GpuStage stage);
+
+struct FrameRecord {
+    uint64_t frame = 0;
+    float intervalMs = 0.f; // since the previous frame started; 0 if unknown
+    float cpuMs[kCpuStageCount] = {};
+    float gpuMs[kGpuStageCount] = {};
+    float gpuTotalMs = 0.f;
+    bool gpuValid = false;  // false without timestamp support
+};
+
+struct FramePercentiles {
+    float p50 = 0.f;
+    float p95 = 0.f;
+    float p99 = 0.f;
+};
+
+struct FrameStats {
+    uint32_t frames = 0;        // records in the window
+    uint64_t totalFrames = 0;   // since reset()
+    uint64_t droppedFrames = 0; // intervals over 1.5x the display period
+    uint64_t lostRecords = 0;   // pushed while the ring was full
+    float displayPeriodMs = 0.f;
+    FramePercentiles interval;
+    FramePercentiles cpu[kCpuStageCount];
+    FramePercentiles cpuTotal;
+    FramePercentiles gpu[kGpuStageCount];
+    FramePercentiles gpuTotal;
+};
+
+// One line, as logged by collect().
+void formatFrameStats(const FrameStats& stats, char* out, size_t size);
+
+// Flat layout for the JNI query: frames, totalFrames, droppedFrames,
+// lostRecords, displayPeriodMs, then p50, p95, p99 of the interval, the CPU
+// total, each CpuStage, the GPU total and each GpuStage. Returns the count
+// written, at most kFrameStatsValues.
+constexpr size_t kFrameStatsValues = 5 + 3 * (1 + 1 + kCpuStageCount + 1 + kGpuStageCount);
+size_t flattenFrameStats(const FrameStats& stats, float* out, size_t capacity);
+
+class FrameProfiler {
+public:
+    struct Options {
+        uint32_t window = 600;                 // frames the percentiles cover
+        float displayPeriodMs = 1000.f / 60.f; // until noteVsync() measures it
+        double logSeconds = 5.0;               // 0 disables the log line
+    };
+
+    explicit FrameProfiler(size_t ringCapacity = 256);
+
+    // Consumer side.
+    Options options;
+
+    // Either thread.
+    void setEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    // Producer. Returns false, counting the record as lost, when the ring
+    // is full.
+    bool push(const FrameRecord& record);
+
+    // Consumer. A display vsync timestamp; the shortest interval seen over a
+    // log period becomes the display period used to count dropped frames.
+    void noteVsync(int64_t frameTimeNanos);
+    // Consumer. Moves finished records into the window.
+    void collect();
+    // Consumer. collect(), then percentiles over the window.
+    FrameStats stats();
+    // Consumer. Clears the window and the counters.
+    void reset();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    SpscQueue<FrameRecord> ring_;
+    std::atomic<bool> enabled_{ false };
+    std::atomic<uint64_t> lost_{ 0 };
+
+    // Consumer state.
+    std::vector<FrameRecord> window_;
+    size_t windowNext_ = 0;
+    uint64_t totalFrames_ = 0;
+    uint64_t droppedFrames_ = 0;
+    int64_t lastVsync_ = 0;
+    float shortestVsyncMs_ = 0.f; // this log period; 0 when none seen
+    Clock::time_point lastLog_ = Clock::now();
+    std::vector<float> scratch_;
+};
@@ -0,0 +1,261 @@
+#include "gpu_allocator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+static uint64_t alignUp(uint64_t v, uint64_t alignment) {
+    return (v + alignment - 1) & ~(alignment - 1);
+}
+
+} // namespace
+
+bool HostMemoryBackend::allocate(uint32_t /*memoryType*/, uint64_t size, uint64_t* handle, void** mapped) {
+    void* p = std::malloc((size_t)size);
+    if (!p) return false;
+    *handle = (uint64_t)(uintptr_t)p;
+    *mapped = p;
+    live_++;
+    total_++;
+    return true;
+}
+
+void HostMemoryBackend::release(uint64_t handle) {
+    std::free((void*)(uintptr_t)handle);
+    live_--;
+}
+
+GpuAllocator::~GpuAllocator() {
+    for (uint32_t i = 0; i < (uint32_t)blocks_.size(); i++) {
+        if (blocks_[i].memory) releaseBlock(i);
+    }
+}
+
+uint32_t GpuAllocator::newBlock(uint32_t memoryType, uint64_t size, Pool pool, bool dedicated) {
+    uint64_t memory = 0;
+    void* mapped = nullptr;
+    if (!backend_.allocate(memoryType, size, &memory, &mapped)) return UINT32_MAX;
+
+    uint32_t index = 0;
+    while (index < blocks_.size() && blocks_[index].memory) index++;
+    if (index == blocks_.size()) blocks_.emplace_back();
+
+    Block& b = blocks_[index];
+    b.memory = memory;
+    b.mapped = mapped;
+    b.size = size;
+    b.memoryType = memoryType;
+    b.pool = pool;
+    b.dedicated = dedicated;
+    if (pool == Pool::FreeList && !dedicated) b.freeRanges.emplace(0, size);
+    return index;
+}
+
+void GpuAllocator::releaseBlock(uint32_t index) {
+    backend_.release(blocks_[index].memory);
+    blocks_[index] = Block{};
+}
+
+void GpuAllocator::fill(uint32_t index, uint64_t offset, uint64_t size, GpuAllocation& out) {
+    Block& b = blocks_[index];
+    out.memory = b.memory;
+    out.offset = offset;
+    out.size = size;
+    out.mapped = b.mapped ? static_cast<uint8_t*>(b.mapped) + offset : nullptr;
+    out.memoryType = b.memoryType;
+    out.block = index;
+    b.live++;
+}
+
+bool GpuAllocator::allocateFromBlock(uint32_t index, uint64_t size, uint64_t alignment, GpuAllocation& out) {
+    Block& b = blocks_[index];
+    if (b.pool == Pool::Linear) {
+        const uint64_t start = alignUp(b.head, alignment);
+        if (start + size > b.size) return false;
+        b.used += start + size - b.head;
+        b.head = start + size;
+        fill(index, start, size, out);
+        return true;
+    }
+
+    // First fit. Alignment padding in front stays a free range of its own.
+    for (auto it = b.freeRanges.begin(); it != b.freeRanges.end(); ++it) {
+        const uint64_t offset = it->first, end = it->first + it->second;
+        const uint64_t start = alignUp(offset, alignment);
+        if (start + size > end) continue;
+        b.freeRanges.erase(it);
+        if (start > offset) b.freeRanges.emplace(offset, start - offset);
+        if (start + size < end) b.freeRanges.emplace(start + size, end - start - size);
+        b.used += size;
+        fill(index, start, size, out);
+        return true;
+    }
+    return false;
+}
+
+bool GpuAllocator::allocate(uint32_t memoryType, uint64_t size, uint64_t alignment, GpuAllocation& out, Pool pool) {
+    out = GpuAllocation{};
+    if (size == 0 || alignment == 0 || (alignment & (alignment - 1))) return false;
+
+    if (size >= options_.dedicatedThreshold) {
+        const uint32_t index = newBlock(memoryType, size, Pool::FreeList, true);
+        if (index == UINT32_MAX) return false;
+        blocks_[index].used = size;
+        fill(index, 0, size, out);
+        return true;
+    }
+
+    for (uint32_t i = 0; i < (uint32_t)blocks_.size(); i++) {
+        const Block& b = blocks_[i];
+        if (!b.memory || b.dedicated || b.memoryType != memoryType || b.pool != pool) continue;
+        if (allocateFromBlock(i, size, alignment, out)) return true;
+    }
+
+    const uint32_t index = newBlock(memoryType, std::max(options_.blockSize, size + alignment), pool, false);
+    if (index == UINT32_MAX) return false;
+    return allocateFromBlock(index, size, alignment, out);
+}
+
+void GpuAllocator::free(GpuAllocation& allocation) {
+    if (!allocation || allocation.block >= blocks_.size()) return;
+    const uint32_t index = allocation.block;
+    const uint64_t offset = allocation.offset, size = allocation.size;
+    allocation = GpuAllocation{};
+
+    Block& b = blocks_[index];
+    if (!b.memory || b.live == 0) return; // already rewound by resetLinear()
+    b.live--;
+
+    if (b.dedicated) {
+        releaseBlock(index);
+        return;
+    }
+    if (b.pool == Pool::Linear) {
+        if (b.live == 0) b.head = b.used = 0;
+        return;
+    }
+
+    // Reinsert and merge with the neighbouring free ranges.
+    b.used -= size;
+    auto it = b.freeRanges.emplace(offset, size).first;
+    auto next = std::next(it);
+    if (next != b.freeRanges.end() && it->first + it->second == next->first) {
+        it->second += next->second;
+        b.freeRanges.erase(next);
+    }
+    if (it != b.freeRanges.begin()) {
+        auto prev = std::prev(it);
+        if (prev->first + prev->second == it->first) {
+            prev->second += it->second;
+            b.freeRanges.erase(it);
+        }
+    }
+
+    // Give an empty block back unless it is the last one of its type.
+    if (b.live == 0) {
+        for (uint32_t i = 0; i < (uint32_t)blocks_.size(); i++) {
+            const Block& o = blocks_[i];
+            if (i != index && o.memory && !o.dedicated && o.pool == Pool::FreeList && o.memoryType == b.memoryType) {
+                releaseBlock(index);
+                break;
+            }
+        }
+    }
+}
+
+void GpuAllocator::resetLinear(uint32_t memoryType) {
+    for (Block& b : blocks_) {
+        if (b.memory && b.pool == Pool::Linear && b.memoryType == memoryType) b.head = b.used = b.live = 0;
+    }
+}
+
+GpuAllocator::Stats GpuAllocator::stats() const {
+    Stats s;
+    for (const Block& b : blocks_) {
+        if (!b.memory) continue;
+        s.blocks++;
+        if (b.dedicated) s.dedicatedBlocks++;
+        s.blockBytes += b.size;
+        s.usedBytes += b.used;
+        s.allocations += b.live;
+        for (const auto& r : b.freeRanges) {
+            s.freeBytes += r.second;
+            s.largestFree = std::max(s.largestFree, r.second);
+        }
+    }
+    s.fragmentation = s.freeBytes ? 1.f - (float)((double)s.largestFree / (double)s.freeBytes) : 0.f;
+    return s;
+}
+
+void StagingRing::init(void* mapped, uint64_t capacity) {
+    base_ = static_cast<uint8_t*>(mapped);
+    capacity_ = capacity;
+    reset();
+    stats_ = Stats{};
+    stats_.capacity = capacity;
+}
+
+void StagingRing::reset() {
+    head_ = tail_ = submitted_ = 0;
+    pending_.clear();
+    stats_.inFlight = 0;
+}
+
+bool StagingRing::allocate(uint64_t size, uint64_t alignment, Region& out) {
+    if (size == 0 || size > capacity_) return false;
+
+    uint64_t pos = head_;
+    const uint64_t offset = pos % capacity_;
+    uint64_t start = alignUp(offset, alignment);
+    if (start + size > capacity_) {
+        // Skip the tail end of the ring; it is reclaimed with this region.
+        pos += capacity_ - offset;
+        start = 0;
+    } else {
+        pos += start - offset;
+    }
+    if (pos + size - tail_ > capacity_) {
+        stats_.full++;
+        return false;
+    }
+
+    head_ = pos + size;
+    stats_.inFlight = head_ - tail_;
+    out.offset = start;
+    out.size = size;
+    out.ptr = base_ + start;
+    return true;
+}
+
+bool StagingRing::upload(const void* data, uint64_t size, uint64_t alignment, Region& out) {
+    if (!allocate(size, alignment, out)) return false;
+    auto t0 = Clock::now();
+    std::memcpy(out.ptr, data, (size_t)size);
+    stats_.copyMs += msSince(t0);
+    stats_.bytesUploaded += size;
+    stats_.uploads++;
+    return true;
+}
+
+void StagingRing::submit(uint64_t fenceValue) {
+    if (head_ == submitted_) return;
+    pending_.push_back({ head_, fenceValue });
+    submitted_ = head_;
+}
+
+void StagingRing::retire(uint64_t completedValue) {
+    size_t done = 0;
+    while (done < pending_.size() && pending_[done].fence <= completedValue) tail_ = pending_[done++].end;
+    pending_.erase(pending_.begin(), pending_.begin() + (ptrdiff_t)done);
+    stats_.inFlight = head_ - tail_;
+}
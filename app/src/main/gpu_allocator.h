@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+// Device memory sub-allocation, independent of the graphics API.
+//
+// GpuAllocator carves buffers out of large blocks obtained from a
+// MemoryBackend, one set of blocks per memory type, instead of making one
+// driver allocation per buffer (drivers cap the allocation count, often at
+// 4096). Blocks come in two flavours:
+//   - free-list blocks: first-fit over an offset-ordered free map, freed
+//     ranges coalesce with their neighbours;
+//   - linear blocks: bump allocation for data with a shared lifetime, such
+//     as per-scene or per-frame buffers, released all at once.
+// Requests above Options::dedicatedThreshold get a block of their own.
+//
+// The backend is an interface so the bookkeeping can be exercised on the
+// CPU with HostMemoryBackend; the Vulkan one lives in vk_memory.h.
+class MemoryBackend {
+public:
+    virtual ~MemoryBackend() = default;
+
+    // Allocates `size` bytes of `memoryType`. `handle` identifies the memory
+    // to the backend (a VkDeviceMemory for Vulkan); `mapped` is set to a
+    // persistent host pointer for host-visible types, null otherwise.
+    virtual bool allocate(uint32_t memoryType, uint64_t size, uint64_t* handle, void** mapped) = 0;
+    virtual void release(uint64_t handle) = 0;
+};
+
+// Backend on plain host memory; every type is "mapped".
+class HostMemoryBackend : public MemoryBackend {
+public:
+    bool allocate(uint32_t memoryType, uint64_t size, uint64_t* handle, void** mapped) override;
+    void release(uint64_t handle) override;
+
+    uint32_t liveAllocations() const { return live_; }
+    uint32_t totalAllocations() const { return total_; }
+
+private:
+    uint32_t live_ = 0;
+    uint32_t total_ = 0;
+};
+
+struct GpuAllocation {
+    uint64_t memory = 0;    // backend handle of the block
+    uint64_t offset = 0;    // within the block
+    uint64_t size = 0;
+    void* mapped = nullptr; // host pointer at `offset`, if the type is mapped
+    uint32_t memoryType = 0;
+    uint32_t block = UINT32_MAX;
+
+    explicit operator bool() const { return block != UINT32_MAX; }
+};
+
+class GpuAllocator {
+public:
+    enum class Pool : uint8_t {
+        FreeList,
+        Linear,
+    };
+
+    struct Options {
+        uint64_t blockSize = 64ull << 20;
+        uint64_t dedicatedThreshold = 32ull << 20;
+    };
+
+    struct Stats {
+        uint64_t blockBytes = 0;    // obtained from the backend
+        uint64_t usedBytes = 0;     // handed out (linear blocks count padding too)
+        uint32_t blocks = 0;
+        uint32_t dedicatedBlocks = 0;
+        uint32_t allocations = 0;
+        uint64_t freeBytes = 0;     // free-list blocks only
+        uint64_t largestFree = 0;
+        // 1 - largestFree / freeBytes: 0 when all free space is one range.
+        float fragmentation = 0.f;
+    };
+
+    explicit GpuAllocator(MemoryBackend& backend) : backend_(backend) {}
+    GpuAllocator(MemoryBackend& backend, const Options& options) : backend_(backend), options_(options) {}
+    ~GpuAllocator();
+
+    GpuAllocator(const GpuAllocator&) = delete;
+    GpuAllocator& operator=(const GpuAllocator&) = delete;
+
+    // `alignment` must be a power of two.
+    bool allocate(uint32_t memoryType, uint64_t size, uint64_t alignment, GpuAllocation& out,
+                  Pool pool = Pool::FreeList);
+    // Returns the range; resets `allocation`. Linear blocks are rewound
+    // once their last allocation is freed.
+    void free(GpuAllocation& allocation);
+    // Rewinds every linear block of `memoryType`. Allocations made from them
+    // must no longer be used (and need not be freed).
+    void resetLinear(uint32_t memoryType);
+
+    Stats stats() const;
+
+private:
+    struct Block {
+        uint64_t memory = 0; // 0: unused slot
+        void* mapped = nullptr;
+        uint64_t size = 0;
+        uint64_t used = 0;
+        uint32_t memoryType = 0;
+        uint32_t live = 0;   // allocations not yet freed
+        Pool pool = Pool::FreeList;
+        bool dedicated = false;
+        std::map<uint64_t, uint64_t> freeRanges; // offset -> size, free-list only
+        uint64_t head = 0;                       // linear only
+    };
+
+    uint32_t newBlock(uint32_t memoryType, uint64_t size, Pool pool, bool dedicated);
+    void releaseBlock(uint32_t index);
+    bool allocateFromBlock(uint32_t index, uint64_t size, uint64_t alignment, GpuAllocation& out);
+    void fill(uint32_t index, uint64_t offset, uint64_t size, GpuAllocation& out);
+
+    MemoryBackend& backend_;
+    Options options_;
+    std::vector<Block> blocks_;
+};
+
+// Persistently mapped ring for streaming uploads.
+//
+// Space is handed out in order; each submit() closes the regions written
+// since the previous one under a fence value (e.g. a frame serial), and
+// retire() reclaims everything up to the last completed value. A region
+// never wraps around the end of the ring. The ring does not own memory:
+// init() takes a mapped range, e.g. from a GpuAllocator host-visible block.
+class StagingRing {
+public:
+    struct Region {
+        uint64_t offset = 0; // from the start of the ring
+        uint64_t size = 0;
+        void* ptr = nullptr;
+    };
+
+    struct Stats {
+        uint64_t capacity = 0;
+        uint64_t inFlight = 0;      // allocated and not yet retired
+        uint64_t bytesUploaded = 0; // through upload()
+        uint32_t uploads = 0;
+        uint32_t full = 0;          // allocations refused for lack of space
+        double copyMs = 0.0;        // time spent copying in upload()
+
+        double copyMBps() const { return copyMs > 0.0 ? (double)bytesUploaded / (copyMs * 1e3) : 0.0; }
+    };
+
+    void init(void* mapped, uint64_t capacity);
+    void reset();
+
+    // `alignment` must be a power of two. Fails when the space would have
+    // to come from regions still in flight.
+    bool allocate(uint64_t size, uint64_t alignment, Region& out);
+    // allocate() plus a copy of `data`.
+    bool upload(const void* data, uint64_t size, uint64_t alignment, Region& out);
+
+    void submit(uint64_t fenceValue);
+    void retire(uint64_t completedValue);
+
+    uint64_t capacity() const { return capacity_; }
+    uint64_t available() const { return capacity_ - (head_ - tail_); }
+    const Stats& stats() const { return stats_; }
+
+private:
+    struct Pending {
+        uint64_t end;   // head_ when submitted
+        uint64_t fence;
+    };
+
+    uint8_t* base_ = nullptr;
+    uint64_t capacity_ = 0;
+    uint64_t head_ = 0; // monotonic write position
+    uint64_t tail_ = 0; // monotonic start of the oldest in-flight region
+    uint64_t submitted_ = 0;
+    // Oldest first. A vector rather than a deque, so steady submit/retire
+    // cycles reuse its storage instead of allocating.
+    std::vector<Pending> pending_;
+    Stats stats_;
+};
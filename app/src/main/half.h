@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// IEEE 754 binary16 conversions (round to nearest even, denormals kept).
+
+inline uint16_t floatToHalf(float f) {
+    uint32_t x;
+    std::memcpy(&x, &f, sizeof(x));
+
+    uint32_t sign = (x >> 16) & 0x8000u;
+    uint32_t absx = x & 0x7FFFFFFFu;
+
+    if (absx >= 0x7F800000u) {
+        // Inf / NaN (keep NaN quiet)
+        return (uint16_t)(sign | 0x7C00u | (absx > 0x7F800000u ? 0x0200u : 0u));
+    }
+    if (absx >= 0x477FF000u) {
+        // Rounds past the largest half -> inf
+        return (uint16_t)(sign | 0x7C00u);
+    }
+    if (absx < 0x38800000u) {
+        // Subnormal half (or zero)
+        if (absx < 0x33000000u) return (uint16_t)sign;
+        uint32_t mant = (absx & 0x007FFFFFu) | 0x00800000u;
+        uint32_t shift = 126u - (absx >> 23); // 14..24
+        uint32_t half = mant >> shift;
+        uint32_t rem = mant & ((1u << shift) - 1u);
+        uint32_t mid = 1u << (shift - 1u);
+        if (rem > mid || (rem == mid && (half & 1u))) half++;
+        return (uint16_t)(sign | half);
+    }
+
+    uint32_t h = ((absx - 0x38000000u) >> 13);
+    uint32_t rem = absx & 0x1FFFu;
+    if (rem > 0x1000u || (rem == 0x1000u && (h & 1u))) h++;
+    return (uint16_t)(sign | h);
+}
+
+inline float halfToFloat(uint16_t h) {
+    // Shift exponent and mantissa into place and rebias; subnormals are
+    // renormalized with one float subtraction instead of a loop.
+    const uint32_t shiftedExp = 0x7C00u << 13;
+    uint32_t o = (uint32_t)(h & 0x7FFFu) << 13;
+    uint32_t exp = o & shiftedExp;
+    o += (127u - 15u) << 23;
+
+    float f;
+    if (exp == shiftedExp) {
+        o += (128u - 16u) << 23; // Inf / NaN
+        std::memcpy(&f, &o, sizeof(f));
+    } else if (exp == 0) {
+        o += 1u << 23;
+        std::memcpy(&f, &o, sizeof(f));
+        f -= 6.103515625e-05f; // 2^-14
+    } else {
+        std::memcpy(&f, &o, sizeof(f));
+    }
+
+    uint32_t x;
+    std::memcpy(&x, &f, sizeof(x));
+    x |= (uint32_t)(h & 0x8000u) << 16;
+    std::memcpy(&f, &x, sizeof(f));
+    return f;
+}
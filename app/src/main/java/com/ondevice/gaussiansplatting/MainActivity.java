@@ -15,12 +15,16 @@ public class MainActivity extends Activity {
 
     private SurfaceView surfaceView;
     private boolean surfaceReady = false;
+    // Debug: `adb shell am start -n <activity> --ei resize_storm N` runs a
+    // swapchain resize benchmark once the surface is up (results in logcat).
+    private int resizeStorm = 0;
 
+    // Rendering happens on a native thread; vsync ticks only pace it.
     private final Choreographer.FrameCallback frameCallback = new Choreographer.FrameCallback() {
         @Override
         public void doFrame(long frameTimeNanos) {
             if (surfaceReady) {
-                nativeRender();
+                nativeOnVsync(frameTimeNanos);
             }
             Choreographer.getInstance().postFrameCallback(this);
         }
@@ -29,6 +33,23 @@ public class MainActivity extends Activity {
     @Override
     protected void onCreate(Bundle savedInstanceState) {
         super.onCreate(savedInstanceState);
+        nativeSetCacheDir(getCacheDir().getAbsolutePath());
+        resizeStorm = getIntent().getIntExtra("resize_storm", 0);
+        // Debug: `--ez profile true` turns on frame profiling; percentiles are
+        // logged every few seconds and returned by nativeGetFrameStats().
+        if (getIntent().getBooleanExtra("profile", false)) {
+            nativeSetProfilingEnabled(true);
+        }
+        // Debug: `--ei trace_frames N` writes a Chrome trace of N frames, or with
+        // 0 of the scene load, to <cache>/trace.json (GS_ENABLE_TRACING builds).
+        int traceFrames = getIntent().getIntExtra("trace_frames", -1);
+        if (traceFrames >= 0) {
+            nativeCaptureTrace(getCacheDir().getAbsolutePath() + "/trace.json", traceFrames);
+        }
+        String scene = getIntent().getStringExtra("scene");
+        if (scene != null) {
+            nativeLoadScene(scene);
+        }
 
         surfaceView = new SurfaceView(this);
         setContentView(surfaceView);
@@ -44,6 +65,10 @@ public class MainActivity extends Activity {
             @Override
             public void surfaceChanged(SurfaceHolder holder, int format, int width, int height) {
                 nativeOnSurfaceChanged(width, height);
+                if (resizeStorm > 0) {
+                    nativeRunResizeStorm(resizeStorm);
+                    resizeStorm = 0;
+                }
             }
 
             @Override
@@ -66,8 +91,19 @@ public class MainActivity extends Activity {
         super.onPause();
     }
 
+    public native void nativeSetCacheDir(String dir);
     public native void nativeOnSurfaceCreated(Surface surface);
     public native void nativeOnSurfaceChanged(int width, int height);
     public native void nativeOnSurfaceDestroyed();
-    public native void nativeRender();
+    public native void nativeOnVsync(long frameTimeNanos);
+    public native void nativeLoadScene(String path);
+    public native void nativeSetCamera(float[] eyeTargetUp, float fovY);
+    public native void nativeRunResizeStorm(int iterations);
+    public native void nativeCaptureTrace(String path, int frames);
+    public native void nativeSetProfilingEnabled(boolean enabled);
+    // frames, total, dropped, lost, display period ms, then p50/p95/p99 ms of
+    // the frame interval, CPU total, CPU stages (fence, acquire, record,
+    // submit, present), GPU total and GPU stages (upload, image, pass,
+    // readback). Call on the UI thread.
+    public native float[] nativeGetFrameStats();
 }
\ No newline at end of file
@@ -0,0 +1,16 @@
+#pragma once
+
+// Logging for the native code: logcat on Android, stdout/stderr elsewhere.
+
+#if defined(__ANDROID__)
+#include <android/log.h>
+
+#define LOG_TAG "GaussianSplat"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#include <cstdio>
+
+#define LOGI(...) (std::fprintf(stdout, __VA_ARGS__), std::fputc('\n', stdout))
+#define LOGE(...) (std::fprintf(stderr, __VA_ARGS__), std::fputc('\n', stderr))
+#endif
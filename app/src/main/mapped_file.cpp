@@ -0,0 +1,86 @@
+#include "mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <utility>
+
+namespace {
+
+static size_t pageSize() {
+    static const size_t kPage = (size_t)sysconf(_SC_PAGESIZE);
+    return kPage;
+}
+
+// madvise wants page aligned ranges; shrink [offset, offset + length) inwards.
+static bool alignedRange(size_t total, size_t offset, size_t length, size_t& begin, size_t& end) {
+    if (offset >= total) return false;
+    if (length > total - offset) length = total - offset;
+    const size_t page = pageSize();
+    begin = offset & ~(page - 1);
+    end = (offset + length) & ~(page - 1);
+    return end > begin;
+}
+
+} // namespace
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+    }
+    return *this;
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference to the file.
+    ::close(fd);
+    if (p == MAP_FAILED) return false;
+
+    data_ = static_cast<const uint8_t*>(p);
+    size_ = (size_t)st.st_size;
+    return true;
+}
+
+void MappedFile::close() {
+    if (!data_) return;
+    munmap(const_cast<uint8_t*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+}
+
+void MappedFile::adviseSequential(size_t offset, size_t length) const {
+    size_t begin = 0, end = 0;
+    if (!data_ || !alignedRange(size_, offset, length, begin, end)) return;
+    madvise(const_cast<uint8_t*>(data_) + begin, end - begin, MADV_SEQUENTIAL);
+    madvise(const_cast<uint8_t*>(data_) + begin, end - begin, MADV_WILLNEED);
+}
+
+void MappedFile::release(size_t offset, size_t length) const {
+    size_t begin = 0, end = 0;
+    if (!data_ || !alignedRange(size_, offset, length, begin, end)) return;
+    madvise(const_cast<uint8_t*>(data_) + begin, end - begin, MADV_DONTNEED);
+}
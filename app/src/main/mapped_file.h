@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read-only memory mapping of a whole file.
+// The mapping is released when the object is destroyed.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return data_ != nullptr; }
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+
+    // Hint that [offset, offset + length) will be read front to back.
+    void adviseSequential(size_t offset, size_t length) const;
+    // Drop already consumed pages from the page cache mapping of this process.
+    void release(size_t offset, size_t length) const;
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
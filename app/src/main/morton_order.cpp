@@ -0,0 +1,121 @@
+#include "morton_order.h"
+#include "radix_sort.h"
+#include "thread_pool.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+constexpr size_t kGrain = 1 << 15;
+
+// Quantizes positions to `cells` per axis and fills keys and the identity
+// permutation.
+template <typename Key, typename Encode>
+static void computeKeys(const SplatCloud& cloud, const float lo[3], float scale, uint32_t cells,
+                        Key* keys, uint32_t* order, Encode encode) {
+    const float maxCell = (float)(cells - 1);
+    ThreadPool::shared().parallelFor(cloud.count, kGrain, [&](size_t begin, size_t end) {
+        const float* px = cloud.pos[0].data();
+        const float* py = cloud.pos[1].data();
+        const float* pz = cloud.pos[2].data();
+        for (size_t i = begin; i < end; i++) {
+            uint32_t q[3];
+            const float p[3] = { px[i], py[i], pz[i] };
+            for (int k = 0; k < 3; k++) {
+                // NaN fails the comparison and lands in cell 0.
+                const float c = (p[k] - lo[k]) * scale;
+                q[k] = c > 0.f ? (uint32_t)std::min(c, maxCell) : 0u;
+            }
+            keys[i] = encode(q[0], q[1], q[2]);
+            order[i] = (uint32_t)i;
+        }
+    });
+}
+
+} // namespace
+
+void mortonOrderSplats(SplatCloud& cloud, MortonBits bits, MortonOrderStats* stats) {
+    GS_TRACE_SCOPE("mortonOrderSplats");
+    MortonOrderStats st;
+    auto start = Clock::now();
+    const size_t n = cloud.count;
+    if (n < 2) {
+        if (stats) *stats = st;
+        return;
+    }
+    ThreadPool& pool = ThreadPool::shared();
+
+    // Bounds of the finite positions.
+    auto t0 = Clock::now();
+    float lo[3] = { INFINITY, INFINITY, INFINITY };
+    float hi[3] = { -INFINITY, -INFINITY, -INFINITY };
+    std::mutex boundsMutex;
+    pool.parallelFor(n, kGrain, [&](size_t begin, size_t end) {
+        float l[3] = { INFINITY, INFINITY, INFINITY };
+        float h[3] = { -INFINITY, -INFINITY, -INFINITY };
+        for (int k = 0; k < 3; k++) {
+            const float* p = cloud.pos[k].data();
+            for (size_t i = begin; i < end; i++) {
+                if (!std::isfinite(p[i])) continue;
+                l[k] = std::min(l[k], p[i]);
+                h[k] = std::max(h[k], p[i]);
+            }
+        }
+        std::lock_guard<std::mutex> lock(boundsMutex);
+        for (int k = 0; k < 3; k++) {
+            lo[k] = std::min(lo[k], l[k]);
+            hi[k] = std::max(hi[k], h[k]);
+        }
+    });
+    float extent = 0.f;
+    for (int k = 0; k < 3; k++) {
+        if (!(lo[k] <= hi[k])) lo[k] = hi[k] = 0.f; // no finite positions
+        extent = std::max(extent, hi[k] - lo[k]);
+    }
+    st.boundsMs = msSince(t0);
+
+    // Cubic cells keep the curve's locality the same along every axis.
+    const uint32_t axisBits = (uint32_t)bits;
+    const uint32_t cells = 1u << axisBits;
+    const float scale = extent > 0.f ? (float)cells / extent : 0.f;
+
+    std::vector<uint32_t> order(n), orderTmp(n);
+    if (bits == MortonBits::Bits30) {
+        std::vector<uint32_t> keys(n), keysTmp(n);
+        t0 = Clock::now();
+        computeKeys(cloud, lo, scale, cells, keys.data(), order.data(),
+                    [](uint32_t x, uint32_t y, uint32_t z) { return mortonCode30(x, y, z); });
+        st.codeMs = msSince(t0);
+        t0 = Clock::now();
+        radixSortPairs(keys.data(), order.data(), n, keysTmp.data(), orderTmp.data(), pool, 3 * axisBits);
+        st.sortMs = msSince(t0);
+    } else {
+        std::vector<uint64_t> keys(n), keysTmp(n);
+        t0 = Clock::now();
+        computeKeys(cloud, lo, scale, cells, keys.data(), order.data(),
+                    [](uint32_t x, uint32_t y, uint32_t z) { return mortonCode63(x, y, z); });
+        st.codeMs = msSince(t0);
+        t0 = Clock::now();
+        radixSortPairs(keys.data(), order.data(), n, keysTmp.data(), orderTmp.data(), pool, 3 * axisBits);
+        st.sortMs = msSince(t0);
+    }
+    std::vector<uint32_t>().swap(orderTmp);
+
+    t0 = Clock::now();
+    permuteSplats(cloud, order.data());
+    st.permuteMs = msSince(t0);
+
+    st.totalMs = msSince(start);
+    if (stats) *stats = st;
+}
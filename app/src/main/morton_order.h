@@ -0,0 +1,63 @@
+#pragma once
+
+#include "splat_cloud.h"
+
+#include <cstdint>
+
+// Z-order (Morton) codes and the load-time pass that sorts splats by them.
+//
+// Trained 3DGS files store splats in optimizer order, which is close to
+// random in space. Sorting along a Z-order curve over the scene bounds puts
+// spatial neighbours next to each other in every plane, so anything that
+// walks neighbourhoods (chunk culling, tile binning, LOD merging, GPU
+// fetches) touches far fewer cache lines and pages.
+
+enum class MortonBits : uint32_t {
+    Bits30 = 10, // 10 bits per axis, 32-bit keys: 4 radix passes
+    Bits63 = 21, // 21 bits per axis, 64-bit keys: 8 radix passes
+};
+
+// Spreads the low 10 bits of v so that bit i lands on bit 3i.
+inline uint32_t mortonSpread10(uint32_t v) {
+    v &= 0x3ffu;
+    v = (v | (v << 16)) & 0x030000ffu;
+    v = (v | (v << 8)) & 0x0300f00fu;
+    v = (v | (v << 4)) & 0x030c30c3u;
+    v = (v | (v << 2)) & 0x09249249u;
+    return v;
+}
+
+// Spreads the low 21 bits of v so that bit i lands on bit 3i.
+inline uint64_t mortonSpread21(uint64_t v) {
+    v &= 0x1fffffull;
+    v = (v | (v << 32)) & 0x001f00000000ffffull;
+    v = (v | (v << 16)) & 0x001f0000ff0000ffull;
+    v = (v | (v << 8)) & 0x100f00f00f00f00full;
+    v = (v | (v << 4)) & 0x10c30c30c30c30c3ull;
+    v = (v | (v << 2)) & 0x1249249249249249ull;
+    return v;
+}
+
+// Interleaves quantized coordinates, x in the lowest bit.
+inline uint32_t mortonCode30(uint32_t x, uint32_t y, uint32_t z) {
+    return mortonSpread10(x) | (mortonSpread10(y) << 1) | (mortonSpread10(z) << 2);
+}
+
+inline uint64_t mortonCode63(uint32_t x, uint32_t y, uint32_t z) {
+    return mortonSpread21(x) | (mortonSpread21(y) << 1) | (mortonSpread21(z) << 2);
+}
+
+struct MortonOrderStats {
+    double boundsMs = 0.0;
+    double codeMs = 0.0;
+    double sortMs = 0.0;
+    double permuteMs = 0.0;
+    double totalMs = 0.0;
+};
+
+// Reorders every plane of `cloud` by the Morton code of its position,
+// quantized on a cubic grid over the bounding box. Splats that share a cell
+// keep their relative order; non-finite coordinates are clamped to the
+// grid. Needs 16 (30 bits) or 24 (63 bits) bytes of scratch per splat on
+// top of the single plane permuteSplats() uses.
+void mortonOrderSplats(SplatCloud& cloud, MortonBits bits = MortonBits::Bits30, MortonOrderStats* stats = nullptr);
@@ -0,0 +1,164 @@
+#include "pipeline_cache.h"
+#include "log.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+// VkPipelineCacheHeaderVersionOne as laid out in the cache data.
+constexpr size_t kHeaderSize = 16 + VK_UUID_SIZE;
+
+static uint32_t readU32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// True when validated cache data holds anything after its header.
+static bool hasEntries(const std::vector<uint8_t>& data) {
+    return data.size() > readU32(data.data());
+}
+
+static bool readFile(const std::string& path, std::vector<uint8_t>& out) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) return false;
+    out.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return !in.bad();
+}
+
+} // namespace
+
+bool validatePipelineCacheHeader(const uint8_t* data, size_t size, const VkPhysicalDeviceProperties& props,
+                                 std::string* error) {
+    auto fail = [&](const char* what) {
+        if (error) *error = what;
+        return false;
+    };
+
+    if (size < kHeaderSize) return fail("truncated header");
+    const uint32_t headerSize = readU32(data);
+    if (headerSize < kHeaderSize || headerSize > size) return fail("bad header size");
+    if (readU32(data + 4) != VK_PIPELINE_CACHE_HEADER_VERSION_ONE) return fail("unknown header version");
+    if (readU32(data + 8) != props.vendorID) return fail("vendor ID mismatch");
+    if (readU32(data + 12) != props.deviceID) return fail("device ID mismatch");
+    if (std::memcmp(data + 16, props.pipelineCacheUUID, VK_UUID_SIZE) != 0) return fail("cache UUID mismatch");
+    return true;
+}
+
+bool PipelineCache::create(VkDevice device, VkPhysicalDevice phys, const std::string& path) {
+    destroy();
+    auto t0 = Clock::now();
+    device_ = device;
+    path_ = path;
+    stats_ = Stats{};
+
+    std::vector<uint8_t> data;
+    if (!path_.empty() && readFile(path_, data) && !data.empty()) {
+        VkPhysicalDeviceProperties props{};
+        vkGetPhysicalDeviceProperties(phys, &props);
+        if (!validatePipelineCacheHeader(data.data(), data.size(), props, &stats_.rejected)) {
+            LOGI("Discarding pipeline cache %s: %s", path_.c_str(), stats_.rejected.c_str());
+            data.clear();
+        } else if (!hasEntries(data)) {
+            stats_.rejected = "no pipelines after the header";
+            data.clear();
+        } else {
+            stats_.warm = true;
+            stats_.loadedBytes = data.size();
+        }
+    }
+
+    VkPipelineCacheCreateInfo ci{};
+    ci.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    ci.initialDataSize = data.size();
+    ci.pInitialData = data.empty() ? nullptr : data.data();
+    VkResult r = vkCreatePipelineCache(device_, &ci, nullptr, &cache_);
+    if (r != VK_SUCCESS && !data.empty()) {
+        // Some drivers reject data that passes the header check; start cold.
+        stats_.warm = false;
+        stats_.loadedBytes = 0;
+        stats_.rejected = "rejected by driver";
+        data.clear();
+        ci.initialDataSize = 0;
+        ci.pInitialData = nullptr;
+        r = vkCreatePipelineCache(device_, &ci, nullptr, &cache_);
+    }
+    if (r != VK_SUCCESS) {
+        LOGE("vkCreatePipelineCache failed: %d", (int)r);
+        cache_ = VK_NULL_HANDLE;
+        device_ = VK_NULL_HANDLE;
+        return false;
+    }
+
+    lastData_.swap(data);
+    stats_.loadMs = msSince(t0);
+    LOGI("Pipeline cache %s (%zu bytes, %.2f ms)", stats_.warm ? "warm" : "cold", stats_.loadedBytes, stats_.loadMs);
+    return true;
+}
+
+bool PipelineCache::save(std::string* error) {
+    auto fail = [&](const char* what) {
+        if (error) *error = what;
+        return false;
+    };
+
+    if (!cache_) return fail("no pipeline cache");
+    if (path_.empty()) return true;
+
+    auto t0 = Clock::now();
+    size_t size = 0;
+    if (vkGetPipelineCacheData(device_, cache_, &size, nullptr) != VK_SUCCESS) return fail("vkGetPipelineCacheData failed");
+    std::vector<uint8_t> data(size);
+    if (vkGetPipelineCacheData(device_, cache_, &size, data.data()) != VK_SUCCESS) return fail("vkGetPipelineCacheData failed");
+    data.resize(size);
+    // The same size can hold different pipelines, so compare the bytes. A
+    // header alone would only read back as a cold cache.
+    if (data == lastData_) return true;
+    if (data.size() < kHeaderSize || !hasEntries(data)) return true;
+
+    const std::string tmp = path_ + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) return fail("cannot create file");
+        out.write(reinterpret_cast<const char*>(data.data()), (std::streamsize)data.size());
+        if (!out) return fail("write failed");
+    }
+    if (std::rename(tmp.c_str(), path_.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return fail("rename failed");
+    }
+
+    lastData_.swap(data);
+    stats_.savedBytes = size;
+    stats_.saveMs = msSince(t0);
+    LOGI("Pipeline cache saved (%zu bytes, %.2f ms)", size, stats_.saveMs);
+    return true;
+}
+
+uint32_t PipelineCache::timeCreate(const std::function<uint32_t()>& create) {
+    auto t0 = Clock::now();
+    const uint32_t pipelines = create();
+    const double ms = msSince(t0);
+    stats_.pipelines += pipelines;
+    stats_.createMs += ms;
+    LOGI("Created %u pipelines in %.2f ms (%s cache)", pipelines, ms, stats_.warm ? "warm" : "cold");
+    return pipelines;
+}
+
+void PipelineCache::destroy() {
+    if (cache_) vkDestroyPipelineCache(device_, cache_, nullptr);
+    cache_ = VK_NULL_HANDLE;
+    device_ = VK_NULL_HANDLE;
+    lastData_.clear();
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// VkPipelineCache persisted to a file between runs.
+//
+// create() reads the file and checks the VkPipelineCacheHeaderVersionOne
+// header against the current physical device (vendor ID, device ID and
+// pipelineCacheUUID, which changes with driver updates). Data that fails
+// the check is discarded and an empty cache is created instead, so a stale
+// file only costs a cold start, and so does a file holding nothing past the
+// header. save() writes through a temporary file and a rename, so an
+// interrupted write never leaves a truncated cache behind.
+class PipelineCache {
+public:
+    struct Stats {
+        bool warm = false;       // loaded data passed validation and holds pipelines
+        size_t loadedBytes = 0;
+        size_t savedBytes = 0;
+        double loadMs = 0.0;
+        double saveMs = 0.0;
+        uint32_t pipelines = 0;  // created through timeCreate()
+        double createMs = 0.0;
+        std::string rejected;    // why the file was discarded, if it was
+    };
+
+    PipelineCache() = default;
+    ~PipelineCache() { destroy(); }
+
+    PipelineCache(const PipelineCache&) = delete;
+    PipelineCache& operator=(const PipelineCache&) = delete;
+
+    // Creates the cache, seeded from `path` when it holds valid data for
+    // this device. An empty path gives an in-memory cache that is never
+    // saved. Only fails if vkCreatePipelineCache does.
+    bool create(VkDevice device, VkPhysicalDevice phys, const std::string& path);
+    // Writes the cache to the path given to create(). Skipped when the
+    // data is what was last loaded or saved, or holds only the header.
+    bool save(std::string* error = nullptr);
+    void destroy();
+
+    // Runs `create`, which builds pipelines against handle() and returns
+    // how many, and adds its time to the stats. Logged with the warm/cold
+    // state, so the cost of a cold start shows next to a warm one.
+    uint32_t timeCreate(const std::function<uint32_t()>& create);
+
+    VkPipelineCache handle() const { return cache_; }
+    const Stats& stats() const { return stats_; }
+
+private:
+    VkDevice device_ = VK_NULL_HANDLE;
+    VkPipelineCache cache_ = VK_NULL_HANDLE;
+    std::string path_;
+    std::vector<uint8_t> lastData_; // as last loaded or saved
+    Stats stats_;
+};
+
+// Returns true when `data` starts with a pipeline cache header written for
+// the device described by `props`; otherwise fills `error`.
+bool validatePipelineCacheHeader(const uint8_t* data, size_t size, const VkPhysicalDeviceProperties& props,
+                                 std::string* error = nullptr);
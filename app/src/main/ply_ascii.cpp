@@ -0,0 +1,137 @@
+#include "ply_ascii.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// Chunks smaller than this are not worth a task.
+constexpr size_t kMinChunkBytes = 1 << 20;
+
+// Longer tokens are not numbers a PLY exporter writes.
+constexpr size_t kMaxTokenChars = 63;
+
+struct Chunk {
+    const char* begin = nullptr;
+    const char* end = nullptr;
+    size_t lines = 0;
+    size_t firstRow = 0;
+    bool ok = true;
+    size_t badRow = 0;
+};
+
+static inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static size_t countLines(const char* begin, const char* end) {
+    size_t n = 0;
+    const char* p = begin;
+    while (p < end) {
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', (size_t)(end - p)));
+        if (!nl) {
+            n++; // last line without terminator
+            break;
+        }
+        n++;
+        p = nl + 1;
+    }
+    return n;
+}
+
+} // namespace
+
+bool parsePlyAsciiRow(const char* begin, const char* end, float* values, size_t count) {
+    const char* p = begin;
+    for (size_t i = 0; i < count; i++) {
+        while (p < end && isBlank(*p)) p++;
+        const char* tokenEnd = p;
+        while (tokenEnd < end && !isBlank(*tokenEnd)) tokenEnd++;
+        const size_t len = (size_t)(tokenEnd - p);
+        if (len == 0 || len > kMaxTokenChars) return false;
+
+        // strtof needs a terminator, which the mapped body does not have.
+        char token[kMaxTokenChars + 1];
+        std::memcpy(token, p, len);
+        token[len] = '\0';
+        char* parsed = nullptr;
+        values[i] = std::strtof(token, &parsed);
+        if (parsed != token + len) return false;
+        p = tokenEnd;
+    }
+    return true;
+}
+
+bool parsePlyAsciiBody(const char* begin, const char* end, size_t rows, size_t props,
+                       PlyAsciiRowFn emit, ThreadPool& pool, std::string* error) {
+    if (rows == 0) return true;
+
+    const size_t bytes = (size_t)(end - begin);
+    size_t chunkCount = std::max<size_t>(1, std::min<size_t>(pool.concurrency() * 4, bytes / kMinChunkBytes));
+
+    // Newline aligned split points.
+    std::vector<Chunk> chunks;
+    chunks.reserve(chunkCount);
+    const char* cur = begin;
+    for (size_t c = 0; c < chunkCount && cur < end; c++) {
+        const char* split = c + 1 == chunkCount ? end : begin + bytes * (c + 1) / chunkCount;
+        if (split < cur) split = cur;
+        if (split < end) {
+            const char* nl = static_cast<const char*>(std::memchr(split, '\n', (size_t)(end - split)));
+            split = nl ? nl + 1 : end;
+        }
+        Chunk ch;
+        ch.begin = cur;
+        ch.end = split;
+        chunks.push_back(ch);
+        cur = split;
+    }
+
+    pool.run(chunks.size(), [&](size_t c) {
+        GS_TRACE_SCOPE("countLines");
+        chunks[c].lines = countLines(chunks[c].begin, chunks[c].end);
+    });
+
+    size_t total = 0;
+    for (auto& ch : chunks) {
+        ch.firstRow = total;
+        total += ch.lines;
+    }
+    if (total < rows) {
+        if (error) *error = "ASCII body has " + std::to_string(total) + " lines, expected " + std::to_string(rows);
+        return false;
+    }
+
+    pool.run(chunks.size(), [&](size_t c) {
+        GS_TRACE_SCOPE("parseAsciiChunk");
+        Chunk& ch = chunks[c];
+        if (ch.firstRow >= rows) return; // past the vertex element (faces etc.)
+
+        std::vector<float> values(props);
+        const char* p = ch.begin;
+        for (size_t row = ch.firstRow; row < rows && p < ch.end; row++) {
+            const char* nl = static_cast<const char*>(std::memchr(p, '\n', (size_t)(ch.end - p)));
+            const char* lineEnd = nl ? nl : ch.end;
+            if (!parsePlyAsciiRow(p, lineEnd, values.data(), props)) {
+                ch.ok = false;
+                ch.badRow = row;
+                return;
+            }
+            emit(row, values.data());
+            p = nl ? nl + 1 : ch.end;
+        }
+    });
+
+    for (const auto& ch : chunks) {
+        if (ch.ok) continue;
+        if (error) {
+            *error = "malformed ASCII vertex " + std::to_string(ch.badRow) +
+                     " (expected " + std::to_string(props) + " values)";
+        }
+        return false;
+    }
+    return true;
+}
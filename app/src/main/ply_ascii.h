@@ -0,0 +1,28 @@
+#pragma once
+
+#include "thread_pool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Parses exactly `count` whitespace separated numbers from [begin, end).
+// Each token is copied out and parsed with strtof, so the C locale's
+// decimal point is expected: Android's libc only has that one, and the
+// tools never call setlocale. (Float std::from_chars would avoid this but
+// is missing from the NDK's libc++.)
+bool parsePlyAsciiRow(const char* begin, const char* end, float* values, size_t count);
+
+// Row sink for the ASCII body parser: receives the vertex index and the
+// values of every property of that row, in header order. Called concurrently
+// for distinct rows.
+using PlyAsciiRowFn = FunctionRef<void(size_t row, const float* values)>;
+
+// Parses the first `rows` lines of an ASCII PLY body.
+//
+// The body is split into newline aligned chunks; line counts per chunk are
+// prefix summed so every chunk knows the vertex index of its first line, and
+// chunks are then parsed independently on the pool. On failure `error`
+// names the first bad vertex.
+bool parsePlyAsciiBody(const char* begin, const char* end, size_t rows, size_t props,
+                       PlyAsciiRowFn emit, ThreadPool& pool, std::string* error);
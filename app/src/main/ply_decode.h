@@ -0,0 +1,84 @@
+#pragma once
+
+#include "ply_loader.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Shared by the PLY readers. Rows are little endian; so are all of our
+// targets (Android ARM64/x86_64), so scalars are copied out as-is.
+
+inline float decodePlyScalar(PlyType type, const uint8_t* src) {
+    switch (type) {
+    case PlyType::Float32: { float v; std::memcpy(&v, src, sizeof(v)); return v; }
+    case PlyType::Float64: { double v; std::memcpy(&v, src, sizeof(v)); return (float)v; }
+    case PlyType::UInt8:   return (float)*src;
+    case PlyType::Int8:    return (float)(int8_t)*src;
+    case PlyType::UInt16:  { uint16_t v; std::memcpy(&v, src, sizeof(v)); return (float)v; }
+    case PlyType::Int16:   { int16_t v; std::memcpy(&v, src, sizeof(v)); return (float)v; }
+    case PlyType::UInt32:  { uint32_t v; std::memcpy(&v, src, sizeof(v)); return (float)v; }
+    case PlyType::Int32:   { int32_t v; std::memcpy(&v, src, sizeof(v)); return (float)v; }
+    }
+    return 0.f;
+}
+
+// One step of a decode plan: where a property sits in the row and its type.
+// Plans are resolved from the header once, so the per-row loop does no
+// string work at all.
+struct PlyDecodeOp {
+    uint32_t offset = 0;
+    PlyType type = PlyType::Float32;
+};
+
+inline PlyDecodeOp makePlyDecodeOp(const PlyProperty& p) {
+    PlyDecodeOp op;
+    op.offset = (uint32_t)p.offset;
+    op.type = p.type;
+    return op;
+}
+
+inline float decodePlyOp(const PlyDecodeOp& op, const uint8_t* row) {
+    return decodePlyScalar(op.type, row + op.offset);
+}
+
+struct SplatCloud;
+
+// Decode plan for 3DGS vertex rows. Each field names a destination plane of
+// a SplatCloud; fields missing from the file are filled with a raw default
+// (before activation) instead.
+struct SplatDecodePlan {
+    enum Plane : uint16_t {
+        PosX = 0, PosY, PosZ,
+        ScaleX, ScaleY, ScaleZ,
+        RotW, RotX, RotY, RotZ,
+        Opacity,
+        DcR, DcG, DcB,
+        RestBase, // RestBase + j holds f_rest_j
+    };
+
+    struct Field {
+        PlyDecodeOp op;
+        int prop = -1;    // index into PlyHeader::props, -1 when missing
+        uint16_t plane = 0;
+        float def = 0.f;
+    };
+
+    std::vector<Field> fields;
+    uint32_t shRestCoeffs = 0;
+    // No f_dc_* in the file: the DC planes receive 0..255 vertex colours and
+    // are converted to SH in finishSplatRows.
+    bool dcFromRgb = false;
+    float rgbScale = 1.f / 255.f; // 1 for float colour properties
+};
+
+bool buildSplatDecodePlan(const PlyHeader& h, SplatDecodePlan& out);
+
+float* splatPlane(SplatCloud& cloud, uint16_t plane);
+
+// Decodes `n` binary rows into cloud[dstOffset, dstOffset + n).
+void decodeSplatRows(const uint8_t* rows, size_t stride, size_t n,
+                     const SplatDecodePlan& plan, SplatCloud& cloud, size_t dstOffset);
+
+// Colour conversion and activations for rows [begin, end) once decoded.
+void finishSplatRows(const SplatDecodePlan& plan, SplatCloud& cloud, size_t begin, size_t end);
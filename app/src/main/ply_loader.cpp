@@ -1,125 +1,289 @@
 #include "ply_loader.h"
+#include "ply_decode.h"
+#include "mapped_file.h"
+#include "splat_cloud.h"
+#include "ply_ascii.h"
+#include "thread_pool.h"
+#include "trace.h"
 
-#include <fstream>
 #include <sstream>
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <cstdio>
 #include <cstring>
 
 namespace {
 
-enum class PlyFormat {
-    Ascii,
-    BinaryLittleEndian,
-};
+static bool parseType(const std::string& t, PlyType& out, size_t& size) {
+    if (t == "char" || t == "int8")        { out = PlyType::Int8;    size = 1; return true; }
+    if (t == "uchar" || t == "uint8")      { out = PlyType::UInt8;   size = 1; return true; }
+    if (t == "short" || t == "int16")      { out = PlyType::Int16;   size = 2; return true; }
+    if (t == "ushort" || t == "uint16")    { out = PlyType::UInt16;  size = 2; return true; }
+    if (t == "int" || t == "int32")        { out = PlyType::Int32;   size = 4; return true; }
+    if (t == "uint" || t == "uint32")      { out = PlyType::UInt32;  size = 4; return true; }
+    if (t == "float" || t == "float32")    { out = PlyType::Float32; size = 4; return true; }
+    if (t == "double" || t == "float64")   { out = PlyType::Float64; size = 8; return true; }
+    return false;
+}
+
+static bool isFloatType(PlyType t) {
+    return t == PlyType::Float32 || t == PlyType::Float64;
+}
 
-struct Property {
-    std::string name;
-    std::string type;
-    size_t offset = 0;
-    size_t size = 0;
+static bool fail(std::string* error, const char* what) {
+    if (error) *error = what;
+    return false;
+}
+
+// Returns the next line in [pos, end) without the terminator and advances pos.
+static bool nextLine(const uint8_t* data, size_t size, size_t& pos, std::string& line) {
+    if (pos >= size) return false;
+    const uint8_t* begin = data + pos;
+    const uint8_t* nl = static_cast<const uint8_t*>(std::memchr(begin, '\n', size - pos));
+    size_t len = nl ? (size_t)(nl - begin) : size - pos;
+    pos += len + (nl ? 1 : 0);
+    if (len > 0 && begin[len - 1] == '\r') len--;
+    line.assign(reinterpret_cast<const char*>(begin), len);
+    return true;
+}
+
+struct PointPlan {
+    int ix = -1, iy = -1, iz = -1;
+    int ir = -1, ig = -1, ib = -1;
+    PlyDecodeOp x, y, z;
+    PlyDecodeOp r, g, b;
+    bool hasR = false;
+    bool hasG = false;
+    bool hasB = false;
 };
 
-static size_t typeSize(const std::string& t) {
-    if (t == "char" || t == "int8") return 1;
-    if (t == "uchar" || t == "uint8") return 1;
-    if (t == "short" || t == "int16") return 2;
-    if (t == "ushort" || t == "uint16") return 2;
-    if (t == "int" || t == "int32") return 4;
-    if (t == "uint" || t == "uint32") return 4;
-    if (t == "float" || t == "float32") return 4;
-    if (t == "double" || t == "float64") return 8;
-    return 0;
+static const char* bodyBegin(const MappedFile& file, const PlyHeader& h) {
+    return reinterpret_cast<const char*>(file.data()) + h.dataOffset;
 }
 
-template <typename T>
-static bool readExact(std::istream& in, T& out) {
-    return (bool)in.read(reinterpret_cast<char*>(&out), sizeof(T));
+static const char* bodyEnd(const MappedFile& file) {
+    return reinterpret_cast<const char*>(file.data()) + file.size();
 }
 
-static bool readScalar(std::istream& in, const std::string& type, float& outFloat, uint8_t& outU8) {
-    outFloat = 0.f;
-    outU8 = 0;
+static bool loadAsciiPoints(const MappedFile& file, const PlyHeader& h, const PointPlan& plan,
+                            std::vector<PlyPoint>& out, std::string* error) {
+    GS_TRACE_SCOPE("loadAsciiPoints");
+    auto emit = [&](size_t i, const float* v) {
+        PlyPoint& p = out[i];
+        p.x = v[plan.ix];
+        p.y = v[plan.iy];
+        p.z = v[plan.iz];
+        p.r = plan.hasR ? (uint8_t)(int)v[plan.ir] : 255;
+        p.g = plan.hasG ? (uint8_t)(int)v[plan.ig] : 255;
+        p.b = plan.hasB ? (uint8_t)(int)v[plan.ib] : 255;
+    };
+    return parsePlyAsciiBody(bodyBegin(file, h), bodyEnd(file), h.vertexCount, h.props.size(),
+                             emit, ThreadPool::shared(), error);
+}
 
-    if (type == "float" || type == "float32") {
-        float v = 0;
-        if (!readExact(in, v)) return false;
-        outFloat = v;
-        return true;
+static bool loadBinaryPoints(const MappedFile& file, const PlyHeader& h, const PointPlan& plan,
+                             std::vector<PlyPoint>& out) {
+    GS_TRACE_SCOPE("loadBinaryPoints");
+    const size_t bodySize = (size_t)h.vertexCount * h.stride;
+    if (file.size() - h.dataOffset < bodySize) return false;
+
+    file.adviseSequential(h.dataOffset, bodySize);
+
+    const uint8_t* row = file.data() + h.dataOffset;
+    for (uint32_t i = 0; i < h.vertexCount; i++, row += h.stride) {
+        PlyPoint& p = out[i];
+        p.x = decodePlyOp(plan.x, row);
+        p.y = decodePlyOp(plan.y, row);
+        p.z = decodePlyOp(plan.z, row);
+        p.r = plan.hasR ? (uint8_t)decodePlyOp(plan.r, row) : 255;
+        p.g = plan.hasG ? (uint8_t)decodePlyOp(plan.g, row) : 255;
+        p.b = plan.hasB ? (uint8_t)decodePlyOp(plan.b, row) : 255;
     }
-    if (type == "double" || type == "float64") {
-        double v = 0;
-        if (!readExact(in, v)) return false;
-        outFloat = (float)v;
-        return true;
+    return true;
+}
+
+// Rows decoded per block; a block of full 3DGS rows stays in L2 while each
+// column is pulled out of it.
+constexpr size_t kDecodeBlockRows = 256;
+
+template <typename T>
+static void decodeColumn(const uint8_t* src, size_t stride, size_t n, float* dst) {
+    for (size_t i = 0; i < n; i++, src += stride) {
+        T v;
+        std::memcpy(&v, src, sizeof(T));
+        dst[i] = (float)v;
     }
-    if (type == "uchar" || type == "uint8") {
-        uint8_t v = 0;
-        if (!readExact(in, v)) return false;
-        outU8 = v;
-        outFloat = (float)v;
-        return true;
+}
+
+static void decodeColumn(PlyType type, const uint8_t* src, size_t stride, size_t n, float* dst) {
+    switch (type) {
+    case PlyType::Float32: decodeColumn<float>(src, stride, n, dst); break;
+    case PlyType::Float64: decodeColumn<double>(src, stride, n, dst); break;
+    case PlyType::UInt8:   decodeColumn<uint8_t>(src, stride, n, dst); break;
+    case PlyType::Int8:    decodeColumn<int8_t>(src, stride, n, dst); break;
+    case PlyType::UInt16:  decodeColumn<uint16_t>(src, stride, n, dst); break;
+    case PlyType::Int16:   decodeColumn<int16_t>(src, stride, n, dst); break;
+    case PlyType::UInt32:  decodeColumn<uint32_t>(src, stride, n, dst); break;
+    case PlyType::Int32:   decodeColumn<int32_t>(src, stride, n, dst); break;
     }
-    if (type == "char" || type == "int8") {
-        int8_t v = 0;
-        if (!readExact(in, v)) return false;
-        outU8 = (uint8_t)v;
-        outFloat = (float)v;
-        return true;
+}
+
+static bool loadAsciiSplats(const MappedFile& file, const PlyHeader& h, const SplatDecodePlan& plan,
+                            SplatCloud& out, std::string* error) {
+    // Property index -> destination plane, nullptr for ignored properties.
+    std::vector<float*> planeForProp(h.props.size(), nullptr);
+    for (const auto& f : plan.fields) {
+        float* dst = splatPlane(out, f.plane);
+        if (f.prop >= 0) planeForProp[f.prop] = dst;
+        else std::fill(dst, dst + out.count, f.def);
     }
-    if (type == "ushort" || type == "uint16") {
-        uint16_t v = 0;
-        if (!readExact(in, v)) return false;
-        outU8 = (uint8_t)(v & 0xFF);
-        outFloat = (float)v;
-        return true;
+
+    auto emit = [&](size_t i, const float* v) {
+        for (size_t p = 0; p < planeForProp.size(); p++) {
+            if (planeForProp[p]) planeForProp[p][i] = v[p];
+        }
+    };
+    return parsePlyAsciiBody(bodyBegin(file, h), bodyEnd(file), h.vertexCount, h.props.size(),
+                             emit, ThreadPool::shared(), error);
+}
+
+} // namespace
+
+bool buildSplatDecodePlan(const PlyHeader& h, SplatDecodePlan& out) {
+    out = SplatDecodePlan{};
+
+    auto add = [&](const char* name, uint16_t plane, float def) -> bool {
+        SplatDecodePlan::Field f;
+        f.prop = h.find(name);
+        f.plane = plane;
+        f.def = def;
+        if (f.prop >= 0) f.op = makePlyDecodeOp(h.props[f.prop]);
+        out.fields.push_back(f);
+        return f.prop >= 0;
+    };
+
+    if (!add("x", SplatDecodePlan::PosX, 0.f)) return false;
+    if (!add("y", SplatDecodePlan::PosY, 0.f)) return false;
+    if (!add("z", SplatDecodePlan::PosZ, 0.f)) return false;
+
+    // Raw defaults: exp(-4.6) ~ 1cm, sigmoid(8) ~ 1, identity rotation.
+    add("scale_0", SplatDecodePlan::ScaleX, -4.6f);
+    add("scale_1", SplatDecodePlan::ScaleY, -4.6f);
+    add("scale_2", SplatDecodePlan::ScaleZ, -4.6f);
+    add("rot_0", SplatDecodePlan::RotW, 1.f);
+    add("rot_1", SplatDecodePlan::RotX, 0.f);
+    add("rot_2", SplatDecodePlan::RotY, 0.f);
+    add("rot_3", SplatDecodePlan::RotZ, 0.f);
+    add("opacity", SplatDecodePlan::Opacity, 8.f);
+
+    if (h.find("f_dc_0") >= 0) {
+        add("f_dc_0", SplatDecodePlan::DcR, 0.f);
+        add("f_dc_1", SplatDecodePlan::DcG, 0.f);
+        add("f_dc_2", SplatDecodePlan::DcB, 0.f);
+    } else {
+        out.dcFromRgb = true;
+        int ir = h.find("red");
+        out.rgbScale = (ir >= 0 && isFloatType(h.props[ir].type)) ? 1.f : 1.f / 255.f;
+        float def = 1.f / out.rgbScale;
+        add("red", SplatDecodePlan::DcR, def);
+        add("green", SplatDecodePlan::DcG, def);
+        add("blue", SplatDecodePlan::DcB, def);
     }
-    if (type == "short" || type == "int16") {
-        int16_t v = 0;
-        if (!readExact(in, v)) return false;
-        outU8 = (uint8_t)(v & 0xFF);
-        outFloat = (float)v;
-        return true;
+
+    uint32_t rest = 0;
+    char name[24];
+    for (;; rest++) {
+        std::snprintf(name, sizeof(name), "f_rest_%u", rest);
+        if (h.find(name) < 0) break;
     }
-    if (type == "uint" || type == "uint32") {
-        uint32_t v = 0;
-        if (!readExact(in, v)) return false;
-        outU8 = (uint8_t)(v & 0xFF);
-        outFloat = (float)v;
-        return true;
+    // Only complete bands per channel are usable.
+    uint32_t perChannel = shRestCoeffsForDegree(shDegreeForRestCoeffs(rest / 3));
+    out.shRestCoeffs = perChannel;
+    for (uint32_t j = 0; j < perChannel * 3; j++) {
+        // f_rest is channel-major with `rest / 3` coefficients per channel.
+        uint32_t c = j / perChannel, k = j % perChannel;
+        std::snprintf(name, sizeof(name), "f_rest_%u", c * (rest / 3) + k);
+        add(name, (uint16_t)(SplatDecodePlan::RestBase + j), 0.f);
     }
-    if (type == "int" || type == "int32") {
-        int32_t v = 0;
-        if (!readExact(in, v)) return false;
-        outU8 = (uint8_t)(v & 0xFF);
-        outFloat = (float)v;
-        return true;
+    return true;
+}
+
+float* splatPlane(SplatCloud& cloud, uint16_t plane) {
+    switch (plane) {
+    case SplatDecodePlan::PosX: return cloud.pos[0].data();
+    case SplatDecodePlan::PosY: return cloud.pos[1].data();
+    case SplatDecodePlan::PosZ: return cloud.pos[2].data();
+    case SplatDecodePlan::ScaleX: return cloud.scale[0].data();
+    case SplatDecodePlan::ScaleY: return cloud.scale[1].data();
+    case SplatDecodePlan::ScaleZ: return cloud.scale[2].data();
+    case SplatDecodePlan::RotW: return cloud.rot[0].data();
+    case SplatDecodePlan::RotX: return cloud.rot[1].data();
+    case SplatDecodePlan::RotY: return cloud.rot[2].data();
+    case SplatDecodePlan::RotZ: return cloud.rot[3].data();
+    case SplatDecodePlan::Opacity: return cloud.opacity.data();
+    case SplatDecodePlan::DcR: return cloud.shDc[0].data();
+    case SplatDecodePlan::DcG: return cloud.shDc[1].data();
+    case SplatDecodePlan::DcB: return cloud.shDc[2].data();
+    default: break;
     }
+    uint32_t j = plane - SplatDecodePlan::RestBase;
+    return cloud.shRest.data() + (size_t)j * cloud.count;
+}
 
-    return false;
+void decodeSplatRows(const uint8_t* rows, size_t stride, size_t n,
+                     const SplatDecodePlan& plan, SplatCloud& cloud, size_t dstOffset) {
+    GS_TRACE_SCOPE("decodeSplatRows");
+    for (size_t base = 0; base < n; base += kDecodeBlockRows) {
+        size_t m = std::min(kDecodeBlockRows, n - base);
+        const uint8_t* block = rows + base * stride;
+        for (const auto& f : plan.fields) {
+            float* dst = splatPlane(cloud, f.plane) + dstOffset + base;
+            if (f.prop < 0) {
+                for (size_t i = 0; i < m; i++) dst[i] = f.def;
+            } else {
+                decodeColumn(f.op.type, block + f.op.offset, stride, m, dst);
+            }
+        }
+    }
 }
 
-} // namespace
+void finishSplatRows(const SplatDecodePlan& plan, SplatCloud& cloud, size_t begin, size_t end) {
+    GS_TRACE_SCOPE("finishSplatRows");
+    if (plan.dcFromRgb) {
+        const float s = plan.rgbScale / kShC0;
+        const float bias = 0.5f / kShC0;
+        for (auto& ch : cloud.shDc) {
+            float* dc = ch.data();
+            for (size_t i = begin; i < end; i++) dc[i] = dc[i] * s - bias;
+        }
+    }
+    activateSplats(cloud, begin, end);
+}
 
-bool loadPlyVertices(const std::string& path, std::vector<PlyPoint>& out) {
-    out.clear();
+int PlyHeader::find(const char* name) const {
+    for (size_t i = 0; i < props.size(); i++) {
+        if (props[i].name == name) return (int)i;
+    }
+    return -1;
+}
 
-    std::ifstream in(path, std::ios::binary);
-    if (!in.is_open()) return false;
+bool parsePlyHeader(const uint8_t* data, size_t size, PlyHeader& out) {
+    out = PlyHeader{};
 
+    size_t pos = 0;
     std::string line;
-    if (!std::getline(in, line)) return false;
+    if (!nextLine(data, size, pos, line)) return false;
     if (line.rfind("ply", 0) != 0) return false;
 
-    PlyFormat format = PlyFormat::Ascii;
     bool inVertexElement = false;
-    uint32_t vertexCount = 0;
+    bool sawEnd = false;
 
-    std::vector<Property> props;
-    size_t stride = 0;
-
-    while (std::getline(in, line)) {
-        if (line == "end_header") break;
+    while (nextLine(data, size, pos, line)) {
+        if (line == "end_header") {
+            sawEnd = true;
+            break;
+        }
 
         std::istringstream ss(line);
         std::string tok;
@@ -128,8 +292,8 @@ bool loadPlyVertices(const std::string& path, std::vector<PlyPoint>& out) {
         if (tok == "format") {
             std::string fmt;
             ss >> fmt;
-            if (fmt == "ascii") format = PlyFormat::Ascii;
-            else if (fmt == "binary_little_endian") format = PlyFormat::BinaryLittleEndian;
+            if (fmt == "ascii") out.format = PlyFormat::Ascii;
+            else if (fmt == "binary_little_endian") out.format = PlyFormat::BinaryLittleEndian;
             else return false; // unsupported
         } else if (tok == "element") {
             std::string name;
@@ -137,9 +301,9 @@ bool loadPlyVertices(const std::string& path, std::vector<PlyPoint>& out) {
             ss >> name >> count;
             inVertexElement = (name == "vertex");
             if (inVertexElement) {
-                vertexCount = count;
-                props.clear();
-                stride = 0;
+                out.vertexCount = count;
+                out.props.clear();
+                out.stride = 0;
             }
         } else if (tok == "property") {
             if (!inVertexElement) continue;
@@ -154,136 +318,86 @@ bool loadPlyVertices(const std::string& path, std::vector<PlyPoint>& out) {
                 continue;
             }
 
-            std::string name;
-            ss >> name;
-
-            size_t sz = typeSize(type);
-            if (sz == 0) return false;
-
-            Property p;
-            p.name = name;
-            p.type = type;
-            p.offset = stride;
-            p.size = sz;
-            props.push_back(p);
-            stride += sz;
+            PlyProperty p;
+            if (!parseType(type, p.type, p.size)) return false;
+            ss >> p.name;
+            p.offset = out.stride;
+            out.stride += p.size;
+            out.props.push_back(p);
         }
     }
 
-    if (vertexCount == 0) return false;
-
-    // Find x/y/z and optional r/g/b
-    const Property* px = nullptr;
-    const Property* py = nullptr;
-    const Property* pz = nullptr;
-    const Property* pr = nullptr;
-    const Property* pg = nullptr;
-    const Property* pb = nullptr;
-
-    for (const auto& p : props) {
-        if (p.name == "x") px = &p;
-        else if (p.name == "y") py = &p;
-        else if (p.name == "z") pz = &p;
-        else if (p.name == "red" || p.name == "r") pr = &p;
-        else if (p.name == "green" || p.name == "g") pg = &p;
-        else if (p.name == "blue" || p.name == "b") pb = &p;
-    }
+    if (!sawEnd) return false;
+    out.dataOffset = pos;
+    return out.vertexCount > 0;
+}
 
-    if (!px || !py || !pz) return false;
-
-    out.resize(vertexCount);
-
-    if (format == PlyFormat::Ascii) {
-        // After header, stream is already at first vertex line
-        for (uint32_t i = 0; i < vertexCount; i++) {
-            if (!std::getline(in, line)) return false;
-            std::istringstream vs(line);
-
-            // Read all properties in order
-            float x=0,y=0,z=0;
-            uint8_t r=255,g=255,b=255;
-
-            for (const auto& p : props) {
-                if (p.type == "float" || p.type == "float32" || p.type == "double" || p.type == "float64") {
-                    double v=0;
-                    vs >> v;
-                    if (p.name == "x") x = (float)v;
-                    else if (p.name == "y") y = (float)v;
-                    else if (p.name == "z") z = (float)v;
-                } else {
-                    int v=0;
-                    vs >> v;
-                    if (p.name == "red" || p.name == "r") r = (uint8_t)v;
-                    else if (p.name == "green" || p.name == "g") g = (uint8_t)v;
-                    else if (p.name == "blue" || p.name == "b") b = (uint8_t)v;
-                }
-            }
+bool loadPlyVertices(const std::string& path, std::vector<PlyPoint>& out, std::string* error) {
+    GS_TRACE_SCOPE("loadPlyVertices");
+    out.clear();
 
-            out[i] = PlyPoint{ x, y, z, r, g, b };
-        }
-        return true;
-    }
+    MappedFile file;
+    if (!file.open(path)) return fail(error, "cannot open file");
 
-    // Binary little endian
-    std::vector<uint8_t> row(stride);
-
-    for (uint32_t i = 0; i < vertexCount; i++) {
-        if (!in.read(reinterpret_cast<char*>(row.data()), (std::streamsize)stride)) return false;
-
-        auto readF = [&](const Property* p, float def) -> float {
-            if (!p) return def;
-            std::istringstream dummy;
-            float outF=0.f; uint8_t outU8=0;
-            // Use a memstream approach: just copy bytes into scalar variables
-            // We rely on little-endian host (Android ARM64 is LE).
-            if (p->type == "float" || p->type == "float32") {
-                float v;
-                std::memcpy(&v, row.data() + p->offset, sizeof(float));
-                return v;
-            }
-            if (p->type == "double" || p->type == "float64") {
-                double v;
-                std::memcpy(&v, row.data() + p->offset, sizeof(double));
-                return (float)v;
-            }
-            if (p->type == "int" || p->type == "int32") {
-                int32_t v; std::memcpy(&v, row.data() + p->offset, sizeof(int32_t));
-                return (float)v;
-            }
-            if (p->type == "uint" || p->type == "uint32") {
-                uint32_t v; std::memcpy(&v, row.data() + p->offset, sizeof(uint32_t));
-                return (float)v;
-            }
-            if (p->type == "short" || p->type == "int16") {
-                int16_t v; std::memcpy(&v, row.data() + p->offset, sizeof(int16_t));
-                return (float)v;
-            }
-            if (p->type == "ushort" || p->type == "uint16") {
-                uint16_t v; std::memcpy(&v, row.data() + p->offset, sizeof(uint16_t));
-                return (float)v;
-            }
-            if (p->type == "char" || p->type == "int8") {
-                int8_t v; std::memcpy(&v, row.data() + p->offset, sizeof(int8_t));
-                return (float)v;
-            }
-            if (p->type == "uchar" || p->type == "uint8") {
-                uint8_t v; std::memcpy(&v, row.data() + p->offset, sizeof(uint8_t));
-                return (float)v;
-            }
-            return def;
-        };
+    PlyHeader h;
+    if (!parsePlyHeader(file.data(), file.size(), h)) return fail(error, "bad PLY header");
+
+    // Resolve x/y/z and optional r/g/b once.
+    PointPlan plan;
+    plan.ix = h.find("x"); plan.iy = h.find("y"); plan.iz = h.find("z");
+    if (plan.ix < 0 || plan.iy < 0 || plan.iz < 0) return fail(error, "missing x/y/z");
+
+    plan.ir = h.find("red"); if (plan.ir < 0) plan.ir = h.find("r");
+    plan.ig = h.find("green"); if (plan.ig < 0) plan.ig = h.find("g");
+    plan.ib = h.find("blue"); if (plan.ib < 0) plan.ib = h.find("b");
+
+    plan.x = makePlyDecodeOp(h.props[plan.ix]);
+    plan.y = makePlyDecodeOp(h.props[plan.iy]);
+    plan.z = makePlyDecodeOp(h.props[plan.iz]);
+    if (plan.ir >= 0) { plan.r = makePlyDecodeOp(h.props[plan.ir]); plan.hasR = true; }
+    if (plan.ig >= 0) { plan.g = makePlyDecodeOp(h.props[plan.ig]); plan.hasG = true; }
+    if (plan.ib >= 0) { plan.b = makePlyDecodeOp(h.props[plan.ib]); plan.hasB = true; }
 
-        float x = readF(px, 0.f);
-        float y = readF(py, 0.f);
-        float z = readF(pz, 0.f);
+    out.resize(h.vertexCount);
 
-        uint8_t r = 255, g = 255, b = 255;
-        if (pr) r = (uint8_t)readF(pr, 255.f);
-        if (pg) g = (uint8_t)readF(pg, 255.f);
-        if (pb) b = (uint8_t)readF(pb, 255.f);
+    bool ok = h.format == PlyFormat::Ascii
+        ? loadAsciiPoints(file, h, plan, out, error)
+        : loadBinaryPoints(file, h, plan, out) || fail(error, "truncated binary body");
+    if (!ok) out.clear();
+    return ok;
+}
+
+bool loadPlySplats(const std::string& path, SplatCloud& out, std::string* error) {
+    GS_TRACE_SCOPE("loadPlySplats");
+    out.clear();
+
+    MappedFile file;
+    if (!file.open(path)) return fail(error, "cannot open file");
+
+    PlyHeader h;
+    if (!parsePlyHeader(file.data(), file.size(), h)) return fail(error, "bad PLY header");
 
-        out[i] = PlyPoint{ x, y, z, r, g, b };
+    SplatDecodePlan plan;
+    if (!buildSplatDecodePlan(h, plan)) return fail(error, "missing x/y/z");
+
+    out.resize(h.vertexCount, plan.shRestCoeffs);
+
+    bool ok = true;
+    if (h.format == PlyFormat::Ascii) {
+        ok = loadAsciiSplats(file, h, plan, out, error);
+    } else {
+        const size_t bodySize = (size_t)h.vertexCount * h.stride;
+        ok = file.size() - h.dataOffset >= bodySize || fail(error, "truncated binary body");
+        if (ok) {
+            file.adviseSequential(h.dataOffset, bodySize);
+            decodeSplatRows(file.data() + h.dataOffset, h.stride, h.vertexCount, plan, out, 0);
+        }
     }
 
+    if (!ok) {
+        out.clear();
+        return false;
+    }
+    finishSplatRows(plan, out, 0, out.count);
     return true;
 }
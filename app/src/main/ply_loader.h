@@ -1,9 +1,12 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <vector>
 
+struct SplatCloud;
+
 struct PlyPoint {
     float x = 0.f;
     float y = 0.f;
@@ -13,8 +16,55 @@ struct PlyPoint {
     uint8_t b = 255;
 };
 
+enum class PlyFormat {
+    Ascii,
+    BinaryLittleEndian,
+};
+
+enum class PlyType : uint8_t {
+    Int8,
+    UInt8,
+    Int16,
+    UInt16,
+    Int32,
+    UInt32,
+    Float32,
+    Float64,
+};
+
+struct PlyProperty {
+    std::string name;
+    PlyType type = PlyType::Float32;
+    size_t offset = 0; // byte offset inside a binary row
+    size_t size = 0;
+};
+
+// Parsed header of the vertex element. Everything after `dataOffset` is body.
+struct PlyHeader {
+    PlyFormat format = PlyFormat::Ascii;
+    uint32_t vertexCount = 0;
+    std::vector<PlyProperty> props;
+    size_t stride = 0;     // bytes per binary vertex row
+    size_t dataOffset = 0; // first byte after "end_header\n"
+
+    // Index into props, or -1.
+    int find(const char* name) const;
+};
+
+// Parses the header at the start of a PLY file held in memory.
+bool parsePlyHeader(const uint8_t* data, size_t size, PlyHeader& out);
+
 // Minimal PLY loader:
 // - Supports ASCII and binary_little_endian
 // - Reads only vertex element
 // - Reads x,y,z and optional uchar r,g,b (common PLY export)
-bool loadPlyVertices(const std::string& path, std::vector<PlyPoint>& out);
+// The file is memory mapped; binary rows are decoded in place and ASCII
+// bodies are parsed in parallel. `error`, when given, describes a failure.
+bool loadPlyVertices(const std::string& path, std::vector<PlyPoint>& out,
+                     std::string* error = nullptr);
+
+// Loads a 3D Gaussian Splatting export (x/y/z, scale_*, rot_*, opacity,
+// f_dc_*, f_rest_*) into a SplatCloud with activations applied.
+// Plain point clouds load too: missing attributes get small isotropic,
+// opaque splats coloured from red/green/blue.
+bool loadPlySplats(const std::string& path, SplatCloud& out, std::string* error = nullptr);
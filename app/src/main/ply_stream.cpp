@@ -0,0 +1,125 @@
+#include "ply_stream.h"
+#include "ply_ascii.h"
+#include "splat_cloud.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+bool PlySplatStream::open(const std::string& path, std::string* error) {
+    close();
+
+    if (!file_.open(path)) error_ = "cannot open file";
+    else if (!parsePlyHeader(file_.data(), file_.size(), header_)) error_ = "bad PLY header";
+    else if (!buildSplatDecodePlan(header_, plan_)) error_ = "missing x/y/z";
+    else if (header_.format == PlyFormat::BinaryLittleEndian &&
+             file_.size() - header_.dataOffset < (size_t)header_.vertexCount * header_.stride) {
+        error_ = "truncated binary body";
+    }
+
+    if (failed()) {
+        if (error) *error = error_;
+        file_.close();
+        return false;
+    }
+
+    bodyPos_ = header_.dataOffset;
+    if (header_.format == PlyFormat::BinaryLittleEndian) {
+        file_.adviseSequential(bodyPos_, (size_t)header_.vertexCount * header_.stride);
+    }
+    return true;
+}
+
+void PlySplatStream::close() {
+    file_.close();
+    header_ = PlyHeader{};
+    plan_ = SplatDecodePlan{};
+    next_ = 0;
+    bodyPos_ = 0;
+    error_.clear();
+}
+
+bool PlySplatStream::next(SplatCloud& batch, size_t maxSplats) {
+    if (!file_.isOpen() || failed() || done() || maxSplats == 0) return false;
+
+    size_t n = std::min(maxSplats, total() - next_);
+    batch.resize(n, plan_.shRestCoeffs);
+
+    size_t consumedFrom = bodyPos_;
+    bool ok = header_.format == PlyFormat::Ascii ? nextAscii(batch, n) : nextBinary(batch, n);
+    if (!ok) {
+        batch.resize(0, plan_.shRestCoeffs);
+        return false;
+    }
+
+    finishSplatRows(plan_, batch, 0, n);
+    next_ += n;
+    file_.release(consumedFrom, bodyPos_ - consumedFrom);
+    return true;
+}
+
+bool PlySplatStream::nextBinary(SplatCloud& batch, size_t n) {
+    decodeSplatRows(file_.data() + bodyPos_, header_.stride, n, plan_, batch, 0);
+    bodyPos_ += n * header_.stride;
+    return true;
+}
+
+bool PlySplatStream::nextAscii(SplatCloud& batch, size_t n) {
+    const char* data = reinterpret_cast<const char*>(file_.data());
+    const char* begin = data + bodyPos_;
+    const char* fileEnd = data + file_.size();
+
+    // Find the end of the n-th line so the batch can be parsed in parallel.
+    const char* end = begin;
+    for (size_t i = 0; i < n && end < fileEnd; i++) {
+        const char* nl = static_cast<const char*>(std::memchr(end, '\n', (size_t)(fileEnd - end)));
+        end = nl ? nl + 1 : fileEnd;
+    }
+
+    std::vector<float*> planeForProp(header_.props.size(), nullptr);
+    for (const auto& f : plan_.fields) {
+        float* dst = splatPlane(batch, f.plane);
+        if (f.prop >= 0) planeForProp[f.prop] = dst;
+        else std::fill(dst, dst + n, f.def);
+    }
+
+    auto emit = [&](size_t i, const float* v) {
+        for (size_t p = 0; p < planeForProp.size(); p++) {
+            if (planeForProp[p]) planeForProp[p][i] = v[p];
+        }
+    };
+
+    std::string err;
+    if (!parsePlyAsciiBody(begin, end, n, header_.props.size(), emit, ThreadPool::shared(), &err)) {
+        // Row numbers from the parser are relative to this batch.
+        error_ = err + " in batch starting at vertex " + std::to_string(next_);
+        return false;
+    }
+    bodyPos_ = (size_t)(end - data);
+    return true;
+}
+
+PlyStreamResult streamPlySplats(const std::string& path, const PlyStreamOptions& options,
+                                const PlyBatchFn& onBatch, std::string* error) {
+    PlySplatStream stream;
+    if (!stream.open(path, error)) return PlyStreamResult::Failed;
+
+    SplatCloud batch;
+    while (!stream.done()) {
+        if (options.cancel && options.cancel->load(std::memory_order_relaxed)) {
+            return PlyStreamResult::Cancelled;
+        }
+
+        size_t first = stream.decoded();
+        if (!stream.next(batch, std::max<size_t>(options.batchSize, 1))) break;
+        if (options.onProgress) options.onProgress(stream.decoded(), stream.total());
+        if (!onBatch(batch, first)) return PlyStreamResult::Cancelled;
+    }
+
+    if (stream.failed()) {
+        if (error) *error = stream.error();
+        return PlyStreamResult::Failed;
+    }
+    return PlyStreamResult::Completed;
+}
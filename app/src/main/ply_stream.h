@@ -0,0 +1,70 @@
+#pragma once
+
+#include "mapped_file.h"
+#include "ply_decode.h"
+#include "ply_loader.h"
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <string>
+
+struct SplatCloud;
+
+// Pull-style progressive loader for 3DGS PLY files.
+//
+// Each next() call decodes the following batch of splats into a caller owned
+// SplatCloud (activations applied), so memory stays bounded by the batch size
+// rather than the scene. Pages of the mapping that have been consumed are
+// dropped as the stream advances.
+class PlySplatStream {
+public:
+    bool open(const std::string& path, std::string* error = nullptr);
+    void close();
+
+    const PlyHeader& header() const { return header_; }
+    uint32_t shRestCoeffs() const { return plan_.shRestCoeffs; }
+    size_t total() const { return header_.vertexCount; }
+    size_t decoded() const { return next_; }
+    float progress() const { return total() ? (float)next_ / (float)total() : 1.f; }
+
+    bool done() const { return next_ >= total(); }
+    bool failed() const { return !error_.empty(); }
+    const std::string& error() const { return error_; }
+
+    // Decodes up to `maxSplats` splats into `batch` (resized to the number
+    // decoded). Returns false at the end of the vertex element or on error.
+    bool next(SplatCloud& batch, size_t maxSplats);
+
+private:
+    bool nextBinary(SplatCloud& batch, size_t n);
+    bool nextAscii(SplatCloud& batch, size_t n);
+
+    MappedFile file_;
+    PlyHeader header_;
+    SplatDecodePlan plan_;
+    size_t next_ = 0;      // index of the next splat to decode
+    size_t bodyPos_ = 0;   // byte offset of the next row
+    std::string error_;
+};
+
+struct PlyStreamOptions {
+    size_t batchSize = 64 * 1024;
+    // Checked between batches.
+    const std::atomic<bool>* cancel = nullptr;
+    std::function<void(size_t decoded, size_t total)> onProgress;
+};
+
+enum class PlyStreamResult {
+    Completed,
+    Cancelled,
+    Failed,
+};
+
+// Receives each decoded batch and the scene index of its first splat.
+// Returning false stops the stream (reported as Cancelled).
+using PlyBatchFn = std::function<bool(const SplatCloud& batch, size_t first)>;
+
+// Push-style wrapper over PlySplatStream.
+PlyStreamResult streamPlySplats(const std::string& path, const PlyStreamOptions& options,
+                                const PlyBatchFn& onBatch, std::string* error = nullptr);
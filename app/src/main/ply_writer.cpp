@@ -0,0 +1,69 @@
+#include "ply_writer.h"
+#include "splat_cloud.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+namespace {
+
+// Rows converted per write; keeps the row buffer in L2.
+constexpr size_t kRowsPerBlock = 1024;
+
+static float logit(float a) {
+    a = std::min(std::max(a, 1e-6f), 1.f - 1e-6f);
+    return std::log(a / (1.f - a));
+}
+
+} // namespace
+
+bool writePlySplats(const std::string& path, const SplatCloud& cloud, std::string* error) {
+    auto fail = [&](const char* what) {
+        if (error) *error = what;
+        return false;
+    };
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) return fail("cannot create file");
+
+    const uint32_t rest = cloud.shRestCoeffs;
+    std::string header = "ply\nformat binary_little_endian 1.0\nelement vertex " + std::to_string(cloud.count) + "\n";
+    const char* fixed[] = { "x", "y", "z", "nx", "ny", "nz", "f_dc_0", "f_dc_1", "f_dc_2" };
+    for (const char* name : fixed) header += std::string("property float ") + name + "\n";
+    char name[24];
+    for (uint32_t j = 0; j < 3 * rest; j++) {
+        std::snprintf(name, sizeof(name), "f_rest_%u", j);
+        header += std::string("property float ") + name + "\n";
+    }
+    const char* tail[] = { "opacity", "scale_0", "scale_1", "scale_2", "rot_0", "rot_1", "rot_2", "rot_3" };
+    for (const char* n : tail) header += std::string("property float ") + n + "\n";
+    header += "end_header\n";
+    out.write(header.data(), (std::streamsize)header.size());
+
+    // f_rest is channel-major, matching shRestPlane(channel, k).
+    const size_t stride = 17 + 3 * (size_t)rest;
+    const bool shape = cloud.hasShape();
+    std::vector<float> rows(kRowsPerBlock * stride);
+    for (size_t begin = 0; begin < cloud.count; begin += kRowsPerBlock) {
+        const size_t n = std::min(kRowsPerBlock, cloud.count - begin);
+        for (size_t r = 0; r < n; r++) {
+            const size_t i = begin + r;
+            float* row = &rows[r * stride];
+            size_t c = 0;
+            for (int k = 0; k < 3; k++) row[c++] = cloud.pos[k][i];
+            for (int k = 0; k < 3; k++) row[c++] = 0.f;
+            for (int k = 0; k < 3; k++) row[c++] = cloud.shDc[k][i];
+            for (uint32_t ch = 0; ch < 3; ch++) {
+                for (uint32_t k = 0; k < rest; k++) row[c++] = cloud.shRestPlane(ch, k)[i];
+            }
+            row[c++] = logit(cloud.opacity[i]);
+            for (int k = 0; k < 3; k++) row[c++] = shape ? std::log(std::max(cloud.scale[k][i], 1e-30f)) : -4.6f;
+            for (int k = 0; k < 4; k++) row[c++] = shape ? cloud.rot[k][i] : (k == 0 ? 1.f : 0.f);
+        }
+        out.write(reinterpret_cast<const char*>(rows.data()), (std::streamsize)(n * stride * sizeof(float)));
+    }
+    if (!out) return fail("write failed");
+    return true;
+}
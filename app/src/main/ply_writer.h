@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+
+struct SplatCloud;
+
+// Writes `cloud` as a binary little-endian 3DGS PLY (x/y/z, nx/ny/nz,
+// f_dc_*, f_rest_*, opacity, scale_*, rot_*), the layout training exports
+// and viewers expect. Activations are undone on the way out: log scales and
+// logit opacity. Clouds without scale and rotation are written with the
+// loader's defaults for them.
+bool writePlySplats(const std::string& path, const SplatCloud& cloud, std::string* error = nullptr);
@@ -0,0 +1,113 @@
+#include "radix_sort.h"
+#include "thread_pool.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t kDigitBits = 8;
+constexpr uint32_t kBuckets = 1u << kDigitBits;
+
+// Below this a single block is faster than the fork/join overhead.
+constexpr size_t kMinItemsPerBlock = 1 << 15;
+
+template <typename Key>
+static void radixSortPairsImpl(Key* keys, uint32_t* values, size_t n,
+                               Key* keysTmp, uint32_t* valuesTmp,
+                               ThreadPool& pool, uint32_t keyBits) {
+    if (n < 2) return;
+
+    const uint32_t passes = std::min<uint32_t>((keyBits + kDigitBits - 1) / kDigitBits,
+                                               (uint32_t)(sizeof(Key) * 8 / kDigitBits));
+    const size_t blocks = std::max<size_t>(1, std::min<size_t>(pool.concurrency() * 2, n / kMinItemsPerBlock));
+    const size_t blockSize = (n + blocks - 1) / blocks;
+
+    // hist[block * kBuckets + digit], turned into scatter offsets in place.
+    // Kept per calling thread so repeated sorts stay off the heap; the
+    // blocks reach it through the local pointer, not their own thread's.
+    static thread_local std::vector<size_t> histScratch;
+    histScratch.resize(blocks * kBuckets);
+    size_t* hist = histScratch.data();
+
+    Key* srcK = keys;
+    Key* dstK = keysTmp;
+    uint32_t* srcV = values;
+    uint32_t* dstV = valuesTmp;
+
+    auto forBlocks = [&](auto&& fn) {
+        if (blocks == 1) {
+            fn(0, 0, n);
+            return;
+        }
+        pool.run(blocks, [&](size_t b) {
+            size_t begin = b * blockSize;
+            fn(b, begin, std::min(n, begin + blockSize));
+        });
+    };
+
+    for (uint32_t pass = 0; pass < passes; pass++) {
+        const uint32_t shift = pass * kDigitBits;
+
+        forBlocks([&](size_t b, size_t begin, size_t end) {
+            size_t* h = &hist[b * kBuckets];
+            std::fill(h, h + kBuckets, 0);
+            for (size_t i = begin; i < end; i++) h[(srcK[i] >> shift) & (kBuckets - 1)]++;
+        });
+
+        // All keys share this digit: the pass would be a plain copy.
+        bool trivial = false;
+        for (uint32_t d = 0; d < kBuckets && !trivial; d++) {
+            size_t total = 0;
+            for (size_t b = 0; b < blocks; b++) total += hist[b * kBuckets + d];
+            if (total == n) trivial = true;
+            else if (total != 0) break;
+        }
+        if (trivial) continue;
+
+        // Exclusive prefix over (digit, block) keeps the sort stable.
+        size_t sum = 0;
+        for (uint32_t d = 0; d < kBuckets; d++) {
+            for (size_t b = 0; b < blocks; b++) {
+                size_t c = hist[b * kBuckets + d];
+                hist[b * kBuckets + d] = sum;
+                sum += c;
+            }
+        }
+
+        forBlocks([&](size_t b, size_t begin, size_t end) {
+            size_t* off = &hist[b * kBuckets];
+            for (size_t i = begin; i < end; i++) {
+                size_t o = off[(srcK[i] >> shift) & (kBuckets - 1)]++;
+                dstK[o] = srcK[i];
+                dstV[o] = srcV[i];
+            }
+        });
+
+        std::swap(srcK, dstK);
+        std::swap(srcV, dstV);
+    }
+
+    if (srcK != keys) {
+        std::memcpy(keys, srcK, n * sizeof(Key));
+        std::memcpy(values, srcV, n * sizeof(uint32_t));
+    }
+}
+
+} // namespace
+
+void radixSortPairs(uint32_t* keys, uint32_t* values, size_t n,
+                    uint32_t* keysTmp, uint32_t* valuesTmp,
+                    ThreadPool& pool, uint32_t keyBits) {
+    GS_TRACE_SCOPE("radixSortPairs");
+    radixSortPairsImpl(keys, values, n, keysTmp, valuesTmp, pool, keyBits);
+}
+
+void radixSortPairs(uint64_t* keys, uint32_t* values, size_t n,
+                    uint64_t* keysTmp, uint32_t* valuesTmp,
+                    ThreadPool& pool, uint32_t keyBits) {
+    GS_TRACE_SCOPE("radixSortPairs");
+    radixSortPairsImpl(keys, values, n, keysTmp, valuesTmp, pool, keyBits);
+}
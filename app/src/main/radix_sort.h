@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+class ThreadPool;
+
+// Parallel LSD radix sort of key/value pairs, 8 bits per pass.
+//
+// Keys and values are sorted in place (ascending keys, stable); the tmp
+// arrays must hold n elements each. Only the low `keyBits` bits of the keys
+// are considered, and passes whose digit is the same for every key are
+// skipped, so narrow keys cost fewer passes.
+void radixSortPairs(uint32_t* keys, uint32_t* values, size_t n,
+                    uint32_t* keysTmp, uint32_t* valuesTmp,
+                    ThreadPool& pool, uint32_t keyBits = 32);
+
+void radixSortPairs(uint64_t* keys, uint32_t* values, size_t n,
+                    uint64_t* keysTmp, uint32_t* valuesTmp,
+                    ThreadPool& pool, uint32_t keyBits = 64);
+
+// Maps a float to a uint32 with the same ordering (negative values included).
+inline uint32_t floatToSortableBits(float f) {
+    uint32_t u;
+    std::memcpy(&u, &f, sizeof(u));
+    return (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+}
+
+// Key for front-to-back order by view depth.
+inline uint32_t packDepthKey(float depth) {
+    return floatToSortableBits(depth);
+}
+
+// Key for (tile, front-to-back depth) order.
+inline uint64_t packTileDepthKey(uint32_t tile, float depth) {
+    return ((uint64_t)tile << 32) | floatToSortableBits(depth);
+}
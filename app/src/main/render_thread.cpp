@@ -0,0 +1,384 @@
+#include "render_thread.h"
+#include "camera.h"
+#include "compact_splat.h"
+#include "cpu_rasterizer.h"
+#include "log.h"
+#include "sh_eval.h"
+#include "splat_cloud.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cmath>
+
+// CPU path that turns the scene into frame images.
+struct RenderThread::Frame {
+    CpuRasterizer raster;
+    std::vector<uint8_t> image;
+    std::vector<SplatRange> ranges;
+    SplatLodCut cut;
+    SplatCloud lodCloud; // the cut's splats, gathered every frame
+    // Lowers the SH degree while rasterizing runs over the frame budget.
+    ShDegreeController shDegree;
+};
+
+// Default view: outside a sphere, looking at its centre.
+static RenderThread::CameraPose framing(const float centre[3], float radius) {
+    RenderThread::CameraPose pose;
+    for (int k = 0; k < 3; k++) pose.target[k] = centre[k];
+    pose.eye[0] = centre[0];
+    pose.eye[1] = centre[1];
+    pose.eye[2] = centre[2] - 1.5f * radius;
+    return pose;
+}
+
+// Framing of the bounding sphere of [0, n) around its centroid.
+static RenderThread::CameraPose defaultPoseFor(const SplatCloud& c, size_t n) {
+    float centre[3] = { 0.f, 0.f, 0.f };
+    for (int k = 0; k < 3; k++) {
+        double sum = 0.0;
+        for (size_t i = 0; i < n; i++) sum += c.pos[k][i];
+        centre[k] = n ? (float)(sum / (double)n) : 0.f;
+    }
+    float radius = 0.f;
+    for (size_t i = 0; i < n; i++) {
+        const float dx = c.pos[0][i] - centre[0], dy = c.pos[1][i] - centre[1], dz = c.pos[2][i] - centre[2];
+        radius = std::max(radius, dx * dx + dy * dy + dz * dz);
+    }
+    return framing(centre, std::sqrt(radius));
+}
+
+RenderThread::~RenderThread() {
+    stop();
+}
+
+void RenderThread::start() {
+    if (thread_.joinable()) return;
+    thread_ = std::thread([this] { threadMain(); });
+}
+
+void RenderThread::stop() {
+    if (!thread_.joinable()) return;
+    post(Command{});
+    thread_.join();
+}
+
+void RenderThread::post(Command&& cmd) {
+    start();
+    // The queue only fills up if the render thread is stuck for dozens of
+    // events; wait for room rather than dropping a surface event.
+    while (!queue_.tryPush(std::move(cmd))) std::this_thread::yield();
+    wake();
+}
+
+void RenderThread::postAndWait(Command&& cmd) {
+    const uint64_t serial = cmd.serial = ++nextSerial_;
+    post(std::move(cmd));
+    std::unique_lock<std::mutex> lock(doneMutex_);
+    doneCv_.wait(lock, [&] { return done_ >= serial; });
+}
+
+void RenderThread::wake() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        wakePending_ = true;
+    }
+    wakeCv_.notify_one();
+}
+
+#if defined(__ANDROID__)
+void RenderThread::postSurfaceCreated(ANativeWindow* window) {
+    ANativeWindow_acquire(window);
+    Command cmd;
+    cmd.type = CommandType::SurfaceCreated;
+    cmd.window = window;
+    post(std::move(cmd));
+}
+#endif
+
+void RenderThread::postSurfaceChanged(int width, int height) {
+    Command cmd;
+    cmd.type = CommandType::SurfaceChanged;
+    cmd.width = width;
+    cmd.height = height;
+    post(std::move(cmd));
+}
+
+void RenderThread::postSurfaceDestroyed() {
+    Command cmd;
+    cmd.type = CommandType::SurfaceDestroyed;
+    postAndWait(std::move(cmd));
+}
+
+void RenderThread::postLoadScene(const std::string& path) {
+    Command cmd;
+    cmd.type = CommandType::LoadScene;
+    cmd.path = path;
+    post(std::move(cmd));
+}
+
+void RenderThread::postPipelineCachePath(const std::string& path) {
+    Command cmd;
+    cmd.type = CommandType::PipelineCachePath;
+    cmd.path = path;
+    post(std::move(cmd));
+}
+
+void RenderThread::postResizeStorm(uint32_t iterations) {
+    Command cmd;
+    cmd.type = CommandType::ResizeStorm;
+    cmd.width = (int)iterations;
+    post(std::move(cmd));
+}
+
+void RenderThread::postTraceCapture(const std::string& path, uint32_t frames) {
+    Command cmd;
+    cmd.type = CommandType::TraceCapture;
+    cmd.path = path;
+    cmd.width = (int)frames;
+    post(std::move(cmd));
+}
+
+void RenderThread::onVsync(int64_t frameTimeNanos) {
+    vsyncCount_.fetch_add(1, std::memory_order_release);
+    wake();
+    if (profiler_.enabled()) {
+        profiler_.noteVsync(frameTimeNanos);
+        profiler_.collect();
+    }
+}
+
+bool RenderThread::apply(Command& cmd) {
+    switch (cmd.type) {
+    case CommandType::SurfaceCreated:
+#if defined(__ANDROID__)
+        renderer_.onSurfaceCreated(static_cast<ANativeWindow*>(cmd.window));
+        ANativeWindow_release(static_cast<ANativeWindow*>(cmd.window));
+#endif
+        break;
+    case CommandType::SurfaceChanged:
+        renderer_.onSurfaceChanged(cmd.width, cmd.height);
+        break;
+    case CommandType::SurfaceDestroyed:
+        renderer_.onSurfaceDestroyed();
+        break;
+    case CommandType::LoadScene:
+        if (openStreamed(cmd.path)) {
+            if (traceLoad_) finishTrace();
+            break;
+        }
+        // Replaces any load in progress; the current scene stays up.
+        loader_.options.buildLod = options.lodBudget > 0;
+        loader_.start(cmd.path);
+        loading_ = true;
+        break;
+    case CommandType::PipelineCachePath:
+        renderer_.setPipelineCachePath(cmd.path);
+        break;
+    case CommandType::ResizeStorm:
+        renderer_.runResizeStorm((uint32_t)cmd.width);
+        break;
+    case CommandType::TraceCapture:
+        if (!traceStart()) {
+            LOGE("Trace capture needs a build with GS_ENABLE_TRACING");
+            break;
+        }
+        tracePath_ = cmd.path;
+        traceFrames_ = (uint32_t)cmd.width;
+        traceLoad_ = traceFrames_ == 0;
+        break;
+    case CommandType::Quit:
+        if (!tracePath_.empty()) finishTrace();
+        return false;
+    }
+
+    if (cmd.serial) {
+        {
+            std::lock_guard<std::mutex> lock(doneMutex_);
+            done_ = cmd.serial;
+        }
+        doneCv_.notify_all();
+    }
+    return true;
+}
+
+bool RenderThread::openStreamed(const std::string& path) {
+    if (path.size() < 4 || path.compare(path.size() - 4, 4, ".gsc") != 0) return false;
+    // The header and chunk table tell the decoded size; anything that fits
+    // the budget loads whole, and open errors are reported by the loader.
+    {
+        CompactSplatReader probe;
+        if (!probe.open(path)) return false;
+        if (splatDataBytes(probe.header().count, probe.shRestCoeffs()) <= options.residentBudget) return false;
+    }
+    residency_.options.budgetBytes = options.residentBudget;
+    std::string error;
+    if (!residency_.open(path, &error)) {
+        LOGE("Streaming %s failed: %s", path.c_str(), error.c_str());
+        return true;
+    }
+    loader_.cancel();
+    loading_ = false;
+    scene_.reset();
+
+    float lo[3], hi[3];
+    residency_.bounds(lo, hi);
+    float centre[3], radius2 = 0.f;
+    for (int k = 0; k < 3; k++) {
+        centre[k] = 0.5f * (lo[k] + hi[k]);
+        radius2 += 0.25f * (hi[k] - lo[k]) * (hi[k] - lo[k]);
+    }
+    defaultPose_ = framing(centre, std::sqrt(radius2));
+    LOGI("Streaming %s: %.0f MB of splats through %u chunk slots (%.0f MB)", path.c_str(),
+         (double)residency_.sceneBytes() / (1024.0 * 1024.0), residency_.stats().slots,
+         (double)options.residentBudget / (1024.0 * 1024.0));
+    return true;
+}
+
+void RenderThread::pollLoader() {
+    if (!loading_) return;
+    switch (loader_.state()) {
+    case SceneLoader::State::Loading:
+        return;
+    case SceneLoader::State::Ready: {
+        const SceneLoader::Stats st = loader_.stats();
+        scene_ = loader_.takeScene();
+        residency_.close();
+        if (frame_) frame_->cut.reset();
+        defaultPose_ = defaultPoseFor(scene_->cloud, scene_->cloud.count);
+        LOGI("Loaded %s (%zu splats, %zu pruned) in %.1f ms: read %.0f MB/s, preprocess %.0f MB/s, index %.1f ms",
+             scene_->path.c_str(), st.splats, st.prune.input - st.prune.output, st.totalMs, st.read.mbPerSecond(),
+             st.preprocess.mbPerSecond(), st.indexMs);
+        break;
+    }
+    case SceneLoader::State::Failed:
+        LOGE("Loading scene failed: %s", loader_.error().c_str());
+        break;
+    case SceneLoader::State::Idle:
+    case SceneLoader::State::Cancelled:
+        break;
+    }
+    loading_ = false;
+    if (traceLoad_) finishTrace();
+}
+
+void RenderThread::finishTrace() {
+    traceStop();
+    TraceWriteStats st;
+    std::string error;
+    if (traceWrite(tracePath_, &st, &error)) {
+        LOGI("Trace written to %s: %llu events on %u threads, %llu dropped", tracePath_.c_str(),
+             (unsigned long long)st.events, st.threads, (unsigned long long)st.dropped);
+    } else {
+        LOGE("Writing trace failed: %s", error.c_str());
+    }
+    tracePath_.clear();
+    traceFrames_ = 0;
+    traceLoad_ = false;
+}
+
+void RenderThread::renderFrame() {
+    GS_TRACE_SCOPE("renderFrame");
+    if (camera_.read(pose_)) havePose_ = true;
+    pollLoader();
+    const auto now = std::chrono::steady_clock::now();
+    const float dt = std::chrono::duration<float>(now - lastFrame_).count();
+    lastFrame_ = now;
+    if (!renderer_.isPresentable()) return;
+
+    const VkExtent2D extent = renderer_.extent();
+    if (extent.width > 0 && extent.height > 0) {
+        if (!frame_) frame_ = std::make_unique<Frame>();
+        Frame& f = *frame_;
+        const size_t stride = (size_t)extent.width * 4;
+        f.image.resize(stride * extent.height);
+        auto cameraFor = [&](const CameraPose& fallback) {
+            const CameraPose& p = havePose_ ? pose_ : fallback;
+            return makeLookAtCamera(p.eye, p.target, p.up, p.fovY, extent.width, extent.height);
+        };
+
+        const auto drawStart = std::chrono::steady_clock::now();
+        bool drawn = false;
+        if (scene_) {
+            const Camera cam = cameraFor(defaultPose_);
+            const SplatCloud& cloud = scene_->cloud;
+            f.raster.options.covariances = scene_->covariances.count() == cloud.count ? &scene_->covariances : nullptr;
+            if (options.lodBudget && scene_->lod.nodeCount()) {
+                f.cut.options.budget = options.lodBudget;
+                f.cut.update(scene_->lod, cam);
+                f.cut.gather(scene_->lod, f.lodCloud);
+                f.raster.options.covariances = nullptr;
+                f.raster.options.depthPresort = false;
+                f.raster.render(f.lodCloud, cam, f.image.data(), stride);
+            } else if (scene_->bvh.splatCount() == cloud.count && cloud.count) {
+                // The presort covers the whole cloud, so it only pays while
+                // most of it is in view; a held camera reuses the last order.
+                scene_->bvh.query(cam.frustum(), f.ranges);
+                f.raster.options.depthPresort = scene_->bvh.queryStats().culledFraction < 0.5f;
+                f.raster.render(cloud, cam, f.ranges, f.image.data(), stride);
+            } else {
+                f.raster.options.depthPresort = true;
+                f.raster.render(cloud, cam, f.image.data(), stride);
+            }
+            drawn = true;
+        } else if (residency_.isOpen()) {
+            // Chunks still loading are simply missing for a frame or two.
+            const Camera cam = cameraFor(defaultPose_);
+            residency_.update(cam, dt);
+            f.raster.options.covariances = nullptr;
+            f.raster.options.depthPresort = false;
+            f.raster.render(residency_.cloud(), cam, residency_.ranges(), f.image.data(), stride);
+            drawn = true;
+        } else if (loading_) {
+            // Preview of the first scene; the framing follows the data.
+            drawn = loader_.withPartial([&](const SplatCloud& cloud, SplatRange decoded) {
+                const Camera cam = cameraFor(defaultPoseFor(cloud, decoded.end));
+                f.ranges.assign(1, decoded);
+                f.raster.options.covariances = nullptr;
+                f.raster.options.depthPresort = false;
+                f.raster.render(cloud, cam, f.ranges, f.image.data(), stride);
+            });
+        }
+        if (drawn) {
+            const double drawMs =
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - drawStart).count();
+            f.raster.options.shDegree = f.shDegree.update(drawMs);
+            renderer_.setFrameImage(f.image.data(), extent.width, extent.height, stride);
+        }
+    }
+    renderer_.render();
+}
+
+void RenderThread::threadMain() {
+    const bool paced = options.vsyncPaced;
+    traceThreadName("render");
+    renderer_.setProfiler(&profiler_);
+    renderedVsync_ = vsyncCount_.load(std::memory_order_acquire);
+
+    Command cmd;
+    for (;;) {
+        while (queue_.tryPop(cmd)) {
+            if (!apply(cmd)) {
+                loader_.cancel();
+                renderer_.shutdown();
+                scene_.reset();
+                residency_.close();
+                frame_.reset();
+                return;
+            }
+        }
+
+        const uint64_t vsync = vsyncCount_.load(std::memory_order_acquire);
+        if (!paced || vsync != renderedVsync_) {
+            // Missed ticks are dropped rather than rendered back to back.
+            renderedVsync_ = vsync;
+            renderFrame();
+            // After the frame's scopes have closed.
+            if (traceFrames_ && renderer_.isPresentable() && --traceFrames_ == 0) finishTrace();
+            if (!paced && renderer_.isPresentable()) continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        wakeCv_.wait(lock, [&] { return wakePending_; });
+        wakePending_ = false;
+    }
+}
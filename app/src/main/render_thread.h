@@ -0,0 +1,170 @@
+#pragma once
+
+#include "chunk_residency.h"
+#include "frame_profiler.h"
+#include "scene_loader.h"
+#include "spsc_queue.h"
+#include "triple_buffer.h"
+#include "vulkan_renderer.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Native render thread that owns the VulkanRenderer and the scene.
+//
+// Events from the Java side are posted through a lock-free SPSC queue and
+// applied on the render thread between frames, so the Vulkan objects are
+// only ever touched by that thread. The post*() functions, setCamera() and
+// onVsync() form the producer side and must all be called from one thread
+// (the UI thread on Android).
+//
+// The camera pose goes through a triple-buffered mailbox instead of the
+// queue: only the newest pose matters, and the writer never blocks.
+//
+// Scenes load on a SceneLoader in the background. The current scene stays
+// on screen until the new one is ready; with no scene yet, the splats
+// decoded so far are drawn as they arrive.
+//
+// .gsc scenes whose decoded size exceeds Options::residentBudget are not
+// loaded whole: a ChunkResidency streams the chunks around the camera into
+// a pool of that size instead.
+//
+// With vsync pacing on, one frame is rendered per onVsync() (Choreographer
+// ticks); otherwise the thread renders continuously and FIFO presentation
+// paces it.
+//
+// Frame profiling (FrameProfiler) is off until setProfilingEnabled(true).
+// The renderer pushes the records; the producer thread drains them on each
+// onVsync(), which also logs the periodic summary line.
+//
+// postTraceCapture() records a CPU trace (trace.h) of a number of frames
+// or of one scene load, in builds with GS_ENABLE_TRACING.
+class RenderThread {
+public:
+    struct CameraPose {
+        float eye[3] = { 0.f, 0.f, -3.f };
+        float target[3] = { 0.f, 0.f, 0.f };
+        float up[3] = { 0.f, -1.f, 0.f };
+        float fovY = 1.0471976f; // 60 degrees
+    };
+
+    struct Options {
+        bool vsyncPaced = true;
+        uint64_t residentBudget = 512ull << 20; // larger .gsc scenes stream from disk
+        // When set, loaded scenes get a LOD hierarchy and are drawn as a cut
+        // of at most this many splats.
+        size_t lodBudget = 0;
+    };
+
+    Options options; // read when the thread starts
+
+    RenderThread() = default;
+    ~RenderThread();
+
+    RenderThread(const RenderThread&) = delete;
+    RenderThread& operator=(const RenderThread&) = delete;
+
+    // Starts the thread if it is not running; post*() call this too.
+    void start();
+    // Stops the thread after it has shut the renderer down. Counts as a
+    // producer call.
+    void stop();
+
+#if defined(__ANDROID__)
+    // Takes its own reference to `window`.
+    void postSurfaceCreated(ANativeWindow* window);
+#endif
+    void postSurfaceChanged(int width, int height);
+    // Blocks until the render thread has released the surface, as Android
+    // requires before surfaceDestroyed() returns.
+    void postSurfaceDestroyed();
+    void postLoadScene(const std::string& path);
+    void postPipelineCachePath(const std::string& path);
+    void postResizeStorm(uint32_t iterations);
+    // Writes a Chrome trace of the next `frames` frames to `path`; with 0,
+    // of the next scene load, from now until it is ready or fails.
+    void postTraceCapture(const std::string& path, uint32_t frames);
+
+    void setCamera(const CameraPose& pose) { camera_.write(pose); }
+    void onVsync(int64_t frameTimeNanos);
+
+    // Producer calls.
+    void setProfilingEnabled(bool enabled) { profiler_.setEnabled(enabled); }
+    FrameStats frameStats() { return profiler_.stats(); }
+
+private:
+    enum class CommandType : uint8_t {
+        SurfaceCreated,
+        SurfaceChanged,
+        SurfaceDestroyed,
+        LoadScene,
+        PipelineCachePath,
+        ResizeStorm,
+        TraceCapture,
+        Quit,
+    };
+
+    struct Command {
+        CommandType type = CommandType::Quit;
+        void* window = nullptr; // ANativeWindow*, referenced
+        int width = 0;
+        int height = 0;
+        std::string path;
+        uint64_t serial = 0;    // acknowledged through done_ when non-zero
+    };
+
+    void post(Command&& cmd);
+    void postAndWait(Command&& cmd);
+    void wake();
+    void threadMain();
+    // Returns false on Quit.
+    bool apply(Command& cmd);
+    // Shows `path` through residency_ if it is a .gsc scene too large to
+    // load whole.
+    bool openStreamed(const std::string& path);
+    // Adopts a finished load, or reports a failed one.
+    void pollLoader();
+    void renderFrame();
+    void finishTrace();
+
+    std::thread thread_;
+    SpscQueue<Command> queue_{ 64 };
+    TripleBuffer<CameraPose> camera_;
+
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCv_;
+    bool wakePending_ = false;
+    std::atomic<uint64_t> vsyncCount_{ 0 };
+
+    // Completion of blocking commands.
+    std::mutex doneMutex_;
+    std::condition_variable doneCv_;
+    uint64_t done_ = 0;
+    uint64_t nextSerial_ = 0; // producer-owned
+
+    // Records pushed by the renderer, consumed by the producer thread.
+    FrameProfiler profiler_;
+
+    // Render thread state.
+    struct Frame;                  // CPU rasterizer and its image
+    std::unique_ptr<Frame> frame_;
+    SceneLoader loader_;
+    bool loading_ = false;
+    std::unique_ptr<SceneLoader::Scene> scene_;
+    ChunkResidency residency_;     // open while a streamed scene is shown
+    CameraPose defaultPose_;       // of scene_ or the streamed scene
+    std::chrono::steady_clock::time_point lastFrame_;
+    VulkanRenderer renderer_;
+    CameraPose pose_;
+    bool havePose_ = false;
+    uint64_t renderedVsync_ = 0;
+    std::string tracePath_;        // non-empty while capturing
+    uint32_t traceFrames_ = 0;     // left to capture; 0 with traceLoad_
+    bool traceLoad_ = false;
+};
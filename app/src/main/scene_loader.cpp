@@ -0,0 +1,462 @@
+#include "scene_loader.h"
+#include "compact_splat.h"
+#include "morton_order.h"
+#include "ply_stream.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+// Blocking FIFO of bounded size between two stages. close() wakes both
+// sides: push() fails from then on, pop() drains what is left first.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity_(std::max<size_t>(capacity, 1)) {}
+
+    bool push(T&& v) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notFull_.wait(lock, [&] { return closed_ || items_.size() < capacity_; });
+        if (closed_) return false;
+        items_.push_back(std::move(v));
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    bool pop(T& out) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notEmpty_.wait(lock, [&] { return closed_ || !items_.empty(); });
+        if (items_.empty()) return false;
+        out = std::move(items_.front());
+        items_.pop_front();
+        notFull_.notify_one();
+        return true;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        notFull_.notify_all();
+        notEmpty_.notify_all();
+    }
+
+private:
+    const size_t capacity_;
+    std::deque<T> items_;
+    std::mutex mutex_;
+    std::condition_variable notFull_;
+    std::condition_variable notEmpty_;
+    bool closed_ = false;
+};
+
+struct Batch {
+    SplatCloud cloud;
+    size_t first = 0; // scene index of cloud's first splat
+};
+
+constexpr auto kUploadRetry = std::chrono::milliseconds(1);
+
+} // namespace
+
+struct SceneLoader::Job {
+    Job(const std::string& p, const Options& o, UploadFn fn)
+        : path(p), options(o), upload(std::move(fn)), decoded(o.queueDepth), assembledRanges(o.queueDepth) {
+        scene = std::make_unique<Scene>();
+        scene->path = path;
+    }
+
+    const std::string path;
+    const Options options;
+    const UploadFn upload;
+    const Clock::time_point started = Clock::now();
+
+    std::atomic<bool> cancelled{ false };
+    std::atomic<State> state{ State::Loading };
+    std::atomic<size_t> total{ 0 };     // set by the read stage once the file is open
+    std::atomic<size_t> assembled{ 0 }; // splats [0, assembled) are in scene->cloud
+    std::atomic<size_t> uploaded{ 0 };
+    uint32_t restCoeffs = 0;            // published to preprocess through `decoded`
+
+    BoundedQueue<Batch> decoded;              // read -> preprocess
+    BoundedQueue<SplatRange> assembledRanges; // preprocess -> upload
+
+    std::unique_ptr<Scene> scene;
+    std::mutex partialMutex; // held while scene->cloud is resized or reordered
+
+    // Batch clouds handed back by preprocess, so the read stage reuses
+    // their planes instead of allocating a batch worth of memory each time.
+    std::mutex sparesMutex;
+    std::vector<SplatCloud> spares;
+
+    mutable std::mutex mutex; // error, stats, running
+    std::condition_variable stopped;
+    std::string error;
+    Stats stats;
+    int running = 3;
+
+    void abort() {
+        cancelled.store(true, std::memory_order_relaxed);
+        decoded.close();
+        assembledRanges.close();
+    }
+
+    void fail(const std::string& message) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            error = message;
+        }
+        State expected = State::Loading;
+        state.compare_exchange_strong(expected, State::Failed);
+        abort();
+    }
+
+    bool stopping() const { return cancelled.load(std::memory_order_relaxed); }
+
+    void account(StageStats Stats::*stage, double busyMs, double waitMs, uint64_t bytes) {
+        std::lock_guard<std::mutex> lock(mutex);
+        StageStats& s = stats.*stage;
+        s.busyMs += busyMs;
+        s.waitMs += waitMs;
+        s.bytes += bytes;
+    }
+
+    SplatCloud takeSpare() {
+        std::lock_guard<std::mutex> lock(sparesMutex);
+        if (spares.empty()) return SplatCloud{};
+        SplatCloud c = std::move(spares.back());
+        spares.pop_back();
+        return c;
+    }
+
+    void recycle(SplatCloud&& cloud) {
+        std::lock_guard<std::mutex> lock(sparesMutex);
+        spares.push_back(std::move(cloud));
+    }
+
+    void stageDone() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--running == 0) stopped.notify_all();
+    }
+};
+
+SceneLoader::SceneLoader() = default;
+
+SceneLoader::~SceneLoader() {
+    cancel();
+    // stages_ joins its workers once they have run off the cancelled job.
+}
+
+void SceneLoader::start(const std::string& path, UploadFn upload) {
+    cancel();
+    auto job = std::make_shared<Job>(path, options, std::move(upload));
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job_ = job;
+    }
+    stages_.submit([job] {
+        traceThreadName("scene read");
+        runRead(*job);
+        job->stageDone();
+    });
+    stages_.submit([job] {
+        traceThreadName("scene preprocess");
+        runPreprocess(*job);
+        job->stageDone();
+    });
+    stages_.submit([job] {
+        traceThreadName("scene upload");
+        runUpload(*job);
+        job->stageDone();
+    });
+}
+
+void SceneLoader::cancel() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!job_) return;
+    State expected = State::Loading;
+    job_->state.compare_exchange_strong(expected, State::Cancelled);
+    job_->abort();
+}
+
+SceneLoader::State SceneLoader::state() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return job_ ? job_->state.load() : State::Idle;
+}
+
+float SceneLoader::progress() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!job_) return 0.f;
+    const size_t total = job_->total.load(std::memory_order_relaxed);
+    if (!total) return job_->state.load() == State::Loading ? 0.f : 1.f;
+    // Assembly and upload weigh the same; decoding overlaps assembly.
+    const size_t done = job_->assembled.load(std::memory_order_relaxed) + job_->uploaded.load(std::memory_order_relaxed);
+    return std::min(1.f, (float)((double)done / (2.0 * (double)total)));
+}
+
+std::string SceneLoader::error() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!job_) return std::string();
+    std::lock_guard<std::mutex> jobLock(job_->mutex);
+    return job_->error;
+}
+
+SceneLoader::Stats SceneLoader::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!job_) return Stats{};
+    std::lock_guard<std::mutex> jobLock(job_->mutex);
+    return job_->stats;
+}
+
+std::unique_ptr<SceneLoader::Scene> SceneLoader::takeScene() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!job_ || job_->state.load() != State::Ready) return nullptr;
+    std::unique_ptr<Scene> scene = std::move(job_->scene);
+    job_->state.store(State::Idle);
+    return scene;
+}
+
+bool SceneLoader::withPartial(const std::function<void(const SplatCloud& cloud, SplatRange decoded)>& fn) {
+    std::shared_ptr<Job> job;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job = job_;
+    }
+    if (!job || job->state.load() != State::Loading) return false;
+
+    std::unique_lock<std::mutex> lock(job->partialMutex, std::try_to_lock);
+    if (!lock.owns_lock()) return false;
+    const size_t n = job->assembled.load(std::memory_order_acquire);
+    if (n == 0 || !job->scene->cloud.hasShape()) return false;
+    fn(job->scene->cloud, SplatRange{ 0, (uint32_t)n });
+    return true;
+}
+
+SceneLoader::State SceneLoader::wait() {
+    std::shared_ptr<Job> job;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job = job_;
+    }
+    if (!job) return State::Idle;
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->stopped.wait(lock, [&] { return job->running == 0; });
+    return job->state.load();
+}
+
+void SceneLoader::runRead(Job& job) {
+    const size_t batchSize = std::max<size_t>(job.options.batchSize, 1);
+
+    // Hands a decoded batch to preprocess; false once the job is stopping.
+    auto emit = [&](SplatCloud&& cloud, size_t first, double busyMs) {
+        const uint64_t bytes = splatDataBytes(cloud.count, cloud.shRestCoeffs);
+        auto t0 = Clock::now();
+        Batch batch;
+        batch.cloud = std::move(cloud);
+        batch.first = first;
+        const bool ok = job.decoded.push(std::move(batch));
+        job.account(&Stats::read, busyMs, msSince(t0), bytes);
+        return ok;
+    };
+
+    std::string error;
+    if (isCompactSplatFile(job.path)) {
+        CompactSplatReader reader;
+        if (!reader.open(job.path, &error)) return job.fail(error);
+        job.restCoeffs = reader.shRestCoeffs();
+        job.total.store(reader.header().count);
+
+        // Whole chunks per batch, decoded in parallel.
+        const std::vector<CompactChunk>& chunks = reader.chunks();
+        std::vector<size_t> offsets;
+        size_t first = 0;
+        for (size_t c = 0; c < chunks.size() && !job.stopping();) {
+            auto t0 = Clock::now();
+            size_t end = c, n = 0;
+            offsets.clear();
+            while (end < chunks.size() && (n == 0 || n + chunks[end].count <= batchSize)) {
+                offsets.push_back(n);
+                n += chunks[end++].count;
+            }
+            GS_TRACE_SCOPE("read chunks");
+            SplatCloud batch = job.takeSpare();
+            batch.resize(n, job.restCoeffs);
+            ThreadPool::shared().run(end - c, [&](size_t k) { reader.decodeChunk(c + k, batch, offsets[k]); });
+            if (!emit(std::move(batch), first, msSince(t0))) break;
+            first += n;
+            c = end;
+        }
+    } else {
+        PlySplatStream stream;
+        if (!stream.open(job.path, &error)) return job.fail(error);
+        job.restCoeffs = stream.shRestCoeffs();
+        job.total.store(stream.total());
+
+        while (!job.stopping()) {
+            GS_TRACE_SCOPE("read rows");
+            auto t0 = Clock::now();
+            const size_t first = stream.decoded();
+            SplatCloud batch = job.takeSpare();
+            if (!stream.next(batch, batchSize)) break;
+            if (!emit(std::move(batch), first, msSince(t0))) break;
+        }
+        if (stream.failed()) return job.fail(stream.error());
+    }
+    job.decoded.close();
+}
+
+void SceneLoader::runPreprocess(Job& job) {
+    Scene& scene = *job.scene;
+    const bool streamRanges = !job.options.prune && !job.options.buildBvh && !job.options.mortonOrder;
+
+    // Offers [begin, end) to the upload stage in batch-sized pieces.
+    auto offer = [&](size_t begin, size_t end) {
+        const size_t step = std::max<size_t>(job.options.batchSize, 1);
+        for (size_t i = begin; i < end; i += step) {
+            auto t0 = Clock::now();
+            SplatRange r{ (uint32_t)i, (uint32_t)std::min(end, i + step) };
+            const bool ok = job.assembledRanges.push(std::move(r));
+            job.account(&Stats::preprocess, 0.0, msSince(t0), 0);
+            if (!ok) return false;
+        }
+        return true;
+    };
+
+    bool sized = false;
+    Batch batch;
+    for (;;) {
+        auto t0 = Clock::now();
+        const bool got = job.decoded.pop(batch);
+        const double waitMs = msSince(t0);
+        if (!got || job.stopping()) {
+            job.account(&Stats::preprocess, 0.0, waitMs, 0);
+            break;
+        }
+
+        GS_TRACE_SCOPE("assemble batch");
+        t0 = Clock::now();
+        if (!sized) {
+            std::lock_guard<std::mutex> lock(job.partialMutex);
+            scene.cloud.resize(job.total.load(), job.restCoeffs);
+            sized = true;
+        }
+        const size_t end = batch.first + batch.cloud.count;
+        if (end > scene.cloud.count) {
+            job.fail("file holds more splats than its header declares");
+            break;
+        }
+        // Batches arrive in file order, so [0, end) is now complete.
+        copySplats(batch.cloud, scene.cloud, batch.first);
+        job.assembled.store(end, std::memory_order_release);
+        job.account(&Stats::preprocess, msSince(t0), waitMs, splatDataBytes(batch.cloud.count, job.restCoeffs));
+        job.recycle(std::move(batch.cloud));
+
+        if (streamRanges && !offer(batch.first, end)) break;
+    }
+
+    if (!job.stopping()) {
+        if (!sized) scene.cloud.resize(job.total.load(), job.restCoeffs);
+        if (job.assembled.load() != scene.cloud.count) {
+            job.fail("file ended before its declared splat count");
+        } else {
+            auto t0 = Clock::now();
+            SplatPruneStats pruneStats;
+            if (job.options.prune) {
+                std::lock_guard<std::mutex> lock(job.partialMutex);
+                pruneSplats(scene.cloud, job.options.pruneOptions, &pruneStats);
+                job.assembled.store(scene.cloud.count, std::memory_order_release);
+                job.total.store(scene.cloud.count);
+            }
+            std::string error;
+            bool indexed = true;
+            if (job.options.buildBvh && scene.cloud.count) {
+                std::lock_guard<std::mutex> lock(job.partialMutex);
+                indexed = scene.bvh.build(scene.cloud, &error);
+            } else if (job.options.mortonOrder) {
+                std::lock_guard<std::mutex> lock(job.partialMutex);
+                mortonOrderSplats(scene.cloud);
+            }
+            if (indexed && job.options.buildLod && scene.cloud.count) {
+                indexed = scene.lod.build(scene.cloud, &error);
+            }
+            if (indexed && job.options.buildCovariances && scene.cloud.count) {
+                indexed = scene.covariances.build(scene.cloud, job.options.covariancePrecision, &error);
+                if (indexed && job.options.releaseShape && !job.options.buildLod) {
+                    std::lock_guard<std::mutex> lock(job.partialMutex);
+                    scene.cloud.releaseShape();
+                }
+            }
+            const double indexMs = msSince(t0);
+            job.account(&Stats::preprocess, indexMs, 0.0, 0);
+            if (!indexed) {
+                job.fail(error);
+            } else {
+                {
+                    std::lock_guard<std::mutex> lock(job.mutex);
+                    job.stats.indexMs = indexMs;
+                    job.stats.prune = pruneStats;
+                }
+                if (!streamRanges) offer(0, scene.cloud.count);
+            }
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(job.sparesMutex);
+        job.spares.clear();
+    }
+    job.assembledRanges.close();
+}
+
+void SceneLoader::runUpload(Job& job) {
+    const Scene& scene = *job.scene;
+    SplatRange range{ 0, 0 };
+    for (;;) {
+        auto t0 = Clock::now();
+        const bool got = job.assembledRanges.pop(range);
+        double waitMs = msSince(t0);
+        if (!got || job.stopping()) {
+            job.account(&Stats::upload, 0.0, waitMs, 0);
+            break;
+        }
+
+        GS_TRACE_SCOPE("upload range");
+        double busyMs = 0.0;
+        if (job.upload) {
+            for (;;) {
+                t0 = Clock::now();
+                const bool accepted = job.upload(scene, range);
+                busyMs += msSince(t0);
+                if (accepted || job.stopping()) break;
+                t0 = Clock::now();
+                std::this_thread::sleep_for(kUploadRetry);
+                waitMs += msSince(t0);
+            }
+        }
+        job.account(&Stats::upload, busyMs, waitMs, splatDataBytes(range.end - range.begin, scene.cloud.shRestCoeffs));
+        job.uploaded.store(range.end, std::memory_order_relaxed);
+    }
+
+    if (job.stopping()) return;
+    {
+        std::lock_guard<std::mutex> lock(job.mutex);
+        job.stats.splats = scene.cloud.count;
+        job.stats.totalMs = msSince(job.started);
+    }
+    State expected = State::Loading;
+    job.state.compare_exchange_strong(expected, State::Ready);
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "covariance_store.h"
+#include "spatial_index.h"
+#include "splat_lod.h"
+#include "splat_prune.h"
+#include "splat_cloud.h"
+#include "thread_pool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Asynchronous scene loading in three pipelined stages:
+//
+//   read        decode batches from a PLY (PlySplatStream) or .gsc file,
+//               activations applied by the decoders
+//   preprocess  copy batches into the scene cloud as they arrive, then
+//               prune it, put it in spatial order (BVH build or Morton
+//               sort), build the LOD hierarchy if asked and covariances,
+//               then drop scale and rotation when nothing else reads them
+//   upload      hand the finished scene to an optional sink in batches,
+//               e.g. a GPU staging ring, retrying while it is full
+//
+// Stages run on the loader's own small worker pool and talk through
+// bounded queues, so a slow stage throttles the ones before it instead of
+// buffering the whole file. The caller keeps rendering its current scene
+// meanwhile and can draw the splats decoded so far with withPartial().
+//
+// start() and cancel() abandon the load in progress: its stages notice
+// between batches and exit, and its results are dropped.
+class SceneLoader {
+public:
+    struct Options {
+        size_t batchSize = 64 * 1024; // splats per batch
+        size_t queueDepth = 4;        // batches buffered between stages
+        bool prune = true;
+        SplatPruneOptions pruneOptions;
+        bool buildBvh = true;
+        // Sort by Morton code when no BVH is built; BVH order is already
+        // spatially coherent.
+        bool mortonOrder = true;
+        // LOD hierarchy over the ordered cloud, for budgeted rendering.
+        bool buildLod = false;
+        bool buildCovariances = true;
+        CovariancePrecision covariancePrecision = CovariancePrecision::Float32;
+        // Drop scale and rotation once covariances are built (28 bytes per
+        // splat). Kept when the LOD hierarchy is built, since it gathers
+        // them; the upload sink sees a cloud without them otherwise.
+        bool releaseShape = true;
+    };
+
+    struct Scene {
+        std::string path;
+        SplatCloud cloud;
+        SplatBvh bvh;               // empty unless Options::buildBvh
+        SplatLod lod;               // empty unless Options::buildLod
+        CovarianceStore covariances; // empty unless Options::buildCovariances
+    };
+
+    // Receives [range.begin, range.end) of the scene on the upload stage,
+    // in order. When the cloud gets pruned or reordered the ranges follow
+    // that; otherwise they stream in as batches are assembled. Returning
+    // false means "busy": the same range is offered again shortly.
+    using UploadFn = std::function<bool(const Scene& scene, SplatRange range)>;
+
+    enum class State : uint8_t {
+        Idle,
+        Loading,
+        Ready,     // takeScene() has a result
+        Cancelled,
+        Failed,
+    };
+
+    struct StageStats {
+        double busyMs = 0.0; // working, excluding time blocked on queues
+        double waitMs = 0.0; // blocked on a full or empty queue
+        uint64_t bytes = 0;  // decoded splat data through the stage
+
+        double mbPerSecond() const { return busyMs > 0.0 ? (double)bytes / (busyMs * 1e3) : 0.0; }
+    };
+
+    struct Stats {
+        StageStats read;
+        StageStats preprocess;
+        StageStats upload;
+        double indexMs = 0.0; // pruning, reordering, LOD and covariances, part of preprocess
+        SplatPruneStats prune;
+        double totalMs = 0.0; // start to Ready
+        size_t splats = 0;
+    };
+
+    Options options; // applied by the next start()
+
+    SceneLoader();
+    ~SceneLoader();
+
+    SceneLoader(const SceneLoader&) = delete;
+    SceneLoader& operator=(const SceneLoader&) = delete;
+
+    // Starts loading `path`, cancelling any load in progress.
+    void start(const std::string& path, UploadFn upload = nullptr);
+    void cancel();
+
+    State state() const;
+    // Rough fraction of the current load done, in [0, 1].
+    float progress() const;
+    // Valid once the state is Failed.
+    std::string error() const;
+    // Stage timings of the current load, final once it has stopped.
+    Stats stats() const;
+
+    // Moves the finished scene out (state goes back to Idle), or returns
+    // null if the current load has not finished.
+    std::unique_ptr<Scene> takeScene();
+
+    // While the current load is running, calls fn(cloud, assembled) with
+    // the splats assembled so far and returns true. Never blocks: returns
+    // false instead while the cloud is being resized or reordered, and
+    // once its shape has been released.
+    bool withPartial(const std::function<void(const SplatCloud& cloud, SplatRange decoded)>& fn);
+
+    // Blocks until the current load stops (for tools).
+    State wait();
+
+private:
+    struct Job;
+
+    static void runRead(Job& job);
+    static void runPreprocess(Job& job);
+    static void runUpload(Job& job);
+
+    // One worker per stage, separate from ThreadPool::shared() so stages
+    // that block on their queues never starve the parallel loops inside
+    // the decoders and index builds.
+    ThreadPool stages_{ 3 };
+    mutable std::mutex mutex_;
+    std::shared_ptr<Job> job_;
+};
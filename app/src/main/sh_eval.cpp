@@ -0,0 +1,194 @@
+#include "sh_eval.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr float kShC1 = 0.4886025119029199f;
+constexpr float kShC2[5] = { 1.0925484305920792f, -1.0925484305920792f, 0.31539156525252005f,
+                             -1.0925484305920792f, 0.5462742152960396f };
+constexpr float kShC3[7] = { -0.5900435899266435f, 2.890611442640554f, -0.4570457994644658f,
+                             0.3731763325901154f, -0.4570457994644658f, 1.445305721320277f,
+                             -0.5900435899266435f };
+
+// Lane abstraction so the same kernel body runs 4 wide and on the tail.
+struct VectorLanes {
+    using V = simd::f32x4;
+    static constexpr size_t kWidth = 4;
+    static V load(const float* p) { return simd::load(p); }
+    static void store(float* p, V v) { simd::store(p, v); }
+    static V set1(float x) { return simd::set1(x); }
+    static V max(V a, V b) { return simd::max(a, b); }
+    static V sqrt(V a) { return simd::sqrt(a); }
+};
+
+struct ScalarLanes {
+    using V = float;
+    static constexpr size_t kWidth = 1;
+    static V load(const float* p) { return *p; }
+    static void store(float* p, V v) { *p = v; }
+    static V set1(float x) { return x; }
+    static V max(V a, V b) { return a > b ? a : b; }
+    static V sqrt(V a) { return std::sqrt(a); }
+};
+
+template <uint32_t Degree, typename L>
+static size_t evalRun(const SplatCloud& cloud, const float eye[3], size_t begin, size_t end,
+                      float* r, float* g, float* b) {
+    using V = typename L::V;
+    const uint32_t coeffs = cloud.shRestCoeffs;
+    const float* px = cloud.pos[0].data();
+    const float* py = cloud.pos[1].data();
+    const float* pz = cloud.pos[2].data();
+    const V ex = L::set1(eye[0]), ey = L::set1(eye[1]), ez = L::set1(eye[2]);
+    const V half = L::set1(0.5f), zero = L::set1(0.f), one = L::set1(1.f);
+    float* out[3] = { r, g, b };
+
+    size_t i = begin;
+    for (; i + L::kWidth <= end; i += L::kWidth) {
+        V x = L::load(px + i) - ex;
+        V y = L::load(py + i) - ey;
+        V z = L::load(pz + i) - ez;
+        if (Degree > 0) {
+            const V inv = one / L::sqrt(L::max(x * x + y * y + z * z, L::set1(1e-20f)));
+            x = x * inv;
+            y = y * inv;
+            z = z * inv;
+        }
+
+        // Basis values shared by the three channels.
+        V basis[15];
+        if (Degree > 0) {
+            basis[0] = L::set1(-kShC1) * y;
+            basis[1] = L::set1(kShC1) * z;
+            basis[2] = L::set1(-kShC1) * x;
+        }
+        if (Degree > 1) {
+            const V xx = x * x, yy = y * y, zz = z * z;
+            basis[3] = L::set1(kShC2[0]) * (x * y);
+            basis[4] = L::set1(kShC2[1]) * (y * z);
+            basis[5] = L::set1(kShC2[2]) * (zz + zz - xx - yy);
+            basis[6] = L::set1(kShC2[3]) * (x * z);
+            basis[7] = L::set1(kShC2[4]) * (xx - yy);
+            if (Degree > 2) {
+                const V three = L::set1(3.f), four = L::set1(4.f);
+                basis[8] = L::set1(kShC3[0]) * y * (three * xx - yy);
+                basis[9] = L::set1(kShC3[1]) * (x * y) * z;
+                basis[10] = L::set1(kShC3[2]) * y * (four * zz - xx - yy);
+                basis[11] = L::set1(kShC3[3]) * z * (zz + zz - three * xx - three * yy);
+                basis[12] = L::set1(kShC3[4]) * x * (four * zz - xx - yy);
+                basis[13] = L::set1(kShC3[5]) * z * (xx - yy);
+                basis[14] = L::set1(kShC3[6]) * x * (xx - three * yy);
+            }
+        }
+
+        constexpr uint32_t used = (Degree + 1) * (Degree + 1) - 1;
+        for (uint32_t c = 0; c < 3; c++) {
+            V acc = L::set1(kShC0) * L::load(cloud.shDc[c].data() + i) + half;
+            const float* plane = cloud.shRest.data() + (size_t)c * coeffs * cloud.count + i;
+            for (uint32_t k = 0; k < used; k++) {
+                acc = acc + basis[k] * L::load(plane + (size_t)k * cloud.count);
+            }
+            L::store(out[c] + (i - begin), L::max(acc, zero));
+        }
+    }
+    return i;
+}
+
+template <uint32_t Degree>
+static void evalDegree(const SplatCloud& cloud, const float eye[3], size_t begin, size_t end,
+                       float* r, float* g, float* b) {
+    size_t i = evalRun<Degree, VectorLanes>(cloud, eye, begin, end, r, g, b);
+    size_t off = i - begin;
+    evalRun<Degree, ScalarLanes>(cloud, eye, i, end, r + off, g + off, b + off);
+}
+
+} // namespace
+
+template <uint32_t Degree>
+void evalShColors(const SplatCloud& cloud, const float eye[3], size_t begin, size_t end,
+                  float* r, float* g, float* b) {
+    static_assert(Degree <= 3, "SH degree must be 0..3");
+    evalDegree<Degree>(cloud, eye, begin, end, r, g, b);
+}
+
+template void evalShColors<0>(const SplatCloud&, const float*, size_t, size_t, float*, float*, float*);
+template void evalShColors<1>(const SplatCloud&, const float*, size_t, size_t, float*, float*, float*);
+template void evalShColors<2>(const SplatCloud&, const float*, size_t, size_t, float*, float*, float*);
+template void evalShColors<3>(const SplatCloud&, const float*, size_t, size_t, float*, float*, float*);
+
+void evalShColors(const SplatCloud& cloud, const float eye[3], uint32_t degree, size_t begin, size_t end,
+                  float* r, float* g, float* b) {
+    switch (std::min(degree, cloud.shDegree())) {
+    case 0:
+        evalDegree<0>(cloud, eye, begin, end, r, g, b);
+        break;
+    case 1:
+        evalDegree<1>(cloud, eye, begin, end, r, g, b);
+        break;
+    case 2:
+        evalDegree<2>(cloud, eye, begin, end, r, g, b);
+        break;
+    default:
+        evalDegree<3>(cloud, eye, begin, end, r, g, b);
+        break;
+    }
+}
+
+void evalShColorsReference(const SplatCloud& cloud, const float eye[3], uint32_t degree, size_t begin, size_t end,
+                           float* r, float* g, float* b) {
+    degree = std::min(degree, cloud.shDegree());
+    float* out[3] = { r, g, b };
+    for (size_t i = begin; i < end; i++) {
+        float x = cloud.pos[0][i] - eye[0];
+        float y = cloud.pos[1][i] - eye[1];
+        float z = cloud.pos[2][i] - eye[2];
+        const float len = std::sqrt(std::max(x * x + y * y + z * z, 1e-20f));
+        x /= len;
+        y /= len;
+        z /= len;
+        const float xx = x * x, yy = y * y, zz = z * z;
+
+        for (uint32_t c = 0; c < 3; c++) {
+            auto sh = [&](uint32_t k) { return cloud.shRestPlane(c, k - 1)[i]; };
+            float v = kShC0 * cloud.shDc[c][i];
+            if (degree > 0) {
+                v += -kShC1 * y * sh(1) + kShC1 * z * sh(2) - kShC1 * x * sh(3);
+            }
+            if (degree > 1) {
+                v += kShC2[0] * x * y * sh(4) + kShC2[1] * y * z * sh(5) +
+                     kShC2[2] * (2.f * zz - xx - yy) * sh(6) + kShC2[3] * x * z * sh(7) +
+                     kShC2[4] * (xx - yy) * sh(8);
+            }
+            if (degree > 2) {
+                v += kShC3[0] * y * (3.f * xx - yy) * sh(9) + kShC3[1] * x * y * z * sh(10) +
+                     kShC3[2] * y * (4.f * zz - xx - yy) * sh(11) +
+                     kShC3[3] * z * (2.f * zz - 3.f * xx - 3.f * yy) * sh(12) +
+                     kShC3[4] * x * (4.f * zz - xx - yy) * sh(13) + kShC3[5] * z * (xx - yy) * sh(14) +
+                     kShC3[6] * x * (xx - 3.f * yy) * sh(15);
+            }
+            out[c][i - begin] = std::max(0.f, v + 0.5f);
+        }
+    }
+}
+
+uint32_t ShDegreeController::update(double frameMs) {
+    if (frameMs > options.frameBudgetMs) {
+        under_ = 0;
+        if (++over_ >= options.patience && degree_ > 0) {
+            degree_ = degree() - 1;
+            over_ = 0;
+        }
+    } else if (frameMs < options.frameBudgetMs * options.recoverFraction) {
+        over_ = 0;
+        if (++under_ >= options.patience && degree_ < options.maxDegree) {
+            degree_++;
+            under_ = 0;
+        }
+    } else {
+        over_ = under_ = 0;
+    }
+    return degree();
+}
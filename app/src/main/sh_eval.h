@@ -0,0 +1,53 @@
+#pragma once
+
+#include "splat_cloud.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// View-dependent colour from spherical harmonics, as in 3DGS:
+// rgb = max(0, 0.5 + sum_l sum_m c_lm Y_lm(d)) with d the unit direction
+// from the camera centre to the splat.
+//
+// The kernel reads the SoA coefficient planes of a SplatCloud directly and
+// writes planar r, g, b for splats [begin, end). The degree is a template
+// parameter so each degree compiles to its own loop; the runtime entry
+// point dispatches and clamps to what the cloud stores.
+
+template <uint32_t Degree>
+void evalShColors(const SplatCloud& cloud, const float eye[3], size_t begin, size_t end,
+                  float* r, float* g, float* b);
+
+void evalShColors(const SplatCloud& cloud, const float eye[3], uint32_t degree, size_t begin, size_t end,
+                  float* r, float* g, float* b);
+
+// Plain scalar loop with the same contract, kept as the reference the
+// vectorized kernel is checked against.
+void evalShColorsReference(const SplatCloud& cloud, const float eye[3], uint32_t degree, size_t begin, size_t end,
+                           float* r, float* g, float* b);
+
+// Picks the SH degree to evaluate from recent frame times: drops one degree
+// after `patience` frames over budget, and raises it again after `patience`
+// frames comfortably (below `recoverFraction` x budget) under it.
+class ShDegreeController {
+public:
+    struct Options {
+        uint32_t maxDegree = 3;
+        double frameBudgetMs = 16.6;
+        double recoverFraction = 0.7;
+        uint32_t patience = 30;
+    };
+
+    Options options;
+
+    // Feeds one frame's time; returns the degree for the next frame.
+    uint32_t update(double frameMs);
+
+    uint32_t degree() const { return degree_ < options.maxDegree ? degree_ : options.maxDegree; }
+    void reset() { degree_ = options.maxDegree; over_ = under_ = 0; }
+
+private:
+    uint32_t degree_ = 3;
+    uint32_t over_ = 0;
+    uint32_t under_ = 0;
+};
@@ -0,0 +1,288 @@
+#pragma once
+
+// Thin 4-wide float SIMD layer: SSE2 on x86, NEON on ARM, scalar elsewhere.
+// Only what the splat kernels need; masks are lane-wise all-ones / all-zeros
+// stored in an f32x4 and combined with select().
+//
+// f32x8 has the same operations 8 wide: native with AVX (GS_ENABLE_AVX
+// host builds), otherwise a pair of f32x4, which still gives the
+// scheduler two independent chains per instruction.
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define GS_SIMD_SSE2 1
+#include <emmintrin.h>
+#if defined(__AVX__)
+#define GS_SIMD_AVX 1
+#include <immintrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define GS_SIMD_NEON 1
+#include <arm_neon.h>
+#else
+#define GS_SIMD_SCALAR 1
+#endif
+
+namespace simd {
+
+#if GS_SIMD_SSE2
+
+struct f32x4 {
+    __m128 v;
+};
+
+inline f32x4 load(const float* p) { return { _mm_loadu_ps(p) }; }
+inline void store(float* p, f32x4 a) { _mm_storeu_ps(p, a.v); }
+inline f32x4 set1(float x) { return { _mm_set1_ps(x) }; }
+inline f32x4 set(float a, float b, float c, float d) { return { _mm_setr_ps(a, b, c, d) }; }
+
+inline f32x4 operator+(f32x4 a, f32x4 b) { return { _mm_add_ps(a.v, b.v) }; }
+inline f32x4 operator-(f32x4 a, f32x4 b) { return { _mm_sub_ps(a.v, b.v) }; }
+inline f32x4 operator*(f32x4 a, f32x4 b) { return { _mm_mul_ps(a.v, b.v) }; }
+inline f32x4 operator/(f32x4 a, f32x4 b) { return { _mm_div_ps(a.v, b.v) }; }
+inline f32x4 sqrt(f32x4 a) { return { _mm_sqrt_ps(a.v) }; }
+inline f32x4 min(f32x4 a, f32x4 b) { return { _mm_min_ps(a.v, b.v) }; }
+inline f32x4 max(f32x4 a, f32x4 b) { return { _mm_max_ps(a.v, b.v) }; }
+
+inline f32x4 cmpLt(f32x4 a, f32x4 b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+inline f32x4 cmpLe(f32x4 a, f32x4 b) { return { _mm_cmple_ps(a.v, b.v) }; }
+inline f32x4 cmpGe(f32x4 a, f32x4 b) { return { _mm_cmpge_ps(a.v, b.v) }; }
+inline f32x4 maskAnd(f32x4 a, f32x4 b) { return { _mm_and_ps(a.v, b.v) }; }
+// a & ~b
+inline f32x4 maskAndNot(f32x4 a, f32x4 b) { return { _mm_andnot_ps(b.v, a.v) }; }
+// mask ? a : b
+inline f32x4 select(f32x4 mask, f32x4 a, f32x4 b) {
+    return { _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)) };
+}
+inline bool any(f32x4 mask) { return _mm_movemask_ps(mask.v) != 0; }
+// Bit i set for lane i of a mask.
+inline uint32_t laneMask(f32x4 mask) { return (uint32_t)_mm_movemask_ps(mask.v); }
+
+// 2^n for integral n held in a float vector (n in [-126, 127]).
+inline f32x4 exp2i(f32x4 n) {
+    __m128i e = _mm_add_epi32(_mm_cvttps_epi32(n.v), _mm_set1_epi32(127));
+    return { _mm_castsi128_ps(_mm_slli_epi32(e, 23)) };
+}
+inline f32x4 floor(f32x4 a) {
+    __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v));
+    // Truncation rounds negative values up; step back where it did.
+    return { _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a.v), _mm_set1_ps(1.f))) };
+}
+
+#elif GS_SIMD_NEON
+
+struct f32x4 {
+    float32x4_t v;
+};
+
+inline f32x4 load(const float* p) { return { vld1q_f32(p) }; }
+inline void store(float* p, f32x4 a) { vst1q_f32(p, a.v); }
+inline f32x4 set1(float x) { return { vdupq_n_f32(x) }; }
+inline f32x4 set(float a, float b, float c, float d) {
+    const float t[4] = { a, b, c, d };
+    return { vld1q_f32(t) };
+}
+
+inline f32x4 operator+(f32x4 a, f32x4 b) { return { vaddq_f32(a.v, b.v) }; }
+inline f32x4 operator-(f32x4 a, f32x4 b) { return { vsubq_f32(a.v, b.v) }; }
+inline f32x4 operator*(f32x4 a, f32x4 b) { return { vmulq_f32(a.v, b.v) }; }
+#if defined(__aarch64__)
+inline f32x4 operator/(f32x4 a, f32x4 b) { return { vdivq_f32(a.v, b.v) }; }
+inline f32x4 sqrt(f32x4 a) { return { vsqrtq_f32(a.v) }; }
+#else
+// ARMv7 has no vector divide or sqrt: estimate plus two Newton steps.
+inline f32x4 operator/(f32x4 a, f32x4 b) {
+    float32x4_t r = vrecpeq_f32(b.v);
+    r = vmulq_f32(r, vrecpsq_f32(b.v, r));
+    r = vmulq_f32(r, vrecpsq_f32(b.v, r));
+    return { vmulq_f32(a.v, r) };
+}
+inline f32x4 sqrt(f32x4 a) {
+    float32x4_t r = vrsqrteq_f32(a.v);
+    r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(a.v, r), r));
+    r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(a.v, r), r));
+    // a * rsqrt(a), with sqrt(0) = 0 instead of 0 * inf.
+    uint32x4_t zero = vceqq_f32(a.v, vdupq_n_f32(0.f));
+    return { vbslq_f32(zero, vdupq_n_f32(0.f), vmulq_f32(a.v, r)) };
+}
+#endif
+inline f32x4 min(f32x4 a, f32x4 b) { return { vminq_f32(a.v, b.v) }; }
+inline f32x4 max(f32x4 a, f32x4 b) { return { vmaxq_f32(a.v, b.v) }; }
+
+inline f32x4 cmpLt(f32x4 a, f32x4 b) { return { vreinterpretq_f32_u32(vcltq_f32(a.v, b.v)) }; }
+inline f32x4 cmpLe(f32x4 a, f32x4 b) { return { vreinterpretq_f32_u32(vcleq_f32(a.v, b.v)) }; }
+inline f32x4 cmpGe(f32x4 a, f32x4 b) { return { vreinterpretq_f32_u32(vcgeq_f32(a.v, b.v)) }; }
+inline f32x4 maskAnd(f32x4 a, f32x4 b) {
+    return { vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a.v), vreinterpretq_u32_f32(b.v))) };
+}
+inline f32x4 maskAndNot(f32x4 a, f32x4 b) {
+    return { vreinterpretq_f32_u32(vbicq_u32(vreinterpretq_u32_f32(a.v), vreinterpretq_u32_f32(b.v))) };
+}
+inline f32x4 select(f32x4 mask, f32x4 a, f32x4 b) {
+    return { vbslq_f32(vreinterpretq_u32_f32(mask.v), a.v, b.v) };
+}
+inline bool any(f32x4 mask) {
+    uint32x4_t m = vreinterpretq_u32_f32(mask.v);
+    uint32x2_t r = vorr_u32(vget_low_u32(m), vget_high_u32(m));
+    return (vget_lane_u32(r, 0) | vget_lane_u32(r, 1)) != 0;
+}
+inline uint32_t laneMask(f32x4 mask) {
+    const uint32_t weights[4] = { 1, 2, 4, 8 };
+    uint32x4_t m = vandq_u32(vreinterpretq_u32_f32(mask.v), vld1q_u32(weights));
+    uint32x2_t r = vadd_u32(vget_low_u32(m), vget_high_u32(m));
+    return vget_lane_u32(vpadd_u32(r, r), 0);
+}
+
+inline f32x4 exp2i(f32x4 n) {
+    int32x4_t e = vaddq_s32(vcvtq_s32_f32(n.v), vdupq_n_s32(127));
+    return { vreinterpretq_f32_s32(vshlq_n_s32(e, 23)) };
+}
+inline f32x4 floor(f32x4 a) {
+    float32x4_t t = vcvtq_f32_s32(vcvtq_s32_f32(a.v));
+    uint32x4_t gt = vcgtq_f32(t, a.v);
+    return { vsubq_f32(t, vreinterpretq_f32_u32(vandq_u32(gt, vreinterpretq_u32_f32(vdupq_n_f32(1.f))))) };
+}
+
+#else
+
+struct f32x4 {
+    float v[4];
+};
+
+inline f32x4 load(const float* p) { f32x4 r; std::memcpy(r.v, p, sizeof(r.v)); return r; }
+inline void store(float* p, f32x4 a) { std::memcpy(p, a.v, sizeof(a.v)); }
+inline f32x4 set1(float x) { return { { x, x, x, x } }; }
+inline f32x4 set(float a, float b, float c, float d) { return { { a, b, c, d } }; }
+
+#define GS_SIMD_LANEWISE(expr) \
+    f32x4 r;                   \
+    for (int i = 0; i < 4; i++) r.v[i] = (expr); \
+    return r
+
+inline f32x4 operator+(f32x4 a, f32x4 b) { GS_SIMD_LANEWISE(a.v[i] + b.v[i]); }
+inline f32x4 operator-(f32x4 a, f32x4 b) { GS_SIMD_LANEWISE(a.v[i] - b.v[i]); }
+inline f32x4 operator*(f32x4 a, f32x4 b) { GS_SIMD_LANEWISE(a.v[i] * b.v[i]); }
+inline f32x4 operator/(f32x4 a, f32x4 b) { GS_SIMD_LANEWISE(a.v[i] / b.v[i]); }
+inline f32x4 sqrt(f32x4 a) { GS_SIMD_LANEWISE(std::sqrt(a.v[i])); }
+inline f32x4 min(f32x4 a, f32x4 b) { GS_SIMD_LANEWISE(a.v[i] < b.v[i] ? a.v[i] : b.v[i]); }
+inline f32x4 max(f32x4 a, f32x4 b) { GS_SIMD_LANEWISE(a.v[i] > b.v[i] ? a.v[i] : b.v[i]); }
+
+inline float maskBits(bool b) {
+    uint32_t u = b ? 0xFFFFFFFFu : 0u;
+    float f;
+    std::memcpy(&f, &u, sizeof(f));
+    return f;
+}
+inline uint32_t bits(float f) {
+    uint32_t u;
+    std::memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+inline f32x4 cmpLt(f32x4 a, f32x4 b) { GS_SIMD_LANEWISE(maskBits(a.v[i] < b.v[i])); }
+inline f32x4 cmpLe(f32x4 a, f32x4 b) { GS_SIMD_LANEWISE(maskBits(a.v[i] <= b.v[i])); }
+inline f32x4 cmpGe(f32x4 a, f32x4 b) { GS_SIMD_LANEWISE(maskBits(a.v[i] >= b.v[i])); }
+inline f32x4 maskAnd(f32x4 a, f32x4 b) { GS_SIMD_LANEWISE(maskBits(bits(a.v[i]) && bits(b.v[i]))); }
+inline f32x4 maskAndNot(f32x4 a, f32x4 b) { GS_SIMD_LANEWISE(maskBits(bits(a.v[i]) && !bits(b.v[i]))); }
+inline f32x4 select(f32x4 mask, f32x4 a, f32x4 b) { GS_SIMD_LANEWISE(bits(mask.v[i]) ? a.v[i] : b.v[i]); }
+inline bool any(f32x4 mask) {
+    return (bits(mask.v[0]) | bits(mask.v[1]) | bits(mask.v[2]) | bits(mask.v[3])) != 0;
+}
+inline uint32_t laneMask(f32x4 mask) {
+    uint32_t m = 0;
+    for (int i = 0; i < 4; i++) m |= (bits(mask.v[i]) ? 1u : 0u) << i;
+    return m;
+}
+
+inline f32x4 exp2i(f32x4 n) { GS_SIMD_LANEWISE(std::ldexp(1.f, (int)n.v[i])); }
+inline f32x4 floor(f32x4 a) { GS_SIMD_LANEWISE(std::floor(a.v[i])); }
+
+#undef GS_SIMD_LANEWISE
+
+#endif
+
+#if GS_SIMD_AVX
+
+struct f32x8 {
+    __m256 v;
+};
+
+inline f32x8 load8(const float* p) { return { _mm256_loadu_ps(p) }; }
+inline void store(float* p, f32x8 a) { _mm256_storeu_ps(p, a.v); }
+inline f32x8 set1x8(float x) { return { _mm256_set1_ps(x) }; }
+
+inline f32x8 operator+(f32x8 a, f32x8 b) { return { _mm256_add_ps(a.v, b.v) }; }
+inline f32x8 operator-(f32x8 a, f32x8 b) { return { _mm256_sub_ps(a.v, b.v) }; }
+inline f32x8 operator*(f32x8 a, f32x8 b) { return { _mm256_mul_ps(a.v, b.v) }; }
+inline f32x8 operator/(f32x8 a, f32x8 b) { return { _mm256_div_ps(a.v, b.v) }; }
+inline f32x8 sqrt(f32x8 a) { return { _mm256_sqrt_ps(a.v) }; }
+inline f32x8 min(f32x8 a, f32x8 b) { return { _mm256_min_ps(a.v, b.v) }; }
+inline f32x8 max(f32x8 a, f32x8 b) { return { _mm256_max_ps(a.v, b.v) }; }
+
+inline f32x8 cmpLt(f32x8 a, f32x8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+inline f32x8 cmpLe(f32x8 a, f32x8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ) }; }
+inline f32x8 cmpGe(f32x8 a, f32x8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ) }; }
+inline f32x8 maskAnd(f32x8 a, f32x8 b) { return { _mm256_and_ps(a.v, b.v) }; }
+inline f32x8 maskAndNot(f32x8 a, f32x8 b) { return { _mm256_andnot_ps(b.v, a.v) }; }
+inline f32x8 select(f32x8 mask, f32x8 a, f32x8 b) { return { _mm256_blendv_ps(b.v, a.v, mask.v) }; }
+inline bool any(f32x8 mask) { return _mm256_movemask_ps(mask.v) != 0; }
+inline uint32_t laneMask(f32x8 mask) { return (uint32_t)_mm256_movemask_ps(mask.v); }
+
+inline f32x8 floor(f32x8 a) { return { _mm256_floor_ps(a.v) }; }
+
+#else
+
+struct f32x8 {
+    f32x4 lo, hi;
+};
+
+inline f32x8 load8(const float* p) { return { load(p), load(p + 4) }; }
+inline void store(float* p, f32x8 a) {
+    store(p, a.lo);
+    store(p + 4, a.hi);
+}
+inline f32x8 set1x8(float x) { return { set1(x), set1(x) }; }
+
+inline f32x8 operator+(f32x8 a, f32x8 b) { return { a.lo + b.lo, a.hi + b.hi }; }
+inline f32x8 operator-(f32x8 a, f32x8 b) { return { a.lo - b.lo, a.hi - b.hi }; }
+inline f32x8 operator*(f32x8 a, f32x8 b) { return { a.lo * b.lo, a.hi * b.hi }; }
+inline f32x8 operator/(f32x8 a, f32x8 b) { return { a.lo / b.lo, a.hi / b.hi }; }
+inline f32x8 sqrt(f32x8 a) { return { sqrt(a.lo), sqrt(a.hi) }; }
+inline f32x8 min(f32x8 a, f32x8 b) { return { min(a.lo, b.lo), min(a.hi, b.hi) }; }
+inline f32x8 max(f32x8 a, f32x8 b) { return { max(a.lo, b.lo), max(a.hi, b.hi) }; }
+
+inline f32x8 cmpLt(f32x8 a, f32x8 b) { return { cmpLt(a.lo, b.lo), cmpLt(a.hi, b.hi) }; }
+inline f32x8 cmpLe(f32x8 a, f32x8 b) { return { cmpLe(a.lo, b.lo), cmpLe(a.hi, b.hi) }; }
+inline f32x8 cmpGe(f32x8 a, f32x8 b) { return { cmpGe(a.lo, b.lo), cmpGe(a.hi, b.hi) }; }
+inline f32x8 maskAnd(f32x8 a, f32x8 b) { return { maskAnd(a.lo, b.lo), maskAnd(a.hi, b.hi) }; }
+inline f32x8 maskAndNot(f32x8 a, f32x8 b) { return { maskAndNot(a.lo, b.lo), maskAndNot(a.hi, b.hi) }; }
+inline f32x8 select(f32x8 mask, f32x8 a, f32x8 b) { return { select(mask.lo, a.lo, b.lo), select(mask.hi, a.hi, b.hi) }; }
+inline bool any(f32x8 mask) { return any(mask.lo) || any(mask.hi); }
+inline uint32_t laneMask(f32x8 mask) { return laneMask(mask.lo) | (laneMask(mask.hi) << 4); }
+
+inline f32x8 floor(f32x8 a) { return { floor(a.lo), floor(a.hi) }; }
+
+#endif
+
+// e^x for x <= 0, ~4e-6 relative error; inputs below -87 flush towards 0.
+// Used for Gaussian falloff where inputs are never positive.
+inline f32x4 expNeg(f32x4 x) {
+    x = max(x, set1(-87.f));
+    f32x4 t = x * set1(1.44269504088896341f); // log2(e)
+    f32x4 n = floor(t);
+    f32x4 f = t - n; // [0, 1)
+
+    // 2^f on [0, 1), minimax polynomial
+    f32x4 p = set1(1.8775767e-3f);
+    p = p * f + set1(8.9893397e-3f);
+    p = p * f + set1(5.5826318e-2f);
+    p = p * f + set1(2.4015361e-1f);
+    p = p * f + set1(6.9315308e-1f);
+    p = p * f + set1(9.9999994e-1f);
+    return p * exp2i(n);
+}
+
+} // namespace simd
@@ -0,0 +1,185 @@
+#include "spatial_index.h"
+#include "thread_pool.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+// Half extent of the 3-sigma box along each world axis: for M = R S the
+// ellipsoid's extent along axis k is 3 * |row k of M|.
+static void splatExtent(float sx, float sy, float sz, float qw, float qx, float qy, float qz, float out[3]) {
+    const float r[9] = {
+        1.f - 2.f * (qy * qy + qz * qz), 2.f * (qx * qy - qw * qz), 2.f * (qx * qz + qw * qy),
+        2.f * (qx * qy + qw * qz), 1.f - 2.f * (qx * qx + qz * qz), 2.f * (qy * qz - qw * qx),
+        2.f * (qx * qz - qw * qy), 2.f * (qy * qz + qw * qx), 1.f - 2.f * (qx * qx + qy * qy),
+    };
+    for (int k = 0; k < 3; k++) {
+        const float a = r[k * 3 + 0] * sx, b = r[k * 3 + 1] * sy, c = r[k * 3 + 2] * sz;
+        out[k] = 3.f * std::sqrt(a * a + b * b + c * c);
+    }
+}
+
+} // namespace
+
+void SplatBvh::clear() {
+    nodes_.clear();
+    count_ = 0;
+    stats_ = Stats{};
+    queryStats_ = QueryStats{};
+}
+
+bool SplatBvh::build(SplatCloud& cloud, std::string* error) {
+    GS_TRACE_SCOPE("SplatBvh::build");
+    auto t0 = Clock::now();
+    clear();
+    if (!cloud.hasShape()) {
+        if (error) *error = "cloud has no scale or rotation";
+        return false;
+    }
+
+    const size_t n = cloud.count;
+    count_ = n;
+    if (options.leafSize == 0) options.leafSize = 1;
+
+    centre_.resize(n * 3);
+    extent_.resize(n * 3);
+    order_.resize(n);
+    ThreadPool::shared().parallelFor(n, 1 << 14, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            for (int k = 0; k < 3; k++) centre_[i * 3 + k] = cloud.pos[k][i];
+            splatExtent(cloud.scale[0][i], cloud.scale[1][i], cloud.scale[2][i],
+                        cloud.rot[0][i], cloud.rot[1][i], cloud.rot[2][i], cloud.rot[3][i], &extent_[i * 3]);
+            order_[i] = (uint32_t)i;
+        }
+    });
+
+    if (n > 0) {
+        nodes_.reserve(2 * (n + options.leafSize - 1) / options.leafSize);
+        buildNode(0, (uint32_t)n);
+        permuteSplats(cloud, order_.data());
+    }
+
+    for (const Node& node : nodes_) {
+        if (node.right == 0) stats_.leaves++;
+    }
+    stats_.nodes = nodes_.size();
+    stats_.bytes = nodes_.capacity() * sizeof(Node);
+
+    // The scratch is only needed while building.
+    std::vector<float>().swap(centre_);
+    std::vector<float>().swap(extent_);
+    std::vector<uint32_t>().swap(order_);
+    stats_.buildMs = msSince(t0);
+    return true;
+}
+
+uint32_t SplatBvh::buildNode(uint32_t begin, uint32_t end) {
+    const uint32_t index = (uint32_t)nodes_.size();
+    nodes_.push_back(Node{});
+    const uint32_t count = end - begin;
+
+    if (count <= options.leafSize) {
+        Node node{};
+        node.begin = begin;
+        node.count = count;
+        for (int k = 0; k < 3; k++) {
+            node.min[k] = INFINITY;
+            node.max[k] = -INFINITY;
+        }
+        for (uint32_t j = begin; j < end; j++) {
+            const float* c = &centre_[order_[j] * 3];
+            const float* e = &extent_[order_[j] * 3];
+            for (int k = 0; k < 3; k++) {
+                node.min[k] = std::min(node.min[k], c[k] - e[k]);
+                node.max[k] = std::max(node.max[k], c[k] + e[k]);
+            }
+        }
+        nodes_[index] = node;
+        return index;
+    }
+
+    // Split the longest axis of the centroid bounds.
+    float cmin[3] = { INFINITY, INFINITY, INFINITY };
+    float cmax[3] = { -INFINITY, -INFINITY, -INFINITY };
+    for (uint32_t j = begin; j < end; j++) {
+        const float* c = &centre_[order_[j] * 3];
+        for (int k = 0; k < 3; k++) {
+            cmin[k] = std::min(cmin[k], c[k]);
+            cmax[k] = std::max(cmax[k], c[k]);
+        }
+    }
+    int axis = 0;
+    for (int k = 1; k < 3; k++) {
+        if (cmax[k] - cmin[k] > cmax[axis] - cmin[axis]) axis = k;
+    }
+
+    // Median rounded up to a whole number of leaves.
+    const uint32_t leaves = (count + options.leafSize - 1) / options.leafSize;
+    const uint32_t mid = begin + (leaves + 1) / 2 * options.leafSize;
+    std::nth_element(order_.begin() + begin, order_.begin() + mid, order_.begin() + end,
+                     [&](uint32_t a, uint32_t b) { return centre_[a * 3 + axis] < centre_[b * 3 + axis]; });
+
+    buildNode(begin, mid);
+    const uint32_t right = buildNode(mid, end);
+
+    const Node& l = nodes_[index + 1];
+    const Node& r = nodes_[right];
+    Node node{};
+    node.begin = begin;
+    node.count = count;
+    node.right = right;
+    for (int k = 0; k < 3; k++) {
+        node.min[k] = std::min(l.min[k], r.min[k]);
+        node.max[k] = std::max(l.max[k], r.max[k]);
+    }
+    nodes_[index] = node;
+    return index;
+}
+
+void SplatBvh::query(const Frustum& frustum, std::vector<SplatRange>& out) {
+    GS_TRACE_SCOPE("SplatBvh::query");
+    auto t0 = Clock::now();
+    out.clear();
+    queryStats_ = QueryStats{};
+    if (nodes_.empty()) return;
+
+    auto emit = [&](const Node& node) {
+        queryStats_.visibleSplats += node.count;
+        if (!out.empty() && out.back().end == node.begin) {
+            out.back().end = node.begin + node.count;
+        } else {
+            out.push_back(SplatRange{ node.begin, node.begin + node.count });
+        }
+    };
+
+    // Depth-first, left child first, so ranges come out ascending.
+    stack_.clear();
+    stack_.push_back(0);
+    while (!stack_.empty()) {
+        const uint32_t index = stack_.back();
+        stack_.pop_back();
+        const Node& node = nodes_[index];
+        queryStats_.nodesTested++;
+
+        if (!frustum.intersects(node.min, node.max)) continue;
+        if (node.right == 0 || frustum.contains(node.min, node.max)) {
+            emit(node);
+            continue;
+        }
+        stack_.push_back(node.right);
+        stack_.push_back(index + 1);
+    }
+
+    queryStats_.ranges = out.size();
+    queryStats_.culledFraction = count_ ? 1.f - (float)queryStats_.visibleSplats / (float)count_ : 0.f;
+    queryStats_.ms = msSince(t0);
+}
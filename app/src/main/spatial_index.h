@@ -0,0 +1,79 @@
+#pragma once
+
+#include "camera.h"
+#include "splat_cloud.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Bounding volume hierarchy over a splat cloud, built once at load time.
+//
+// Building reorders the cloud so every leaf is a contiguous chunk of at most
+// `leafSize` splats and every subtree is a contiguous range. Splat bounds
+// are the axis-aligned box of the 3-sigma ellipsoid. A frustum query then
+// returns the visible splat ranges, so culled chunks never reach projection
+// or sorting. Splits are at the centroid median of the longest axis, rounded
+// so that leaves stay full.
+class SplatBvh {
+public:
+    struct Options {
+        uint32_t leafSize = 256;
+    };
+
+    struct Node {
+        float min[3];
+        float max[3];
+        uint32_t begin; // splat range covered by the subtree
+        uint32_t count;
+        uint32_t right; // right child index, 0 for leaves; left is this + 1
+    };
+
+    struct Stats {
+        double buildMs = 0.0;
+        size_t nodes = 0;
+        size_t leaves = 0;
+        size_t bytes = 0; // node storage
+    };
+
+    struct QueryStats {
+        double ms = 0.0;
+        size_t nodesTested = 0;
+        size_t visibleSplats = 0;
+        size_t ranges = 0;
+        float culledFraction = 0.f; // of all splats
+    };
+
+    Options options;
+
+    // Builds the hierarchy and reorders `cloud` to match it. Splat bounds
+    // need scale and rotation, so fails (leaving the index empty) when the
+    // cloud has released them.
+    bool build(SplatCloud& cloud, std::string* error = nullptr);
+    void clear();
+
+    // Appends the splat ranges that may intersect `frustum` to `out`
+    // (cleared first). Adjacent ranges are merged and come out ascending.
+    void query(const Frustum& frustum, std::vector<SplatRange>& out);
+
+    const std::vector<Node>& nodes() const { return nodes_; }
+    size_t splatCount() const { return count_; }
+    const Stats& stats() const { return stats_; }
+    const QueryStats& queryStats() const { return queryStats_; }
+
+private:
+    uint32_t buildNode(uint32_t begin, uint32_t end);
+
+    std::vector<Node> nodes_;
+    size_t count_ = 0;
+
+    // Build scratch: per splat box centre and half extent, and the order.
+    std::vector<float> centre_;
+    std::vector<float> extent_;
+    std::vector<uint32_t> order_;
+    std::vector<uint32_t> stack_;
+
+    Stats stats_;
+    QueryStats queryStats_;
+};
@@ -0,0 +1,170 @@
+#include "splat_cloud.h"
+#include "thread_pool.h"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+void SplatCloud::resize(size_t n, uint32_t restCoeffs) {
+    count = n;
+    shRestCoeffs = restCoeffs;
+
+    for (auto& a : pos) a.resize(n);
+    for (auto& a : scale) a.resize(n);
+    for (auto& a : rot) a.resize(n);
+    opacity.resize(n);
+    for (auto& a : shDc) a.resize(n);
+    shRest.resize(n * 3 * (size_t)restCoeffs);
+}
+
+void SplatCloud::clear() {
+    count = 0;
+    shRestCoeffs = 0;
+
+    for (auto& a : pos) a.reset();
+    for (auto& a : scale) a.reset();
+    for (auto& a : rot) a.reset();
+    opacity.reset();
+    for (auto& a : shDc) a.reset();
+    shRest.reset();
+}
+
+void SplatCloud::releaseShape() {
+    for (auto& a : scale) a.reset();
+    for (auto& a : rot) a.reset();
+}
+
+uint32_t SplatCloud::shDegree() const {
+    return shDegreeForRestCoeffs(shRestCoeffs);
+}
+
+size_t SplatCloud::bytes() const {
+    size_t total = opacity.bytes() + shRest.bytes();
+    for (const auto& a : pos) total += a.bytes();
+    for (const auto& a : scale) total += a.bytes();
+    for (const auto& a : rot) total += a.bytes();
+    for (const auto& a : shDc) total += a.bytes();
+    return total;
+}
+
+uint32_t shRestCoeffsForDegree(uint32_t degree) {
+    return (degree + 1) * (degree + 1) - 1;
+}
+
+uint32_t shDegreeForRestCoeffs(uint32_t coeffs) {
+    if (coeffs >= 15) return 3;
+    if (coeffs >= 8) return 2;
+    if (coeffs >= 3) return 1;
+    return 0;
+}
+
+void activateSplats(SplatCloud& cloud, size_t begin, size_t end) {
+    float* sx = cloud.scale[0].data();
+    float* sy = cloud.scale[1].data();
+    float* sz = cloud.scale[2].data();
+    for (size_t i = begin; i < end; i++) {
+        sx[i] = std::exp(sx[i]);
+        sy[i] = std::exp(sy[i]);
+        sz[i] = std::exp(sz[i]);
+    }
+
+    float* op = cloud.opacity.data();
+    for (size_t i = begin; i < end; i++) {
+        op[i] = 1.f / (1.f + std::exp(-op[i]));
+    }
+
+    float* qw = cloud.rot[0].data();
+    float* qx = cloud.rot[1].data();
+    float* qy = cloud.rot[2].data();
+    float* qz = cloud.rot[3].data();
+    for (size_t i = begin; i < end; i++) {
+        float n2 = qw[i] * qw[i] + qx[i] * qx[i] + qy[i] * qy[i] + qz[i] * qz[i];
+        if (n2 > 1e-20f) {
+            float inv = 1.f / std::sqrt(n2);
+            qw[i] *= inv;
+            qx[i] *= inv;
+            qy[i] *= inv;
+            qz[i] *= inv;
+        } else {
+            qw[i] = 1.f;
+            qx[i] = qy[i] = qz[i] = 0.f;
+        }
+    }
+}
+
+void permuteSplats(SplatCloud& cloud, const uint32_t* order) {
+    const size_t n = cloud.count;
+    std::vector<float*> planes;
+    for (auto& a : cloud.pos) planes.push_back(a.data());
+    if (cloud.hasShape()) {
+        for (auto& a : cloud.scale) planes.push_back(a.data());
+        for (auto& a : cloud.rot) planes.push_back(a.data());
+    }
+    planes.push_back(cloud.opacity.data());
+    for (auto& a : cloud.shDc) planes.push_back(a.data());
+    for (uint32_t c = 0; c < 3; c++) {
+        for (uint32_t k = 0; k < cloud.shRestCoeffs; k++) planes.push_back(cloud.shRestPlane(c, k));
+    }
+
+    // Gather one plane at a time through a single scratch plane.
+    AlignedArray<float> scratch;
+    scratch.resize(n);
+    ThreadPool& pool = ThreadPool::shared();
+    for (float* plane : planes) {
+        pool.parallelFor(n, 1 << 16, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) scratch[i] = plane[order[i]];
+        });
+        std::memcpy(plane, scratch.data(), n * sizeof(float));
+    }
+}
+
+void compactSplats(SplatCloud& cloud, const uint32_t* keep, size_t n) {
+    const size_t oldCount = cloud.count;
+    AlignedArray<float> scratch;
+    scratch.resize(n);
+    ThreadPool& pool = ThreadPool::shared();
+    auto gather = [&](const float* src, float* dst) {
+        pool.parallelFor(n, 1 << 16, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) scratch[i] = src[keep[i]];
+        });
+        std::memcpy(dst, scratch.data(), n * sizeof(float));
+    };
+
+    for (auto& a : cloud.pos) gather(a.data(), a.data());
+    if (cloud.hasShape()) {
+        for (auto& a : cloud.scale) gather(a.data(), a.data());
+        for (auto& a : cloud.rot) gather(a.data(), a.data());
+    }
+    gather(cloud.opacity.data(), cloud.opacity.data());
+    for (auto& a : cloud.shDc) gather(a.data(), a.data());
+    // Rest planes are packed by count: plane p moves from p * oldCount to
+    // p * n, never past the start of a plane not yet gathered.
+    float* rest = cloud.shRest.data();
+    for (size_t p = 0; p < 3 * (size_t)cloud.shRestCoeffs; p++) gather(rest + p * oldCount, rest + p * n);
+
+    const bool shape = cloud.hasShape();
+    cloud.count = n;
+    for (auto& a : cloud.pos) a.resize(n);
+    if (shape) {
+        for (auto& a : cloud.scale) a.resize(n);
+        for (auto& a : cloud.rot) a.resize(n);
+    }
+    cloud.opacity.resize(n);
+    for (auto& a : cloud.shDc) a.resize(n);
+    cloud.shRest.resize(n * 3 * (size_t)cloud.shRestCoeffs);
+}
+
+void copySplats(const SplatCloud& src, SplatCloud& dst, size_t dstOffset) {
+    const size_t n = src.count;
+    auto copy = [&](const float* from, float* to) { std::memcpy(to + dstOffset, from, n * sizeof(float)); };
+    for (int k = 0; k < 3; k++) copy(src.pos[k].data(), dst.pos[k].data());
+    if (src.hasShape() && dst.hasShape()) {
+        for (int k = 0; k < 3; k++) copy(src.scale[k].data(), dst.scale[k].data());
+        for (int k = 0; k < 4; k++) copy(src.rot[k].data(), dst.rot[k].data());
+    }
+    copy(src.opacity.data(), dst.opacity.data());
+    for (int k = 0; k < 3; k++) copy(src.shDc[k].data(), dst.shDc[k].data());
+    for (uint32_t c = 0; c < 3; c++) {
+        for (uint32_t k = 0; k < src.shRestCoeffs; k++) copy(src.shRestPlane(c, k), dst.shRestPlane(c, k));
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "aligned_array.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Structure-of-arrays store for 3D Gaussians.
+//
+// Every attribute component lives in its own aligned plane of `count` floats,
+// so kernels can stream one component for many splats at a time and each
+// plane can be uploaded to the GPU as-is.
+//
+// Values are stored activated: scales are linear (exp applied), opacity is in
+// [0, 1] (sigmoid applied) and rotations are unit quaternions (w, x, y, z).
+// SH coefficients are kept as exported by 3DGS training.
+struct SplatCloud {
+    static constexpr uint32_t kMaxShRestCoeffs = 15; // degree 3, per channel
+
+    size_t count = 0;
+    uint32_t shRestCoeffs = 0; // per channel: 0, 3, 8 or 15
+
+    AlignedArray<float> pos[3];   // x, y, z
+    AlignedArray<float> scale[3];
+    AlignedArray<float> rot[4];   // w, x, y, z
+    AlignedArray<float> opacity;
+    AlignedArray<float> shDc[3];  // r, g, b
+    // Higher order SH, one plane per (channel, coefficient):
+    // plane c * shRestCoeffs + k holds f_rest_(c * shRestCoeffs + k).
+    AlignedArray<float> shRest;
+
+    // Contents are unspecified after a resize.
+    void resize(size_t n, uint32_t restCoeffs);
+    void clear();
+
+    // Frees scale and rotation, e.g. once a CovarianceStore holds the
+    // shape. Kernels that need them must check hasShape().
+    void releaseShape();
+    bool hasShape() const { return scale[0].size() == count; }
+
+    uint32_t shDegree() const;
+    size_t bytes() const;
+
+    float* shRestPlane(uint32_t channel, uint32_t k) {
+        return shRest.data() + (size_t)(channel * shRestCoeffs + k) * count;
+    }
+    const float* shRestPlane(uint32_t channel, uint32_t k) const {
+        return shRest.data() + (size_t)(channel * shRestCoeffs + k) * count;
+    }
+};
+
+// Half-open range of splat indices [begin, end).
+struct SplatRange {
+    uint32_t begin;
+    uint32_t end;
+};
+
+// Attribute bytes of `n` splats (position, scale, rotation, opacity, DC and
+// rest SH), independent of plane capacities.
+inline uint64_t splatDataBytes(size_t n, uint32_t restCoeffs) {
+    return (uint64_t)n * (14 + 3 * (uint64_t)restCoeffs) * sizeof(float);
+}
+
+// Number of f_rest coefficients per channel for an SH degree, and back.
+uint32_t shRestCoeffsForDegree(uint32_t degree);
+uint32_t shDegreeForRestCoeffs(uint32_t coeffs);
+
+// Converts raw 3DGS values in [begin, end) to their activated form:
+// exp on scales, sigmoid on opacity, normalized quaternions.
+void activateSplats(SplatCloud& cloud, size_t begin, size_t end);
+
+// Reorders every plane so that splat i becomes old splat order[i]. `order`
+// must be a permutation of [0, count).
+void permuteSplats(SplatCloud& cloud, const uint32_t* order);
+
+// Keeps splats keep[0], ..., keep[n - 1] (in that order, each index below
+// count) and drops the rest; planes shrink in place through one scratch
+// plane.
+void compactSplats(SplatCloud& cloud, const uint32_t* keep, size_t n);
+
+// Copies every splat of `src` to [dstOffset, dstOffset + src.count) of `dst`.
+// `dst` must be large enough and have the same shRestCoeffs; shape planes
+// are copied when both clouds have them.
+void copySplats(const SplatCloud& src, SplatCloud& dst, size_t dstOffset);
+
+// SH band 0 constant; DC colour is 0.5 + kShC0 * f_dc.
+constexpr float kShC0 = 0.28209479177387814f;
@@ -0,0 +1,505 @@
+#include "splat_lod.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+// Row-major rotation matrix of a unit quaternion (w, x, y, z).
+static void quatToMatrix(float qw, float qx, float qy, float qz, float r[9]) {
+    r[0] = 1.f - 2.f * (qy * qy + qz * qz);
+    r[1] = 2.f * (qx * qy - qw * qz);
+    r[2] = 2.f * (qx * qz + qw * qy);
+    r[3] = 2.f * (qx * qy + qw * qz);
+    r[4] = 1.f - 2.f * (qx * qx + qz * qz);
+    r[5] = 2.f * (qy * qz - qw * qx);
+    r[6] = 2.f * (qx * qz - qw * qy);
+    r[7] = 2.f * (qy * qz + qw * qx);
+    r[8] = 1.f - 2.f * (qx * qx + qy * qy);
+}
+
+// Unit quaternion (w, x, y, z) of a row-major rotation matrix.
+static void matrixToQuat(const double r[9], float q[4]) {
+    const double trace = r[0] + r[4] + r[8];
+    double w, x, y, z;
+    if (trace > 0.0) {
+        double s = 2.0 * std::sqrt(trace + 1.0);
+        w = 0.25 * s;
+        x = (r[7] - r[5]) / s;
+        y = (r[2] - r[6]) / s;
+        z = (r[3] - r[1]) / s;
+    } else if (r[0] > r[4] && r[0] > r[8]) {
+        double s = 2.0 * std::sqrt(1.0 + r[0] - r[4] - r[8]);
+        w = (r[7] - r[5]) / s;
+        x = 0.25 * s;
+        y = (r[1] + r[3]) / s;
+        z = (r[2] + r[6]) / s;
+    } else if (r[4] > r[8]) {
+        double s = 2.0 * std::sqrt(1.0 + r[4] - r[0] - r[8]);
+        w = (r[2] - r[6]) / s;
+        x = (r[1] + r[3]) / s;
+        y = 0.25 * s;
+        z = (r[5] + r[7]) / s;
+    } else {
+        double s = 2.0 * std::sqrt(1.0 + r[8] - r[0] - r[4]);
+        w = (r[3] - r[1]) / s;
+        x = (r[2] + r[6]) / s;
+        y = (r[5] + r[7]) / s;
+        z = 0.25 * s;
+    }
+    const double n = std::sqrt(w * w + x * x + y * y + z * z);
+    q[0] = (float)(w / n);
+    q[1] = (float)(x / n);
+    q[2] = (float)(y / n);
+    q[3] = (float)(z / n);
+}
+
+// Cyclic Jacobi eigendecomposition of a symmetric 3x3 matrix given as
+// (xx, xy, xz, yy, yz, zz). Eigenvectors end up in the columns of `vec`
+// (row-major) and form a proper rotation.
+static void symmetricEigen3(const double cov[6], double val[3], double vec[9]) {
+    double a[3][3] = {
+        { cov[0], cov[1], cov[2] },
+        { cov[1], cov[3], cov[4] },
+        { cov[2], cov[4], cov[5] },
+    };
+    double v[3][3] = { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+
+    for (int sweep = 0; sweep < 16; sweep++) {
+        const double off = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+        const double diag = a[0][0] * a[0][0] + a[1][1] * a[1][1] + a[2][2] * a[2][2];
+        if (off <= 1e-24 * diag || off == 0.0) break;
+
+        for (int p = 0; p < 2; p++) {
+            for (int q = p + 1; q < 3; q++) {
+                if (a[p][q] == 0.0) continue;
+                const double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+                const double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+                const double c = 1.0 / std::sqrt(t * t + 1.0);
+                const double s = t * c;
+
+                // A' = J^T A J for the rotation J in the (p, q) plane.
+                for (int k = 0; k < 3; k++) {
+                    const double akp = a[k][p], akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < 3; k++) {
+                    const double apk = a[p][k], aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < 3; k++) {
+                    const double vkp = v[k][p], vkq = v[k][q];
+                    v[k][p] = c * vkp - s * vkq;
+                    v[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < 3; i++) val[i] = a[i][i];
+    const double det = v[0][0] * (v[1][1] * v[2][2] - v[1][2] * v[2][1]) -
+                       v[0][1] * (v[1][0] * v[2][2] - v[1][2] * v[2][0]) +
+                       v[0][2] * (v[1][0] * v[2][1] - v[1][1] * v[2][0]);
+    if (det < 0.0) {
+        for (int k = 0; k < 3; k++) v[k][2] = -v[k][2];
+    }
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) vec[r * 3 + c] = v[r][c];
+    }
+}
+
+// Reads splat `i` of either the base cloud or the parents cloud.
+struct NodeSource {
+    const SplatCloud* base;
+    SplatCloud* parents;
+
+    const SplatCloud& cloud(uint32_t node) const {
+        return node < base->count ? *base : *parents;
+    }
+    size_t index(uint32_t node) const {
+        return node < base->count ? node : node - base->count;
+    }
+};
+
+// Projected-area proxy of an ellipsoid with these axis lengths.
+static float areaProxy(float s0, float s1, float s2) {
+    return s0 * s1 + s1 * s2 + s0 * s2;
+}
+
+} // namespace
+
+void SplatLod::clear() {
+    base_ = nullptr;
+    parents_.clear();
+    parent_.clear();
+    firstChild_.clear();
+    childCount_.clear();
+    sphere_.clear();
+    stats_ = Stats{};
+}
+
+bool SplatLod::build(const SplatCloud& base, std::string* error) {
+    auto t0 = Clock::now();
+    clear();
+    if (!base.hasShape()) {
+        if (error) *error = "cloud has no scale or rotation";
+        return false;
+    }
+    base_ = &base;
+
+    const size_t n = base.count;
+    const uint32_t b = std::max<uint32_t>(2, std::min<uint32_t>(options.branching, 255));
+    if (n == 0) return true;
+
+    // Level extents in node ids.
+    std::vector<size_t> levelStart = { 0, n };
+    size_t total = n;
+    for (size_t cur = n; cur > 1;) {
+        cur = (cur + b - 1) / b;
+        total += cur;
+        levelStart.push_back(total);
+    }
+    stats_.levels = (uint32_t)levelStart.size() - 1;
+
+    parents_.resize(total - n, base.shRestCoeffs);
+    parent_.assign(total, kNone);
+    firstChild_.assign(total, kNone);
+    childCount_.assign(total, 0);
+    sphere_.resize(total * 4);
+
+    ThreadPool& pool = ThreadPool::shared();
+    pool.parallelFor(n, 1 << 14, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            float* s = &sphere_[i * 4];
+            for (int k = 0; k < 3; k++) s[k] = base.pos[k][i];
+            s[3] = 3.f * std::max(base.scale[0][i], std::max(base.scale[1][i], base.scale[2][i]));
+        }
+    });
+
+    const NodeSource src{ &base, &parents_ };
+    const uint32_t rest = base.shRestCoeffs * 3;
+
+    for (size_t level = 1; level + 1 < levelStart.size(); level++) {
+        const size_t childBegin = levelStart[level - 1];
+        const size_t childEnd = levelStart[level];
+        const size_t nodeBegin = levelStart[level];
+        const size_t count = levelStart[level + 1] - nodeBegin;
+
+        pool.parallelFor(count, 256, [&](size_t gBegin, size_t gEnd) {
+            std::vector<float> weights(b);
+            for (size_t g = gBegin; g < gEnd; g++) {
+                const uint32_t id = (uint32_t)(nodeBegin + g);
+                const uint32_t first = (uint32_t)(childBegin + g * b);
+                const uint32_t last = (uint32_t)std::min(childEnd, (size_t)first + b);
+                firstChild_[id] = first;
+                childCount_[id] = (uint8_t)(last - first);
+
+                // Weights: opacity x area, so faint or tiny children count less.
+                double wsum = 0.0;
+                for (uint32_t c = first; c < last; c++) {
+                    const SplatCloud& cc = src.cloud(c);
+                    const size_t ci = src.index(c);
+                    weights[c - first] = cc.opacity[ci] * areaProxy(cc.scale[0][ci], cc.scale[1][ci], cc.scale[2][ci]);
+                    wsum += weights[c - first];
+                    parent_[c] = id;
+                }
+                // Fully transparent children still place the parent, with
+                // uniform weights, but leave it transparent too.
+                const double opacityArea = wsum;
+                if (wsum <= 0.0) {
+                    std::fill(weights.begin(), weights.end(), 1.f);
+                    wsum = (double)(last - first);
+                }
+
+                double mean[3] = { 0.0, 0.0, 0.0 };
+                for (uint32_t c = first; c < last; c++) {
+                    const SplatCloud& cc = src.cloud(c);
+                    const size_t ci = src.index(c);
+                    for (int k = 0; k < 3; k++) mean[k] += weights[c - first] * cc.pos[k][ci];
+                }
+                for (int k = 0; k < 3; k++) mean[k] /= wsum;
+
+                // Sum of w * (Sigma_i + d d^T), d = mu_i - mu.
+                double cov[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+                float radius = 0.f;
+                for (uint32_t c = first; c < last; c++) {
+                    const SplatCloud& cc = src.cloud(c);
+                    const size_t ci = src.index(c);
+                    const double w = weights[c - first];
+                    float r[9];
+                    quatToMatrix(cc.rot[0][ci], cc.rot[1][ci], cc.rot[2][ci], cc.rot[3][ci], r);
+                    const float s[3] = { cc.scale[0][ci], cc.scale[1][ci], cc.scale[2][ci] };
+                    float m[9];
+                    for (int row = 0; row < 3; row++) {
+                        for (int col = 0; col < 3; col++) m[row * 3 + col] = r[row * 3 + col] * s[col];
+                    }
+                    const double d[3] = { cc.pos[0][ci] - mean[0], cc.pos[1][ci] - mean[1], cc.pos[2][ci] - mean[2] };
+                    const int idx[6][2] = { { 0, 0 }, { 0, 1 }, { 0, 2 }, { 1, 1 }, { 1, 2 }, { 2, 2 } };
+                    for (int e = 0; e < 6; e++) {
+                        const int p = idx[e][0], q = idx[e][1];
+                        const double sigma = m[p * 3 + 0] * m[q * 3 + 0] + m[p * 3 + 1] * m[q * 3 + 1] + m[p * 3 + 2] * m[q * 3 + 2];
+                        cov[e] += w * (sigma + d[p] * d[q]);
+                    }
+
+                    const float* cs = &sphere_[(size_t)c * 4];
+                    const float dist = (float)std::sqrt((cs[0] - mean[0]) * (cs[0] - mean[0]) +
+                                                        (cs[1] - mean[1]) * (cs[1] - mean[1]) +
+                                                        (cs[2] - mean[2]) * (cs[2] - mean[2]));
+                    radius = std::max(radius, dist + cs[3]);
+                }
+                for (double& e : cov) e /= wsum;
+
+                double val[3], vec[9];
+                symmetricEigen3(cov, val, vec);
+                float scale[3];
+                for (int k = 0; k < 3; k++) scale[k] = (float)std::sqrt(std::max(val[k], 1e-12));
+                float q[4];
+                matrixToQuat(vec, q);
+
+                const size_t pi = id - n;
+                for (int k = 0; k < 3; k++) {
+                    parents_.pos[k][pi] = (float)mean[k];
+                    parents_.scale[k][pi] = scale[k];
+                }
+                for (int k = 0; k < 4; k++) parents_.rot[k][pi] = q[k];
+                // Keeps sum(opacity x area) of the children, capped at opaque.
+                parents_.opacity[pi] = (float)std::min(1.0, opacityArea / std::max(1e-20f, areaProxy(scale[0], scale[1], scale[2])));
+
+                for (int ch = 0; ch < 3; ch++) {
+                    double dc = 0.0;
+                    for (uint32_t c = first; c < last; c++) dc += weights[c - first] * src.cloud(c).shDc[ch][src.index(c)];
+                    parents_.shDc[ch][pi] = (float)(dc / wsum);
+                }
+                for (uint32_t k = 0; k < rest; k++) {
+                    double acc = 0.0;
+                    for (uint32_t c = first; c < last; c++) {
+                        const SplatCloud& cc = src.cloud(c);
+                        acc += weights[c - first] * cc.shRest[(size_t)k * cc.count + src.index(c)];
+                    }
+                    parents_.shRest[(size_t)k * parents_.count + pi] = (float)(acc / wsum);
+                }
+
+                float* ps = &sphere_[(size_t)id * 4];
+                for (int k = 0; k < 3; k++) ps[k] = (float)mean[k];
+                ps[3] = radius;
+            }
+        });
+    }
+
+    stats_.nodes = total;
+    stats_.bytes = parents_.bytes() + parent_.capacity() * sizeof(uint32_t) +
+                   firstChild_.capacity() * sizeof(uint32_t) + childCount_.capacity() +
+                   sphere_.capacity() * sizeof(float);
+    stats_.buildMs = msSince(t0);
+    return true;
+}
+
+void SplatLodCut::update(const SplatLod& lod, const Camera& camera) {
+    auto t0 = Clock::now();
+    stats_ = Stats{};
+
+    const size_t nodes = lod.nodeCount();
+    if (lod_ != &lod || lodNodes_ != nodes) {
+        lod_ = &lod;
+        lodNodes_ = nodes;
+        cut_.clear();
+        stamp_.assign(nodes, 0);
+        seen_.assign(nodes, 0);
+        dropped_.assign(nodes, 0);
+        frame_ = 0;
+        threshold_ = options.minPixelThreshold;
+    }
+    visible_.clear();
+    if (nodes == 0) return;
+    if (cut_.empty()) cut_.push_back(lod.root());
+
+    // Stamp 0 means "never seen"; skip it when the counter wraps. Each
+    // update takes two: one per count of the cut's sibling groups.
+    auto nextStamp = [&]() {
+        if (++frame_ == 0) {
+            std::fill(stamp_.begin(), stamp_.end(), 0);
+            std::fill(dropped_.begin(), dropped_.end(), 0);
+            frame_ = 1;
+        }
+        return frame_;
+    };
+    nextStamp();
+
+    const Frustum frustum = camera.frustum();
+    float eye[3];
+    camera.position(eye);
+    const float focal = std::max(camera.fx, camera.fy);
+    const float tau = threshold_;
+
+    auto outside = [&](uint32_t node) {
+        const float* s = &lod.sphere_[(size_t)node * 4];
+        for (const auto& p : frustum.planes) {
+            if (p[0] * s[0] + p[1] * s[1] + p[2] * s[2] + p[3] < -s[3]) return true;
+        }
+        return false;
+    };
+    // Projected diameter bound in pixels; huge when the eye is inside.
+    auto pixels = [&](uint32_t node) {
+        const float* s = &lod.sphere_[(size_t)node * 4];
+        const float dx = s[0] - eye[0], dy = s[1] - eye[1], dz = s[2] - eye[2];
+        const float dist = std::sqrt(dx * dx + dy * dy + dz * dz) - s[3];
+        return dist <= camera.znear ? INFINITY : 2.f * focal * s[3] / dist;
+    };
+    auto wantsRefine = [&](uint32_t node) {
+        return !lod.isLeaf(node) && !outside(node) && pixels(node) > tau;
+    };
+
+    // Count each parent's children present in the cut.
+    for (uint32_t node : cut_) {
+        const uint32_t p = lod.parentOf(node);
+        if (p == SplatLod::kNone) continue;
+        if (stamp_[p] != frame_) {
+            stamp_[p] = frame_;
+            seen_[p] = 0;
+        }
+        seen_[p]++;
+    }
+
+    next_.clear();
+    for (uint32_t node : cut_) {
+        const uint32_t p = lod.parentOf(node);
+        if (p != SplatLod::kNone && seen_[p] == lod.childCount(p)) {
+            if (outside(p) || pixels(p) <= tau) {
+                next_.push_back(p);
+                stats_.collapsed++;
+                seen_[p] = kCollapsed;
+                continue;
+            }
+        } else if (p != SplatLod::kNone && seen_[p] == kCollapsed) {
+            continue; // a sibling already collapsed into the parent
+        }
+        next_.push_back(node);
+    }
+
+    // The budget holds within the frame: either collapse the smallest whole
+    // sibling groups until it fits, or refine the largest nodes first until
+    // the next one would not fit. Nodes leave next_ by their dropped_ stamp.
+    const uint32_t stamp = nextStamp();
+    size_t visible = 0;
+    for (uint32_t node : next_) visible += outside(node) ? 0 : 1;
+    auto visibleChildren = [&](uint32_t node) {
+        size_t count = 0;
+        const uint32_t first = lod.firstChild(node);
+        for (uint32_t c = first; c < first + lod.childCount(node); c++) count += outside(c) ? 0 : 1;
+        return count;
+    };
+    auto larger = [](const HeapEntry& a, const HeapEntry& b) { return a.pixels > b.pixels; };
+    auto smaller = [](const HeapEntry& a, const HeapEntry& b) { return a.pixels < b.pixels; };
+    heap_.clear();
+
+    if (visible > options.budget) {
+        auto countChild = [&](uint32_t node) {
+            const uint32_t p = lod.parentOf(node);
+            if (p == SplatLod::kNone) return;
+            if (stamp_[p] != stamp) {
+                stamp_[p] = stamp;
+                seen_[p] = 0;
+            }
+            if (++seen_[p] == lod.childCount(p)) {
+                heap_.push_back(HeapEntry{ outside(p) ? 0.f : pixels(p), p });
+                std::push_heap(heap_.begin(), heap_.end(), larger);
+            }
+        };
+        for (uint32_t node : next_) countChild(node);
+        float collapsedPixels = tau;
+        while (visible > options.budget && !heap_.empty()) {
+            std::pop_heap(heap_.begin(), heap_.end(), larger);
+            const HeapEntry e = heap_.back();
+            heap_.pop_back();
+            const uint32_t first = lod.firstChild(e.node);
+            for (uint32_t c = first; c < first + lod.childCount(e.node); c++) dropped_[c] = stamp;
+            visible = visible - visibleChildren(e.node) + (outside(e.node) ? 0 : 1);
+            next_.push_back(e.node);
+            stats_.collapsed++;
+            collapsedPixels = std::max(collapsedPixels, e.pixels);
+            countChild(e.node);
+        }
+        // Groups this small collapse by themselves from next frame on.
+        threshold_ = collapsedPixels;
+    } else {
+        for (uint32_t node : next_) {
+            if (wantsRefine(node)) heap_.push_back(HeapEntry{ pixels(node), node });
+        }
+        std::make_heap(heap_.begin(), heap_.end(), smaller);
+        bool full = false;
+        while (!heap_.empty()) {
+            const HeapEntry e = heap_.front();
+            const size_t after = visible - 1 + visibleChildren(e.node);
+            if (after > options.budget) {
+                // Only nodes larger than this one want refining next frame.
+                threshold_ = e.pixels;
+                full = true;
+                break;
+            }
+            std::pop_heap(heap_.begin(), heap_.end(), smaller);
+            heap_.pop_back();
+            dropped_[e.node] = stamp;
+            visible = after;
+            stats_.refined++;
+            const uint32_t first = lod.firstChild(e.node);
+            for (uint32_t c = first; c < first + lod.childCount(e.node); c++) {
+                next_.push_back(c);
+                if (wantsRefine(c)) {
+                    heap_.push_back(HeapEntry{ pixels(c), c });
+                    std::push_heap(heap_.begin(), heap_.end(), smaller);
+                }
+            }
+        }
+        // Everything above the threshold fit: let finer nodes in again.
+        if (!full && (double)visible < 0.8 * (double)options.budget) threshold_ *= 0.5f;
+    }
+    threshold_ = std::min(options.maxPixelThreshold, std::max(options.minPixelThreshold, threshold_));
+
+    cut_.clear();
+    for (uint32_t node : next_) {
+        if (dropped_[node] == stamp) continue;
+        cut_.push_back(node);
+        if (!outside(node)) visible_.push_back(node);
+    }
+
+    stats_.cut = cut_.size();
+    stats_.visible = visible_.size();
+    stats_.pixelThreshold = tau;
+    stats_.ms = msSince(t0);
+}
+
+void SplatLodCut::gather(const SplatLod& lod, SplatCloud& out) const {
+    const SplatCloud& base = *lod.base_;
+    const SplatCloud& parents = lod.parents_;
+    const size_t n = visible_.size();
+    out.resize(n, base.shRestCoeffs);
+
+    auto copyPlane = [&](float* dst, const float* fromBase, const float* fromParents) {
+        ThreadPool::shared().parallelFor(n, 1 << 14, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                const uint32_t node = visible_[i];
+                dst[i] = node < base.count ? fromBase[node] : fromParents[node - base.count];
+            }
+        });
+    };
+    for (int k = 0; k < 3; k++) copyPlane(out.pos[k].data(), base.pos[k].data(), parents.pos[k].data());
+    for (int k = 0; k < 3; k++) copyPlane(out.scale[k].data(), base.scale[k].data(), parents.scale[k].data());
+    for (int k = 0; k < 4; k++) copyPlane(out.rot[k].data(), base.rot[k].data(), parents.rot[k].data());
+    copyPlane(out.opacity.data(), base.opacity.data(), parents.opacity.data());
+    for (int k = 0; k < 3; k++) copyPlane(out.shDc[k].data(), base.shDc[k].data(), parents.shDc[k].data());
+    for (uint32_t c = 0; c < 3; c++) {
+        for (uint32_t k = 0; k < base.shRestCoeffs; k++) {
+            copyPlane(out.shRestPlane(c, k), base.shRestPlane(c, k), parents.shRestPlane(c, k));
+        }
+    }
+}
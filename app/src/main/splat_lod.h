@@ -0,0 +1,137 @@
+#pragma once
+
+#include "camera.h"
+#include "splat_cloud.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Level-of-detail hierarchy over a splat cloud.
+//
+// The base cloud must already be in a spatially coherent order (SplatBvh
+// leaves it that way). Each level merges runs of `branching` consecutive
+// nodes of the level below into one parent Gaussian by moment matching:
+// weighted mean and covariance (spread of the children included), opacity
+// conserving opacity x area, and weighted SH. Parents are stored in their
+// own SplatCloud next to the base cloud.
+//
+// Node ids: [0, base.count) are base splats, the rest index `parents()`
+// with id - base.count, level by level up to the root.
+class SplatLod {
+public:
+    static constexpr uint32_t kNone = ~0u;
+
+    struct Options {
+        uint32_t branching = 4;
+    };
+
+    struct Stats {
+        double buildMs = 0.0;
+        uint32_t levels = 0; // including the base level
+        size_t nodes = 0;
+        size_t bytes = 0;    // parents cloud plus node arrays
+    };
+
+    Options options;
+
+    // Builds the hierarchy for `base`, which must outlive this object.
+    // Moment matching needs scale and rotation, so fails (leaving the
+    // hierarchy empty) when `base` has released them.
+    bool build(const SplatCloud& base, std::string* error = nullptr);
+    void clear();
+
+    const SplatCloud& parents() const { return parents_; }
+    size_t nodeCount() const { return parent_.size(); }
+    uint32_t root() const { return parent_.empty() ? kNone : (uint32_t)parent_.size() - 1; }
+    uint32_t parentOf(uint32_t node) const { return parent_[node]; }
+    uint32_t firstChild(uint32_t node) const { return firstChild_[node]; }
+    uint32_t childCount(uint32_t node) const { return childCount_[node]; }
+    bool isLeaf(uint32_t node) const { return childCount_[node] == 0; }
+
+    const Stats& stats() const { return stats_; }
+
+private:
+    friend class SplatLodCut;
+
+    const SplatCloud* base_ = nullptr;
+    SplatCloud parents_;
+
+    std::vector<uint32_t> parent_;
+    std::vector<uint32_t> firstChild_;
+    std::vector<uint8_t> childCount_;
+    // Bounding sphere of the node's 3-sigma extent (subtree included).
+    std::vector<float> sphere_; // x, y, z, radius
+
+    Stats stats_;
+};
+
+// Per-frame cut through a SplatLod: the set of nodes rendered this frame.
+//
+// A node is refined into its children while its bounding sphere projects
+// larger than `pixelThreshold`; siblings collapse back into their parent once
+// it projects smaller. Updates start from last frame's cut, so the cost
+// scales with the cut rather than the scene. Nodes outside the frustum
+// collapse and are not emitted.
+//
+// The visible cut never exceeds `budget`: refinement takes the largest
+// nodes first and stops at the first one that would not fit, and a cut that
+// is over budget (say after a camera cut) collapses its smallest sibling
+// groups, as many levels as needed. The threshold follows where either
+// stopped, so the next frame starts close to the budget.
+class SplatLodCut {
+public:
+    struct Options {
+        size_t budget = 1u << 20;     // target visible splats
+        float minPixelThreshold = 1.f; // never refine below this size
+        float maxPixelThreshold = 256.f;
+    };
+
+    struct Stats {
+        double ms = 0.0;
+        size_t cut = 0;     // nodes in the cut, culled included
+        size_t visible = 0; // nodes emitted
+        size_t refined = 0;
+        size_t collapsed = 0;
+        float pixelThreshold = 0.f;
+    };
+
+    Options options;
+
+    // Updates the cut for `camera`. Resets when the hierarchy changed.
+    void update(const SplatLod& lod, const Camera& camera);
+    void reset() { cut_.clear(); }
+
+    // Visible cut nodes (SplatLod node ids).
+    const std::vector<uint32_t>& visible() const { return visible_; }
+
+    // Copies the visible cut into `out` as a renderable cloud.
+    void gather(const SplatLod& lod, SplatCloud& out) const;
+
+    const Stats& stats() const { return stats_; }
+
+private:
+    static constexpr uint32_t kCollapsed = ~0u;
+
+    struct HeapEntry {
+        float pixels;
+        uint32_t node;
+    };
+
+    std::vector<uint32_t> cut_;
+    std::vector<uint32_t> next_;
+    std::vector<uint32_t> visible_;
+    std::vector<HeapEntry> heap_;
+    // Per node: stamp and number of its children seen in the cut, and the
+    // stamp of the update that took it out of the cut.
+    std::vector<uint32_t> stamp_;
+    std::vector<uint32_t> seen_;
+    std::vector<uint32_t> dropped_;
+    uint32_t frame_ = 0;
+    const SplatLod* lod_ = nullptr;
+    size_t lodNodes_ = 0;
+    float threshold_ = 0.f;
+
+    Stats stats_;
+};
@@ -0,0 +1,315 @@
+#include "splat_projection.h"
+#include "covariance_store.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Lane abstraction so one kernel body runs 8 or 4 wide and on the tail.
+struct Lanes8 {
+    using V = simd::f32x8;
+    using M = simd::f32x8;
+    static constexpr size_t kWidth = 8;
+    static V load(const float* p) { return simd::load8(p); }
+    static void store(float* p, V v) { simd::store(p, v); }
+    static V set1(float x) { return simd::set1x8(x); }
+    static V min(V a, V b) { return simd::min(a, b); }
+    static V max(V a, V b) { return simd::max(a, b); }
+    static V sqrt(V a) { return simd::sqrt(a); }
+    static V floor(V a) { return simd::floor(a); }
+    static M cmpLt(V a, V b) { return simd::cmpLt(a, b); }
+    static M cmpLe(V a, V b) { return simd::cmpLe(a, b); }
+    static M cmpGe(V a, V b) { return simd::cmpGe(a, b); }
+    static M maskAnd(M a, M b) { return simd::maskAnd(a, b); }
+    static uint32_t laneMask(M m) { return simd::laneMask(m); }
+};
+
+struct Lanes4 {
+    using V = simd::f32x4;
+    using M = simd::f32x4;
+    static constexpr size_t kWidth = 4;
+    static V load(const float* p) { return simd::load(p); }
+    static void store(float* p, V v) { simd::store(p, v); }
+    static V set1(float x) { return simd::set1(x); }
+    static V min(V a, V b) { return simd::min(a, b); }
+    static V max(V a, V b) { return simd::max(a, b); }
+    static V sqrt(V a) { return simd::sqrt(a); }
+    static V floor(V a) { return simd::floor(a); }
+    static M cmpLt(V a, V b) { return simd::cmpLt(a, b); }
+    static M cmpLe(V a, V b) { return simd::cmpLe(a, b); }
+    static M cmpGe(V a, V b) { return simd::cmpGe(a, b); }
+    static M maskAnd(M a, M b) { return simd::maskAnd(a, b); }
+    static uint32_t laneMask(M m) { return simd::laneMask(m); }
+};
+
+struct ScalarLanes {
+    using V = float;
+    using M = bool;
+    static constexpr size_t kWidth = 1;
+    static V load(const float* p) { return *p; }
+    static void store(float* p, V v) { *p = v; }
+    static V set1(float x) { return x; }
+    static V min(V a, V b) { return a < b ? a : b; }
+    static V max(V a, V b) { return a > b ? a : b; }
+    static V sqrt(V a) { return std::sqrt(a); }
+    static V floor(V a) { return std::floor(a); }
+    static M cmpLt(V a, V b) { return a < b; }
+    static M cmpLe(V a, V b) { return a <= b; }
+    static M cmpGe(V a, V b) { return a >= b; }
+    static M maskAnd(M a, M b) { return a && b; }
+    static uint32_t laneMask(M m) { return m ? 1u : 0u; }
+};
+
+// Runs whole groups of L::kWidth splats from `begin`; returns where it
+// stopped. `written` counts the outputs so far.
+template <typename L>
+static size_t projectRun(const ProjectionView& view, const ProjectionInput& in, size_t begin, size_t end,
+                         const ProjectionOutput& out, size_t& written) {
+    using V = typename L::V;
+    using M = typename L::M;
+    constexpr size_t W = L::kWidth;
+
+    V R[9], Tr[3];
+    for (int k = 0; k < 9; k++) R[k] = L::set1(view.rot[k]);
+    for (int k = 0; k < 3; k++) Tr[k] = L::set1(view.trans[k]);
+    const V fx = L::set1(view.fx), fy = L::set1(view.fy), negFx = L::set1(-view.fx), negFy = L::set1(-view.fy);
+    const V cx = L::set1(view.cx), cy = L::set1(view.cy);
+    const V znear = L::set1(view.znear), zfar = L::set1(view.zfar);
+    const V limX = L::set1(view.limX), limY = L::set1(view.limY);
+    const V negLimX = L::set1(-view.limX), negLimY = L::set1(-view.limY);
+    const V cullW = L::set1(view.cullWidth), cullH = L::set1(view.cullHeight);
+    const V zero = L::set1(0.f), one = L::set1(1.f), two = L::set1(2.f), half = L::set1(0.5f);
+    const V three = L::set1(3.f), lowPass = L::set1(0.3f), minDisc = L::set1(0.1f), minusOne = L::set1(-1.f);
+
+    size_t i = begin;
+    for (; i + W <= end; i += W) {
+        const V px = L::load(in.pos[0] + i), py = L::load(in.pos[1] + i), pz = L::load(in.pos[2] + i);
+        const V t0 = R[0] * px + R[1] * py + R[2] * pz + Tr[0];
+        const V t1 = R[3] * px + R[4] * py + R[5] * pz + Tr[1];
+        const V t2 = R[6] * px + R[7] * py + R[8] * pz + Tr[2];
+        M keep = L::maskAnd(L::cmpGe(t2, znear), L::cmpLe(t2, zfar));
+        if (!L::laneMask(keep)) continue;
+
+        V cov[6];
+        if (in.covariances) {
+            alignas(32) float lanes[6][W];
+            for (size_t l = 0; l < W; l++) {
+                float c[6];
+                in.covariances->get(i + l, c);
+                for (int k = 0; k < 6; k++) lanes[k][l] = c[k];
+            }
+            for (int k = 0; k < 6; k++) cov[k] = L::load(lanes[k]);
+        } else {
+            const V qw = L::load(in.rot[0] + i), qx = L::load(in.rot[1] + i);
+            const V qy = L::load(in.rot[2] + i), qz = L::load(in.rot[3] + i);
+            const V sx = L::load(in.scale[0] + i), sy = L::load(in.scale[1] + i), sz = L::load(in.scale[2] + i);
+            // M = R S, as splatCovariance().
+            const V m00 = (one - two * (qy * qy + qz * qz)) * sx;
+            const V m01 = (two * (qx * qy - qw * qz)) * sy;
+            const V m02 = (two * (qx * qz + qw * qy)) * sz;
+            const V m10 = (two * (qx * qy + qw * qz)) * sx;
+            const V m11 = (one - two * (qx * qx + qz * qz)) * sy;
+            const V m12 = (two * (qy * qz - qw * qx)) * sz;
+            const V m20 = (two * (qx * qz - qw * qy)) * sx;
+            const V m21 = (two * (qy * qz + qw * qx)) * sy;
+            const V m22 = (one - two * (qx * qx + qy * qy)) * sz;
+            cov[0] = m00 * m00 + m01 * m01 + m02 * m02;
+            cov[1] = m00 * m10 + m01 * m11 + m02 * m12;
+            cov[2] = m00 * m20 + m01 * m21 + m02 * m22;
+            cov[3] = m10 * m10 + m11 * m11 + m12 * m12;
+            cov[4] = m10 * m20 + m11 * m21 + m12 * m22;
+            cov[5] = m20 * m20 + m21 * m21 + m22 * m22;
+        }
+
+        const V invZ = one / t2;
+        const V tx = L::min(limX, L::max(negLimX, t0 * invZ)) * t2;
+        const V ty = L::min(limY, L::max(negLimY, t1 * invZ)) * t2;
+
+        // J = [fx/z 0 -fx x/z^2; 0 fy/z -fy y/z^2], T = J W
+        const V j00 = fx * invZ, j02 = negFx * tx * invZ * invZ;
+        const V j11 = fy * invZ, j12 = negFy * ty * invZ * invZ;
+        const V T0[3] = { j00 * R[0] + j02 * R[6], j00 * R[1] + j02 * R[7], j00 * R[2] + j02 * R[8] };
+        const V T1[3] = { j11 * R[3] + j12 * R[6], j11 * R[4] + j12 * R[7], j11 * R[5] + j12 * R[8] };
+
+        const V s0[3] = { cov[0] * T0[0] + cov[1] * T0[1] + cov[2] * T0[2],
+                          cov[1] * T0[0] + cov[3] * T0[1] + cov[4] * T0[2],
+                          cov[2] * T0[0] + cov[4] * T0[1] + cov[5] * T0[2] };
+        const V s1[3] = { cov[0] * T1[0] + cov[1] * T1[1] + cov[2] * T1[2],
+                          cov[1] * T1[0] + cov[3] * T1[1] + cov[4] * T1[2],
+                          cov[2] * T1[0] + cov[4] * T1[1] + cov[5] * T1[2] };
+
+        const V a = T0[0] * s0[0] + T0[1] * s0[1] + T0[2] * s0[2] + lowPass;
+        const V b = T0[0] * s1[0] + T0[1] * s1[1] + T0[2] * s1[2];
+        const V c = T1[0] * s1[0] + T1[1] * s1[1] + T1[2] * s1[2] + lowPass;
+
+        const V det = a * c - b * b;
+        keep = L::maskAnd(keep, L::cmpLt(zero, det));
+        const V invDet = one / det;
+
+        const V mid = half * (a + c);
+        const V lambda = mid + L::sqrt(L::max(minDisc, mid * mid - det));
+        const V radius = minusOne * L::floor(minusOne * (three * L::sqrt(lambda)));
+
+        const V mx = fx * t0 * invZ + cx;
+        const V my = fy * t1 * invZ + cy;
+        keep = L::maskAnd(keep, L::maskAnd(L::cmpGe(mx + radius, zero), L::cmpLt(mx - radius, cullW)));
+        keep = L::maskAnd(keep, L::maskAnd(L::cmpGe(my + radius, zero), L::cmpLt(my - radius, cullH)));
+        uint32_t mask = L::laneMask(keep);
+        if (!mask) continue;
+
+        alignas(32) float res[8][W];
+        L::store(res[0], mx);
+        L::store(res[1], my);
+        L::store(res[2], c * invDet);
+        L::store(res[3], minusOne * b * invDet);
+        L::store(res[4], a * invDet);
+        L::store(res[5], t2);
+        L::store(res[6], L::load(in.opacity + i));
+        L::store(res[7], radius);
+        for (; mask; mask &= mask - 1) {
+            const size_t l = (size_t)__builtin_ctz(mask);
+            const size_t k = written++;
+            out.index[k] = (uint32_t)(i + l);
+            out.meanX[k] = res[0][l];
+            out.meanY[k] = res[1][l];
+            out.conicA[k] = res[2][l];
+            out.conicB[k] = res[3][l];
+            out.conicC[k] = res[4][l];
+            out.depth[k] = res[5][l];
+            out.opacity[k] = res[6][l];
+            out.radius[k] = (uint32_t)res[7][l];
+        }
+    }
+    return i;
+}
+
+template <typename L>
+static size_t projectLanes(const ProjectionView& view, const ProjectionInput& in, size_t begin, size_t end,
+                           const ProjectionOutput& out) {
+    size_t written = 0;
+    const size_t i = projectRun<L>(view, in, begin, end, out, written);
+    projectRun<ScalarLanes>(view, in, i, end, out, written);
+    return written;
+}
+
+static size_t projectReference(const ProjectionView& v, const ProjectionInput& in, size_t begin, size_t end,
+                               const ProjectionOutput& out) {
+    const float* W = v.rot;
+    size_t written = 0;
+    for (size_t i = begin; i < end; i++) {
+        const float p[3] = { in.pos[0][i], in.pos[1][i], in.pos[2][i] };
+        const float t[3] = { W[0] * p[0] + W[1] * p[1] + W[2] * p[2] + v.trans[0],
+                             W[3] * p[0] + W[4] * p[1] + W[5] * p[2] + v.trans[1],
+                             W[6] * p[0] + W[7] * p[1] + W[8] * p[2] + v.trans[2] };
+        if (!(t[2] >= v.znear && t[2] <= v.zfar)) continue;
+
+        float cov[6];
+        if (in.covariances) {
+            in.covariances->get(i, cov);
+        } else {
+            splatCovariance(in.scale[0][i], in.scale[1][i], in.scale[2][i],
+                            in.rot[0][i], in.rot[1][i], in.rot[2][i], in.rot[3][i], cov);
+        }
+
+        const float invZ = 1.f / t[2];
+        const float tx = std::min(v.limX, std::max(-v.limX, t[0] * invZ)) * t[2];
+        const float ty = std::min(v.limY, std::max(-v.limY, t[1] * invZ)) * t[2];
+
+        // J = [fx/z 0 -fx x/z^2; 0 fy/z -fy y/z^2], T = J W
+        const float j00 = v.fx * invZ, j02 = -v.fx * tx * invZ * invZ;
+        const float j11 = v.fy * invZ, j12 = -v.fy * ty * invZ * invZ;
+        const float T0[3] = { j00 * W[0] + j02 * W[6], j00 * W[1] + j02 * W[7], j00 * W[2] + j02 * W[8] };
+        const float T1[3] = { j11 * W[3] + j12 * W[6], j11 * W[4] + j12 * W[7], j11 * W[5] + j12 * W[8] };
+
+        // Sigma * T^T columns
+        const float s0[3] = { cov[0] * T0[0] + cov[1] * T0[1] + cov[2] * T0[2],
+                              cov[1] * T0[0] + cov[3] * T0[1] + cov[4] * T0[2],
+                              cov[2] * T0[0] + cov[4] * T0[1] + cov[5] * T0[2] };
+        const float s1[3] = { cov[0] * T1[0] + cov[1] * T1[1] + cov[2] * T1[2],
+                              cov[1] * T1[0] + cov[3] * T1[1] + cov[4] * T1[2],
+                              cov[2] * T1[0] + cov[4] * T1[1] + cov[5] * T1[2] };
+
+        // Low-pass filter: every splat covers at least ~one pixel.
+        const float a = T0[0] * s0[0] + T0[1] * s0[1] + T0[2] * s0[2] + 0.3f;
+        const float b = T0[0] * s1[0] + T0[1] * s1[1] + T0[2] * s1[2];
+        const float c = T1[0] * s1[0] + T1[1] * s1[1] + T1[2] * s1[2] + 0.3f;
+
+        const float det = a * c - b * b;
+        if (!(det > 0.f)) continue;
+        const float invDet = 1.f / det;
+
+        const float mid = 0.5f * (a + c);
+        const float lambda = mid + std::sqrt(std::max(0.1f, mid * mid - det));
+        const float radius = std::ceil(3.f * std::sqrt(lambda));
+
+        const float mx = v.fx * t[0] * invZ + v.cx;
+        const float my = v.fy * t[1] * invZ + v.cy;
+        if (!(mx + radius >= 0.f && mx - radius < v.cullWidth && my + radius >= 0.f && my - radius < v.cullHeight)) {
+            continue;
+        }
+
+        const size_t k = written++;
+        out.index[k] = (uint32_t)i;
+        out.meanX[k] = mx;
+        out.meanY[k] = my;
+        out.conicA[k] = c * invDet;
+        out.conicB[k] = -b * invDet;
+        out.conicC[k] = a * invDet;
+        out.depth[k] = t[2];
+        out.opacity[k] = in.opacity[i];
+        out.radius[k] = (uint32_t)radius;
+    }
+    return written;
+}
+
+} // namespace
+
+ProjectionView makeProjectionView(const Camera& camera, float cullWidth, float cullHeight) {
+    ProjectionView v;
+    std::copy(camera.rot, camera.rot + 9, v.rot);
+    std::copy(camera.trans, camera.trans + 3, v.trans);
+    v.fx = camera.fx;
+    v.fy = camera.fy;
+    v.cx = camera.cx;
+    v.cy = camera.cy;
+    v.znear = camera.znear;
+    v.zfar = camera.zfar;
+    // Clamp the Jacobian outside 1.3x the view frustum like the reference
+    // implementation does, so splats behind the image edges stay bounded.
+    v.limX = 1.3f * 0.5f * (float)camera.width / camera.fx;
+    v.limY = 1.3f * 0.5f * (float)camera.height / camera.fy;
+    v.cullWidth = cullWidth;
+    v.cullHeight = cullHeight;
+    return v;
+}
+
+const char* projectionKernelName(ProjectionKernel kernel) {
+    switch (kernel) {
+    case ProjectionKernel::Reference:
+        return "reference";
+    case ProjectionKernel::Simd4:
+        return "simd x4";
+    case ProjectionKernel::Simd8:
+#if GS_SIMD_AVX
+        return "simd x8 (avx)";
+#else
+        return "simd x8 (2 x f32x4)";
+#endif
+    }
+    return "?";
+}
+
+size_t projectSplats(const ProjectionView& view, const ProjectionInput& in, size_t begin, size_t end,
+                     const ProjectionOutput& out, ProjectionKernel kernel) {
+    switch (kernel) {
+    case ProjectionKernel::Reference:
+        return projectReference(view, in, begin, end, out);
+    case ProjectionKernel::Simd4:
+        return projectLanes<Lanes4>(view, in, begin, end, out);
+    case ProjectionKernel::Simd8:
+        break;
+    }
+    return projectLanes<Lanes8>(view, in, begin, end, out);
+}
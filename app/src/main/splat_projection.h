@@ -0,0 +1,66 @@
+#pragma once
+
+#include "camera.h"
+
+#include <cstddef>
+#include <cstdint>
+
+class CovarianceStore;
+
+// Splat attributes read by projection, as planes indexed by splat. The 3D
+// covariance comes from `covariances` when set, else from scale and
+// rotation.
+struct ProjectionInput {
+    const float* pos[3] = {};
+    const float* scale[3] = {};
+    const float* rot[4] = {};
+    const float* opacity = nullptr;
+    const CovarianceStore* covariances = nullptr;
+};
+
+// Compact per-splat results: entry k describes splat index[k]. Every array
+// needs room for end - begin entries.
+struct ProjectionOutput {
+    uint32_t* index = nullptr;
+    float* meanX = nullptr;
+    float* meanY = nullptr;
+    float* conicA = nullptr; // inverse 2D covariance (A, B; B, C)
+    float* conicB = nullptr;
+    float* conicC = nullptr;
+    float* depth = nullptr;
+    float* opacity = nullptr;
+    uint32_t* radius = nullptr; // 3 sigma of the major axis, whole pixels
+};
+
+// Camera terms shared by every splat of a frame.
+struct ProjectionView {
+    float rot[9];
+    float trans[3];
+    float fx, fy, cx, cy;
+    float znear, zfar;
+    float limX, limY;            // Jacobian clamp, tan of 1.3x the half fov
+    float cullWidth, cullHeight; // screen rectangle splats must touch
+};
+
+ProjectionView makeProjectionView(const Camera& camera, float cullWidth, float cullHeight);
+
+enum class ProjectionKernel : uint32_t {
+    Reference, // one splat at a time, the behaviour the others must match
+    Simd4,
+    Simd8,     // f32x8: AVX when built with it, else two f32x4
+};
+
+const char* projectionKernelName(ProjectionKernel kernel);
+
+// EWA projection of splats [begin, end): view transform, perspective
+// Jacobian clamped to 1.3x the frustum, 2D covariance with a 0.3 px
+// low-pass, its inverse and the 3-sigma radius of the larger eigenvalue.
+//
+// Splats outside [znear, zfar], with a degenerate 2D covariance, or whose
+// radius square misses [0, cullWidth) x [0, cullHeight) are dropped; the
+// rest are written to `out` in order. Returns how many were written.
+//
+// The SIMD kernels run the same math over SoA lanes, with culled lanes
+// masked out when the results are compacted.
+size_t projectSplats(const ProjectionView& view, const ProjectionInput& in, size_t begin, size_t end,
+                     const ProjectionOutput& out, ProjectionKernel kernel = ProjectionKernel::Simd8);
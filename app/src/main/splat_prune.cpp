@@ -0,0 +1,231 @@
+#include "splat_prune.h"
+#include "radix_sort.h"
+#include "thread_pool.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+constexpr size_t kGrain = 1 << 14;
+
+enum Verdict : uint8_t {
+    Keep,
+    LowOpacity,
+    Small,
+    Duplicate,
+};
+
+// Cell coordinates wrap at 21 bits; cells that alias only add candidates,
+// since duplicates are confirmed on the actual positions.
+constexpr uint64_t kCellMask = (1u << 21) - 1;
+
+static uint64_t packCell(int64_t x, int64_t y, int64_t z) {
+    return ((uint64_t)x & kCellMask) | (((uint64_t)y & kCellMask) << 21) | (((uint64_t)z & kCellMask) << 42);
+}
+
+// Open-addressing map from a cell to its run [begin, end) in the list of
+// candidates sorted by cell.
+class CellTable {
+public:
+    void build(const uint64_t* sortedCells, size_t n) {
+        size_t unique = 0;
+        for (size_t i = 0; i < n; i++) unique += (i == 0 || sortedCells[i] != sortedCells[i - 1]) ? 1 : 0;
+        size_t capacity = 16;
+        while (capacity < unique * 2) capacity *= 2;
+        mask_ = capacity - 1;
+        slots_.assign(capacity, Slot{});
+        for (size_t i = 0; i < n;) {
+            size_t j = i + 1;
+            while (j < n && sortedCells[j] == sortedCells[i]) j++;
+            size_t s = hash(sortedCells[i]) & mask_;
+            while (slots_[s].end) s = (s + 1) & mask_;
+            slots_[s] = Slot{ sortedCells[i], (uint32_t)i, (uint32_t)j };
+            i = j;
+        }
+    }
+
+    bool find(uint64_t cell, uint32_t& begin, uint32_t& end) const {
+        for (size_t s = hash(cell) & mask_;; s = (s + 1) & mask_) {
+            const Slot& slot = slots_[s];
+            if (!slot.end) return false;
+            if (slot.cell == cell) {
+                begin = slot.begin;
+                end = slot.end;
+                return true;
+            }
+        }
+    }
+
+private:
+    struct Slot {
+        uint64_t cell = 0;
+        uint32_t begin = 0;
+        uint32_t end = 0; // 0: empty
+    };
+
+    static uint64_t hash(uint64_t v) {
+        v ^= v >> 33;
+        v *= 0xff51afd7ed558ccdull;
+        v ^= v >> 33;
+        return v;
+    }
+
+    std::vector<Slot> slots_;
+    size_t mask_ = 0;
+};
+
+static bool isDuplicate(const SplatCloud& c, const SplatPruneOptions& o, uint32_t a, uint32_t b) {
+    const float dx = c.pos[0][a] - c.pos[0][b], dy = c.pos[1][a] - c.pos[1][b], dz = c.pos[2][a] - c.pos[2][b];
+    if (dx * dx + dy * dy + dz * dz > o.mergeDistance * o.mergeDistance) return false;
+    for (int k = 0; k < 3; k++) {
+        const float sa = c.scale[k][a], sb = c.scale[k][b];
+        if (std::fabs(sa - sb) > o.mergeScaleTolerance * std::max(sa, sb)) return false;
+    }
+    float dot = 0.f;
+    for (int k = 0; k < 4; k++) dot += c.rot[k][a] * c.rot[k][b];
+    if (1.f - std::fabs(dot) > o.mergeRotationTolerance) return false;
+    for (int k = 0; k < 3; k++) {
+        if (kShC0 * std::fabs(c.shDc[k][a] - c.shDc[k][b]) > o.mergeColorTolerance) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+void pruneSplats(SplatCloud& cloud, const SplatPruneOptions& options, SplatPruneStats* stats) {
+    GS_TRACE_SCOPE("pruneSplats");
+    SplatPruneStats st;
+    auto start = Clock::now();
+    const size_t n = cloud.count;
+    st.input = n;
+    ThreadPool& pool = ThreadPool::shared();
+    const bool shape = cloud.hasShape();
+
+    // Per-splat rules.
+    auto t0 = Clock::now();
+    std::vector<uint8_t> verdict(n, Keep);
+    std::atomic<size_t> lowOpacity{ 0 }, small{ 0 };
+    const float minRadius = options.minExtent / 3.f;
+    pool.parallelFor(n, kGrain, [&](size_t begin, size_t end) {
+        size_t o = 0, s = 0;
+        for (size_t i = begin; i < end; i++) {
+            if (cloud.opacity[i] < options.minOpacity) {
+                verdict[i] = LowOpacity;
+                o++;
+            } else if (shape && minRadius > 0.f &&
+                       std::max(cloud.scale[0][i], std::max(cloud.scale[1][i], cloud.scale[2][i])) < minRadius) {
+                verdict[i] = Small;
+                s++;
+            }
+        }
+        lowOpacity.fetch_add(o, std::memory_order_relaxed);
+        small.fetch_add(s, std::memory_order_relaxed);
+    });
+    st.opacity = lowOpacity.load();
+    st.extent = small.load();
+    st.filterMs = msSince(t0);
+
+    // Duplicates: every survivor looks for an earlier one in the cells
+    // around it. Each splat only writes its own target entry, so the search
+    // runs in parallel; merging opacities afterwards is a short serial pass.
+    t0 = Clock::now();
+    if (options.mergeDistance > 0.f && shape && n > 1) {
+        std::vector<uint32_t> candidates;
+        candidates.reserve(n - st.opacity - st.extent);
+        for (size_t i = 0; i < n; i++) {
+            if (verdict[i] != Keep) continue;
+            if (!std::isfinite(cloud.pos[0][i]) || !std::isfinite(cloud.pos[1][i]) || !std::isfinite(cloud.pos[2][i])) continue;
+            candidates.push_back((uint32_t)i);
+        }
+        const size_t m = candidates.size();
+        // Cells twice the merge distance: everything within reach of a
+        // splat lies in its own cell or the neighbours on the sides of the
+        // nearer faces, 8 cells instead of 27.
+        const float inv = 0.5f / options.mergeDistance;
+        auto cellCoord = [&](uint32_t i, int k) { return std::min(std::max(cloud.pos[k][i] * inv, -1e15f), 1e15f); };
+        auto cellOf = [&](uint32_t i, int k) { return (int64_t)std::floor(cellCoord(i, k)); };
+
+        std::vector<uint64_t> cells(m), cellsTmp(m);
+        std::vector<uint32_t> candidatesTmp(m);
+        pool.parallelFor(m, kGrain, [&](size_t begin, size_t end) {
+            for (size_t s = begin; s < end; s++) {
+                const uint32_t i = candidates[s];
+                cells[s] = packCell(cellOf(i, 0), cellOf(i, 1), cellOf(i, 2));
+            }
+        });
+        // Stable, so each cell's run stays in index order.
+        radixSortPairs(cells.data(), candidates.data(), m, cellsTmp.data(), candidatesTmp.data(), pool, 63);
+        std::vector<uint64_t>().swap(cellsTmp);
+        std::vector<uint32_t>().swap(candidatesTmp);
+
+        CellTable table;
+        table.build(cells.data(), m);
+
+        std::vector<uint32_t> target(n, UINT32_MAX);
+        pool.parallelFor(m, kGrain, [&](size_t begin, size_t end) {
+            for (size_t s = begin; s < end; s++) {
+                const uint32_t i = candidates[s];
+                int64_t cell[3], side[3];
+                for (int k = 0; k < 3; k++) {
+                    const float c = cellCoord(i, k), f = std::floor(c);
+                    cell[k] = (int64_t)f;
+                    side[k] = c - f < 0.5f ? -1 : 1;
+                }
+                uint32_t best = UINT32_MAX;
+                for (int corner = 0; corner < 8; corner++) {
+                    const int64_t x = cell[0] + ((corner & 1) ? side[0] : 0);
+                    const int64_t y = cell[1] + ((corner & 2) ? side[1] : 0);
+                    const int64_t z = cell[2] + ((corner & 4) ? side[2] : 0);
+                    uint32_t b, e;
+                    if (!table.find(packCell(x, y, z), b, e)) continue;
+                    for (uint32_t r = b; r < e; r++) {
+                        const uint32_t j = candidates[r];
+                        if (j >= std::min(i, best)) break; // runs are in index order
+                        if (isDuplicate(cloud, options, i, j)) best = j;
+                    }
+                }
+                if (best != UINT32_MAX) target[i] = best;
+            }
+        });
+
+        // Fold each duplicate into the surviving splat at the root of its
+        // chain; ascending order means earlier links are already resolved.
+        float* opacity = cloud.opacity.data();
+        for (size_t i = 0; i < n; i++) {
+            if (target[i] == UINT32_MAX) continue;
+            uint32_t root = target[i];
+            if (verdict[root] == Duplicate) root = target[root];
+            target[i] = root;
+            verdict[i] = Duplicate;
+            opacity[root] = 1.f - (1.f - opacity[root]) * (1.f - opacity[i]);
+            st.duplicates++;
+        }
+    }
+    st.mergeMs = msSince(t0);
+
+    t0 = Clock::now();
+    st.output = n - st.opacity - st.extent - st.duplicates;
+    if (st.output != n) {
+        std::vector<uint32_t> keep;
+        keep.reserve(st.output);
+        for (size_t i = 0; i < n; i++) {
+            if (verdict[i] == Keep) keep.push_back((uint32_t)i);
+        }
+        compactSplats(cloud, keep.data(), keep.size());
+    }
+    st.compactMs = msSince(t0);
+
+    st.totalMs = msSince(start);
+    if (stats) *stats = st;
+}
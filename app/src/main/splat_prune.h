@@ -0,0 +1,50 @@
+#pragma once
+
+#include "splat_cloud.h"
+
+#include <cstddef>
+
+// Removes Gaussians that cannot contribute visibly, before anything is
+// built on top of the cloud. Rules, applied in this order:
+//
+//   opacity     activated opacity below minOpacity
+//   extent      largest 3-sigma radius below minExtent (world units), i.e.
+//               sub-pixel from every viewpoint at least that close
+//   duplicates  splats within mergeDistance of an earlier one with the
+//               same scale, rotation and DC colour (within tolerance). The
+//               earlier splat is kept with the pair's combined opacity,
+//               1 - (1 - a)(1 - b), so stacked copies look the same.
+//
+// Duplicates are found through a spatial hash of cells twice mergeDistance
+// wide, probing the 8 cells nearest to each splat.
+// Rules that need scale and rotation are skipped for clouds without them.
+struct SplatPruneOptions {
+    float minOpacity = 1.f / 255.f; // invisible after 8-bit blending; 0 disables
+    float minExtent = 0.f;          // 0 disables
+    float mergeDistance = 0.f;      // 0 disables duplicate merging
+    float mergeScaleTolerance = 0.05f;  // relative, per axis
+    float mergeRotationTolerance = 1e-3f; // 1 - |dot(q_a, q_b)|
+    float mergeColorTolerance = 1.f / 255.f; // per channel, DC colour
+};
+
+// World-space extent that covers `pixels` pixels at distance `distance` for
+// a camera with focal length `focalPixels`: a minExtent for scenes that are
+// never viewed from closer than `distance`.
+inline float extentForPixels(float pixels, float distance, float focalPixels) {
+    return focalPixels > 0.f ? pixels * distance / focalPixels : 0.f;
+}
+
+struct SplatPruneStats {
+    size_t input = 0;
+    size_t opacity = 0;    // removed by each rule
+    size_t extent = 0;
+    size_t duplicates = 0;
+    size_t output = 0;
+    double filterMs = 0.0;
+    double mergeMs = 0.0;
+    double compactMs = 0.0;
+    double totalMs = 0.0;
+};
+
+// Prunes `cloud` in place; survivors keep their relative order.
+void pruneSplats(SplatCloud& cloud, const SplatPruneOptions& options, SplatPruneStats* stats = nullptr);
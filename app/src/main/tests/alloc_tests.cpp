@@ -0,0 +1,110 @@
+// Steady-state heap checks. This binary always counts operator new (its
+// own copy of alloc_tracker.cpp is built with GS_TRACK_ALLOCATIONS), so
+// ctest covers them without the option.
+//
+// Each test warms its path up over a few frames, then requires the same
+// frames to run again without a single allocation on the calling thread.
+
+#include "test_util.h"
+
+#include "alloc_tracker.h"
+#include "camera.h"
+#include "cpu_rasterizer.h"
+#include "frame_arena.h"
+#include "spatial_index.h"
+#include "splat_cloud.h"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+constexpr int kWarmupFrames = 3;
+constexpr int kCheckedFrames = 8;
+
+static bool testTrackingEnabled() {
+    CHECK(allocationTrackingEnabled());
+    AllocationWatch watch;
+    std::vector<int> v(16);
+    CHECK(watch.count() == 1);
+    return true;
+}
+
+// The renderer's per-frame pattern: a reserved FrameVector, one grown by
+// push_back, and raw arrays, all reset together. The first frames spill into
+// extra blocks; once those are merged the arena stops touching the heap.
+static bool testFrameArenaSteadyState() {
+    FrameArena arena(1024);
+    auto frame = [&](uint32_t n) {
+        arena.reset();
+        FrameVector<uint32_t> order{ ArenaAllocator<uint32_t>(arena) };
+        order.reserve(n);
+        for (uint32_t i = 0; i < n; i++) order.push_back(n - i);
+        FrameVector<uint64_t> grown{ ArenaAllocator<uint64_t>(arena) };
+        for (uint32_t i = 0; i < n / 4; i++) grown.push_back(i);
+        float* scratch = arena.allocateArray<float>(n);
+        scratch[n - 1] = 1.f;
+        void* aligned = arena.allocate(100, 256);
+        return ((uintptr_t)aligned & 255) == 0 && order.front() == n && grown.size() == n / 4;
+    };
+
+    const uint32_t sizes[kCheckedFrames] = { 5000, 3000, 5000, 1, 4999, 2500, 5000, 4096 };
+    for (int f = 0; f < kWarmupFrames; f++) CHECK(frame(5000));
+    const uint32_t blockAllocations = arena.stats().blockAllocations;
+    CHECK(arena.stats().blocks == 1);
+
+    AllocationWatch watch;
+    for (uint32_t n : sizes) CHECK(frame(n));
+    CHECK(watch.count() == 0);
+    CHECK(arena.stats().blockAllocations == blockAllocations);
+    CHECK(arena.stats().blocks == 1);
+    return true;
+}
+
+// BVH query and CPU rasterization over an orbit, as the render loop runs
+// them: replaying frames already seen reuses every scratch buffer.
+static bool testCpuFrameSteadyState() {
+    SplatCloud cloud;
+    makeShapeCloud(cloud, 4000, 5.f, 9);
+    SplatBvh bvh;
+    CHECK(bvh.build(cloud));
+
+    const uint32_t width = 160, height = 120;
+    const float up[3] = { 0.f, -1.f, 0.f };
+    const float target[3] = { 0.f, 0.f, 0.f };
+    std::vector<Camera> cameras;
+    for (int f = 0; f < kCheckedFrames; f++) {
+        const float a = 2.f * 3.14159265f * (float)f / (float)kCheckedFrames;
+        const float eye[3] = { 12.f * std::cos(a), 1.f, 12.f * std::sin(a) };
+        cameras.push_back(makeLookAtCamera(eye, target, up, 1.f, width, height));
+    }
+
+    CpuRasterizer raster;
+    std::vector<uint8_t> image((size_t)width * height * 4);
+    std::vector<SplatRange> ranges;
+    auto frame = [&](const Camera& camera) {
+        bvh.query(camera.frustum(), ranges);
+        raster.render(cloud, camera, ranges, image.data(), (size_t)width * 4);
+    };
+
+    for (int pass = 0; pass < kWarmupFrames; pass++) {
+        for (const Camera& camera : cameras) frame(camera);
+    }
+    AllocationWatch watch;
+    for (const Camera& camera : cameras) frame(camera);
+    CHECK(watch.count() == 0);
+    CHECK(bvh.queryStats().visibleSplats > 0);
+    return true;
+}
+
+} // namespace
+
+int main() {
+    const Test tests[] = {
+        { "allocation tracking enabled", testTrackingEnabled },
+        { "frame arena steady state", testFrameArenaSteadyState },
+        { "cpu frame steady state", testCpuFrameSteadyState },
+    };
+    return runTests(tests);
+}
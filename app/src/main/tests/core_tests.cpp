@@ -0,0 +1,422 @@
+// Unit checks for gs_core that need no scene file; registered with ctest.
+//
+// Each test returns false after printing what failed. Inputs are
+// synthetic and seeded, so a failure reproduces.
+
+#include "test_util.h"
+
+#include "camera.h"
+#include "covariance_store.h"
+#include "gpu_allocator.h"
+#include "sh_eval.h"
+#include "spatial_index.h"
+#include "splat_cloud.h"
+#include "splat_lod.h"
+#include "splat_projection.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+// Cloud with `restCoeffs` SH coefficients per channel, in the range 3DGS
+// training produces.
+static void makeShCloud(SplatCloud& cloud, size_t n, uint32_t restCoeffs, uint32_t seed) {
+    Rng rng{ seed };
+    cloud.resize(n, restCoeffs);
+    for (size_t i = 0; i < n; i++) {
+        for (int k = 0; k < 3; k++) {
+            cloud.pos[k][i] = rng.uniform(-10.f, 10.f);
+            cloud.shDc[k][i] = rng.uniform(-2.f, 2.f);
+        }
+    }
+    for (size_t i = 0; i < cloud.shRest.size(); i++) cloud.shRest[i] = rng.uniform(-0.5f, 0.5f);
+}
+
+// The vectorized kernel against the scalar reference, per degree, over an
+// unaligned sub-range so the SIMD body and the scalar tail both run.
+static bool testShKernelMatchesReference() {
+    // Observed error is below 1e-6; this leaves room for other SIMD targets.
+    const float kMaxError = 1e-5f;
+    SplatCloud cloud;
+    const size_t n = 10007;
+    makeShCloud(cloud, n, 15, 7);
+    const float eyes[3][3] = { { 0.f, 0.f, -30.f }, { 25.f, -4.f, 3.f }, { 0.5f, 0.25f, 0.125f } };
+    const size_t begin = 3, end = n - 2, m = end - begin;
+    std::vector<float> rgb(m * 3), ref(m * 3);
+    for (const float* eye : eyes) {
+        for (uint32_t d = 0; d <= 3; d++) {
+            evalShColors(cloud, eye, d, begin, end, rgb.data(), rgb.data() + m, rgb.data() + 2 * m);
+            evalShColorsReference(cloud, eye, d, begin, end, ref.data(), ref.data() + m, ref.data() + 2 * m);
+            float maxErr = 0.f;
+            for (size_t i = 0; i < rgb.size(); i++) maxErr = std::max(maxErr, std::fabs(rgb[i] - ref[i]));
+            if (!(maxErr <= kMaxError)) std::fprintf(stderr, "sh degree %u: max error %g\n", d, maxErr);
+            CHECK(maxErr <= kMaxError);
+            for (float v : rgb) CHECK(v >= 0.f);
+        }
+    }
+    return true;
+}
+
+// Asking for more degrees than the cloud stores evaluates what it has.
+static bool testShDegreeClamped() {
+    SplatCloud cloud;
+    const size_t n = 1001;
+    makeShCloud(cloud, n, 3, 11);
+    const float eye[3] = { 1.f, 2.f, -20.f };
+    std::vector<float> a(n * 3), b(n * 3);
+    evalShColors(cloud, eye, 3, 0, n, a.data(), a.data() + n, a.data() + 2 * n);
+    evalShColors(cloud, eye, 1, 0, n, b.data(), b.data() + n, b.data() + 2 * n);
+    CHECK(a == b);
+    return true;
+}
+
+static bool testShDegreeController() {
+    ShDegreeController c;
+    c.options.patience = 3;
+    c.options.frameBudgetMs = 10.0;
+    c.reset();
+    CHECK(c.degree() == 3);
+    // Two slow frames are not enough; the third drops a degree.
+    CHECK(c.update(20.0) == 3);
+    CHECK(c.update(20.0) == 3);
+    CHECK(c.update(20.0) == 2);
+    // A frame in the dead band between recovery and budget resets the run.
+    CHECK(c.update(20.0) == 2);
+    CHECK(c.update(8.0) == 2);
+    CHECK(c.update(20.0) == 2);
+    CHECK(c.update(20.0) == 2);
+    CHECK(c.update(20.0) == 1);
+    for (int i = 0; i < 9; i++) c.update(20.0);
+    CHECK(c.degree() == 0);
+    c.update(20.0);
+    CHECK(c.degree() == 0);
+    // Fast frames bring it back one degree per run, up to maxDegree.
+    for (int i = 0; i < 3; i++) c.update(1.0);
+    CHECK(c.degree() == 1);
+    for (int i = 0; i < 30; i++) c.update(1.0);
+    CHECK(c.degree() == 3);
+    c.options.maxDegree = 1;
+    CHECK(c.degree() == 1);
+    return true;
+}
+
+// Both SIMD projection kernels against the reference, for every covariance
+// source, from cameras inside and outside the cloud. The bounds are the
+// ones splat_bench --project applies to real scenes.
+static bool testProjectionKernelsMatchReference() {
+    const float kMaxAbs = 1e-3f;
+    const float kMaxRel = 1e-4f;
+    SplatCloud cloud;
+    const size_t n = 20011;
+    makeShapeCloud(cloud, n, 5.f, 5);
+    CovarianceStore stores[2];
+    CHECK(stores[0].build(cloud, CovariancePrecision::Float32));
+    CHECK(stores[1].build(cloud, CovariancePrecision::Float16));
+    const CovarianceStore* sources[3] = { nullptr, &stores[0], &stores[1] };
+
+    ProjectionInput in;
+    for (int k = 0; k < 3; k++) in.pos[k] = cloud.pos[k].data();
+    for (int k = 0; k < 3; k++) in.scale[k] = cloud.scale[k].data();
+    for (int k = 0; k < 4; k++) in.rot[k] = cloud.rot[k].data();
+    in.opacity = cloud.opacity.data();
+
+    struct Planes {
+        std::vector<uint32_t> index, radius;
+        std::vector<float> meanX, meanY, conicA, conicB, conicC, depth, opacity;
+        ProjectionOutput output(size_t count) {
+            for (auto* v : { &index, &radius }) v->resize(count);
+            for (auto* v : { &meanX, &meanY, &conicA, &conicB, &conicC, &depth, &opacity }) v->resize(count);
+            ProjectionOutput o;
+            o.index = index.data();
+            o.meanX = meanX.data();
+            o.meanY = meanY.data();
+            o.conicA = conicA.data();
+            o.conicB = conicB.data();
+            o.conicC = conicC.data();
+            o.depth = depth.data();
+            o.opacity = opacity.data();
+            o.radius = radius.data();
+            return o;
+        }
+    };
+    const ProjectionKernel kernels[3] = { ProjectionKernel::Reference, ProjectionKernel::Simd4, ProjectionKernel::Simd8 };
+    Planes planes[3];
+
+    const float up[3] = { 0.f, -1.f, 0.f };
+    const float eyes[3][3] = { { 0.f, 0.f, -20.f }, { 0.3f, -0.2f, 0.1f }, { 12.f, 3.f, 9.f } };
+    const float target[3] = { 0.f, 0.f, 0.f };
+    for (const CovarianceStore* store : sources) {
+        in.covariances = store;
+        for (const float* eye : eyes) {
+            const Camera camera = makeLookAtCamera(eye, target, up, 1.f, 640, 480);
+            const ProjectionView view = makeProjectionView(camera, 640.f, 480.f);
+            size_t counts[3];
+            // An odd sub-range so the SIMD tails run too.
+            for (int k = 0; k < 3; k++) counts[k] = projectSplats(view, in, 1, n, planes[k].output(n), kernels[k]);
+            CHECK(counts[0] > 1000);
+            const Planes& ref = planes[0];
+            for (int k = 1; k < 3; k++) {
+                const Planes& p = planes[k];
+                CHECK(counts[k] == counts[0]);
+                for (size_t i = 0; i < counts[0]; i++) {
+                    CHECK(p.index[i] == ref.index[i]);
+                    CHECK(std::fabs(p.meanX[i] - ref.meanX[i]) <= kMaxAbs);
+                    CHECK(std::fabs(p.meanY[i] - ref.meanY[i]) <= kMaxAbs);
+                    CHECK(std::fabs(p.depth[i] - ref.depth[i]) <= kMaxAbs);
+                    const float scale = std::max(std::fabs(ref.conicA[i]), std::fabs(ref.conicC[i]));
+                    CHECK(std::fabs(p.conicA[i] - ref.conicA[i]) <= kMaxRel * scale);
+                    CHECK(std::fabs(p.conicB[i] - ref.conicB[i]) <= kMaxRel * scale);
+                    CHECK(std::fabs(p.conicC[i] - ref.conicC[i]) <= kMaxRel * scale);
+                    CHECK(std::max(p.radius[i], ref.radius[i]) - std::min(p.radius[i], ref.radius[i]) <= 1);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// The cut never exceeds its budget, including right after the camera jumps
+// in close, and with the whole cloud in view every base splat is drawn
+// through exactly one cut node.
+static bool testLodCutBudgetAndCoverage() {
+    SplatCloud cloud;
+    const size_t n = 20000;
+    makeShapeCloud(cloud, n, 5.f, 13);
+    SplatBvh bvh;
+    CHECK(bvh.build(cloud));
+    SplatLod lod;
+    CHECK(lod.build(cloud));
+    CHECK(lod.nodeCount() > n);
+
+    const float up[3] = { 0.f, -1.f, 0.f };
+    const float target[3] = { 0.f, 0.f, 0.f };
+    std::vector<uint8_t> inCut(lod.nodeCount());
+    auto coversOnce = [&](const std::vector<uint32_t>& visible) {
+        std::fill(inCut.begin(), inCut.end(), 0);
+        for (uint32_t node : visible) {
+            CHECK(node < lod.nodeCount());
+            CHECK(!inCut[node]);
+            inCut[node] = 1;
+        }
+        for (uint32_t leaf = 0; leaf < (uint32_t)n; leaf++) {
+            uint32_t covered = 0;
+            for (uint32_t node = leaf; node != SplatLod::kNone; node = lod.parentOf(node)) covered += inCut[node];
+            CHECK(covered == 1);
+        }
+        return true;
+    };
+
+    for (size_t budget : { (size_t)500, (size_t)5000 }) {
+        SplatLodCut cut;
+        cut.options.budget = budget;
+        size_t maxVisible = 0;
+        for (int f = 0; f < 24; f++) {
+            const float a = 0.3f * (float)f;
+            // Frames 8-11 jump in close, where most of the cloud is refined
+            // or out of view; the others see all of it.
+            const float dist = (f >= 8 && f < 12) ? 4.f : 25.f;
+            const float eye[3] = { dist * std::cos(a), 2.f, dist * std::sin(a) };
+            cut.update(lod, makeLookAtCamera(eye, target, up, 1.f, 640, 480));
+            CHECK(cut.visible().size() <= budget);
+            CHECK(cut.stats().visible == cut.visible().size());
+            maxVisible = std::max(maxVisible, cut.visible().size());
+            if (dist > 10.f) CHECK(coversOnce(cut.visible()));
+        }
+        // The budget is used, not just respected.
+        CHECK(maxVisible > budget / 2);
+    }
+    return true;
+}
+
+// Mixed sizes and alignments across several blocks, checked again after
+// freeing every other one and refilling the holes.
+static bool testAllocatorNoOverlap() {
+    HostMemoryBackend backend;
+    GpuAllocator::Options options;
+    options.blockSize = 256 << 10;
+    options.dedicatedThreshold = 128 << 10;
+    GpuAllocator allocator(backend, options);
+
+    Rng rng{ 3 };
+    std::vector<GpuAllocation> allocations(300);
+    std::vector<uint64_t> alignments(allocations.size());
+    auto fillSlot = [&](size_t i) {
+        alignments[i] = 1ull << (uint32_t)rng.uniform(0.f, 13.f);
+        const uint64_t size = 1 + (uint64_t)rng.uniform(0.f, 16384.f);
+        return allocator.allocate(0, size, alignments[i], allocations[i]);
+    };
+    auto checkLayout = [&]() {
+        std::vector<const GpuAllocation*> live;
+        for (size_t i = 0; i < allocations.size(); i++) {
+            const GpuAllocation& a = allocations[i];
+            if (!a) continue;
+            CHECK(a.offset % alignments[i] == 0);
+            // The host backend's handle is the block's base pointer.
+            CHECK(a.mapped == (void*)(uintptr_t)(a.memory + a.offset));
+            live.push_back(&a);
+        }
+        std::sort(live.begin(), live.end(), [](const GpuAllocation* a, const GpuAllocation* b) {
+            return a->memory != b->memory ? a->memory < b->memory : a->offset < b->offset;
+        });
+        for (size_t i = 1; i < live.size(); i++) {
+            if (live[i]->memory == live[i - 1]->memory) CHECK(live[i - 1]->offset + live[i - 1]->size <= live[i]->offset);
+        }
+        CHECK(allocator.stats().allocations == live.size());
+        return true;
+    };
+
+    for (size_t i = 0; i < allocations.size(); i++) CHECK(fillSlot(i));
+    CHECK(allocator.stats().blocks > 1);
+    CHECK(checkLayout());
+    for (size_t i = 0; i < allocations.size(); i += 2) allocator.free(allocations[i]);
+    CHECK(checkLayout());
+    for (size_t i = 0; i < allocations.size(); i += 2) CHECK(fillSlot(i));
+    CHECK(checkLayout());
+    for (GpuAllocation& a : allocations) allocator.free(a);
+    CHECK(allocator.stats().allocations == 0);
+    return true;
+}
+
+// Freeing a block's allocations out of order leaves one free range that a
+// block-sized request fits into without a new backend allocation.
+static bool testAllocatorCoalesces() {
+    HostMemoryBackend backend;
+    GpuAllocator::Options options;
+    options.blockSize = 64 << 10;
+    options.dedicatedThreshold = 1 << 20;
+    GpuAllocator allocator(backend, options);
+
+    GpuAllocation a[4];
+    for (GpuAllocation& x : a) CHECK(allocator.allocate(0, 16 << 10, 1, x));
+    GpuAllocator::Stats st = allocator.stats();
+    CHECK(st.blocks == 1);
+    CHECK(st.freeBytes == 0);
+
+    allocator.free(a[1]);
+    allocator.free(a[3]);
+    st = allocator.stats();
+    CHECK(st.freeBytes == 32 << 10);
+    CHECK(st.largestFree == 16 << 10);
+    allocator.free(a[0]);
+    CHECK(allocator.stats().largestFree == 32 << 10);
+    allocator.free(a[2]);
+    st = allocator.stats();
+    CHECK(st.blocks == 1); // the last block of a type is kept
+    CHECK(st.freeBytes == 64 << 10);
+    CHECK(st.largestFree == 64 << 10);
+    CHECK(st.fragmentation == 0.f);
+
+    GpuAllocation whole;
+    CHECK(allocator.allocate(0, 64 << 10, 1, whole));
+    CHECK(whole.offset == 0);
+    CHECK(backend.totalAllocations() == 1);
+    allocator.free(whole);
+    return true;
+}
+
+// Dedicated blocks go back to the backend on free, as do empty shared
+// blocks while another block of the type remains.
+static bool testAllocatorReleasesBlocks() {
+    HostMemoryBackend backend;
+    GpuAllocator::Options options;
+    options.blockSize = 64 << 10;
+    options.dedicatedThreshold = 256 << 10;
+    GpuAllocator allocator(backend, options);
+
+    GpuAllocation big;
+    CHECK(allocator.allocate(0, 1 << 20, 256, big));
+    CHECK(big.offset == 0);
+    CHECK(allocator.stats().dedicatedBlocks == 1);
+    CHECK(backend.liveAllocations() == 1);
+    allocator.free(big);
+    CHECK(!big);
+    CHECK(allocator.stats().blocks == 0);
+    CHECK(backend.liveAllocations() == 0);
+
+    GpuAllocation x, y;
+    CHECK(allocator.allocate(0, 48 << 10, 1, x));
+    CHECK(allocator.allocate(0, 48 << 10, 1, y));
+    CHECK(x.memory != y.memory);
+    CHECK(backend.liveAllocations() == 2);
+    allocator.free(x);
+    CHECK(backend.liveAllocations() == 1);
+    allocator.free(y);
+    CHECK(backend.liveAllocations() == 1);
+
+    {
+        GpuAllocator scoped(backend, options);
+        GpuAllocation z;
+        CHECK(scoped.allocate(1, 1 << 20, 1, z));
+        CHECK(backend.liveAllocations() == 2);
+    }
+    CHECK(backend.liveAllocations() == 1);
+    return true;
+}
+
+// A region that does not fit before the end of the ring starts over at 0,
+// and only once the regions in its way have retired.
+static bool testStagingRing() {
+    const uint64_t kCapacity = 1024;
+    std::vector<uint8_t> memory(kCapacity);
+    StagingRing ring;
+    ring.init(memory.data(), kCapacity);
+
+    StagingRing::Region r;
+    CHECK(!ring.allocate(kCapacity + 1, 1, r));
+    const uint8_t src[400] = { 1, 2, 3 };
+    CHECK(ring.upload(src, 400, 16, r));
+    CHECK(r.offset == 0);
+    CHECK(r.ptr == memory.data());
+    CHECK(memory[2] == 3);
+    CHECK(ring.allocate(390, 16, r));
+    CHECK(r.offset == 400);
+    ring.submit(1);
+
+    CHECK(ring.allocate(10, 16, r));
+    CHECK(r.offset == 800);
+    ring.submit(2);
+    CHECK(ring.available() == kCapacity - 810);
+
+    // 400 bytes do not fit after 810, and the front is still in flight.
+    CHECK(!ring.allocate(400, 16, r));
+    CHECK(ring.stats().full == 1);
+    ring.retire(0);
+    CHECK(!ring.allocate(400, 16, r));
+    CHECK(ring.stats().full == 2);
+
+    ring.retire(1);
+    CHECK(ring.stats().inFlight == 20);
+    CHECK(ring.allocate(400, 16, r));
+    CHECK(r.offset == 0);
+    CHECK(r.ptr == memory.data());
+    // The skipped end of the ring stays in flight with the wrapped region.
+    CHECK(ring.stats().inFlight == 20 + 214 + 400);
+    ring.submit(3);
+
+    ring.retire(3);
+    CHECK(ring.stats().inFlight == 0);
+    CHECK(ring.available() == kCapacity);
+    CHECK(ring.allocate(kCapacity - 400, 1, r));
+    CHECK(r.offset == 400);
+    return true;
+}
+
+} // namespace
+
+int main() {
+    const Test tests[] = {
+        { "sh kernel matches reference", testShKernelMatchesReference },
+        { "sh degree clamped to cloud", testShDegreeClamped },
+        { "sh degree controller", testShDegreeController },
+        { "projection kernels match reference", testProjectionKernelsMatchReference },
+        { "lod cut: budget and coverage", testLodCutBudgetAndCoverage },
+        { "allocator: no overlap, aligned", testAllocatorNoOverlap },
+        { "allocator: free ranges coalesce", testAllocatorCoalesces },
+        { "allocator: blocks released", testAllocatorReleasesBlocks },
+        { "staging ring: wrap, full, retire", testStagingRing },
+    };
+    return runTests(tests);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+// Shared by the test executables: the CHECK macro, a seeded generator,
+// synthetic clouds and the runner.
+
+#include "splat_cloud.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+namespace {
+
+static int gFailures = 0;
+
+#define CHECK(cond)                                                                     \
+    do {                                                                                \
+        if (!(cond)) {                                                                  \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            gFailures++;                                                                \
+            return false;                                                               \
+        }                                                                               \
+    } while (0)
+
+struct Rng {
+    uint32_t state;
+
+    // Uniform in [lo, hi).
+    float uniform(float lo, float hi) {
+        state = state * 1664525u + 1013904223u;
+        return lo + (hi - lo) * (float)(state >> 8) * (1.f / 16777216.f);
+    }
+};
+
+// Cloud of random Gaussians in a box of half-size `extent` around the
+// origin: log-uniform scales, random unit rotations.
+static void makeShapeCloud(SplatCloud& cloud, size_t n, float extent, uint32_t seed) {
+    Rng rng{ seed };
+    cloud.resize(n, 0);
+    for (size_t i = 0; i < n; i++) {
+        for (int k = 0; k < 3; k++) {
+            cloud.pos[k][i] = rng.uniform(-extent, extent);
+            cloud.scale[k][i] = std::exp(rng.uniform(-5.f, -0.5f));
+            cloud.shDc[k][i] = rng.uniform(-1.f, 1.f);
+        }
+        float q[4], len2 = 0.f;
+        for (float& v : q) {
+            v = rng.uniform(-1.f, 1.f);
+            len2 += v * v;
+        }
+        const float inv = 1.f / std::sqrt(std::max(len2, 1e-6f));
+        for (int k = 0; k < 4; k++) cloud.rot[k][i] = q[k] * inv;
+        cloud.opacity[i] = rng.uniform(0.05f, 1.f);
+    }
+}
+
+struct Test {
+    const char* name;
+    bool (*fn)();
+};
+
+// Runs every test and returns the process exit code.
+template <size_t N>
+static int runTests(const Test (&tests)[N]) {
+    for (const Test& t : tests) {
+        const bool ok = t.fn();
+        std::printf("%s %s\n", ok ? "ok  " : "FAIL", t.name);
+    }
+    return gFailures ? 1 : 0;
+}
+
+} // namespace
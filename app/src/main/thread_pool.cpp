@@ -0,0 +1,136 @@
+#include "thread_pool.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+
+// One run() call, on the caller's stack. Workers join it while it is linked
+// into runs_; the caller unlinks it once every chunk is claimed and waits
+// for the helpers still inside drain() before returning.
+struct ThreadPool::Run {
+    FunctionRef<void(size_t)> fn;
+    size_t chunks;
+    std::atomic<size_t> next{0};
+    uint32_t helpers = 0; // workers inside drain(), guarded by mutex_
+    bool linked = false;
+    Run* nextRun = nullptr;
+
+    Run(FunctionRef<void(size_t)> f, size_t c) : fn(f), chunks(c) {}
+
+    // Pulls chunks until none are left.
+    void drain() {
+        for (;;) {
+            size_t c = next.fetch_add(1, std::memory_order_relaxed);
+            if (c >= chunks) return;
+            fn(c);
+        }
+    }
+};
+
+ThreadPool::ThreadPool(unsigned workers) {
+    if (workers == 0) {
+        unsigned hw = std::thread::hardware_concurrency();
+        workers = hw > 1 ? hw - 1 : 0;
+    }
+    workers_.reserve(workers);
+    for (unsigned i = 0; i < workers; i++) {
+        workers_.emplace_back([this] { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto& t : workers_) t.join();
+}
+
+void ThreadPool::unlink(Run* run) {
+    if (!run->linked) return;
+    for (Run** r = &runs_; *r; r = &(*r)->nextRun) {
+        if (*r == run) {
+            *r = run->nextRun;
+            break;
+        }
+    }
+    run->linked = false;
+}
+
+void ThreadPool::workerLoop() {
+    traceThreadName("pool worker");
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stop_ || runs_ || !tasks_.empty(); });
+            // Fork/join work first: its caller is blocked on it.
+            if (Run* run = runs_) {
+                run->helpers++;
+                lock.unlock();
+                run->drain();
+                lock.lock();
+                // Every chunk is claimed, so nobody else needs to join.
+                unlink(run);
+                if (--run->helpers == 0) helpersDone_.notify_all();
+                continue;
+            }
+            if (stop_ && tasks_.empty()) return;
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+}
+
+void ThreadPool::run(size_t chunks, FunctionRef<void(size_t)> fn) {
+    if (chunks == 0) return;
+    if (chunks == 1 || workers_.empty()) {
+        for (size_t c = 0; c < chunks; c++) fn(c);
+        return;
+    }
+
+    Run run(fn, chunks);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        run.nextRun = runs_;
+        runs_ = &run;
+        run.linked = true;
+    }
+    if (chunks == 2) cv_.notify_one();
+    else cv_.notify_all();
+
+    run.drain();
+
+    // Helpers may still be finishing the chunks they claimed.
+    std::unique_lock<std::mutex> lock(mutex_);
+    unlink(&run);
+    helpersDone_.wait(lock, [&] { return run.helpers == 0; });
+}
+
+void ThreadPool::parallelFor(size_t n, size_t grain, FunctionRef<void(size_t, size_t)> fn) {
+    if (n == 0) return;
+    grain = std::max<size_t>(grain, 1);
+    // A few ranges per thread keeps the load balanced when ranges differ in cost.
+    size_t ranges = std::min((n + grain - 1) / grain, (size_t)concurrency() * 4);
+    size_t step = (n + ranges - 1) / ranges;
+    ranges = (n + step - 1) / step;
+    run(ranges, [&](size_t r) {
+        size_t begin = r * step;
+        fn(begin, std::min(n, begin + step));
+    });
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
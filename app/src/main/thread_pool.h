@@ -0,0 +1,78 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Non-owning reference to a callable, valid while the callable is. Lets
+// run() take any lambda without the heap allocation a std::function may
+// need for its captures.
+template <typename Sig>
+class FunctionRef;
+
+template <typename R, typename... Args>
+class FunctionRef<R(Args...)> {
+public:
+    template <typename Fn, typename = std::enable_if_t<!std::is_same<std::decay_t<Fn>, FunctionRef>::value>>
+    FunctionRef(Fn&& fn)
+        : obj_((void*)std::addressof(fn)),
+          call_([](void* obj, Args... args) -> R {
+              return (*static_cast<std::remove_reference_t<Fn>*>(obj))(std::forward<Args>(args)...);
+          }) {}
+
+    R operator()(Args... args) const { return call_(obj_, std::forward<Args>(args)...); }
+
+private:
+    void* obj_;
+    R (*call_)(void*, Args...);
+};
+
+// Fixed set of worker threads shared by the loader and preprocessing passes.
+//
+// run() is fork/join: the calling thread takes part in the work and returns
+// once every chunk is done, so it is safe to call from inside a task. It
+// does not allocate, so per-frame passes can use it freely.
+class ThreadPool {
+public:
+    // 0 picks std::thread::hardware_concurrency() - 1 workers.
+    explicit ThreadPool(unsigned workers = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Threads available to run(), including the caller.
+    unsigned concurrency() const { return (unsigned)workers_.size() + 1; }
+
+    // Calls fn(chunk) for every chunk in [0, chunks) and waits for all of them.
+    void run(size_t chunks, FunctionRef<void(size_t)> fn);
+
+    // Splits [0, n) into ranges of at least `grain` items and calls
+    // fn(begin, end) for each of them.
+    void parallelFor(size_t n, size_t grain, FunctionRef<void(size_t, size_t)> fn);
+
+    // Queues a task without waiting for it.
+    void submit(std::function<void()> task);
+
+    static ThreadPool& shared();
+
+private:
+    struct Run;
+
+    void workerLoop();
+    void unlink(Run* run);
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    Run* runs_ = nullptr; // run() calls with chunks left to claim
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::condition_variable helpersDone_;
+    bool stop_ = false;
+};
@@ -0,0 +1,215 @@
+#include "tile_binning.h"
+#include "radix_sort.h"
+#include "thread_pool.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+// Splats per block of the count/scan/fill passes.
+constexpr size_t kBlock = 1 << 14;
+
+// Added to the alpha ellipse so the blender's approximate exp never admits
+// a pixel outside the footprint.
+constexpr float kEllipseSlack = 0.01f;
+
+struct Grid {
+    uint32_t tileSize;
+    uint32_t tilesX;
+    uint32_t tilesY;
+};
+
+// Calls fn(ty, tx0, tx1) for each tile row of splat i's footprint.
+template <typename Fn>
+static void forEachSpan(const TileBinInput& in, size_t i, const Grid& g, const TileBinner::Options& o, Fn&& fn) {
+    if (!in.radius[i]) return;
+    const float ts = (float)g.tileSize;
+    const float mx = in.meanX[i], my = in.meanY[i], r = (float)in.radius[i];
+    const int x0 = std::max(0, (int)std::floor((mx - r) / ts));
+    const int y0 = std::max(0, (int)std::floor((my - r) / ts));
+    const int x1 = std::min((int)g.tilesX, (int)std::floor((mx + r) / ts) + 1);
+    const int y1 = std::min((int)g.tilesY, (int)std::floor((my + r) / ts) + 1);
+    if (x0 >= x1 || y0 >= y1) return;
+
+    const float A = in.conicA[i], B = in.conicB[i], C = in.conicC[i];
+    const float det = A * C - B * B;
+    auto square = [&](int tx0, int ty0, int tx1, int ty1) {
+        for (int ty = ty0; ty < ty1; ty++) fn((uint32_t)ty, (uint32_t)tx0, (uint32_t)tx1);
+    };
+    // A single tile has nothing to trim.
+    if (!o.conicFootprint || (x1 - x0 == 1 && y1 - y0 == 1) || !(A > 0.f) || !(det > 0.f)) {
+        square(x0, y0, x1, y1);
+        return;
+    }
+
+    // Alpha reaches minAlpha where A dx^2 + 2B dx dy + C dy^2 = k2.
+    const float opacity = in.opacity[i];
+    if (!(opacity >= o.minAlpha)) return;
+    const float k2 = 2.f * std::log(opacity / o.minAlpha) + kEllipseSlack;
+    // Extents from the covariance, the conic's inverse.
+    const float invDet = 1.f / det;
+    const float xExtent = std::sqrt(k2 * C * invDet), yExtent = std::sqrt(k2 * A * invDet);
+    const int ex0 = std::max(x0, (int)std::floor((mx - xExtent) / ts));
+    const int ey0 = std::max(y0, (int)std::floor((my - yExtent) / ts));
+    const int ex1 = std::min(x1, (int)std::floor((mx + xExtent) / ts) + 1);
+    const int ey1 = std::min(y1, (int)std::floor((my + yExtent) / ts) + 1);
+    if (ex0 >= ex1 || ey0 >= ey1) return;
+    // The ellipse's box is exact when it spans one row or one column.
+    if (ex1 - ex0 == 1 || ey1 - ey0 == 1) {
+        square(ex0, ey0, ex1, ey1);
+        return;
+    }
+
+    // dy of the rightmost point; the leftmost is at -dyRight. Within a
+    // band of rows the right edge peaks closest to it, the left likewise.
+    const float dyRight = -B / C * xExtent;
+    const float invA = 1.f / A;
+    auto edge = [&](float dy, float sign) {
+        const float disc = std::max(0.f, A * k2 - dy * dy * det);
+        return (-B * dy + sign * std::sqrt(disc)) * invA;
+    };
+    for (int ty = ey0; ty < ey1; ty++) {
+        const float lo = std::max((float)ty * ts - my, -yExtent);
+        const float hi = std::min((float)(ty + 1) * ts - my, yExtent);
+        const float right = mx + edge(std::min(std::max(dyRight, lo), hi), 1.f);
+        const float left = mx + edge(std::min(std::max(-dyRight, lo), hi), -1.f);
+        const int tx0 = std::max(ex0, (int)std::floor(left / ts));
+        const int tx1 = std::min(ex1, (int)std::floor(right / ts) + 1);
+        if (tx0 < tx1) fn((uint32_t)ty, (uint32_t)tx0, (uint32_t)tx1);
+    }
+}
+
+} // namespace
+
+void TileBinner::bin(const TileBinInput& in, uint32_t width, uint32_t height, ThreadPool& pool) {
+    GS_TRACE_SCOPE("TileBinner::bin");
+    stats_ = Stats{};
+    auto start = Clock::now();
+    const size_t n = in.count;
+    const Grid grid{ options.tileSize, (width + options.tileSize - 1) / options.tileSize,
+                     (height + options.tileSize - 1) / options.tileSize };
+    tilesX_ = grid.tilesX;
+    tilesY_ = grid.tilesY;
+    const uint32_t tiles = tilesX_ * tilesY_;
+
+    const size_t blocks = (n + kBlock - 1) / kBlock;
+    auto forBlocks = [&](auto&& fn) {
+        pool.run(blocks, [&](size_t b) { fn(b, b * kBlock, std::min(n, (b + 1) * kBlock)); });
+    };
+
+    // Count, with each block's total for the scan.
+    auto t0 = Clock::now();
+    counts_.resize(n);
+    rects_.resize(n * 4);
+    offsets_.resize(n);
+    blockSums_.assign(blocks + 1, 0);
+    blockVisible_.assign(blocks, 0);
+    forBlocks([&](size_t b, size_t begin, size_t end) {
+        uint64_t sum = 0;
+        size_t visible = 0;
+        for (size_t i = begin; i < end; i++) {
+            uint32_t count = 0;
+            uint32_t box[4] = { UINT32_MAX, UINT32_MAX, 0, 0 };
+            forEachSpan(in, i, grid, options, [&](uint32_t ty, uint32_t tx0, uint32_t tx1) {
+                count += tx1 - tx0;
+                box[0] = std::min(box[0], tx0);
+                box[1] = std::min(box[1], ty);
+                box[2] = std::max(box[2], tx1);
+                box[3] = ty + 1;
+            });
+            counts_[i] = count;
+            for (int k = 0; k < 4; k++) rects_[i * 4 + k] = count ? (uint16_t)box[k] : 0;
+            sum += count;
+            visible += count ? 1 : 0;
+        }
+        blockSums_[b + 1] = sum;
+        blockVisible_[b] = visible;
+    });
+    for (size_t v : blockVisible_) stats_.visible += v;
+    stats_.countMs = msSince(t0);
+
+    // Scan: block totals serially, then each block's own prefix. Ordered
+    // input lays the slices out in its order, so its blocks are re-summed
+    // along it; count and fill stay in splat order, which reads the inputs
+    // sequentially.
+    t0 = Clock::now();
+    if (in.order) {
+        forBlocks([&](size_t b, size_t begin, size_t end) {
+            uint64_t sum = 0;
+            for (size_t p = begin; p < end; p++) sum += counts_[in.order[p]];
+            blockSums_[b + 1] = sum;
+        });
+    }
+    for (size_t b = 0; b < blocks; b++) blockSums_[b + 1] += blockSums_[b];
+    const size_t total = (size_t)blockSums_[blocks];
+    stats_.entries = total;
+    forBlocks([&](size_t b, size_t begin, size_t end) {
+        uint32_t offset = (uint32_t)blockSums_[b];
+        for (size_t p = begin; p < end; p++) {
+            const size_t i = in.order ? in.order[p] : p;
+            offsets_[i] = offset;
+            offset += counts_[i];
+        }
+    });
+    stats_.scanMs = msSince(t0);
+
+    // Fill: each splat owns its slice, in splat (or the input's) order, so
+    // the stable sort breaks depth ties the same way every frame. Only
+    // footprints smaller than their box need the ellipse again.
+    t0 = Clock::now();
+    keys_.resize(total);
+    values_.resize(total);
+    keysTmp_.resize(total);
+    valuesTmp_.resize(total);
+    forBlocks([&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            if (!counts_[i]) continue;
+            uint32_t k = offsets_[i];
+            const float depth = in.depth[i];
+            auto span = [&](uint32_t ty, uint32_t tx0, uint32_t tx1) {
+                for (uint32_t tx = tx0; tx < tx1; tx++) {
+                    const uint32_t tile = ty * tilesX_ + tx;
+                    keys_[k] = in.order ? (uint64_t)tile : packTileDepthKey(tile, depth);
+                    values_[k++] = (uint32_t)i;
+                }
+            };
+            const uint16_t* r = &rects_[i * 4];
+            if (counts_[i] == (uint32_t)(r[2] - r[0]) * (uint32_t)(r[3] - r[1])) {
+                for (uint32_t ty = r[1]; ty < r[3]; ty++) span(ty, r[0], r[2]);
+            } else {
+                forEachSpan(in, i, grid, options, span);
+            }
+        }
+    });
+    stats_.fillMs = msSince(t0);
+
+    t0 = Clock::now();
+    uint32_t tileBits = 0;
+    while ((1u << tileBits) < tiles) tileBits++;
+    const uint32_t tileShift = in.order ? 0 : 32;
+    radixSortPairs(keys_.data(), values_.data(), total, keysTmp_.data(), valuesTmp_.data(), pool, tileShift + tileBits);
+    stats_.sortMs = msSince(t0);
+
+    // Ranges: the first and last entry of each tile's run write its bounds.
+    t0 = Clock::now();
+    ranges_.assign(tiles, TileRange{ 0, 0 });
+    pool.parallelFor(total, kBlock, [&](size_t begin, size_t end) {
+        for (size_t e = begin; e < end; e++) {
+            const uint32_t tile = (uint32_t)(keys_[e] >> tileShift);
+            if (e == 0 || (uint32_t)(keys_[e - 1] >> tileShift) != tile) ranges_[tile].begin = (uint32_t)e;
+            if (e + 1 == total || (uint32_t)(keys_[e + 1] >> tileShift) != tile) ranges_[tile].end = (uint32_t)(e + 1);
+        }
+    });
+    stats_.rangesMs = msSince(t0);
+
+    stats_.totalMs = msSince(start);
+}
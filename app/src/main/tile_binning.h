@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// Projected splats as the binner reads them, one entry per splat: screen
+// mean, conic (inverse 2D covariance: A, B, C for A x^2 + 2B xy + C y^2),
+// view depth, opacity and bounding radius in pixels. Radius 0 marks a
+// culled splat.
+struct TileBinInput {
+    size_t count = 0;
+    const float* meanX = nullptr;
+    const float* meanY = nullptr;
+    const float* conicA = nullptr;
+    const float* conicB = nullptr;
+    const float* conicC = nullptr;
+    const float* depth = nullptr;
+    const float* opacity = nullptr;
+    const uint32_t* radius = nullptr;
+    // Optional front-to-back order of the splats (e.g. from a DepthSorter).
+    // With it the keys carry only the tile, and the stable sort keeps each
+    // tile's splats in this order.
+    const uint32_t* order = nullptr;
+};
+
+// Entries [begin, end) of one tile in the sorted lists; {0, 0} when empty.
+struct TileRange {
+    uint32_t begin;
+    uint32_t end;
+};
+
+// Duplicates each projected splat once per screen tile it overlaps and
+// sorts the copies by (tile, depth), so every tile's splats are contiguous
+// and front to back.
+//
+// The passes are flat parallel loops over plain arrays, one per future
+// compute dispatch, and none needs atomics since every output slot has a
+// single writer:
+//
+//   count   tiles touched by splat i            -> counts[i], rects[i]
+//   scan    exclusive prefix sum of counts      -> offsets[i], total
+//   fill    splat i writes its tile|depth keys  -> keys/values[offsets[i] ...]
+//   sort    radix sort on the 64-bit keys (tile bits only for ordered input)
+//   ranges  entries at tile boundaries write    -> ranges[tile]
+//
+// The footprint is the set of tiles, row by row, that the ellipse where
+// the splat's alpha reaches minAlpha overlaps, within its radius square.
+// With conicFootprint off the whole square is used, which duplicates
+// elongated and faint splats into many tiles they never touch.
+class TileBinner {
+public:
+    struct Options {
+        uint32_t tileSize = 16;
+        float minAlpha = 1.f / 255.f;  // the blender's cutoff
+        bool conicFootprint = true;
+    };
+
+    struct Stats {
+        double countMs = 0.0;
+        double scanMs = 0.0;
+        double fillMs = 0.0;
+        double sortMs = 0.0;
+        double rangesMs = 0.0;
+        double totalMs = 0.0;
+        size_t visible = 0; // splats in at least one tile
+        size_t entries = 0; // (tile, splat) pairs
+    };
+
+    Options options;
+
+    void bin(const TileBinInput& input, uint32_t width, uint32_t height, ThreadPool& pool);
+
+    uint32_t tilesX() const { return tilesX_; }
+    uint32_t tilesY() const { return tilesY_; }
+    // tile << 32 | depth bits, or just the tile for ordered input,
+    // ascending; values are splat indices.
+    const std::vector<uint64_t>& keys() const { return keys_; }
+    const std::vector<uint32_t>& values() const { return values_; }
+    // Row-major, tilesX * tilesY.
+    const std::vector<TileRange>& ranges() const { return ranges_; }
+    const Stats& stats() const { return stats_; }
+
+private:
+    uint32_t tilesX_ = 0;
+    uint32_t tilesY_ = 0;
+
+    std::vector<uint32_t> counts_;
+    std::vector<uint16_t> rects_; // tile box of each footprint: x0, y0, x1, y1
+    std::vector<uint32_t> offsets_;
+    std::vector<uint64_t> blockSums_;
+    std::vector<size_t> blockVisible_;
+    std::vector<uint64_t> keys_;
+    std::vector<uint32_t> values_;
+    std::vector<uint64_t> keysTmp_;
+    std::vector<uint32_t> valuesTmp_;
+    std::vector<TileRange> ranges_;
+
+    Stats stats_;
+};
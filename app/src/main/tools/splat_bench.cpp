@@ -0,0 +1,1093 @@
+// Host benchmark for the CPU side of the splat pipeline.
+//
+// Usage: splat_bench --ply-loaders DIR
+//        splat_bench --sort
+//        splat_bench <scene.ply|scene.gsc> [--frames N] [--leaf N]
+//                    [--size WxH] [--render] [--lod BUDGET] [--sh] [--cov]
+//                    [--alloc] [--async] [--morton] [--residency MB]
+//                    [--binning] [--project] [--trace FILE]
+//
+// Builds the spatial index and reports its build time, memory and cull
+// ratio along two camera paths: a yaw sweep from the scene centre (room
+// walk-through) and an orbit outside the bounds. With --render every frame
+// is also rasterized with and without culling; built with
+// GS_TRACK_ALLOCATIONS, each culled frame is rendered again and the run
+// fails if the repeat touches the heap. --lod builds the LOD
+// hierarchy and reports the cut selected under the given splat budget,
+// failing if any frame's cut exceeds it.
+// --sh times SH colour evaluation per degree against the scalar reference
+// and fails if the error exceeds 1e-5.
+// --cov compares projection time and memory with precomputed covariances.
+// --alloc runs the GPU sub-allocator and staging ring on host memory: the
+// scene's planes as buffers, a chunk churn, and a streamed upload.
+// --residency streams a .gsc scene through ChunkResidency with the given
+// budget along the paths and a walk through the scene at ~60 Hz and
+// reports hit rate and chunk traffic.
+// --binning times the tile binning passes at 1080p and a 2K per-eye
+// headset resolution, with conic and radius-square footprints and with a
+// global depth presort.
+// --project times the projection kernels along the orbit and fails when a
+// SIMD kernel strays from the scalar reference beyond its error bound.
+// --ply-loaders writes synthetic 1M and 5M-vertex binary point clouds to
+// DIR and times loadPlyVertices against the original ifstream loader,
+// failing if their results differ.
+// --sort times the full and coherent depth sorts on synthetic 1M to 8M
+// splat clouds along static, slowly orbiting and cutting camera traces.
+// --trace writes a Chrome trace of the whole run (loads, preprocessing and
+// every benchmarked frame) to FILE; needs a GS_ENABLE_TRACING build.
+
+#include "alloc_tracker.h"
+#include "camera.h"
+#include "chunk_residency.h"
+#include "compact_splat.h"
+#include "covariance_store.h"
+#include "cpu_rasterizer.h"
+#include "depth_sorter.h"
+#include "gpu_allocator.h"
+#include "morton_order.h"
+#include "ply_loader.h"
+#include "scene_loader.h"
+#include "sh_eval.h"
+#include "spatial_index.h"
+#include "splat_cloud.h"
+#include "splat_lod.h"
+#include "splat_projection.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+// Writes the capture started for --trace once main returns.
+struct TraceFile {
+    std::string path;
+
+    ~TraceFile() {
+        if (path.empty()) return;
+        traceStop();
+        TraceWriteStats st;
+        std::string error;
+        if (traceWrite(path, &st, &error)) {
+            std::printf("trace: %llu events on %u threads, %llu dropped, written to %s\n",
+                        (unsigned long long)st.events, st.threads, (unsigned long long)st.dropped, path.c_str());
+        } else {
+            std::fprintf(stderr, "trace: %s\n", error.c_str());
+        }
+    }
+};
+
+static void usage() {
+    std::fprintf(stderr, "usage: splat_bench --ply-loaders DIR\n");
+    std::fprintf(stderr, "       splat_bench --sort\n");
+    std::fprintf(stderr, "       splat_bench <scene.ply|scene.gsc> [--frames N] [--leaf N] [--size WxH] [--render] [--lod BUDGET] [--sh] [--cov] [--alloc] [--async] [--morton] [--residency MB] [--binning] [--project] [--trace FILE]\n");
+}
+
+// The binary path of loadPlyVertices before it was memory mapped: rows
+// read through std::ifstream and every property's type matched by name on
+// every row. Kept as the baseline for --ply-loaders.
+static bool legacyLoadPlyVertices(const std::string& path, std::vector<PlyPoint>& out) {
+    out.clear();
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) return false;
+
+    struct Property {
+        std::string name;
+        std::string type;
+        size_t offset = 0;
+    };
+    auto typeSize = [](const std::string& t) -> size_t {
+        if (t == "char" || t == "int8" || t == "uchar" || t == "uint8") return 1;
+        if (t == "short" || t == "int16" || t == "ushort" || t == "uint16") return 2;
+        if (t == "int" || t == "int32" || t == "uint" || t == "uint32") return 4;
+        if (t == "float" || t == "float32") return 4;
+        if (t == "double" || t == "float64") return 8;
+        return 0;
+    };
+
+    std::string line;
+    if (!std::getline(in, line) || line.rfind("ply", 0) != 0) return false;
+    bool binary = false, inVertex = false;
+    uint32_t vertexCount = 0;
+    std::vector<Property> props;
+    size_t stride = 0;
+    while (std::getline(in, line)) {
+        if (line == "end_header") break;
+        std::istringstream ss(line);
+        std::string tok;
+        ss >> tok;
+        if (tok == "format") {
+            std::string fmt;
+            ss >> fmt;
+            binary = fmt == "binary_little_endian";
+        } else if (tok == "element") {
+            std::string name;
+            uint32_t count = 0;
+            ss >> name >> count;
+            inVertex = name == "vertex";
+            if (inVertex) vertexCount = count;
+        } else if (tok == "property" && inVertex) {
+            Property p;
+            ss >> p.type >> p.name;
+            const size_t size = typeSize(p.type);
+            if (p.type == "list" || size == 0) return false;
+            p.offset = stride;
+            props.push_back(p);
+            stride += size;
+        }
+    }
+    if (!binary || vertexCount == 0) return false;
+
+    const Property *px = nullptr, *py = nullptr, *pz = nullptr, *pr = nullptr, *pg = nullptr, *pb = nullptr;
+    for (const Property& p : props) {
+        if (p.name == "x") px = &p;
+        else if (p.name == "y") py = &p;
+        else if (p.name == "z") pz = &p;
+        else if (p.name == "red" || p.name == "r") pr = &p;
+        else if (p.name == "green" || p.name == "g") pg = &p;
+        else if (p.name == "blue" || p.name == "b") pb = &p;
+    }
+    if (!px || !py || !pz) return false;
+
+    out.resize(vertexCount);
+    std::vector<uint8_t> row(stride);
+    for (uint32_t i = 0; i < vertexCount; i++) {
+        if (!in.read(reinterpret_cast<char*>(row.data()), (std::streamsize)stride)) return false;
+        auto readF = [&](const Property* p, float def) -> float {
+            if (!p) return def;
+            std::istringstream dummy;
+            auto get = [&](auto v) {
+                std::memcpy(&v, row.data() + p->offset, sizeof(v));
+                return (float)v;
+            };
+            if (p->type == "float" || p->type == "float32") return get(float());
+            if (p->type == "double" || p->type == "float64") return get(double());
+            if (p->type == "int" || p->type == "int32") return get(int32_t());
+            if (p->type == "uint" || p->type == "uint32") return get(uint32_t());
+            if (p->type == "short" || p->type == "int16") return get(int16_t());
+            if (p->type == "ushort" || p->type == "uint16") return get(uint16_t());
+            if (p->type == "char" || p->type == "int8") return get(int8_t());
+            if (p->type == "uchar" || p->type == "uint8") return get(uint8_t());
+            return def;
+        };
+        PlyPoint& pt = out[i];
+        pt.x = readF(px, 0.f);
+        pt.y = readF(py, 0.f);
+        pt.z = readF(pz, 0.f);
+        pt.r = pr ? (uint8_t)readF(pr, 255.f) : 255;
+        pt.g = pg ? (uint8_t)readF(pg, 255.f) : 255;
+        pt.b = pb ? (uint8_t)readF(pb, 255.f) : 255;
+    }
+    return true;
+}
+
+// A binary point cloud as common exporters write it: position, normal and
+// 8-bit colour.
+static bool writeSyntheticPly(const std::string& path, uint32_t vertices) {
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+    std::fprintf(f, "ply\nformat binary_little_endian 1.0\nelement vertex %u\n"
+                    "property float x\nproperty float y\nproperty float z\n"
+                    "property float nx\nproperty float ny\nproperty float nz\n"
+                    "property uchar red\nproperty uchar green\nproperty uchar blue\nend_header\n",
+                 vertices);
+    constexpr size_t kStride = 6 * sizeof(float) + 3;
+    std::vector<uint8_t> block(kStride * 65536);
+    uint32_t rng = 12345;
+    auto next = [&]() { return rng = rng * 1664525u + 1013904223u; };
+    bool ok = true;
+    for (uint32_t base = 0; base < vertices && ok; base += 65536) {
+        const uint32_t n = std::min<uint32_t>(65536, vertices - base);
+        for (uint32_t i = 0; i < n; i++) {
+            uint8_t* row = &block[i * kStride];
+            float v[6];
+            for (float& x : v) x = (float)(next() >> 8) * (1.f / 16777216.f) * 20.f - 10.f;
+            std::memcpy(row, v, sizeof(v));
+            for (int k = 0; k < 3; k++) row[sizeof(v) + k] = (uint8_t)(next() >> 24);
+        }
+        ok = std::fwrite(block.data(), kStride, n, f) == n;
+    }
+    return std::fclose(f) == 0 && ok;
+}
+
+// Best of three loads of synthetic 1M and 5M-vertex files with each loader.
+static bool benchPlyLoaders(const std::string& dir) {
+    const uint32_t sizes[] = { 1000000, 5000000 };
+    for (uint32_t vertices : sizes) {
+        const std::string path = dir + "/synthetic_" + std::to_string(vertices / 1000000) + "m.ply";
+        if (!writeSyntheticPly(path, vertices)) {
+            std::fprintf(stderr, "cannot write %s\n", path.c_str());
+            return false;
+        }
+        std::vector<PlyPoint> legacy, mapped;
+        double legacyMs = 1e30, mappedMs = 1e30;
+        for (int run = 0; run < 3; run++) {
+            auto t0 = Clock::now();
+            if (!legacyLoadPlyVertices(path, legacy)) {
+                std::fprintf(stderr, "legacy loader failed on %s\n", path.c_str());
+                return false;
+            }
+            legacyMs = std::min(legacyMs, msSince(t0));
+            std::string error;
+            t0 = Clock::now();
+            if (!loadPlyVertices(path, mapped, &error)) {
+                std::fprintf(stderr, "loadPlyVertices failed on %s: %s\n", path.c_str(), error.c_str());
+                return false;
+            }
+            mappedMs = std::min(mappedMs, msSince(t0));
+        }
+        bool same = legacy.size() == mapped.size();
+        for (size_t i = 0; same && i < legacy.size(); i++) {
+            const PlyPoint &a = legacy[i], &b = mapped[i];
+            same = a.x == b.x && a.y == b.y && a.z == b.z && a.r == b.r && a.g == b.g && a.b == b.b;
+        }
+        std::printf("ply %uM vertices: ifstream loader %8.1f ms, mapped loader %7.1f ms (%.1fx)%s\n",
+                    vertices / 1000000, legacyMs, mappedMs, mappedMs > 0 ? legacyMs / mappedMs : 0.0,
+                    same ? "" : ", RESULTS DIFFER");
+        if (!same) return false;
+    }
+    return true;
+}
+
+// Depth sort of synthetic clouds (uniform in a cube, seen from outside)
+// along three camera traces: a static camera, a slow orbit (0.1 degrees a
+// frame) and hard cuts (137.5 degrees a frame). Full and coherent modes
+// run side by side; the run fails if either order is not a depth-sorted
+// permutation.
+static bool benchSort() {
+    const size_t sizes[] = { 1000000, 2000000, 4000000, 8000000 };
+    const char* traces[3] = { "static", "orbit", "cut" };
+    const float stepDegrees[3] = { 0.f, 0.1f, 137.5f };
+    constexpr uint32_t kFrames = 12;
+    const float centre[3] = { 0.f, 0.f, 0.f };
+    const float up[3] = { 0.f, -1.f, 0.f };
+    const float fov = 60.f * 3.14159265f / 180.f;
+
+    SplatCloud cloud;
+    std::vector<uint8_t> seen;
+    for (size_t n : sizes) {
+        cloud.resize(n, 0);
+        uint32_t rng = 12345;
+        for (size_t i = 0; i < n; i++) {
+            for (int k = 0; k < 3; k++) {
+                rng = rng * 1664525u + 1013904223u;
+                cloud.pos[k][i] = (float)(rng >> 8) * (1.f / 16777216.f) * 20.f - 10.f;
+            }
+        }
+        for (int t = 0; t < 3; t++) {
+            DepthSorter sorters[2];
+            sorters[0].options.mode = DepthSorter::Mode::Full;
+            sorters[1].options.mode = DepthSorter::Mode::Coherent;
+            double ms[2] = { 0.0, 0.0 };
+            uint32_t reused = 0;
+            size_t displaced = 0;
+            for (uint32_t f = 0; f < kFrames; f++) {
+                const float a = stepDegrees[t] * (float)f * 3.14159265f / 180.f;
+                const float eye[3] = { 25.f * std::cos(a), 0.f, 25.f * std::sin(a) };
+                const Camera cam = makeLookAtCamera(eye, centre, up, fov, 1920, 1080);
+                for (int m = 0; m < 2; m++) {
+                    const std::vector<uint32_t>& order = sorters[m].sort(cloud, cam);
+                    ms[m] += sorters[m].stats().ms;
+                    // Front to back (up to rounding of the depth) and each
+                    // splat exactly once.
+                    seen.assign(n, 0);
+                    float prevDepth = -INFINITY;
+                    bool ok = order.size() == n;
+                    for (size_t i = 0; ok && i < n; i++) {
+                        const uint32_t idx = order[i];
+                        ok = idx < n && !seen[idx];
+                        if (!ok) break;
+                        seen[idx] = 1;
+                        const float p[3] = { cloud.pos[0][idx], cloud.pos[1][idx], cloud.pos[2][idx] };
+                        float v[3];
+                        cam.toView(p, v);
+                        ok = v[2] + 1e-5f * std::fabs(v[2]) >= prevDepth;
+                        prevDepth = std::max(prevDepth, v[2]);
+                    }
+                    if (!ok) {
+                        std::fprintf(stderr, "sort %zu %s: %s order is wrong at frame %u\n", n, traces[t],
+                                     m ? "coherent" : "full", f);
+                        return false;
+                    }
+                }
+                reused += sorters[1].stats().reusedOrder ? 1 : 0;
+                displaced += sorters[1].stats().displaced;
+            }
+            std::printf("sort %zuM %-6s: full %7.1f ms, coherent %7.1f ms (%.1fx), order reused %u/%u frames, "
+                        "%.0f displaced/frame\n",
+                        n / 1000000, traces[t], ms[0] / kFrames, ms[1] / kFrames, ms[1] > 0 ? ms[0] / ms[1] : 0.0,
+                        reused, kFrames, (double)displaced / kFrames);
+        }
+    }
+    return true;
+}
+
+struct Bounds {
+    float min[3] = { INFINITY, INFINITY, INFINITY };
+    float max[3] = { -INFINITY, -INFINITY, -INFINITY };
+};
+
+static Bounds sceneBounds(const SplatCloud& cloud) {
+    Bounds b;
+    for (int k = 0; k < 3; k++) {
+        for (size_t i = 0; i < cloud.count; i++) {
+            b.min[k] = std::min(b.min[k], cloud.pos[k][i]);
+            b.max[k] = std::max(b.max[k], cloud.pos[k][i]);
+        }
+    }
+    return b;
+}
+
+// Times the SH kernel for every degree the cloud supports and checks it
+// against the scalar reference.
+// Fails when the kernel strays from the reference by more than the bound
+// core_tests holds it to.
+static bool benchSh(const SplatCloud& cloud) {
+    const float kMaxError = 1e-5f;
+    bool ok = true;
+    const size_t n = cloud.count;
+    std::vector<float> rgb(n * 3), ref(n * 3);
+    const float eye[3] = { 0.f, 0.f, 0.f };
+    for (uint32_t d = 0; d <= cloud.shDegree(); d++) {
+        auto t0 = Clock::now();
+        evalShColors(cloud, eye, d, 0, n, rgb.data(), rgb.data() + n, rgb.data() + 2 * n);
+        const double simdMs = msSince(t0);
+        t0 = Clock::now();
+        evalShColorsReference(cloud, eye, d, 0, n, ref.data(), ref.data() + n, ref.data() + 2 * n);
+        const double refMs = msSince(t0);
+
+        float maxErr = 0.f;
+        for (size_t i = 0; i < rgb.size(); i++) maxErr = std::max(maxErr, std::fabs(rgb[i] - ref[i]));
+        std::printf("sh degree %u: %7.2f ms (%6.1f Msplat/s), reference %7.2f ms, max error %g%s\n",
+                    d, simdMs, simdMs > 0 ? (double)n / (simdMs * 1000.0) : 0.0, refMs, maxErr,
+                    maxErr <= kMaxError ? "" : ", OVER BOUND");
+        ok = ok && maxErr <= kMaxError;
+    }
+    return ok;
+}
+
+// Projection time per frame with covariances from scale/rotation, and from
+// fp32 and fp16 stores, over a short orbit.
+static void benchCovariance(const SplatCloud& cloud, const Camera* cams, uint32_t frames, uint32_t width, uint32_t height) {
+    std::vector<uint8_t> image((size_t)width * height * 4);
+    CovarianceStore f32, f16;
+    f32.build(cloud, CovariancePrecision::Float32);
+    f16.build(cloud, CovariancePrecision::Float16);
+
+    const size_t shapeBytes = 7 * sizeof(float) * cloud.count;
+    const CovarianceStore* stores[3] = { nullptr, &f32, &f16 };
+    const char* names[3] = { "scale+rot", "cov fp32", "cov fp16" };
+    for (int s = 0; s < 3; s++) {
+        CpuRasterizer raster;
+        raster.options.covariances = stores[s];
+        double projectMs = 0.0;
+        for (uint32_t f = 0; f < frames; f++) {
+            raster.render(cloud, cams[f], image.data(), (size_t)width * 4);
+            projectMs += raster.stats().projectMs;
+        }
+        const size_t bytes = stores[s] ? stores[s]->bytes() : shapeBytes;
+        std::printf("%-9s: %6.2f MB (%4.1f B/splat), build %6.1f ms, project %6.2f ms/frame\n",
+                    names[s], (double)bytes / (1024.0 * 1024.0), cloud.count ? (double)bytes / (double)cloud.count : 0.0,
+                    stores[s] ? stores[s]->buildMs() : 0.0, projectMs / (double)frames);
+    }
+}
+
+// Culling against fixed chunks of consecutive splats (as .gsc chunks and
+// GPU dispatch groups are laid out) and projection time, in file order and
+// after Morton ordering. Chunk boxes cover splat centres only.
+static void benchMorton(const SplatCloud& cloud, const Camera* cams, uint32_t frames, uint32_t width, uint32_t height) {
+    constexpr size_t kChunk = 4096;
+    SplatCloud sorted;
+    sorted.resize(cloud.count, cloud.shRestCoeffs);
+    copySplats(cloud, sorted, 0);
+
+    const MortonBits bits[2] = { MortonBits::Bits30, MortonBits::Bits63 };
+    for (int b = 0; b < 2; b++) {
+        if (b == 1) copySplats(cloud, sorted, 0);
+        MortonOrderStats ms;
+        mortonOrderSplats(sorted, bits[b], &ms);
+        std::printf("morton %u-bit: %.1f ms (bounds %.1f, codes %.1f, sort %.1f, permute %.1f)\n",
+                    3 * (uint32_t)bits[b], ms.totalMs, ms.boundsMs, ms.codeMs, ms.sortMs, ms.permuteMs);
+    }
+
+    std::vector<uint8_t> image((size_t)width * height * 4);
+    const SplatCloud* clouds[2] = { &cloud, &sorted };
+    const char* names[2] = { "file order", "morton" };
+    for (int c = 0; c < 2; c++) {
+        const SplatCloud& sc = *clouds[c];
+        const size_t chunks = (sc.count + kChunk - 1) / kChunk;
+        std::vector<Bounds> boxes(chunks);
+        double boxVolume = 0.0;
+        for (size_t ch = 0; ch < chunks; ch++) {
+            Bounds& bb = boxes[ch];
+            for (size_t i = ch * kChunk; i < std::min(sc.count, (ch + 1) * kChunk); i++) {
+                for (int k = 0; k < 3; k++) {
+                    bb.min[k] = std::min(bb.min[k], sc.pos[k][i]);
+                    bb.max[k] = std::max(bb.max[k], sc.pos[k][i]);
+                }
+            }
+            boxVolume += (double)(bb.max[0] - bb.min[0]) * (bb.max[1] - bb.min[1]) * (bb.max[2] - bb.min[2]);
+        }
+
+        CpuRasterizer raster;
+        double cullMs = 0.0, projectMs = 0.0;
+        size_t kept = 0;
+        for (uint32_t f = 0; f < frames; f++) {
+            auto t0 = Clock::now();
+            const Frustum fr = cams[f].frustum();
+            for (const Bounds& bb : boxes) kept += fr.intersects(bb.min, bb.max) ? 1 : 0;
+            cullMs += msSince(t0);
+            raster.render(sc, cams[f], image.data(), (size_t)width * 4);
+            projectMs += raster.stats().projectMs;
+        }
+        std::printf("%-10s: %zu chunks of %zu, mean box volume %.3g, chunks kept %.1f%%, cull %.3f ms, project %.2f ms/frame\n",
+                    names[c], chunks, kChunk, chunks ? boxVolume / (double)chunks : 0.0,
+                    chunks ? 100.0 * (double)kept / ((double)chunks * frames) : 0.0, cullMs / frames, projectMs / frames);
+    }
+}
+
+static bool benchGpuMemory(const SplatCloud& cloud) {
+    HostMemoryBackend backend;
+    GpuAllocator allocator(backend);
+
+    // One buffer per attribute plane, as the GPU path will upload them.
+    const size_t planes = 3 + 3 + 4 + 1 + 3 + 3 * (size_t)cloud.shRestCoeffs;
+    const uint64_t planeBytes = std::max<uint64_t>(4, (uint64_t)cloud.count * sizeof(float));
+    std::vector<GpuAllocation> buffers(planes);
+    for (auto& a : buffers) {
+        if (!allocator.allocate(0, planeBytes, 256, a)) {
+            std::fprintf(stderr, "alloc: %llu-byte plane buffer failed\n", (unsigned long long)planeBytes);
+            return false;
+        }
+    }
+    GpuAllocator::Stats st = allocator.stats();
+    std::printf("alloc: %zu plane buffers, %u backend allocations, %.1f MB in %.1f MB of blocks\n", planes,
+                backend.totalAllocations(), (double)st.usedBytes / (1024.0 * 1024.0),
+                (double)st.blockBytes / (1024.0 * 1024.0));
+
+    // Chunk churn: residency-style buffers of mixed sizes freed in random
+    // order, then refilled.
+    std::vector<GpuAllocation> chunks(4096);
+    uint32_t rng = 12345;
+    auto next = [&]() { return rng = rng * 1664525u + 1013904223u; };
+    auto t0 = Clock::now();
+    uint32_t ops = 0;
+    for (int round = 0; round < 8; round++) {
+        for (auto& a : chunks) {
+            if (a && (next() & 1)) {
+                allocator.free(a);
+                ops++;
+            }
+        }
+        for (auto& a : chunks) {
+            if (!a) {
+                const uint64_t size = 4096 + (next() % 256) * 1024;
+                if (!allocator.allocate(0, size, 256, a)) {
+                    std::fprintf(stderr, "alloc churn: %llu-byte chunk failed\n", (unsigned long long)size);
+                    return false;
+                }
+                ops++;
+            }
+        }
+    }
+    const double churnMs = msSince(t0);
+    st = allocator.stats();
+    std::printf("alloc churn: %u ops in %.1f ms (%.2f us/op), %u allocations in %u blocks (%u backend "
+                "allocations total), fragmentation %.2f\n",
+                ops, churnMs, 1e3 * churnMs / (double)std::max(1u, ops), st.allocations, st.blocks,
+                backend.totalAllocations(), st.fragmentation);
+    for (auto& a : chunks) allocator.free(a);
+    for (auto& a : buffers) allocator.free(a);
+
+    // Streaming: every plane through a 32 MB ring in 4 MB chunks with two
+    // frames in flight.
+    constexpr uint64_t kRing = 32ull << 20, kChunk = 4ull << 20;
+    GpuAllocation ringMemory;
+    if (!allocator.allocate(1, kRing, 256, ringMemory)) {
+        std::fprintf(stderr, "staging: ring allocation failed\n");
+        return false;
+    }
+    StagingRing ring;
+    ring.init(ringMemory.mapped, kRing);
+    std::vector<uint8_t> src((size_t)std::min<uint64_t>(planeBytes, kChunk), 0x5a);
+    uint64_t frame = 0, remaining = planeBytes * planes;
+    while (remaining > 0) {
+        StagingRing::Region region;
+        const uint64_t n = std::min<uint64_t>(remaining, src.size());
+        if (ring.upload(src.data(), n, 16, region)) {
+            remaining -= n;
+            continue;
+        }
+        ring.submit(++frame);
+        if (frame >= 2) ring.retire(frame - 2);
+    }
+    ring.submit(++frame);
+    const StagingRing::Stats& rs = ring.stats();
+    std::printf("staging: %.1f MB in %llu frames, copy %.0f MB/s, %u full stalls\n",
+                (double)rs.bytesUploaded / (1024.0 * 1024.0), (unsigned long long)frame, rs.copyMBps(), rs.full);
+    allocator.free(ringMemory);
+    return true;
+}
+
+struct PathResult {
+    double queryMs = 0.0;
+    double culled = 0.0;
+    double ranges = 0.0;
+    double renderAllMs = 0.0;
+    double renderCulledMs = 0.0;
+    double cutMs = 0.0;
+    double cutVisible = 0.0;
+    size_t cutMaxVisible = 0;
+    double cutThreshold = 0.0;
+    double renderLodMs = 0.0;
+    uint64_t steadyAllocations = 0;
+    bool overBudget = false;
+};
+
+} // namespace
+
+// Loads `path` through SceneLoader while the calling thread plays the
+// render thread: it polls at ~60 Hz and peeks at the partial cloud, which
+// must never stall it. Uploads go to a host copy of every plane. A first
+// load is cancelled halfway to time how quickly the stages wind down.
+static bool benchAsyncLoad(const std::string& path, bool buildLod) {
+    SceneLoader loader;
+    loader.options.buildLod = buildLod;
+    std::vector<float> sink;
+    auto upload = [&](const SceneLoader::Scene& scene, SplatRange r) {
+        const SplatCloud& c = scene.cloud;
+        const size_t n = r.end - r.begin;
+        sink.resize(n);
+        const float* planes[] = { c.pos[0].data(), c.pos[1].data(), c.pos[2].data(), c.opacity.data(),
+                                  c.shDc[0].data(), c.shDc[1].data(), c.shDc[2].data() };
+        for (const float* p : planes) std::memcpy(sink.data(), p + r.begin, n * sizeof(float));
+        return true;
+    };
+
+    loader.start(path, upload);
+    while (loader.state() == SceneLoader::State::Loading && loader.progress() < 0.25f) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    auto t0 = Clock::now();
+    loader.cancel();
+    loader.wait();
+    std::printf("async: cancelled at %.0f%%, stages stopped in %.2f ms\n", 100.f * loader.progress(), msSince(t0));
+
+    loader.start(path, upload);
+    uint32_t polls = 0, previews = 0;
+    double maxPollMs = 0.0;
+    size_t lastPreview = 0;
+    while (loader.state() == SceneLoader::State::Loading) {
+        auto p0 = Clock::now();
+        loader.withPartial([&](const SplatCloud&, SplatRange r) {
+            previews++;
+            lastPreview = r.end;
+        });
+        maxPollMs = std::max(maxPollMs, msSince(p0));
+        polls++;
+        std::this_thread::sleep_for(std::chrono::microseconds(16667));
+    }
+    if (loader.wait() != SceneLoader::State::Ready) {
+        std::fprintf(stderr, "async load of %s failed: %s\n", path.c_str(), loader.error().c_str());
+        return false;
+    }
+
+    const SceneLoader::Stats st = loader.stats();
+    std::unique_ptr<SceneLoader::Scene> scene = loader.takeScene();
+    std::printf("async: %zu splats in %.1f ms, %u polls (%u with partial data, last %zu splats), max poll %.3f ms\n",
+                st.splats, st.totalMs, polls, previews, lastPreview, maxPollMs);
+    const SceneLoader::StageStats* stages[] = { &st.read, &st.preprocess, &st.upload };
+    const char* names[] = { "read", "preprocess", "upload" };
+    for (int i = 0; i < 3; i++) {
+        std::printf("  %-10s busy %7.1f ms, waiting %7.1f ms, %7.1f MB, %7.0f MB/s\n", names[i], stages[i]->busyMs,
+                    stages[i]->waitMs, (double)stages[i]->bytes / (1024.0 * 1024.0), stages[i]->mbPerSecond());
+    }
+    std::printf("  index build %.1f ms (pruned %zu of %zu, bvh %zu nodes, lod %zu nodes, covariances %.1f MB)\n",
+                st.indexMs, st.prune.input - st.prune.output, st.prune.input, scene->bvh.stats().nodes,
+                scene->lod.nodeCount(), (double)scene->covariances.bytes() / (1024.0 * 1024.0));
+    std::printf("  scene cloud %.1f MB, scale and rotation %s\n", (double)scene->cloud.bytes() / (1024.0 * 1024.0),
+                scene->cloud.hasShape() ? "kept" : "released");
+    return true;
+}
+
+// Times every projection kernel on one thread, with covariances from
+// scale/rotation and from an fp32 store, and bounds each SIMD kernel's
+// error against the reference: the same splats must survive, means and
+// depth within maxAbs, conics within maxRel of their larger diagonal
+// entry, radii within a pixel. Then checks whole images match.
+static bool benchProjection(const SplatCloud& cloud, const Camera* cams, uint32_t frames, uint32_t width, uint32_t height) {
+    constexpr float kMaxAbs = 1e-3f;
+    constexpr float kMaxRel = 1e-4f;
+    const size_t n = cloud.count;
+    struct Planes {
+        std::vector<uint32_t> index, radius;
+        std::vector<float> meanX, meanY, conicA, conicB, conicC, depth, opacity;
+        void resize(size_t count) {
+            for (auto* v : { &index, &radius }) v->resize(count);
+            for (auto* v : { &meanX, &meanY, &conicA, &conicB, &conicC, &depth, &opacity }) v->resize(count);
+        }
+        ProjectionOutput output() {
+            ProjectionOutput o;
+            o.index = index.data();
+            o.meanX = meanX.data();
+            o.meanY = meanY.data();
+            o.conicA = conicA.data();
+            o.conicB = conicB.data();
+            o.conicC = conicC.data();
+            o.depth = depth.data();
+            o.opacity = opacity.data();
+            o.radius = radius.data();
+            return o;
+        }
+    };
+    const ProjectionKernel kernels[3] = { ProjectionKernel::Reference, ProjectionKernel::Simd4, ProjectionKernel::Simd8 };
+    Planes planes[3];
+    for (Planes& p : planes) p.resize(n);
+
+    CovarianceStore store;
+    store.build(cloud, CovariancePrecision::Float32);
+    ProjectionInput in;
+    for (int k = 0; k < 3; k++) in.pos[k] = cloud.pos[k].data();
+    for (int k = 0; k < 3; k++) in.scale[k] = cloud.scale[k].data();
+    for (int k = 0; k < 4; k++) in.rot[k] = cloud.rot[k].data();
+    in.opacity = cloud.opacity.data();
+
+    bool ok = true;
+    const char* sources[2] = { "scale+rot", "cov fp32" };
+    for (int src = 0; src < 2; src++) {
+        in.covariances = src ? &store : nullptr;
+        double ms[3] = { 0.0, 0.0, 0.0 };
+        size_t visible = 0, mismatched[3] = { 0, 0, 0 };
+        float meanErr[3] = {}, depthErr[3] = {}, conicErr[3] = {};
+        uint32_t radiusErr[3] = {};
+        for (uint32_t f = 0; f < frames; f++) {
+            const ProjectionView view = makeProjectionView(cams[f], (float)width, (float)height);
+            size_t counts[3];
+            for (int k = 0; k < 3; k++) {
+                const auto t0 = Clock::now();
+                counts[k] = projectSplats(view, in, 0, n, planes[k].output(), kernels[k]);
+                ms[k] += msSince(t0);
+            }
+            visible += counts[0];
+            const Planes& ref = planes[0];
+            for (int k = 1; k < 3; k++) {
+                const Planes& p = planes[k];
+                // Walk both lists by splat index; a splat in only one of them
+                // sits on a culling boundary.
+                for (size_t a = 0, b = 0; a < counts[0] || b < counts[k];) {
+                    if (b == counts[k] || (a < counts[0] && ref.index[a] < p.index[b])) {
+                        mismatched[k]++;
+                        a++;
+                        continue;
+                    }
+                    if (a == counts[0] || p.index[b] < ref.index[a]) {
+                        mismatched[k]++;
+                        b++;
+                        continue;
+                    }
+                    meanErr[k] = std::max({ meanErr[k], std::fabs(p.meanX[b] - ref.meanX[a]),
+                                            std::fabs(p.meanY[b] - ref.meanY[a]) });
+                    depthErr[k] = std::max(depthErr[k], std::fabs(p.depth[b] - ref.depth[a]));
+                    const float scale = std::max(std::fabs(ref.conicA[a]), std::fabs(ref.conicC[a]));
+                    conicErr[k] = std::max({ conicErr[k], std::fabs(p.conicA[b] - ref.conicA[a]) / scale,
+                                             std::fabs(p.conicB[b] - ref.conicB[a]) / scale,
+                                             std::fabs(p.conicC[b] - ref.conicC[a]) / scale });
+                    radiusErr[k] = std::max(radiusErr[k], std::max(p.radius[b], ref.radius[a]) -
+                                                              std::min(p.radius[b], ref.radius[a]));
+                    a++;
+                    b++;
+                }
+            }
+        }
+        const double inv = 1.0 / (double)frames;
+        std::printf("projection %-9s: %.0f of %zu splats visible per frame\n", sources[src], (double)visible * inv, n);
+        for (int k = 0; k < 3; k++) {
+            std::printf("  %-20s %7.2f ms (%6.1f Msplat/s)", projectionKernelName(kernels[k]), ms[k] * inv,
+                        ms[k] > 0 ? (double)n * frames / (ms[k] * 1000.0) : 0.0);
+            if (k == 0) {
+                std::printf("\n");
+                continue;
+            }
+            const bool pass = meanErr[k] <= kMaxAbs && depthErr[k] <= kMaxAbs && conicErr[k] <= kMaxRel &&
+                              radiusErr[k] <= 1 && mismatched[k] * 10000 <= visible;
+            ok = ok && pass;
+            std::printf(", max error mean %g px, depth %g, conic %g, radius %u, %zu boundary splats: %s\n",
+                        meanErr[k], depthErr[k], conicErr[k], radiusErr[k], mismatched[k], pass ? "ok" : "FAILED");
+        }
+    }
+
+    // The rasterizer end to end.
+    std::vector<uint8_t> images[2];
+    CpuRasterizer raster[2];
+    raster[0].options.projectionKernel = ProjectionKernel::Reference;
+    int maxDiff = 0;
+    for (int k = 0; k < 2; k++) images[k].resize((size_t)width * height * 4);
+    for (uint32_t f = 0; f < frames; f++) {
+        for (int k = 0; k < 2; k++) raster[k].render(cloud, cams[f], images[k].data(), (size_t)width * 4);
+        for (size_t i = 0; i < images[0].size(); i++) maxDiff = std::max(maxDiff, std::abs(images[0][i] - images[1][i]));
+    }
+    std::printf("rasterizer reference vs %s: max pixel difference %d\n",
+                projectionKernelName(raster[1].options.projectionKernel), maxDiff);
+    return ok;
+}
+
+// Orbit frames at each resolution with both footprints, and the conic one
+// again after a global depth presort; the images must match, since the
+// conic footprint only drops tiles nothing blends into and the presort only
+// changes how the same order is reached.
+static void benchBinning(const SplatCloud& cloud, const float centre[3], float radius, const float up[3], float fov,
+                         uint32_t frames) {
+    struct Resolution {
+        const char* name;
+        uint32_t width, height;
+    };
+    const Resolution resolutions[2] = { { "1080p", 1920, 1080 }, { "2K eye", 2064, 2208 } };
+    constexpr int kModes = 3;
+    for (const Resolution& res : resolutions) {
+        std::vector<uint8_t> images[kModes];
+        CpuRasterizer raster[kModes];
+        TileBinner::Stats sum[kModes] = {};
+        double blendMs[kModes] = {};
+        double presortMs[kModes] = {};
+        int maxDiff = 0;
+        for (int m = 0; m < kModes; m++) {
+            raster[m].options.conicFootprint = m >= 1;
+            raster[m].options.depthPresort = m == 2;
+            images[m].resize((size_t)res.width * res.height * 4);
+        }
+        for (uint32_t f = 0; f < frames; f++) {
+            const float a = 2.f * 3.14159265f * (float)f / (float)frames;
+            const float eye[3] = { centre[0] + 1.5f * radius * std::cos(a), centre[1], centre[2] + 1.5f * radius * std::sin(a) };
+            const Camera cam = makeLookAtCamera(eye, centre, up, fov, res.width, res.height);
+            for (int m = 0; m < kModes; m++) {
+                raster[m].render(cloud, cam, images[m].data(), (size_t)res.width * 4);
+                const TileBinner::Stats& bs = raster[m].binStats();
+                sum[m].countMs += bs.countMs;
+                sum[m].scanMs += bs.scanMs;
+                sum[m].fillMs += bs.fillMs;
+                sum[m].sortMs += bs.sortMs;
+                sum[m].rangesMs += bs.rangesMs;
+                sum[m].totalMs += bs.totalMs;
+                sum[m].entries += bs.entries;
+                sum[m].visible += bs.visible;
+                blendMs[m] += raster[m].stats().blendMs;
+                presortMs[m] += raster[m].stats().presortMs;
+            }
+            for (int m = 1; m < kModes; m++) {
+                for (size_t i = 0; i < images[0].size(); i++) {
+                    maxDiff = std::max(maxDiff, std::abs(images[0][i] - images[m][i]));
+                }
+            }
+        }
+        const double inv = 1.0 / (double)frames;
+        const char* modes[kModes] = { "square", "conic", "sorted" };
+        for (int m = 0; m < kModes; m++) {
+            const TileBinner::Stats& s = sum[m];
+            std::printf("%-6s %-6s: %5.2f entries/splat, bin %6.2f ms (count %.2f, scan %.2f, fill %.2f, sort %.2f, "
+                        "ranges %.2f), blend %6.2f ms",
+                        res.name, modes[m], s.visible ? (double)s.entries / (double)s.visible : 0.0, s.totalMs * inv,
+                        s.countMs * inv, s.scanMs * inv, s.fillMs * inv, s.sortMs * inv, s.rangesMs * inv,
+                        blendMs[m] * inv);
+            if (raster[m].options.depthPresort) std::printf(", presort %6.2f ms", presortMs[m] * inv);
+            std::printf("\n");
+        }
+        std::printf("%-6s %u x %u, %.0f visible splats, %.0f -> %.0f tile entries, max pixel difference %d\n", res.name,
+                    res.width, res.height, (double)sum[1].visible * inv, (double)sum[0].entries * inv,
+                    (double)sum[1].entries * inv, maxDiff);
+    }
+}
+
+// Plays each camera path against a cold ChunkResidency, one frame per
+// 16.7 ms, as the render thread would.
+static bool benchResidency(const std::string& path, uint64_t budgetBytes, const std::vector<Camera>* paths,
+                           const char* const* names, int pathCount) {
+    for (int p = 0; p < pathCount; p++) {
+        ChunkResidency residency;
+        residency.options.budgetBytes = budgetBytes;
+        std::string error;
+        if (!residency.open(path, &error)) {
+            std::fprintf(stderr, "residency: %s\n", error.c_str());
+            return false;
+        }
+        double updateMs = 0.0, maxUpdateMs = 0.0;
+        size_t drawn = 0;
+        for (const Camera& cam : paths[p]) {
+            auto t0 = Clock::now();
+            residency.update(cam, 1.f / 60.f);
+            const double ms = msSince(t0);
+            updateMs += ms;
+            maxUpdateMs = std::max(maxUpdateMs, ms);
+            for (const SplatRange& r : residency.ranges()) drawn += r.end - r.begin;
+            std::this_thread::sleep_for(std::chrono::microseconds(16667));
+        }
+        const ChunkResidency::Stats st = residency.stats();
+        const double mb = 1024.0 * 1024.0;
+        if (p == 0) {
+            std::printf("residency: %.1f MB scene, %u slots of %u splats (%.1f MB budget)\n",
+                        (double)residency.sceneBytes() / mb, st.slots, residency.header().chunkSize,
+                        (double)budgetBytes / mb);
+        }
+        std::printf("  %-6s hit rate %5.1f%%, %u/%u stall frames, %llu loads (%llu prefetched), %llu evictions, "
+                    "%llu dropped, %.0f splats/frame\n",
+                    names[p], 100.f * st.hitRate(), st.stallFrames, st.frames, (unsigned long long)st.loads,
+                    (unsigned long long)st.prefetches, (unsigned long long)st.evictions,
+                    (unsigned long long)st.dropped, st.frames ? (double)drawn / st.frames : 0.0);
+        std::printf("         resident %.1f MB in %u chunks, decode %.0f MB/s, update %.3f ms avg / %.3f ms max\n",
+                    (double)st.residentBytes / mb, st.residentChunks,
+                    st.loadMs > 0.0 ? ((double)st.loadedBytes / mb) / (st.loadMs / 1000.0) : 0.0,
+                    st.frames ? updateMs / st.frames : 0.0, maxUpdateMs);
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 1;
+    }
+
+    if (!std::strcmp(argv[1], "--ply-loaders")) {
+        if (argc != 3) {
+            usage();
+            return 1;
+        }
+        return benchPlyLoaders(argv[2]) ? 0 : 1;
+    }
+    if (!std::strcmp(argv[1], "--sort")) {
+        if (argc != 2) {
+            usage();
+            return 1;
+        }
+        return benchSort() ? 0 : 1;
+    }
+
+    const std::string path = argv[1];
+    uint32_t frames = 36;
+    uint32_t width = 640, height = 360;
+    bool render = false;
+    size_t lodBudget = 0;
+    bool sh = false;
+    bool cov = false;
+    bool alloc = false;
+    bool async = false;
+    bool morton = false;
+    uint64_t residencyBudget = 0;
+    bool binning = false;
+    bool project = false;
+    SplatBvh bvh;
+    TraceFile trace;
+    for (int i = 2; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--frames") && i + 1 < argc) {
+            frames = std::max(1u, (uint32_t)std::strtoul(argv[++i], nullptr, 10));
+        } else if (!std::strcmp(argv[i], "--leaf") && i + 1 < argc) {
+            bvh.options.leafSize = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--size") && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%ux%u", &width, &height) != 2) {
+                usage();
+                return 1;
+            }
+        } else if (!std::strcmp(argv[i], "--render")) {
+            render = true;
+        } else if (!std::strcmp(argv[i], "--cov")) {
+            cov = true;
+        } else if (!std::strcmp(argv[i], "--alloc")) {
+            alloc = true;
+        } else if (!std::strcmp(argv[i], "--async")) {
+            async = true;
+        } else if (!std::strcmp(argv[i], "--morton")) {
+            morton = true;
+        } else if (!std::strcmp(argv[i], "--binning")) {
+            binning = true;
+        } else if (!std::strcmp(argv[i], "--project")) {
+            project = true;
+        } else if (!std::strcmp(argv[i], "--residency") && i + 1 < argc) {
+            residencyBudget = std::strtoull(argv[++i], nullptr, 10) << 20;
+        } else if (!std::strcmp(argv[i], "--sh")) {
+            sh = true;
+        } else if (!std::strcmp(argv[i], "--lod") && i + 1 < argc) {
+            lodBudget = (size_t)std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--trace") && i + 1 < argc) {
+            trace.path = argv[++i];
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    if (!trace.path.empty()) {
+        if (!traceStart()) {
+            std::fprintf(stderr, "--trace needs a build with GS_ENABLE_TRACING\n");
+            return 1;
+        }
+        traceThreadName("main");
+    }
+
+    if (async && !benchAsyncLoad(path, lodBudget > 0)) return 1;
+
+    std::string error;
+    SplatCloud cloud;
+    auto t0 = Clock::now();
+    bool ok = isCompactSplatFile(path) ? loadCompactSplats(path, cloud, &error) : loadPlySplats(path, cloud, &error);
+    if (!ok) {
+        std::fprintf(stderr, "failed to load %s: %s\n", path.c_str(), error.c_str());
+        return 1;
+    }
+    std::printf("%zu splats loaded in %.1f ms\n", cloud.count, msSince(t0));
+
+    if (sh && !benchSh(cloud)) return 1;
+    if (alloc && !benchGpuMemory(cloud)) return 1;
+
+    const Bounds b = sceneBounds(cloud);
+    const float centre[3] = { 0.5f * (b.min[0] + b.max[0]), 0.5f * (b.min[1] + b.max[1]), 0.5f * (b.min[2] + b.max[2]) };
+    const float radius = 0.5f * std::sqrt((b.max[0] - b.min[0]) * (b.max[0] - b.min[0]) +
+                                          (b.max[1] - b.min[1]) * (b.max[1] - b.min[1]) +
+                                          (b.max[2] - b.min[2]) * (b.max[2] - b.min[2]));
+    // 3DGS captures are usually y-down (COLMAP), so "up" is -y.
+    const float up[3] = { 0.f, -1.f, 0.f };
+    const float fov = 60.f * 3.14159265f / 180.f;
+
+    // Camera paths: a yaw sweep from the centre and an orbit outside, plus
+    // a sideways walk through the scene for --residency.
+    std::vector<Camera> paths[3];
+    for (uint32_t f = 0; f < frames; f++) {
+        const float a = 2.f * 3.14159265f * (float)f / (float)frames;
+        const float dir[3] = { std::cos(a), 0.f, std::sin(a) };
+        const float target[3] = { centre[0] + dir[0], centre[1], centre[2] + dir[2] };
+        paths[0].push_back(makeLookAtCamera(centre, target, up, fov, width, height));
+        const float eye[3] = { centre[0] + 1.5f * radius * dir[0], centre[1], centre[2] + 1.5f * radius * dir[2] };
+        paths[1].push_back(makeLookAtCamera(eye, centre, up, fov, width, height));
+        const float walk[3] = { centre[0] + radius * (1.6f * (float)f / (float)frames - 0.8f), centre[1], centre[2] };
+        const float side[3] = { walk[0], walk[1], walk[2] + 1.f };
+        paths[2].push_back(makeLookAtCamera(walk, side, up, fov, width, height));
+    }
+
+    if (binning) benchBinning(cloud, centre, radius, up, fov, frames);
+    if (project && !benchProjection(cloud, paths[1].data(), frames, width, height)) return 1;
+    if (cov) benchCovariance(cloud, paths[1].data(), frames, width, height);
+    // Before the BVH build, which reorders the cloud.
+    if (morton) benchMorton(cloud, paths[0].data(), frames, width, height);
+
+    const char* names[3] = { "sweep", "orbit", "walk" };
+    if (residencyBudget) {
+        if (!isCompactSplatFile(path)) {
+            std::fprintf(stderr, "--residency needs a .gsc scene\n");
+            return 1;
+        }
+        if (!benchResidency(path, residencyBudget, paths, names, 3)) return 1;
+    }
+
+    if (!bvh.build(cloud, &error)) {
+        std::fprintf(stderr, "bvh build failed: %s\n", error.c_str());
+        return 1;
+    }
+    const SplatBvh::Stats& bs = bvh.stats();
+    std::printf("bvh: build %.1f ms, %zu nodes, %zu leaves, %.2f MB (%.2f B/splat)\n",
+                bs.buildMs, bs.nodes, bs.leaves, (double)bs.bytes / (1024.0 * 1024.0),
+                cloud.count ? (double)bs.bytes / (double)cloud.count : 0.0);
+
+    SplatLod lod;
+    SplatLodCut cut;
+    SplatCloud lodCloud;
+    if (lodBudget) {
+        if (!lod.build(cloud, &error)) {
+            std::fprintf(stderr, "lod build failed: %s\n", error.c_str());
+            return 1;
+        }
+        cut.options.budget = lodBudget;
+        const SplatLod::Stats& ls = lod.stats();
+        std::printf("lod: build %.1f ms, %u levels, %zu nodes, %.2f MB\n",
+                    ls.buildMs, ls.levels, ls.nodes, (double)ls.bytes / (1024.0 * 1024.0));
+    }
+
+    CpuRasterizer raster;
+    std::vector<uint8_t> image((size_t)width * height * 4);
+    std::vector<SplatRange> ranges;
+    uint64_t steadyAllocations = 0;
+    bool overBudget = false;
+
+    for (int p = 0; p < 2; p++) {
+        PathResult res;
+        for (uint32_t f = 0; f < frames; f++) {
+            const Camera& cam = paths[p][f];
+
+            bvh.query(cam.frustum(), ranges);
+            const SplatBvh::QueryStats& qs = bvh.queryStats();
+            res.queryMs += qs.ms;
+            res.culled += qs.culledFraction;
+            res.ranges += (double)qs.ranges;
+
+            if (render) {
+                auto r0 = Clock::now();
+                raster.render(cloud, cam, image.data(), (size_t)width * 4);
+                res.renderAllMs += msSince(r0);
+                r0 = Clock::now();
+                raster.render(cloud, cam, ranges, image.data(), (size_t)width * 4);
+                res.renderCulledMs += msSince(r0);
+                if (allocationTrackingEnabled()) {
+                    // The same frame again, as the render loop would see it.
+                    AllocationWatch watch;
+                    bvh.query(cam.frustum(), ranges);
+                    raster.render(cloud, cam, ranges, image.data(), (size_t)width * 4);
+                    res.steadyAllocations += watch.count();
+                }
+            }
+
+            if (lodBudget) {
+                cut.update(lod, cam);
+                res.cutMs += cut.stats().ms;
+                res.cutVisible += (double)cut.stats().visible;
+                res.cutMaxVisible = std::max(res.cutMaxVisible, cut.stats().visible);
+                res.cutThreshold += cut.stats().pixelThreshold;
+                if (render) {
+                    auto r0 = Clock::now();
+                    cut.gather(lod, lodCloud);
+                    raster.render(lodCloud, cam, image.data(), (size_t)width * 4);
+                    res.renderLodMs += msSince(r0);
+                }
+            }
+        }
+
+        const double inv = 1.0 / (double)frames;
+        std::printf("%s: %u frames, culled %.1f%%, %.0f ranges, query %.3f ms",
+                    names[p], frames, 100.0 * res.culled * inv, res.ranges * inv, res.queryMs * inv);
+        if (render) {
+            std::printf(", render %.1f ms -> %.1f ms culled", res.renderAllMs * inv, res.renderCulledMs * inv);
+            if (allocationTrackingEnabled()) std::printf(", %llu steady-state heap allocations",
+                                                         (unsigned long long)res.steadyAllocations);
+        }
+        std::printf("\n");
+        steadyAllocations += res.steadyAllocations;
+        overBudget = overBudget || res.cutMaxVisible > lodBudget;
+        if (lodBudget) {
+            std::printf("%s lod: cut %.3f ms, %.0f visible (max %zu), threshold %.1f px", names[p],
+                        res.cutMs * inv, res.cutVisible * inv, res.cutMaxVisible, res.cutThreshold * inv);
+            if (render) std::printf(", gather + render %.1f ms", res.renderLodMs * inv);
+            std::printf("\n");
+        }
+    }
+    if (lodBudget && overBudget) {
+        std::fprintf(stderr, "the lod cut exceeded its budget\n");
+        return 1;
+    }
+    if (steadyAllocations) {
+        std::fprintf(stderr, "rendering a frame again allocated on the heap\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,126 @@
+// Offline converter: 3DGS PLY -> compact splat container (.gsc).
+//
+// Usage: splat_convert <in.ply> <out.gsc> [--chunk N] [--sh8] [--sh-degree D] [--keep-order]
+//
+// Splats are written in Morton order so each chunk covers a compact region,
+// which is what chunk culling and out-of-core streaming rely on;
+// --keep-order writes them in file order.
+//
+// Prints file sizes and decode throughput of both formats.
+
+#include "compact_splat.h"
+#include "morton_order.h"
+#include "ply_loader.h"
+#include "splat_cloud.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+static void usage() {
+    std::fprintf(stderr, "usage: splat_convert <in.ply> <out.gsc> [--chunk N] [--sh8] [--sh-degree D] [--keep-order]\n");
+}
+
+static void report(const char* label, size_t bytes, size_t count, double ms) {
+    double mb = (double)bytes / (1024.0 * 1024.0);
+    std::printf("%-6s %10.2f MB  %7.1f B/splat  decode %8.1f ms  %8.1f MB/s  %7.2f Msplat/s\n",
+                label, mb, count ? (double)bytes / (double)count : 0.0, ms,
+                ms > 0 ? mb / (ms / 1000.0) : 0.0,
+                ms > 0 ? (double)count / (ms * 1000.0) : 0.0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        usage();
+        return 1;
+    }
+
+    const std::string inPath = argv[1];
+    const std::string outPath = argv[2];
+
+    CompactSplatOptions options;
+    bool keepOrder = false;
+    for (int i = 3; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--chunk") && i + 1 < argc) {
+            options.chunkSize = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--sh8")) {
+            options.shEncoding = CompactShEncoding::UInt8;
+        } else if (!std::strcmp(argv[i], "--sh-degree") && i + 1 < argc) {
+            options.maxShDegree = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--keep-order")) {
+            keepOrder = true;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    std::string error;
+    SplatCloud cloud;
+    auto t0 = Clock::now();
+    if (!loadPlySplats(inPath, cloud, &error)) {
+        std::fprintf(stderr, "failed to load %s: %s\n", inPath.c_str(), error.c_str());
+        return 1;
+    }
+    double plyMs = msSince(t0);
+
+    if (!keepOrder) {
+        MortonOrderStats morton;
+        mortonOrderSplats(cloud, MortonBits::Bits30, &morton);
+        std::printf("morton order %.1f ms\n", morton.totalMs);
+    }
+
+    if (!writeCompactSplats(outPath, cloud, options, &error)) {
+        std::fprintf(stderr, "failed to write %s: %s\n", outPath.c_str(), error.c_str());
+        return 1;
+    }
+
+    SplatCloud decoded;
+    t0 = Clock::now();
+    if (!loadCompactSplats(outPath, decoded, &error)) {
+        std::fprintf(stderr, "failed to read back %s: %s\n", outPath.c_str(), error.c_str());
+        return 1;
+    }
+    double gscMs = msSince(t0);
+
+    CompactSplatReader reader;
+    reader.open(outPath);
+
+    size_t plyBytes = 0;
+    if (FILE* f = std::fopen(inPath.c_str(), "rb")) {
+        std::fseek(f, 0, SEEK_END);
+        plyBytes = (size_t)std::ftell(f);
+        std::fclose(f);
+    }
+
+    // Worst case position error relative to the scene extent.
+    float maxErr = 0.f;
+    for (int a = 0; a < 3; a++) {
+        for (size_t i = 0; i < cloud.count; i++) {
+            maxErr = std::max(maxErr, std::fabs(cloud.pos[a][i] - decoded.pos[a][i]));
+        }
+    }
+
+    std::printf("%zu splats, SH degree %u -> %u (%s), %zu chunks\n",
+                cloud.count, cloud.shDegree(), decoded.shDegree(),
+                options.shEncoding == CompactShEncoding::Half ? "fp16" : "u8",
+                reader.chunks().size());
+    report("ply", plyBytes, cloud.count, plyMs);
+    report("gsc", reader.fileBytes(), decoded.count, gscMs);
+    std::printf("size ratio %.2fx, max position error %g\n",
+                reader.fileBytes() ? (double)plyBytes / (double)reader.fileBytes() : 0.0, maxErr);
+    return 0;
+}
@@ -0,0 +1,120 @@
+// Offline pruning: drops splats that cannot contribute visibly and merges
+// near-exact duplicates, then writes the smaller scene.
+//
+// Usage: splat_prune <in.ply|in.gsc> <out.ply|out.gsc> [--min-opacity A]
+//                    [--min-extent E | --min-pixels P --near D --focal F]
+//                    [--merge D] [--chunk N] [--sh8]
+//
+// The output format follows the extension: .gsc writes the compact
+// container (--chunk and --sh8 as in splat_convert), anything else a 3DGS
+// PLY.
+
+#include "compact_splat.h"
+#include "ply_loader.h"
+#include "ply_writer.h"
+#include "splat_cloud.h"
+#include "splat_prune.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+static void usage() {
+    std::fprintf(stderr,
+                 "usage: splat_prune <in.ply|in.gsc> <out.ply|out.gsc> [--min-opacity A]\n"
+                 "                   [--min-extent E | --min-pixels P --near D --focal F]\n"
+                 "                   [--merge D] [--chunk N] [--sh8]\n");
+}
+
+static bool endsWith(const std::string& s, const char* suffix) {
+    const size_t n = std::strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+static void report(const char* rule, size_t removed, size_t input) {
+    std::printf("  %-11s %9zu (%5.1f%%)\n", rule, removed, input ? 100.0 * (double)removed / (double)input : 0.0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        usage();
+        return 1;
+    }
+
+    const std::string inPath = argv[1];
+    const std::string outPath = argv[2];
+
+    SplatPruneOptions prune;
+    CompactSplatOptions compact;
+    float minPixels = 0.f, nearDistance = 0.f, focal = 0.f;
+    for (int i = 3; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--min-opacity") && i + 1 < argc) {
+            prune.minOpacity = std::strtof(argv[++i], nullptr);
+        } else if (!std::strcmp(argv[i], "--min-extent") && i + 1 < argc) {
+            prune.minExtent = std::strtof(argv[++i], nullptr);
+        } else if (!std::strcmp(argv[i], "--min-pixels") && i + 1 < argc) {
+            minPixels = std::strtof(argv[++i], nullptr);
+        } else if (!std::strcmp(argv[i], "--near") && i + 1 < argc) {
+            nearDistance = std::strtof(argv[++i], nullptr);
+        } else if (!std::strcmp(argv[i], "--focal") && i + 1 < argc) {
+            focal = std::strtof(argv[++i], nullptr);
+        } else if (!std::strcmp(argv[i], "--merge") && i + 1 < argc) {
+            prune.mergeDistance = std::strtof(argv[++i], nullptr);
+        } else if (!std::strcmp(argv[i], "--chunk") && i + 1 < argc) {
+            compact.chunkSize = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--sh8")) {
+            compact.shEncoding = CompactShEncoding::UInt8;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (minPixels > 0.f) {
+        if (nearDistance <= 0.f || focal <= 0.f) {
+            usage();
+            return 1;
+        }
+        prune.minExtent = extentForPixels(minPixels, nearDistance, focal);
+    }
+
+    std::string error;
+    SplatCloud cloud;
+    auto t0 = Clock::now();
+    bool ok = isCompactSplatFile(inPath) ? loadCompactSplats(inPath, cloud, &error) : loadPlySplats(inPath, cloud, &error);
+    if (!ok) {
+        std::fprintf(stderr, "failed to load %s: %s\n", inPath.c_str(), error.c_str());
+        return 1;
+    }
+    std::printf("%zu splats loaded in %.1f ms\n", cloud.count, msSince(t0));
+
+    SplatPruneStats st;
+    pruneSplats(cloud, prune, &st);
+    std::printf("pruned in %.1f ms (filter %.1f, merge %.1f, compact %.1f):\n", st.totalMs, st.filterMs, st.mergeMs,
+                st.compactMs);
+    report("opacity", st.opacity, st.input);
+    report("extent", st.extent, st.input);
+    report("duplicates", st.duplicates, st.input);
+    std::printf("  %-11s %9zu (%5.1f%%)\n", "kept", st.output, st.input ? 100.0 * (double)st.output / (double)st.input : 0.0);
+
+    t0 = Clock::now();
+    ok = endsWith(outPath, ".gsc") ? writeCompactSplats(outPath, cloud, compact, &error)
+                                   : writePlySplats(outPath, cloud, &error);
+    if (!ok) {
+        std::fprintf(stderr, "failed to write %s: %s\n", outPath.c_str(), error.c_str());
+        return 1;
+    }
+    std::printf("wrote %s in %.1f ms\n", outPath.c_str(), msSince(t0));
+    return 0;
+}
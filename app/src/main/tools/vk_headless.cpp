@@ -0,0 +1,240 @@
+// Headless Vulkan frame driver for desktop and CI (e.g. lavapipe).
+//
+// Usage: vk_headless <scene.ply|scene.gsc> [--frames N] [--size WxH]
+//                    [--out DIR] [--pipeline-cache FILE] [--trace FILE]
+//
+// Orbits a fixed camera path around the scene. Each frame is rasterized on
+// the CPU, uploaded and rendered through VulkanRenderer's offscreen target,
+// then read back. Prints per-frame timings and a summary; with --out every
+// read-back frame is written as DIR/frame_NNNN.ppm. --pipeline-cache loads
+// and saves the pipeline cache at FILE and reports whether it was warm.
+// Built with GS_TRACK_ALLOCATIONS it fails when a
+// renderer frame past the first few allocates on the heap. The renderer's
+// frame profiler runs throughout; its percentile line (CPU stages and GPU
+// timestamps) closes the summary. --trace writes a Chrome trace of the
+// load and every frame to FILE (GS_ENABLE_TRACING builds).
+
+#include "alloc_tracker.h"
+#include "camera.h"
+#include "compact_splat.h"
+#include "cpu_rasterizer.h"
+#include "frame_profiler.h"
+#include "ply_loader.h"
+#include "splat_cloud.h"
+#include "trace.h"
+#include "vulkan_renderer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+static void usage() {
+    std::fprintf(stderr, "usage: vk_headless <scene.ply|scene.gsc> [--frames N] [--size WxH] [--out DIR]\n"
+                         "                  [--pipeline-cache FILE] [--trace FILE]\n");
+}
+
+static bool writePpm(const std::string& path, const std::vector<uint8_t>& rgba, uint32_t width, uint32_t height) {
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+    std::fprintf(f, "P6\n%u %u\n255\n", width, height);
+    std::vector<uint8_t> row((size_t)width * 3);
+    for (uint32_t y = 0; y < height; y++) {
+        const uint8_t* src = &rgba[(size_t)y * width * 4];
+        for (uint32_t x = 0; x < width; x++) {
+            row[x * 3 + 0] = src[x * 4 + 0];
+            row[x * 3 + 1] = src[x * 4 + 1];
+            row[x * 3 + 2] = src[x * 4 + 2];
+        }
+        std::fwrite(row.data(), 1, row.size(), f);
+    }
+    return std::fclose(f) == 0;
+}
+
+// Writes the capture started for --trace once main returns.
+struct TraceFile {
+    std::string path;
+
+    ~TraceFile() {
+        if (path.empty()) return;
+        traceStop();
+        TraceWriteStats st;
+        std::string error;
+        if (traceWrite(path, &st, &error)) {
+            std::printf("trace: %llu events on %u threads, %llu dropped, written to %s\n",
+                        (unsigned long long)st.events, st.threads, (unsigned long long)st.dropped, path.c_str());
+        } else {
+            std::fprintf(stderr, "trace: %s\n", error.c_str());
+        }
+    }
+};
+
+struct Summary {
+    double total = 0.0, min = 1e30, max = 0.0;
+
+    void add(double ms) {
+        total += ms;
+        min = std::min(min, ms);
+        max = std::max(max, ms);
+    }
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 1;
+    }
+
+    const std::string path = argv[1];
+    uint32_t frames = 60;
+    uint32_t width = 1280, height = 720;
+    std::string outDir;
+    std::string cachePath;
+    TraceFile trace;
+    for (int i = 2; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--frames") && i + 1 < argc) {
+            frames = std::max(1u, (uint32_t)std::strtoul(argv[++i], nullptr, 10));
+        } else if (!std::strcmp(argv[i], "--size") && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%ux%u", &width, &height) != 2) {
+                usage();
+                return 1;
+            }
+        } else if (!std::strcmp(argv[i], "--out") && i + 1 < argc) {
+            outDir = argv[++i];
+        } else if (!std::strcmp(argv[i], "--pipeline-cache") && i + 1 < argc) {
+            cachePath = argv[++i];
+        } else if (!std::strcmp(argv[i], "--trace") && i + 1 < argc) {
+            trace.path = argv[++i];
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    if (!trace.path.empty()) {
+        if (!traceStart()) {
+            std::fprintf(stderr, "--trace needs a build with GS_ENABLE_TRACING\n");
+            return 1;
+        }
+        traceThreadName("main");
+    }
+
+    std::string error;
+    SplatCloud cloud;
+    bool ok = isCompactSplatFile(path) ? loadCompactSplats(path, cloud, &error) : loadPlySplats(path, cloud, &error);
+    if (!ok) {
+        std::fprintf(stderr, "failed to load %s: %s\n", path.c_str(), error.c_str());
+        return 1;
+    }
+
+    VulkanRenderer renderer;
+    renderer.setPipelineCachePath(cachePath);
+    if (!renderer.initHeadless(width, height)) {
+        std::fprintf(stderr, "failed to initialize headless Vulkan\n");
+        return 1;
+    }
+    FrameProfiler profiler;
+    profiler.options.window = frames;
+    profiler.options.logSeconds = 0.0;
+    profiler.setEnabled(true);
+    renderer.setProfiler(&profiler);
+
+    // Orbit at 1.5x the bounding radius around the centroid.
+    float centre[3] = { 0.f, 0.f, 0.f };
+    for (int k = 0; k < 3; k++) {
+        double sum = 0.0;
+        for (size_t i = 0; i < cloud.count; i++) sum += cloud.pos[k][i];
+        centre[k] = cloud.count ? (float)(sum / (double)cloud.count) : 0.f;
+    }
+    float radius = 0.f;
+    for (size_t i = 0; i < cloud.count; i++) {
+        const float dx = cloud.pos[0][i] - centre[0], dy = cloud.pos[1][i] - centre[1], dz = cloud.pos[2][i] - centre[2];
+        radius = std::max(radius, dx * dx + dy * dy + dz * dz);
+    }
+    radius = std::sqrt(radius);
+    const float up[3] = { 0.f, -1.f, 0.f };
+
+    CpuRasterizer raster;
+    std::vector<uint8_t> image((size_t)width * height * 4);
+    std::vector<uint8_t> readback;
+    Summary rasterMs, uploadMs, gpuMs, readMs, frameMs;
+    uint64_t steadyAllocations = 0;
+
+    std::printf("frame  raster_ms  upload_ms  gpu_ms  readback_ms  total_ms\n");
+    for (uint32_t f = 0; f < frames; f++) {
+        const float a = 2.f * 3.14159265f * (float)f / (float)frames;
+        const float eye[3] = { centre[0] + 1.5f * radius * std::cos(a), centre[1], centre[2] + 1.5f * radius * std::sin(a) };
+        const Camera cam = makeLookAtCamera(eye, centre, up, 60.f * 3.14159265f / 180.f, width, height);
+
+        auto t0 = Clock::now();
+        raster.render(cloud, cam, image.data(), (size_t)width * 4);
+        const double r = msSince(t0);
+
+        auto t1 = Clock::now();
+        renderer.setFrameImage(image.data(), width, height, (size_t)width * 4);
+        const double u = msSince(t1);
+
+        if (!renderer.renderOffscreen(&readback)) {
+            std::fprintf(stderr, "frame %u failed\n", f);
+            return 1;
+        }
+        const VulkanRenderer::FrameTimings& vt = renderer.timings();
+        const double total = msSince(t0);
+        profiler.collect();
+        // The first frames size the arenas and the readback vector.
+        if (f >= 4) steadyAllocations += vt.heapAllocations;
+
+        rasterMs.add(r);
+        uploadMs.add(u);
+        gpuMs.add(vt.recordMs + vt.submitMs);
+        readMs.add(vt.readbackMs);
+        frameMs.add(total);
+        std::printf("%5u  %9.2f  %9.2f  %6.2f  %11.2f  %8.2f\n", f, r, u, vt.recordMs + vt.submitMs, vt.readbackMs, total);
+
+        if (!outDir.empty()) {
+            char name[32];
+            std::snprintf(name, sizeof(name), "/frame_%04u.ppm", f);
+            if (!writePpm(outDir + name, readback, width, height)) {
+                std::fprintf(stderr, "failed to write %s%s\n", outDir.c_str(), name);
+                return 1;
+            }
+        }
+    }
+
+    const double inv = 1.0 / (double)frames;
+    auto line = [&](const char* label, const Summary& s) {
+        std::printf("%-9s avg %8.2f  min %8.2f  max %8.2f ms\n", label, s.total * inv, s.min, s.max);
+    };
+    line("raster", rasterMs);
+    line("upload", uploadMs);
+    line("gpu", gpuMs);
+    line("readback", readMs);
+    line("frame", frameMs);
+    char stats[1024];
+    formatFrameStats(profiler.stats(), stats, sizeof(stats));
+    std::printf("profiler: %s\n", stats);
+
+    const PipelineCache::Stats& pc = renderer.pipelineCacheStats();
+    std::printf("pipeline cache: %s, %zu bytes loaded in %.2f ms, %u pipelines created in %.2f ms\n",
+                pc.warm ? "warm" : "cold", pc.loadedBytes, pc.loadMs, pc.pipelines, pc.createMs);
+    if (!pc.rejected.empty()) std::printf("pipeline cache rejected: %s\n", pc.rejected.c_str());
+    if (allocationTrackingEnabled()) {
+        std::printf("heap allocations in steady renderer frames: %llu\n", (unsigned long long)steadyAllocations);
+        if (steadyAllocations) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,207 @@
+#include "trace.h"
+
+#if GS_ENABLE_TRACING
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// Events per thread and capture; later ones are counted as dropped.
+constexpr uint32_t kEventsPerThread = 1u << 16;
+
+enum class EventKind : uint8_t { Complete, Counter };
+
+struct Event {
+    const char* name;
+    uint64_t startNs;
+    uint64_t endNs;
+    double value;
+    EventKind kind;
+};
+
+// Written only by its thread. A new capture bumps gGeneration; the owner
+// notices on its next event and starts over. The writer reads the events
+// below `count` of buffers already in the current generation.
+struct ThreadBuffer {
+    uint32_t tid = 0;
+    std::atomic<const char*> name{ nullptr };
+    std::atomic<uint32_t> generation{ 0 };
+    std::atomic<uint32_t> count{ 0 };
+    std::atomic<uint64_t> dropped{ 0 };
+    std::unique_ptr<Event[]> events{ new Event[kEventsPerThread] };
+};
+
+std::atomic<uint32_t> gGeneration{ 0 };
+uint64_t gStartNs = 0; // of the current capture
+
+// Buffers live until exit so events of finished threads can still be written.
+std::mutex gRegistryMutex;
+std::vector<std::unique_ptr<ThreadBuffer>> gRegistry;
+
+thread_local ThreadBuffer* tBuffer = nullptr;
+thread_local const char* tName = nullptr;
+
+static ThreadBuffer* threadBuffer() {
+    ThreadBuffer* b = tBuffer;
+    if (!b) {
+        auto fresh = std::make_unique<ThreadBuffer>();
+        fresh->name.store(tName, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(gRegistryMutex);
+        fresh->tid = (uint32_t)gRegistry.size() + 1;
+        b = fresh.get();
+        gRegistry.push_back(std::move(fresh));
+        tBuffer = b;
+    }
+    const uint32_t generation = gGeneration.load(std::memory_order_acquire);
+    if (b->generation.load(std::memory_order_relaxed) != generation) {
+        b->count.store(0, std::memory_order_relaxed);
+        b->dropped.store(0, std::memory_order_relaxed);
+        b->generation.store(generation, std::memory_order_release);
+    }
+    return b;
+}
+
+static void append(const Event& e) {
+    ThreadBuffer* b = threadBuffer();
+    const uint32_t n = b->count.load(std::memory_order_relaxed);
+    if (n == kEventsPerThread) {
+        b->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    b->events[n] = e;
+    b->count.store(n + 1, std::memory_order_release);
+}
+
+// Names are usually literals from this code base, but keep the JSON valid.
+static void writeString(FILE* f, const char* s) {
+    std::fputc('"', f);
+    for (; *s; s++) {
+        const unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            std::fputc('\\', f);
+            std::fputc(c, f);
+        } else if (c < 0x20) {
+            std::fprintf(f, "\\u%04x", c);
+        } else {
+            std::fputc(c, f);
+        }
+    }
+    std::fputc('"', f);
+}
+
+} // namespace
+
+namespace trace_detail {
+
+std::atomic<bool> gActive{ false };
+
+uint64_t nowNs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void complete(const char* name, uint64_t startNs, uint64_t endNs) {
+    append(Event{ name, startNs, endNs, 0.0, EventKind::Complete });
+}
+
+void counter(const char* name, double value) {
+    const uint64_t t = nowNs();
+    append(Event{ name, t, t, value, EventKind::Counter });
+}
+
+} // namespace trace_detail
+
+bool tracingEnabled() { return true; }
+
+bool traceStart() {
+    trace_detail::gActive.store(false, std::memory_order_relaxed);
+    gStartNs = trace_detail::nowNs();
+    gGeneration.fetch_add(1, std::memory_order_acq_rel);
+    trace_detail::gActive.store(true, std::memory_order_release);
+    return true;
+}
+
+void traceStop() { trace_detail::gActive.store(false, std::memory_order_release); }
+
+void traceThreadName(const char* name) {
+    tName = name;
+    if (tBuffer) tBuffer->name.store(name, std::memory_order_relaxed);
+}
+
+bool traceWrite(const std::string& path, TraceWriteStats* stats, std::string* error) {
+    FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) {
+        if (error) *error = "cannot open " + path;
+        return false;
+    }
+
+    TraceWriteStats s;
+    const uint32_t generation = gGeneration.load(std::memory_order_acquire);
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", f);
+    bool first = true;
+    auto begin = [&](const char* ph, uint32_t tid) {
+        std::fprintf(f, "%s\n{\"ph\":\"%s\",\"pid\":1,\"tid\":%u,\"name\":", first ? "" : ",", ph, tid);
+        first = false;
+    };
+
+    std::lock_guard<std::mutex> lock(gRegistryMutex);
+    for (const std::unique_ptr<ThreadBuffer>& b : gRegistry) {
+        if (b->generation.load(std::memory_order_acquire) != generation) continue;
+        const uint32_t count = b->count.load(std::memory_order_acquire);
+        s.threads++;
+        s.dropped += b->dropped.load(std::memory_order_relaxed);
+
+        begin("M", b->tid);
+        std::fputs("\"thread_name\",\"args\":{\"name\":", f);
+        if (const char* name = b->name.load(std::memory_order_relaxed)) {
+            writeString(f, name);
+        } else {
+            std::fprintf(f, "\"thread %u\"", b->tid);
+        }
+        std::fputs("}}", f);
+
+        for (uint32_t i = 0; i < count; i++) {
+            const Event& e = b->events[i];
+            // Scopes opened before this capture started.
+            if (e.startNs < gStartNs) continue;
+            const double ts = (double)(e.startNs - gStartNs) * 1e-3;
+            if (e.kind == EventKind::Complete) {
+                begin("X", b->tid);
+                writeString(f, e.name);
+                std::fprintf(f, ",\"ts\":%.3f,\"dur\":%.3f}", ts, (double)(e.endNs - e.startNs) * 1e-3);
+            } else {
+                begin("C", b->tid);
+                writeString(f, e.name);
+                std::fprintf(f, ",\"ts\":%.3f,\"args\":{\"value\":%.17g}}", ts, e.value);
+            }
+            s.events++;
+        }
+    }
+    std::fputs("\n]}\n", f);
+
+    if (std::fclose(f) != 0) {
+        if (error) *error = "cannot write " + path;
+        return false;
+    }
+    if (stats) *stats = s;
+    return true;
+}
+
+#else
+
+bool tracingEnabled() { return false; }
+bool traceStart() { return false; }
+void traceStop() {}
+void traceThreadName(const char*) {}
+
+bool traceWrite(const std::string&, TraceWriteStats* stats, std::string* error) {
+    if (stats) *stats = TraceWriteStats{};
+    if (error) *error = "built without GS_ENABLE_TRACING";
+    return false;
+}
+
+#endif
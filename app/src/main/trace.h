@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#if GS_ENABLE_TRACING
+#include <atomic>
+#endif
+
+// Scoped CPU trace events, written out as Chrome trace event JSON (opens in
+// Perfetto or chrome://tracing).
+//
+// Built with GS_ENABLE_TRACING (the CMake option of the same name) the
+// GS_TRACE_* macros record into a fixed-size buffer owned by the calling
+// thread: no locks, and no allocation after a thread's first event. Without
+// it they expand to nothing and every function below is a no-op, so release
+// builds carry no trace code at the call sites.
+//
+// A capture runs from traceStart() to traceStop(); traceWrite() then flushes
+// it. Events are only recorded while a capture is running. Names must be
+// string literals (or otherwise outlive the capture).
+
+// True when the trace macros are compiled in.
+bool tracingEnabled();
+
+// Discards earlier events and starts recording. Returns false when tracing
+// is compiled out.
+bool traceStart();
+void traceStop();
+
+// Name shown for the calling thread's track.
+void traceThreadName(const char* name);
+
+struct TraceWriteStats {
+    uint64_t events = 0;
+    uint64_t dropped = 0; // recorded while a thread's buffer was full
+    uint32_t threads = 0;
+};
+
+// Writes the last capture to `path`. Call after traceStop(), not
+// concurrently with traceStart().
+bool traceWrite(const std::string& path, TraceWriteStats* stats, std::string* error);
+
+#if GS_ENABLE_TRACING
+
+namespace trace_detail {
+
+extern std::atomic<bool> gActive;
+
+uint64_t nowNs();
+void complete(const char* name, uint64_t startNs, uint64_t endNs);
+void counter(const char* name, double value);
+
+} // namespace trace_detail
+
+inline bool traceActive() { return trace_detail::gActive.load(std::memory_order_relaxed); }
+
+// Records [construction, destruction) as one complete event.
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) : name_(name), start_(traceActive() ? trace_detail::nowNs() : 0) {}
+    ~TraceScope() {
+        if (start_) trace_detail::complete(name_, start_, trace_detail::nowNs());
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name_;
+    uint64_t start_; // 0 when not recording
+};
+
+#define GS_TRACE_CONCAT_(a, b) a##b
+#define GS_TRACE_CONCAT(a, b) GS_TRACE_CONCAT_(a, b)
+#define GS_TRACE_SCOPE(name) TraceScope GS_TRACE_CONCAT(gsTraceScope, __LINE__)(name)
+#define GS_TRACE_COUNTER(name, value)                                          \
+    do {                                                                       \
+        if (traceActive()) trace_detail::counter(name, (double)(value));       \
+    } while (0)
+
+#else
+
+inline bool traceActive() { return false; }
+
+#define GS_TRACE_SCOPE(name) ((void)0)
+#define GS_TRACE_COUNTER(name, value) ((void)0)
+
+#endif
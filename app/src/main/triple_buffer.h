@@ -0,0 +1,38 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free latest-value mailbox between one writer and one reader.
+//
+// The writer fills its private back slot and swaps it with the shared middle
+// slot; the reader swaps the middle slot with its private front slot when a
+// new value has been published. Neither side ever waits, intermediate values
+// are dropped, and the reader always sees a complete value.
+template <typename T>
+class TripleBuffer {
+public:
+    // Writer.
+    void write(const T& value) {
+        slots_[back_] = value;
+        back_ = middle_.exchange(back_ | kFresh, std::memory_order_acq_rel) & kIndexMask;
+    }
+
+    // Reader. Copies the newest value into `out` if one was written since
+    // the last read; otherwise returns false and leaves `out` alone.
+    bool read(T& out) {
+        if (!(middle_.load(std::memory_order_relaxed) & kFresh)) return false;
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & kIndexMask;
+        out = slots_[front_];
+        return true;
+    }
+
+private:
+    static constexpr uint8_t kIndexMask = 3;
+    static constexpr uint8_t kFresh = 4;
+
+    T slots_[3]{};
+    uint8_t back_ = 0;  // writer-owned
+    uint8_t front_ = 2; // reader-owned
+    std::atomic<uint8_t> middle_{ 1 };
+};
@@ -0,0 +1,47 @@
+#include "vk_memory.h"
+#include "log.h"
+
+VulkanMemoryBackend::VulkanMemoryBackend(VkDevice device, VkPhysicalDevice phys) : device_(device) {
+    vkGetPhysicalDeviceMemoryProperties(phys, &props_);
+}
+
+bool VulkanMemoryBackend::allocate(uint32_t memoryType, uint64_t size, uint64_t* handle, void** mapped) {
+    if (memoryType >= props_.memoryTypeCount) return false;
+
+    VkMemoryAllocateInfo ai{};
+    ai.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    ai.allocationSize = size;
+    ai.memoryTypeIndex = memoryType;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkResult r = vkAllocateMemory(device_, &ai, nullptr, &memory);
+    if (r != VK_SUCCESS) {
+        LOGE("vkAllocateMemory(%llu bytes, type %u) failed: %d", (unsigned long long)size, memoryType, (int)r);
+        return false;
+    }
+
+    *mapped = nullptr;
+    if (props_.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        r = vkMapMemory(device_, memory, 0, VK_WHOLE_SIZE, 0, mapped);
+        if (r != VK_SUCCESS) {
+            LOGE("vkMapMemory failed: %d", (int)r);
+            vkFreeMemory(device_, memory, nullptr);
+            return false;
+        }
+    }
+    *handle = toMemoryHandle(memory);
+    live_++;
+    return true;
+}
+
+void VulkanMemoryBackend::release(uint64_t handle) {
+    // Freeing implicitly unmaps.
+    vkFreeMemory(device_, toVkMemory(handle), nullptr);
+    live_--;
+}
+
+uint32_t VulkanMemoryBackend::findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags props) const {
+    for (uint32_t i = 0; i < props_.memoryTypeCount; i++) {
+        if ((typeBits & (1u << i)) && (props_.memoryTypes[i].propertyFlags & props) == props) return i;
+    }
+    return UINT32_MAX;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "gpu_allocator.h"
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <cstring>
+
+// GpuAllocator backend on vkAllocateMemory. Host-visible types are mapped
+// once for the lifetime of the block.
+class VulkanMemoryBackend : public MemoryBackend {
+public:
+    VulkanMemoryBackend(VkDevice device, VkPhysicalDevice phys);
+
+    bool allocate(uint32_t memoryType, uint64_t size, uint64_t* handle, void** mapped) override;
+    void release(uint64_t handle) override;
+
+    // First type in `typeBits` with all of `props`, or UINT32_MAX.
+    uint32_t findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags props) const;
+    uint32_t liveAllocations() const { return live_; }
+
+private:
+    VkDevice device_;
+    VkPhysicalDeviceMemoryProperties props_{};
+    uint32_t live_ = 0;
+};
+
+// VkDeviceMemory is a pointer on 64-bit targets and a uint64_t on 32-bit
+// ones; the allocator stores it as a plain 64-bit handle either way.
+inline uint64_t toMemoryHandle(VkDeviceMemory memory) {
+    uint64_t h = 0;
+    std::memcpy(&h, &memory, sizeof(memory));
+    return h;
+}
+
+inline VkDeviceMemory toVkMemory(uint64_t handle) {
+    VkDeviceMemory memory;
+    std::memcpy(&memory, &handle, sizeof(memory));
+    return memory;
+}
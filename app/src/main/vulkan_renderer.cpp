@@ -0,0 +1,1218 @@
+#include "vulkan_renderer.h"
+#include "alloc_tracker.h"
+#include "log.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <string>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+static inline bool vk_ok(VkResult r, const char* what) {
+    if (r == VK_SUCCESS) return true;
+    LOGE("%s failed: %d", what, (int)r);
+    return false;
+}
+
+constexpr VkImageSubresourceRange kColorRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+// Frames after a swapchain change before allocations count as steady: each
+// slot's arena settles on one block the second time it is reset.
+constexpr uint32_t kWarmupFrames = 4;
+
+// Consecutive CPU stage times of a FrameRecord; does nothing unless active.
+class StageTimer {
+public:
+    StageTimer(FrameRecord& record, bool active) : record_(record), active_(active) {
+        if (active_) start_ = last_ = Clock::now();
+    }
+
+    Clock::time_point start() const { return start_; }
+    // Time outside any stage is not counted.
+    void skip() {
+        if (active_) last_ = Clock::now();
+    }
+    // Adds the time since the previous mark to `stage`.
+    void mark(CpuStage stage) {
+        if (!active_) return;
+        const Clock::time_point now = Clock::now();
+        record_.cpuMs[(size_t)stage] += (float)std::chrono::duration<double, std::milli>(now - last_).count();
+        last_ = now;
+    }
+
+private:
+    FrameRecord& record_;
+    bool active_;
+    Clock::time_point start_{};
+    Clock::time_point last_{};
+};
+
+} // namespace
+
+void VulkanRenderer::init() {
+    if (instance_) return;
+    createInstance();
+    pickPhysicalDevice();
+    createDevice();
+    if (device_) createMemory();
+    LOGI("Vulkan core initialized");
+}
+
+void VulkanRenderer::shutdown() {
+    if (device_) {
+        vkDeviceWaitIdle(device_);
+        if (swapchain_) destroySwapchain();
+        if (headless_) {
+            destroySync();
+            destroyStaging();
+            destroyCommandPool();
+            destroyFramebuffers();
+            destroyRenderPass();
+            destroyOffscreen();
+        }
+        destroyTimestampPool();
+        destroyMemory();
+        std::string error;
+        if (pipelineCache_.handle() && !pipelineCache_.save(&error)) {
+            LOGE("Saving pipeline cache failed: %s", error.c_str());
+        }
+        pipelineCache_.destroy();
+        vkDestroyDevice(device_, nullptr);
+        device_ = VK_NULL_HANDLE;
+        queue_ = VK_NULL_HANDLE;
+    }
+    if (instance_) {
+        destroySurface();
+        vkDestroyInstance(instance_, nullptr);
+        instance_ = VK_NULL_HANDLE;
+    }
+    phys_ = VK_NULL_HANDLE;
+    headless_ = false;
+}
+
+void VulkanRenderer::createInstance() {
+    VkApplicationInfo app{};
+    app.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    app.pApplicationName = "OnDeviceGaussianSplatting";
+    app.applicationVersion = VK_MAKE_VERSION(0, 1, 0);
+    app.pEngineName = "none";
+    app.engineVersion = VK_MAKE_VERSION(0, 1, 0);
+    app.apiVersion = VK_API_VERSION_1_1;
+
+    std::vector<const char*> exts;
+#if defined(__ANDROID__)
+    if (!headless_) {
+        exts.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
+        exts.push_back(VK_KHR_ANDROID_SURFACE_EXTENSION_NAME);
+    }
+#endif
+
+    VkInstanceCreateInfo ci{};
+    ci.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    ci.pApplicationInfo = &app;
+    ci.enabledExtensionCount = (uint32_t)exts.size();
+    ci.ppEnabledExtensionNames = exts.data();
+
+    vk_ok(vkCreateInstance(&ci, nullptr, &instance_), "vkCreateInstance");
+}
+
+void VulkanRenderer::pickPhysicalDevice() {
+    if (!instance_) return;
+    uint32_t count = 0;
+    vkEnumeratePhysicalDevices(instance_, &count, nullptr);
+    if (count == 0) {
+        LOGE("No Vulkan physical device");
+        return;
+    }
+    std::vector<VkPhysicalDevice> devs(count);
+    vkEnumeratePhysicalDevices(instance_, &count, devs.data());
+    phys_ = devs[0];
+
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(phys_, &props);
+    LOGI("Using GPU: %s", props.deviceName);
+
+    uint32_t qCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(phys_, &qCount, nullptr);
+    std::vector<VkQueueFamilyProperties> qprops(qCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(phys_, &qCount, qprops.data());
+
+    queueFamily_ = 0;
+    for (uint32_t i = 0; i < qCount; i++) {
+        if (qprops[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+            queueFamily_ = i;
+            break;
+        }
+    }
+
+    // No valid bits: the queue cannot write timestamps, profile CPU only.
+    const uint32_t bits = qCount ? qprops[queueFamily_].timestampValidBits : 0;
+    timestampPeriodNs_ = bits ? props.limits.timestampPeriod : 0.f;
+    timestampMask_ = bits >= 64 ? ~0ull : (1ull << bits) - 1;
+}
+
+void VulkanRenderer::createDevice() {
+    if (!phys_) return;
+    float prio = 1.0f;
+    VkDeviceQueueCreateInfo q{};
+    q.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    q.queueFamilyIndex = queueFamily_;
+    q.queueCount = 1;
+    q.pQueuePriorities = &prio;
+
+    std::vector<const char*> exts;
+    if (!headless_) exts.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+
+    VkDeviceCreateInfo ci{};
+    ci.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    ci.queueCreateInfoCount = 1;
+    ci.pQueueCreateInfos = &q;
+    ci.enabledExtensionCount = (uint32_t)exts.size();
+    ci.ppEnabledExtensionNames = exts.data();
+
+    if (!vk_ok(vkCreateDevice(phys_, &ci, nullptr, &device_), "vkCreateDevice")) return;
+    vkGetDeviceQueue(device_, queueFamily_, 0, &queue_);
+    pipelineCache_.create(device_, phys_, pipelineCachePath_);
+}
+
+#if defined(__ANDROID__)
+void VulkanRenderer::createSurface(ANativeWindow* window) {
+    VkAndroidSurfaceCreateInfoKHR ci{};
+    ci.sType = VK_STRUCTURE_TYPE_ANDROID_SURFACE_CREATE_INFO_KHR;
+    ci.window = window;
+    vk_ok(vkCreateAndroidSurfaceKHR(instance_, &ci, nullptr, &surface_), "vkCreateAndroidSurfaceKHR");
+}
+#endif
+
+void VulkanRenderer::destroySurface() {
+    if (!surface_) return;
+    vkDestroySurfaceKHR(instance_, surface_, nullptr);
+    surface_ = VK_NULL_HANDLE;
+}
+
+bool VulkanRenderer::buildSwapchain() {
+    VkSurfaceCapabilitiesKHR caps{};
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(phys_, surface_, &caps);
+
+    uint32_t fmtCount = 0;
+    vkGetPhysicalDeviceSurfaceFormatsKHR(phys_, surface_, &fmtCount, nullptr);
+    std::vector<VkSurfaceFormatKHR> fmts(fmtCount);
+    vkGetPhysicalDeviceSurfaceFormatsKHR(phys_, surface_, &fmtCount, fmts.data());
+    if (fmts.empty()) {
+        LOGE("Surface reports no formats");
+        return false;
+    }
+
+    VkSurfaceFormatKHR chosen = fmts[0];
+    for (auto& f : fmts) {
+        if (f.format == VK_FORMAT_R8G8B8A8_UNORM || f.format == VK_FORMAT_B8G8R8A8_UNORM) {
+            chosen = f;
+            break;
+        }
+    }
+
+    uint32_t pmCount = 0;
+    vkGetPhysicalDeviceSurfacePresentModesKHR(phys_, surface_, &pmCount, nullptr);
+    std::vector<VkPresentModeKHR> pms(pmCount);
+    vkGetPhysicalDeviceSurfacePresentModesKHR(phys_, surface_, &pmCount, pms.data());
+
+    VkPresentModeKHR present = VK_PRESENT_MODE_FIFO_KHR;
+    for (auto pm : pms) {
+        if (pm == VK_PRESENT_MODE_MAILBOX_KHR) {
+            present = pm;
+            break;
+        }
+    }
+
+    // The surface size wins when the platform reports one; the size passed
+    // to onSurfaceChanged is only used when it is left to us.
+    VkExtent2D extent = { requestedWidth_, requestedHeight_ };
+    if (caps.currentExtent.width != UINT32_MAX) extent = caps.currentExtent;
+    extent.width = std::max(caps.minImageExtent.width, std::min(caps.maxImageExtent.width, extent.width));
+    extent.height = std::max(caps.minImageExtent.height, std::min(caps.maxImageExtent.height, extent.height));
+    if (extent.width == 0 || extent.height == 0) return false; // minimized
+
+    uint32_t imageCount = caps.minImageCount + 1;
+    if (caps.maxImageCount > 0 && imageCount > caps.maxImageCount) imageCount = caps.maxImageCount;
+
+    // The frame is cleared or uploaded with transfer commands before the
+    // render pass, so the images must be transfer destinations.
+    if (!(caps.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT)) {
+        LOGE("Swapchain images do not support transfer writes");
+        return false;
+    }
+
+    VkSwapchainCreateInfoKHR ci{};
+    ci.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+    ci.surface = surface_;
+    ci.minImageCount = imageCount;
+    ci.imageFormat = chosen.format;
+    ci.imageColorSpace = chosen.colorSpace;
+    ci.imageExtent = extent;
+    ci.imageArrayLayers = 1;
+    ci.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    ci.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    ci.preTransform = caps.currentTransform;
+    ci.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+    ci.presentMode = present;
+    ci.clipped = VK_TRUE;
+    // Lets the driver hand over resources and keep presenting the old
+    // images until the new ones are ready.
+    ci.oldSwapchain = swapchain_;
+
+    VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+    if (!vk_ok(vkCreateSwapchainKHR(device_, &ci, nullptr, &swapchain), "vkCreateSwapchainKHR")) return false;
+
+    // The old swapchain is retired by the create call above. Its views and
+    // framebuffers may still be referenced by frames in flight, so they are
+    // destroyed once those frames have completed rather than after a
+    // device-wide wait.
+    if (swapchain_) {
+        retired_.push_back({ swapchain_, std::move(imageViews_), std::move(framebuffers_), submittedFrames_ });
+        imageViews_.clear();
+        framebuffers_.clear();
+    }
+    swapchain_ = swapchain;
+    extent_ = extent;
+
+    // Only a format change invalidates the render pass. That is rare
+    // enough to afford an idle wait.
+    if (chosen.format != swapchainFormat_ || !renderPass_) {
+        if (renderPass_) {
+            vkDeviceWaitIdle(device_);
+            destroyRenderPass();
+        }
+        swapchainFormat_ = chosen.format;
+        createRenderPass(VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+    }
+
+    uint32_t scCount = 0;
+    vkGetSwapchainImagesKHR(device_, swapchain_, &scCount, nullptr);
+    images_.resize(scCount);
+    vkGetSwapchainImagesKHR(device_, swapchain_, &scCount, images_.data());
+
+    imageViews_.resize(scCount);
+    for (uint32_t i = 0; i < scCount; i++) {
+        VkImageViewCreateInfo vi{};
+        vi.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        vi.image = images_[i];
+        vi.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        vi.format = swapchainFormat_;
+        vi.subresourceRange = kColorRange;
+        vk_ok(vkCreateImageView(device_, &vi, nullptr, &imageViews_[i]), "vkCreateImageView");
+    }
+    createFramebuffers();
+
+    // Uploads queued for the old size no longer fit the images.
+    for (Staging& st : staging_) st.pending = false;
+    return true;
+}
+
+void VulkanRenderer::createSwapchain(int width, int height) {
+    requestedWidth_ = (uint32_t)std::max(width, 0);
+    requestedHeight_ = (uint32_t)std::max(height, 0);
+    if (!buildSwapchain()) return;
+
+    // Size independent per-frame objects live as long as the surface.
+    if (!commandPool_) {
+        createCommandPool();
+        allocateCommandBuffers();
+        createSync();
+        createStaging();
+    }
+
+    LOGI("Swapchain ready (%ux%u, %u images)", extent_.width, extent_.height, (uint32_t)images_.size());
+}
+
+void VulkanRenderer::recreateSwapchain() {
+    if (!surface_ || !device_) return;
+    auto t0 = Clock::now();
+    if (!buildSwapchain()) {
+        needsRecreate_ = true;
+        return;
+    }
+    needsRecreate_ = false;
+    framesSinceRecreate_ = 0;
+
+    swapchainStats_.recreations++;
+    swapchainStats_.lastRecreateMs = msSince(t0);
+    swapchainStats_.maxRecreateMs = std::max(swapchainStats_.maxRecreateMs, swapchainStats_.lastRecreateMs);
+    LOGI("Swapchain recreated (%ux%u) in %.2f ms", extent_.width, extent_.height, swapchainStats_.lastRecreateMs);
+}
+
+void VulkanRenderer::releaseRetired(bool all) {
+    size_t kept = 0;
+    for (Retired& r : retired_) {
+        if (!all && r.lastFrame > completedFrames_) {
+            retired_[kept++] = std::move(r);
+            continue;
+        }
+        for (auto fb : r.framebuffers) vkDestroyFramebuffer(device_, fb, nullptr);
+        for (auto iv : r.imageViews) vkDestroyImageView(device_, iv, nullptr);
+        vkDestroySwapchainKHR(device_, r.swapchain, nullptr);
+    }
+    retired_.resize(kept);
+}
+
+void VulkanRenderer::destroySwapchain() {
+    if (!device_) return;
+    if (!swapchain_) return;
+
+    // Full teardown, used when the surface itself goes away.
+    vkDeviceWaitIdle(device_);
+    releaseRetired(true);
+
+    destroySync();
+    destroyStaging();
+    destroyCommandPool();
+    destroyFramebuffers();
+    destroyRenderPass();
+
+    for (auto iv : imageViews_) vkDestroyImageView(device_, iv, nullptr);
+    imageViews_.clear();
+    images_.clear();
+
+    vkDestroySwapchainKHR(device_, swapchain_, nullptr);
+    swapchain_ = VK_NULL_HANDLE;
+    swapchainFormat_ = VK_FORMAT_UNDEFINED;
+    needsRecreate_ = false;
+}
+
+void VulkanRenderer::createRenderPass(VkImageLayout finalLayout) {
+    // The target arrives cleared or uploaded by transfer commands.
+    VkAttachmentDescription color{};
+    color.format = swapchainFormat_;
+    color.samples = VK_SAMPLE_COUNT_1_BIT;
+    color.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+    color.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    color.initialLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    color.finalLayout = finalLayout;
+
+    VkAttachmentReference colorRef{};
+    colorRef.attachment = 0;
+    colorRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    VkSubpassDescription sub{};
+    sub.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    sub.colorAttachmentCount = 1;
+    sub.pColorAttachments = &colorRef;
+
+    VkSubpassDependency deps[2]{};
+    // Clear/upload -> attachment writes.
+    deps[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    deps[0].dstSubpass = 0;
+    deps[0].srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    deps[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    deps[0].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    deps[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    // Attachment writes -> headless readback copy.
+    deps[1].srcSubpass = 0;
+    deps[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+    deps[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    deps[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    deps[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    deps[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+    VkRenderPassCreateInfo ci{};
+    ci.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    ci.attachmentCount = 1;
+    ci.pAttachments = &color;
+    ci.subpassCount = 1;
+    ci.pSubpasses = &sub;
+    ci.dependencyCount = 2;
+    ci.pDependencies = deps;
+
+    vk_ok(vkCreateRenderPass(device_, &ci, nullptr, &renderPass_), "vkCreateRenderPass");
+}
+
+void VulkanRenderer::destroyRenderPass() {
+    if (!renderPass_) return;
+    vkDestroyRenderPass(device_, renderPass_, nullptr);
+    renderPass_ = VK_NULL_HANDLE;
+}
+
+void VulkanRenderer::createFramebuffers() {
+    framebuffers_.resize(imageViews_.size());
+    for (size_t i = 0; i < imageViews_.size(); i++) {
+        VkImageView atts[] = { imageViews_[i] };
+        VkFramebufferCreateInfo ci{};
+        ci.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        ci.renderPass = renderPass_;
+        ci.attachmentCount = 1;
+        ci.pAttachments = atts;
+        ci.width = extent_.width;
+        ci.height = extent_.height;
+        ci.layers = 1;
+        vk_ok(vkCreateFramebuffer(device_, &ci, nullptr, &framebuffers_[i]), "vkCreateFramebuffer");
+    }
+}
+
+void VulkanRenderer::destroyFramebuffers() {
+    for (auto fb : framebuffers_) vkDestroyFramebuffer(device_, fb, nullptr);
+    framebuffers_.clear();
+}
+
+void VulkanRenderer::createCommandPool() {
+    VkCommandPoolCreateInfo ci{};
+    ci.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    ci.queueFamilyIndex = queueFamily_;
+    ci.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    vk_ok(vkCreateCommandPool(device_, &ci, nullptr, &commandPool_), "vkCreateCommandPool");
+}
+
+void VulkanRenderer::destroyCommandPool() {
+    if (!commandPool_) return;
+    vkDestroyCommandPool(device_, commandPool_, nullptr);
+    commandPool_ = VK_NULL_HANDLE;
+    commandBuffers_.clear();
+}
+
+void VulkanRenderer::allocateCommandBuffers() {
+    commandBuffers_.resize(kFramesInFlight);
+    VkCommandBufferAllocateInfo ai{};
+    ai.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    ai.commandPool = commandPool_;
+    ai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    ai.commandBufferCount = (uint32_t)commandBuffers_.size();
+    vk_ok(vkAllocateCommandBuffers(device_, &ai, commandBuffers_.data()), "vkAllocateCommandBuffers");
+}
+
+void VulkanRenderer::createSync() {
+    imageAvailable_.resize(kFramesInFlight);
+    renderFinished_.resize(kFramesInFlight);
+    inFlight_.resize(kFramesInFlight);
+
+    VkSemaphoreCreateInfo si{};
+    si.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    VkFenceCreateInfo fi{};
+    fi.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fi.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+    for (uint32_t i = 0; i < kFramesInFlight; i++) {
+        vk_ok(vkCreateSemaphore(device_, &si, nullptr, &imageAvailable_[i]), "vkCreateSemaphore(imageAvail)");
+        vk_ok(vkCreateSemaphore(device_, &si, nullptr, &renderFinished_[i]), "vkCreateSemaphore(renderFinished)");
+        vk_ok(vkCreateFence(device_, &fi, nullptr, &inFlight_[i]), "vkCreateFence");
+    }
+}
+
+void VulkanRenderer::destroySync() {
+    for (auto s : imageAvailable_) vkDestroySemaphore(device_, s, nullptr);
+    for (auto s : renderFinished_) vkDestroySemaphore(device_, s, nullptr);
+    for (auto f : inFlight_) vkDestroyFence(device_, f, nullptr);
+    imageAvailable_.clear();
+    renderFinished_.clear();
+    inFlight_.clear();
+    frameIndex_ = 0;
+}
+
+uint32_t VulkanRenderer::findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags props) const {
+    VkPhysicalDeviceMemoryProperties mem{};
+    vkGetPhysicalDeviceMemoryProperties(phys_, &mem);
+    for (uint32_t i = 0; i < mem.memoryTypeCount; i++) {
+        if ((typeBits & (1u << i)) && (mem.memoryTypes[i].propertyFlags & props) == props) return i;
+    }
+    return UINT32_MAX;
+}
+
+bool VulkanRenderer::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags props,
+                                  VkBuffer& buffer, VkDeviceMemory& memory) {
+    VkBufferCreateInfo bi{};
+    bi.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bi.size = size;
+    bi.usage = usage;
+    bi.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (!vk_ok(vkCreateBuffer(device_, &bi, nullptr, &buffer), "vkCreateBuffer")) return false;
+
+    VkMemoryRequirements req{};
+    vkGetBufferMemoryRequirements(device_, buffer, &req);
+    uint32_t type = findMemoryType(req.memoryTypeBits, props);
+    if (type == UINT32_MAX) {
+        LOGE("No memory type for buffer (props 0x%x)", (unsigned)props);
+        vkDestroyBuffer(device_, buffer, nullptr);
+        buffer = VK_NULL_HANDLE;
+        return false;
+    }
+
+    VkMemoryAllocateInfo ai{};
+    ai.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    ai.allocationSize = req.size;
+    ai.memoryTypeIndex = type;
+    if (!vk_ok(vkAllocateMemory(device_, &ai, nullptr, &memory), "vkAllocateMemory")) {
+        vkDestroyBuffer(device_, buffer, nullptr);
+        buffer = VK_NULL_HANDLE;
+        return false;
+    }
+    vkBindBufferMemory(device_, buffer, memory, 0);
+    return true;
+}
+
+bool VulkanRenderer::ensureStaging(Staging& s, VkDeviceSize size) {
+    if (s.buffer && s.size >= size) return true;
+    releaseStaging(s);
+    if (!createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                      s.buffer, s.memory)) {
+        return false;
+    }
+    if (!vk_ok(vkMapMemory(device_, s.memory, 0, size, 0, &s.mapped), "vkMapMemory(staging)")) return false;
+    s.size = size;
+    return true;
+}
+
+void VulkanRenderer::releaseStaging(Staging& s) {
+    if (s.mapped) vkUnmapMemory(device_, s.memory);
+    if (s.buffer) vkDestroyBuffer(device_, s.buffer, nullptr);
+    if (s.memory) vkFreeMemory(device_, s.memory, nullptr);
+    s = Staging{};
+}
+
+bool VulkanRenderer::createStaging() {
+    const VkDeviceSize size = (VkDeviceSize)extent_.width * extent_.height * 4;
+    staging_.resize(kFramesInFlight);
+    for (Staging& s : staging_) {
+        if (!ensureStaging(s, size)) return false;
+    }
+    return true;
+}
+
+void VulkanRenderer::destroyStaging() {
+    for (Staging& s : staging_) releaseStaging(s);
+    staging_.clear();
+}
+
+void VulkanRenderer::setFrameImage(const uint8_t* rgba, uint32_t width, uint32_t height, size_t rowStride) {
+    GS_TRACE_SCOPE("setFrameImage");
+    if (staging_.empty()) return;
+    if (width != extent_.width || height != extent_.height) {
+        LOGE("Frame image %ux%u does not match target %ux%u", width, height, extent_.width, extent_.height);
+        return;
+    }
+
+    // The slot may still be read by the frame that last used it.
+    vkWaitForFences(device_, 1, &inFlight_[frameIndex_], VK_TRUE, UINT64_MAX);
+
+    // Grown lazily after a resize, one slot at a time, once its fence has
+    // signaled.
+    Staging& s = staging_[frameIndex_];
+    if (!ensureStaging(s, (VkDeviceSize)width * height * 4)) return;
+    uint8_t* dst = static_cast<uint8_t*>(s.mapped);
+    const size_t row = (size_t)width * 4;
+    if (swapchainFormat_ == VK_FORMAT_B8G8R8A8_UNORM) {
+        for (uint32_t y = 0; y < height; y++) {
+            const uint8_t* in = rgba + y * rowStride;
+            uint8_t* out = dst + y * row;
+            for (uint32_t x = 0; x < width; x++) {
+                out[x * 4 + 0] = in[x * 4 + 2];
+                out[x * 4 + 1] = in[x * 4 + 1];
+                out[x * 4 + 2] = in[x * 4 + 0];
+                out[x * 4 + 3] = in[x * 4 + 3];
+            }
+        }
+    } else {
+        for (uint32_t y = 0; y < height; y++) std::memcpy(dst + y * row, rgba + y * rowStride, row);
+    }
+    s.pending = true;
+}
+
+bool VulkanRenderer::createMemory() {
+    memoryBackend_ = std::make_unique<VulkanMemoryBackend>(device_, phys_);
+    allocator_ = std::make_unique<GpuAllocator>(*memoryBackend_);
+
+    VkBufferCreateInfo bi{};
+    bi.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bi.size = kUploadRingSize;
+    bi.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    bi.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (!vk_ok(vkCreateBuffer(device_, &bi, nullptr, &uploadBuffer_), "vkCreateBuffer(upload)")) return false;
+
+    VkMemoryRequirements req{};
+    vkGetBufferMemoryRequirements(device_, uploadBuffer_, &req);
+    const uint32_t type = memoryBackend_->findMemoryType(
+        req.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    if (type == UINT32_MAX || !allocator_->allocate(type, req.size, req.alignment, uploadMemory_)) {
+        LOGE("No host-visible memory for the upload ring");
+        return false;
+    }
+    vkBindBufferMemory(device_, uploadBuffer_, toVkMemory(uploadMemory_.memory), uploadMemory_.offset);
+    uploadRing_.init(uploadMemory_.mapped, kUploadRingSize);
+    return true;
+}
+
+void VulkanRenderer::destroyMemory() {
+    // Only called once the device is idle.
+    for (RetiredBuffer& r : retiredBuffers_) {
+        vkDestroyBuffer(device_, r.buffer.buffer, nullptr);
+        allocator_->free(r.buffer.memory);
+    }
+    retiredBuffers_.clear();
+    pendingCopyRegions_.clear();
+    pendingCopyTargets_.clear();
+    if (uploadBuffer_) vkDestroyBuffer(device_, uploadBuffer_, nullptr);
+    uploadBuffer_ = VK_NULL_HANDLE;
+    if (allocator_) allocator_->free(uploadMemory_);
+    uploadRing_.init(nullptr, 0);
+    allocator_.reset();
+    memoryBackend_.reset();
+}
+
+bool VulkanRenderer::createDeviceBuffer(VkDeviceSize size, VkBufferUsageFlags usage, GpuBuffer& out) {
+    out = GpuBuffer{};
+    if (!allocator_) return false;
+
+    VkBufferCreateInfo bi{};
+    bi.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bi.size = size;
+    bi.usage = usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bi.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (!vk_ok(vkCreateBuffer(device_, &bi, nullptr, &out.buffer), "vkCreateBuffer")) return false;
+
+    VkMemoryRequirements req{};
+    vkGetBufferMemoryRequirements(device_, out.buffer, &req);
+    uint32_t type = memoryBackend_->findMemoryType(req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (type == UINT32_MAX) type = memoryBackend_->findMemoryType(req.memoryTypeBits, 0);
+    if (type == UINT32_MAX || !allocator_->allocate(type, req.size, req.alignment, out.memory)) {
+        LOGE("Device buffer allocation failed (%llu bytes)", (unsigned long long)size);
+        vkDestroyBuffer(device_, out.buffer, nullptr);
+        out = GpuBuffer{};
+        return false;
+    }
+    vkBindBufferMemory(device_, out.buffer, toVkMemory(out.memory.memory), out.memory.offset);
+    out.size = size;
+    return true;
+}
+
+void VulkanRenderer::destroyBuffer(GpuBuffer& buffer) {
+    if (!buffer.buffer) return;
+    // Copies queued for the next frame may still target it.
+    retiredBuffers_.push_back({ buffer, submittedFrames_ + 1 });
+    buffer = GpuBuffer{};
+}
+
+VkDeviceSize VulkanRenderer::uploadToBuffer(const GpuBuffer& buffer, VkDeviceSize offset, const void* data,
+                                            VkDeviceSize size) {
+    GS_TRACE_SCOPE("uploadToBuffer");
+    if (!buffer.buffer || !uploadBuffer_ || offset + size > buffer.size) return 0;
+
+    // Chunks keep one large upload from needing the whole ring at once.
+    constexpr VkDeviceSize kChunk = 4ull << 20;
+    const uint8_t* src = static_cast<const uint8_t*>(data);
+    VkDeviceSize done = 0;
+    while (done < size) {
+        const VkDeviceSize n = std::min(kChunk, size - done);
+        StagingRing::Region region;
+        if (!uploadRing_.upload(src + done, n, 16, region)) break;
+        VkBufferCopy copy{};
+        copy.srcOffset = region.offset;
+        copy.dstOffset = offset + done;
+        copy.size = n;
+        pendingCopyRegions_.push_back(copy);
+        pendingCopyTargets_.push_back(buffer.buffer);
+        done += n;
+    }
+    return done;
+}
+
+void VulkanRenderer::retireCompleted() {
+    uploadRing_.retire(completedFrames_);
+
+    size_t kept = 0;
+    for (RetiredBuffer& r : retiredBuffers_) {
+        if (r.lastFrame > completedFrames_) {
+            retiredBuffers_[kept++] = r;
+            continue;
+        }
+        vkDestroyBuffer(device_, r.buffer.buffer, nullptr);
+        allocator_->free(r.buffer.memory);
+    }
+    retiredBuffers_.resize(kept);
+
+    if (!retired_.empty()) releaseRetired(false);
+}
+
+bool VulkanRenderer::createOffscreen() {
+    VkImageCreateInfo ii{};
+    ii.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    ii.imageType = VK_IMAGE_TYPE_2D;
+    ii.format = swapchainFormat_;
+    ii.extent = { extent_.width, extent_.height, 1 };
+    ii.mipLevels = 1;
+    ii.arrayLayers = 1;
+    ii.samples = VK_SAMPLE_COUNT_1_BIT;
+    ii.tiling = VK_IMAGE_TILING_OPTIMAL;
+    ii.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    ii.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    ii.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (!vk_ok(vkCreateImage(device_, &ii, nullptr, &offscreen_), "vkCreateImage")) return false;
+
+    VkMemoryRequirements req{};
+    vkGetImageMemoryRequirements(device_, offscreen_, &req);
+    VkMemoryAllocateInfo ai{};
+    ai.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    ai.allocationSize = req.size;
+    ai.memoryTypeIndex = findMemoryType(req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (ai.memoryTypeIndex == UINT32_MAX) ai.memoryTypeIndex = findMemoryType(req.memoryTypeBits, 0);
+    if (!vk_ok(vkAllocateMemory(device_, &ai, nullptr, &offscreenMemory_), "vkAllocateMemory(offscreen)")) return false;
+    vkBindImageMemory(device_, offscreen_, offscreenMemory_, 0);
+
+    VkImageViewCreateInfo vi{};
+    vi.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    vi.image = offscreen_;
+    vi.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    vi.format = swapchainFormat_;
+    vi.subresourceRange = kColorRange;
+    imageViews_.resize(1);
+    images_.assign(1, offscreen_);
+    if (!vk_ok(vkCreateImageView(device_, &vi, nullptr, &imageViews_[0]), "vkCreateImageView(offscreen)")) return false;
+
+    // Cached memory makes the CPU read of the result much faster where
+    // the driver offers it.
+    const VkDeviceSize size = (VkDeviceSize)extent_.width * extent_.height * 4;
+    const VkMemoryPropertyFlags host = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    if (!createBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, host | VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+                      readback_, readbackMemory_) &&
+        !createBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, host, readback_, readbackMemory_)) {
+        return false;
+    }
+    return vk_ok(vkMapMemory(device_, readbackMemory_, 0, size, 0, &readbackMapped_), "vkMapMemory(readback)");
+}
+
+void VulkanRenderer::destroyOffscreen() {
+    for (auto iv : imageViews_) vkDestroyImageView(device_, iv, nullptr);
+    imageViews_.clear();
+    images_.clear();
+    if (offscreen_) vkDestroyImage(device_, offscreen_, nullptr);
+    if (offscreenMemory_) vkFreeMemory(device_, offscreenMemory_, nullptr);
+    if (readbackMapped_) vkUnmapMemory(device_, readbackMemory_);
+    if (readback_) vkDestroyBuffer(device_, readback_, nullptr);
+    if (readbackMemory_) vkFreeMemory(device_, readbackMemory_, nullptr);
+    offscreen_ = VK_NULL_HANDLE;
+    offscreenMemory_ = VK_NULL_HANDLE;
+    readback_ = VK_NULL_HANDLE;
+    readbackMemory_ = VK_NULL_HANDLE;
+    readbackMapped_ = nullptr;
+}
+
+bool VulkanRenderer::initHeadless(uint32_t width, uint32_t height) {
+    if (instance_) {
+        LOGE("initHeadless: renderer already initialized");
+        return false;
+    }
+    headless_ = true;
+    createInstance();
+    pickPhysicalDevice();
+    createDevice();
+    if (!device_ || !createMemory()) {
+        shutdown();
+        return false;
+    }
+
+    extent_ = { width, height };
+    swapchainFormat_ = VK_FORMAT_R8G8B8A8_UNORM;
+    if (!createOffscreen()) {
+        shutdown();
+        return false;
+    }
+    createRenderPass(VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    createFramebuffers();
+    createCommandPool();
+    allocateCommandBuffers();
+    createSync();
+    if (!createStaging()) {
+        shutdown();
+        return false;
+    }
+
+    LOGI("Headless target ready (%ux%u)", width, height);
+    return true;
+}
+
+bool VulkanRenderer::ensureTimestampPool() {
+    if (timestampPool_) return true;
+    if (timestampPeriodNs_ <= 0.f) return false;
+    VkQueryPoolCreateInfo ci{};
+    ci.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    ci.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    ci.queryCount = kFramesInFlight * kTimestampsPerFrame;
+    if (!vk_ok(vkCreateQueryPool(device_, &ci, nullptr, &timestampPool_), "vkCreateQueryPool")) {
+        timestampPool_ = VK_NULL_HANDLE;
+        timestampPeriodNs_ = 0.f; // CPU stages only from now on
+        return false;
+    }
+    return true;
+}
+
+void VulkanRenderer::destroyTimestampPool() {
+    if (timestampPool_) vkDestroyQueryPool(device_, timestampPool_, nullptr);
+    timestampPool_ = VK_NULL_HANDLE;
+    for (uint32_t i = 0; i < kFramesInFlight; i++) {
+        slotRecordPending_[i] = false;
+        slotTimestamps_[i] = false;
+    }
+}
+
+void VulkanRenderer::writeTimestamp(VkCommandBuffer cmd, uint32_t index, VkPipelineStageFlagBits stage) {
+    if (!slotTimestamps_[frameIndex_]) return;
+    vkCmdWriteTimestamp(cmd, stage, timestampPool_, frameIndex_ * kTimestampsPerFrame + index);
+}
+
+float VulkanRenderer::frameInterval(Clock::time_point start) {
+    const bool first = lastFrameStart_ == Clock::time_point{};
+    const double ms = first ? 0.0 : std::chrono::duration<double, std::milli>(start - lastFrameStart_).count();
+    lastFrameStart_ = start;
+    return (float)ms;
+}
+
+void VulkanRenderer::finishFrameRecord(uint32_t slot) {
+    if (!slotRecordPending_[slot]) return;
+    slotRecordPending_[slot] = false;
+    FrameRecord& r = slotRecords_[slot];
+    if (slotTimestamps_[slot]) {
+        // The slot's fence has signaled, so the results are available.
+        uint64_t ts[kTimestampsPerFrame] = {};
+        const VkResult res = vkGetQueryPoolResults(device_, timestampPool_, slot * kTimestampsPerFrame,
+                                                   kTimestampsPerFrame, sizeof(ts), ts, sizeof(uint64_t),
+                                                   VK_QUERY_RESULT_64_BIT);
+        if (res == VK_SUCCESS) {
+            auto ms = [&](uint32_t a, uint32_t b) {
+                return (float)((double)((ts[b] - ts[a]) & timestampMask_) * timestampPeriodNs_ * 1e-6);
+            };
+            for (uint32_t k = 0; k < kGpuStageCount; k++) r.gpuMs[k] = ms(k, k + 1);
+            r.gpuTotalMs = ms(0, kTimestampsPerFrame - 1);
+            r.gpuValid = true;
+        }
+    }
+    if (profiler_) profiler_->push(r);
+}
+
+void VulkanRenderer::record(VkCommandBuffer cmd, VkImage image, VkFramebuffer framebuffer) {
+    GS_TRACE_SCOPE("record");
+    VkCommandBufferBeginInfo bi{};
+    bi.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    vk_ok(vkBeginCommandBuffer(cmd, &bi), "vkBeginCommandBuffer");
+
+    slotTimestamps_[frameIndex_] = profiling_ && ensureTimestampPool();
+    if (slotTimestamps_[frameIndex_]) {
+        vkCmdResetQueryPool(cmd, timestampPool_, frameIndex_ * kTimestampsPerFrame, kTimestampsPerFrame);
+    }
+    writeTimestamp(cmd, 0, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+
+    // Streamed buffer uploads, one copy command per target buffer, made
+    // visible to every shader stage after.
+    if (!pendingCopyRegions_.empty()) {
+        FrameArena& arena = frameArenas_[frameIndex_];
+        const size_t count = pendingCopyRegions_.size();
+        FrameVector<uint32_t> order{ ArenaAllocator<uint32_t>(arena) };
+        order.resize(count);
+        for (size_t i = 0; i < count; i++) order[i] = (uint32_t)i;
+        // By target, keeping queue order within each.
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            const VkBuffer ta = pendingCopyTargets_[a], tb = pendingCopyTargets_[b];
+            return ta != tb ? std::less<VkBuffer>()(ta, tb) : a < b;
+        });
+        FrameVector<VkBufferCopy> regions{ ArenaAllocator<VkBufferCopy>(arena) };
+        regions.reserve(count);
+        for (size_t i = 0; i < count;) {
+            const VkBuffer target = pendingCopyTargets_[order[i]];
+            regions.clear();
+            for (; i < count && pendingCopyTargets_[order[i]] == target; i++) {
+                regions.push_back(pendingCopyRegions_[order[i]]);
+            }
+            vkCmdCopyBuffer(cmd, uploadBuffer_, target, (uint32_t)regions.size(), regions.data());
+        }
+        pendingCopyRegions_.clear();
+        pendingCopyTargets_.clear();
+
+        VkMemoryBarrier uploaded{};
+        uploaded.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        uploaded.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        uploaded.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                             1, &uploaded, 0, nullptr, 0, nullptr);
+    }
+    writeTimestamp(cmd, 1, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+    // Previous contents are not needed: UNDEFINED -> TRANSFER_DST.
+    VkImageMemoryBarrier toDst{};
+    toDst.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    toDst.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toDst.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    toDst.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    toDst.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toDst.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toDst.image = image;
+    toDst.subresourceRange = kColorRange;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                         0, nullptr, 0, nullptr, 1, &toDst);
+
+    Staging* upload = staging_.empty() ? nullptr : &staging_[frameIndex_];
+    if (upload && upload->pending) {
+        VkBufferImageCopy region{};
+        region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+        region.imageExtent = { extent_.width, extent_.height, 1 };
+        vkCmdCopyBufferToImage(cmd, upload->buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+        upload->pending = false;
+    } else {
+        VkClearColorValue clear{};
+        clear.float32[0] = 0.07f;
+        clear.float32[1] = 0.07f;
+        clear.float32[2] = 0.12f;
+        clear.float32[3] = 1.0f;
+        vkCmdClearColorImage(cmd, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clear, 1, &kColorRange);
+    }
+    writeTimestamp(cmd, 2, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+    VkRenderPassBeginInfo rbi{};
+    rbi.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    rbi.renderPass = renderPass_;
+    rbi.framebuffer = framebuffer;
+    rbi.renderArea.extent = extent_;
+
+    vkCmdBeginRenderPass(cmd, &rbi, VK_SUBPASS_CONTENTS_INLINE);
+    // TODO: splat draw pass goes here.
+    vkCmdEndRenderPass(cmd);
+    writeTimestamp(cmd, 3, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+    if (headless_) {
+        // The render pass left the image in TRANSFER_SRC_OPTIMAL.
+        VkBufferImageCopy region{};
+        region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+        region.imageExtent = { extent_.width, extent_.height, 1 };
+        vkCmdCopyImageToBuffer(cmd, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback_, 1, &region);
+
+        VkBufferMemoryBarrier toHost{};
+        toHost.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        toHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        toHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        toHost.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        toHost.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        toHost.buffer = readback_;
+        toHost.size = VK_WHOLE_SIZE;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+                             0, nullptr, 1, &toHost, 0, nullptr);
+    }
+    writeTimestamp(cmd, 4, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+    vk_ok(vkEndCommandBuffer(cmd), "vkEndCommandBuffer");
+}
+
+#if defined(__ANDROID__)
+void VulkanRenderer::onSurfaceCreated(ANativeWindow* window) {
+    init();
+    if (surface_) return;
+    createSurface(window);
+}
+#endif
+
+void VulkanRenderer::onSurfaceChanged(int width, int height) {
+    if (!surface_) return;
+    if (!swapchain_) {
+        createSwapchain(width, height);
+        return;
+    }
+    requestedWidth_ = (uint32_t)std::max(width, 0);
+    requestedHeight_ = (uint32_t)std::max(height, 0);
+    recreateSwapchain();
+}
+
+void VulkanRenderer::onSurfaceDestroyed() {
+    if (swapchain_) destroySwapchain();
+    destroySurface();
+    // The process may be killed while in the background.
+    std::string error;
+    if (pipelineCache_.handle() && !pipelineCache_.save(&error)) {
+        LOGE("Saving pipeline cache failed: %s", error.c_str());
+    }
+}
+
+void VulkanRenderer::render() {
+    if (!surface_ || !commandPool_) return;
+    if (needsRecreate_ || !swapchain_) {
+        recreateSwapchain();
+        if (needsRecreate_ || !swapchain_) return;
+    }
+    GS_TRACE_SCOPE("VulkanRenderer::render");
+    const AllocationWatch allocations;
+    const bool profile = profiler_ && profiler_->enabled();
+    FrameRecord frame;
+    StageTimer stages(frame, profile);
+    if (profile) frame.intervalMs = frameInterval(stages.start());
+    else lastFrameStart_ = {};
+
+    vkWaitForFences(device_, 1, &inFlight_[frameIndex_], VK_TRUE, UINT64_MAX);
+    stages.mark(CpuStage::FenceWait);
+    completedFrames_ = std::max(completedFrames_, slotFrame_[frameIndex_]);
+    frameArenas_[frameIndex_].reset();
+    finishFrameRecord(frameIndex_);
+    retireCompleted();
+    profiling_ = profile;
+    stages.skip();
+
+    uint32_t imageIndex = 0;
+    VkResult acquire = vkAcquireNextImageKHR(
+        device_, swapchain_, UINT64_MAX,
+        imageAvailable_[frameIndex_], VK_NULL_HANDLE, &imageIndex);
+    stages.mark(CpuStage::Acquire);
+
+    if (acquire == VK_ERROR_OUT_OF_DATE_KHR) {
+        // Nothing was acquired and the semaphore stays unsignaled.
+        recreateSwapchain();
+        return;
+    }
+    if (acquire != VK_SUCCESS && acquire != VK_SUBOPTIMAL_KHR) {
+        vk_ok(acquire, "vkAcquireNextImageKHR");
+        return;
+    }
+    // A suboptimal image is still presentable; finish this frame with it
+    // and rebuild afterwards.
+    bool recreate = acquire == VK_SUBOPTIMAL_KHR;
+
+    vkResetFences(device_, 1, &inFlight_[frameIndex_]);
+
+    VkCommandBuffer cmd = commandBuffers_[frameIndex_];
+    vkResetCommandBuffer(cmd, 0);
+    record(cmd, images_[imageIndex], framebuffers_[imageIndex]);
+    stages.mark(CpuStage::Record);
+
+    // The clear/upload before the render pass writes the image too.
+    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+    VkSubmitInfo si{};
+    si.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    si.waitSemaphoreCount = 1;
+    si.pWaitSemaphores = &imageAvailable_[frameIndex_];
+    si.pWaitDstStageMask = &waitStage;
+    si.commandBufferCount = 1;
+    si.pCommandBuffers = &cmd;
+    si.signalSemaphoreCount = 1;
+    si.pSignalSemaphores = &renderFinished_[frameIndex_];
+
+    vk_ok(vkQueueSubmit(queue_, 1, &si, inFlight_[frameIndex_]), "vkQueueSubmit");
+    slotFrame_[frameIndex_] = ++submittedFrames_;
+    uploadRing_.submit(submittedFrames_);
+    stages.mark(CpuStage::Submit);
+
+    VkPresentInfoKHR pi{};
+    pi.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    pi.waitSemaphoreCount = 1;
+    pi.pWaitSemaphores = &renderFinished_[frameIndex_];
+    pi.swapchainCount = 1;
+    pi.pSwapchains = &swapchain_;
+    pi.pImageIndices = &imageIndex;
+
+    VkResult present = vkQueuePresentKHR(queue_, &pi);
+    if (present == VK_ERROR_OUT_OF_DATE_KHR || present == VK_SUBOPTIMAL_KHR) recreate = true;
+    stages.mark(CpuStage::Present);
+    if (profile) {
+        // Completed by the next fence wait on this slot.
+        frame.frame = submittedFrames_;
+        slotRecords_[frameIndex_] = frame;
+        slotRecordPending_[frameIndex_] = true;
+    }
+
+    frameIndex_ = (frameIndex_ + 1) % kFramesInFlight;
+    timings_.heapAllocations = allocations.count();
+    if (timings_.heapAllocations && framesSinceRecreate_ >= kWarmupFrames) {
+        LOGE("Steady-state frame made %llu heap allocations", (unsigned long long)timings_.heapAllocations);
+    }
+    framesSinceRecreate_++;
+    if (recreate) recreateSwapchain();
+}
+
+VulkanRenderer::ResizeStormResult VulkanRenderer::runResizeStorm(uint32_t iterations) {
+    ResizeStormResult result;
+    if (!swapchain_ || iterations == 0) return result;
+
+    // Alternate between the current size and half of it, presenting one
+    // frame after each change. The hitch is the time from the resize
+    // request until that frame has been handed to the presentation engine.
+    const uint32_t fullW = requestedWidth_, fullH = requestedHeight_;
+    double total = 0.0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        const bool half = (i & 1) == 0;
+        auto t0 = Clock::now();
+        onSurfaceChanged((int)(half ? fullW / 2 : fullW), (int)(half ? fullH / 2 : fullH));
+        render();
+        const double ms = msSince(t0);
+        total += ms;
+        result.maxHitchMs = std::max(result.maxHitchMs, ms);
+        result.iterations++;
+    }
+    onSurfaceChanged((int)fullW, (int)fullH);
+    result.avgHitchMs = total / (double)result.iterations;
+    LOGI("Resize storm: %u resizes, hitch avg %.2f ms, max %.2f ms",
+         result.iterations, result.avgHitchMs, result.maxHitchMs);
+    return result;
+}
+
+bool VulkanRenderer::renderOffscreen(std::vector<uint8_t>* rgba) {
+    if (!headless_ || !device_) return false;
+    GS_TRACE_SCOPE("VulkanRenderer::renderOffscreen");
+
+    const AllocationWatch allocations;
+    const bool profile = profiler_ && profiler_->enabled();
+    FrameRecord frame;
+    StageTimer stages(frame, profile);
+    if (profile) frame.intervalMs = frameInterval(stages.start());
+    else lastFrameStart_ = {};
+
+    auto t0 = Clock::now();
+    vkWaitForFences(device_, 1, &inFlight_[frameIndex_], VK_TRUE, UINT64_MAX);
+    stages.mark(CpuStage::FenceWait);
+    vkResetFences(device_, 1, &inFlight_[frameIndex_]);
+    frameArenas_[frameIndex_].reset();
+    profiling_ = profile;
+    stages.skip();
+
+    VkCommandBuffer cmd = commandBuffers_[frameIndex_];
+    vkResetCommandBuffer(cmd, 0);
+    record(cmd, offscreen_, framebuffers_[0]);
+    stages.mark(CpuStage::Record);
+    timings_.recordMs = msSince(t0);
+
+    t0 = Clock::now();
+    VkSubmitInfo si{};
+    si.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    si.commandBufferCount = 1;
+    si.pCommandBuffers = &cmd;
+    if (!vk_ok(vkQueueSubmit(queue_, 1, &si, inFlight_[frameIndex_]), "vkQueueSubmit")) return false;
+    slotFrame_[frameIndex_] = ++submittedFrames_;
+    uploadRing_.submit(submittedFrames_);
+    stages.mark(CpuStage::Submit);
+    // Frames are not overlapped here: the readback needs this one finished.
+    if (!vk_ok(vkWaitForFences(device_, 1, &inFlight_[frameIndex_], VK_TRUE, UINT64_MAX), "vkWaitForFences")) {
+        return false;
+    }
+    stages.mark(CpuStage::FenceWait);
+    if (profile) {
+        frame.frame = submittedFrames_;
+        slotRecords_[frameIndex_] = frame;
+        slotRecordPending_[frameIndex_] = true;
+        finishFrameRecord(frameIndex_);
+    }
+    completedFrames_ = submittedFrames_;
+    retireCompleted();
+    timings_.submitMs = msSince(t0);
+
+    t0 = Clock::now();
+    if (rgba) {
+        const size_t bytes = (size_t)extent_.width * extent_.height * 4;
+        rgba->resize(bytes);
+        std::memcpy(rgba->data(), readbackMapped_, bytes);
+    }
+    timings_.readbackMs = msSince(t0);
+
+    frameIndex_ = (frameIndex_ + 1) % kFramesInFlight;
+    timings_.heapAllocations = allocations.count();
+    return true;
+}
@@ -0,0 +1,291 @@
+#pragma once
+
+#if defined(__ANDROID__)
+#include <android/native_window.h>
+#define VK_USE_PLATFORM_ANDROID_KHR
+#endif
+#include <vulkan/vulkan.h>
+
+#include "frame_arena.h"
+#include "frame_profiler.h"
+#include "gpu_allocator.h"
+#include "pipeline_cache.h"
+#include "vk_memory.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Vulkan frame renderer.
+//
+// On Android it renders into a swapchain created from an ANativeWindow.
+// Headless mode (initHeadless) creates the instance without surface
+// extensions and renders into an offscreen image of a given size that can
+// be read back to host memory, so the same frame path runs on desktop
+// drivers and software implementations such as lavapipe.
+//
+// Each frame the target is either cleared or filled from an uploaded RGBA
+// image (setFrameImage, e.g. CpuRasterizer output), then the render pass
+// runs on top.
+//
+// The device gets a PipelineCache persisted at the path given to
+// setPipelineCachePath(), saved when the surface goes away and on
+// shutdown. No pipelines are built yet (frames are a copy plus the render
+// pass), so until then the file is never written; build them through
+// PipelineCache::timeCreate() to get cold/warm creation times.
+//
+// Resizes and out-of-date/suboptimal results rebuild only the swapchain,
+// its image views and framebuffers, passing the old swapchain to the new
+// one. Command buffers, sync objects and the render pass are kept; the
+// retired objects are destroyed once the frames using them complete.
+//
+// Device buffers are sub-allocated from a GpuAllocator, and uploads are
+// streamed through a persistently mapped StagingRing whose regions are
+// reclaimed by frame serial; the copies are recorded at the start of the
+// next frame.
+//
+// Transient per-frame data comes from a FrameArena per frame in flight,
+// reset once that frame's fence has signaled, so a steady frame makes no
+// heap allocations. Built with GS_TRACK_ALLOCATIONS, every frame's count is
+// in timings().heapAllocations and steady frames that allocate are logged.
+//
+// With a FrameProfiler set and enabled, each frame times its CPU stages and
+// writes GPU timestamps between its stages into a query pool; the record is
+// pushed once the frame's fence has signaled and the results are ready.
+class VulkanRenderer {
+public:
+    struct FrameTimings {
+        double recordMs = 0.0;   // command recording and staging copy
+        double submitMs = 0.0;   // submit until the frame's fence signals
+        double readbackMs = 0.0; // headless only: copy out of the readback buffer
+        uint64_t heapAllocations = 0; // operator new calls, when tracked (alloc_tracker.h)
+    };
+
+    struct SwapchainStats {
+        uint32_t recreations = 0;
+        double lastRecreateMs = 0.0;
+        double maxRecreateMs = 0.0;
+    };
+
+    struct ResizeStormResult {
+        uint32_t iterations = 0;
+        double avgHitchMs = 0.0; // resize request until the next frame is presented
+        double maxHitchMs = 0.0;
+    };
+
+    struct GpuBuffer {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        GpuAllocation memory;
+        VkDeviceSize size = 0;
+    };
+
+    ~VulkanRenderer() { shutdown(); }
+
+    // File the pipeline cache is loaded from and saved to; set before
+    // init()/initHeadless(). Empty keeps the cache in memory only.
+    void setPipelineCachePath(const std::string& path) { pipelineCachePath_ = path; }
+    const PipelineCache::Stats& pipelineCacheStats() const { return pipelineCache_.stats(); }
+
+    void init();
+    void shutdown();
+
+#if defined(__ANDROID__)
+    void onSurfaceCreated(ANativeWindow* window);
+#endif
+    void onSurfaceChanged(int width, int height);
+    void onSurfaceDestroyed();
+    void render();
+
+    // Debug benchmark: resizes the swapchain `iterations` times, alternating
+    // between the current and half size (platforms that pin the extent to
+    // the window just recreate at the same size) and measures each hitch.
+    ResizeStormResult runResizeStorm(uint32_t iterations);
+    const SwapchainStats& swapchainStats() const { return swapchainStats_; }
+
+    // Headless: instance and device without presentation, offscreen target.
+    bool initHeadless(uint32_t width, uint32_t height);
+    bool isHeadless() const { return headless_; }
+    // Renders one frame into the offscreen image and waits for it; when
+    // `rgba` is non-null the result is read back (width x height RGBA8).
+    bool renderOffscreen(std::vector<uint8_t>* rgba);
+
+    // Image to show this frame instead of the clear colour. Copied into
+    // the staging buffer of the next frame; must match the target size.
+    void setFrameImage(const uint8_t* rgba, uint32_t width, uint32_t height, size_t rowStride);
+
+    // Device-local buffer (transfer destination plus `usage`).
+    bool createDeviceBuffer(VkDeviceSize size, VkBufferUsageFlags usage, GpuBuffer& out);
+    // Released once the frames submitted so far have completed.
+    void destroyBuffer(GpuBuffer& buffer);
+    // Queues `size` bytes for `buffer` at `offset`; the copy runs at the
+    // start of the next frame. Returns how many bytes were accepted, which
+    // is less than `size` when the staging ring is full: call again with
+    // the remainder on a later frame.
+    VkDeviceSize uploadToBuffer(const GpuBuffer& buffer, VkDeviceSize offset, const void* data, VkDeviceSize size);
+
+    GpuAllocator::Stats memoryStats() const { return allocator_ ? allocator_->stats() : GpuAllocator::Stats{}; }
+    const StagingRing::Stats& uploadStats() const { return uploadRing_.stats(); }
+
+    // True while there is a swapchain to present to.
+    bool isPresentable() const { return swapchain_ != VK_NULL_HANDLE; }
+    VkExtent2D extent() const { return extent_; }
+    const FrameTimings& timings() const { return timings_; }
+
+    // Frame records go to `profiler` (owned by the caller) while it is
+    // enabled; null stops profiling.
+    void setProfiler(FrameProfiler* profiler) { profiler_ = profiler; }
+
+private:
+    VkInstance instance_ = VK_NULL_HANDLE;
+    VkPhysicalDevice phys_ = VK_NULL_HANDLE;
+    VkDevice device_ = VK_NULL_HANDLE;
+    VkQueue queue_ = VK_NULL_HANDLE;
+    uint32_t queueFamily_ = 0;
+    bool headless_ = false;
+
+    VkSurfaceKHR surface_ = VK_NULL_HANDLE;
+    VkSwapchainKHR swapchain_ = VK_NULL_HANDLE;
+    VkFormat swapchainFormat_ = VK_FORMAT_UNDEFINED;
+    VkExtent2D extent_{};
+    uint32_t requestedWidth_ = 0;
+    uint32_t requestedHeight_ = 0;
+    bool needsRecreate_ = false;
+    SwapchainStats swapchainStats_;
+
+    // Swapchains replaced by a recreation, kept until every frame submitted
+    // before the replacement (up to lastFrame) has completed.
+    struct Retired {
+        VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+        std::vector<VkImageView> imageViews;
+        std::vector<VkFramebuffer> framebuffers;
+        uint64_t lastFrame = 0;
+    };
+    std::vector<Retired> retired_;
+
+    std::vector<VkImage> images_;
+    std::vector<VkImageView> imageViews_;
+
+    VkRenderPass renderPass_ = VK_NULL_HANDLE;
+    std::vector<VkFramebuffer> framebuffers_;
+
+    PipelineCache pipelineCache_;
+    std::string pipelineCachePath_;
+
+    VkCommandPool commandPool_ = VK_NULL_HANDLE;
+    std::vector<VkCommandBuffer> commandBuffers_;
+
+    static constexpr uint32_t kFramesInFlight = 2;
+    std::vector<VkSemaphore> imageAvailable_;
+    std::vector<VkSemaphore> renderFinished_;
+    std::vector<VkFence> inFlight_;
+    uint32_t frameIndex_ = 0;
+    uint64_t submittedFrames_ = 0;
+    uint64_t completedFrames_ = 0;
+    uint64_t slotFrame_[kFramesInFlight] = {}; // frame number last submitted per slot
+    FrameArena frameArenas_[kFramesInFlight];   // reset when the slot's fence signals
+    uint32_t framesSinceRecreate_ = 0;
+
+    // Host-visible upload buffer per frame in flight for setFrameImage.
+    struct Staging {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        void* mapped = nullptr;
+        VkDeviceSize size = 0;
+        bool pending = false;
+    };
+    std::vector<Staging> staging_;
+
+    // Headless target and readback buffer.
+    VkImage offscreen_ = VK_NULL_HANDLE;
+    VkDeviceMemory offscreenMemory_ = VK_NULL_HANDLE;
+    VkBuffer readback_ = VK_NULL_HANDLE;
+    VkDeviceMemory readbackMemory_ = VK_NULL_HANDLE;
+    void* readbackMapped_ = nullptr;
+
+    FrameTimings timings_;
+
+    // Profiling. A timestamp before the first GPU stage and after each one,
+    // per frame slot; the slot's record is finished after its fence wait.
+    static constexpr uint32_t kTimestampsPerFrame = (uint32_t)kGpuStageCount + 1;
+    FrameProfiler* profiler_ = nullptr;
+    bool profiling_ = false;          // the frame being recorded
+    float timestampPeriodNs_ = 0.f;   // 0 when the queue has no timestamps
+    uint64_t timestampMask_ = 0;
+    VkQueryPool timestampPool_ = VK_NULL_HANDLE;
+    FrameRecord slotRecords_[kFramesInFlight];
+    bool slotRecordPending_[kFramesInFlight] = {};
+    bool slotTimestamps_[kFramesInFlight] = {};
+    std::chrono::steady_clock::time_point lastFrameStart_{};
+
+    // Device memory and streaming uploads.
+    static constexpr VkDeviceSize kUploadRingSize = 32ull << 20;
+    std::unique_ptr<VulkanMemoryBackend> memoryBackend_;
+    std::unique_ptr<GpuAllocator> allocator_;
+    VkBuffer uploadBuffer_ = VK_NULL_HANDLE;
+    GpuAllocation uploadMemory_;
+    StagingRing uploadRing_;
+    std::vector<VkBufferCopy> pendingCopyRegions_;
+    std::vector<VkBuffer> pendingCopyTargets_;
+    struct RetiredBuffer {
+        GpuBuffer buffer;
+        uint64_t lastFrame = 0;
+    };
+    std::vector<RetiredBuffer> retiredBuffers_;
+
+    void createInstance();
+    void pickPhysicalDevice();
+    void createDevice();
+#if defined(__ANDROID__)
+    void createSurface(ANativeWindow* window);
+#endif
+    void destroySurface();
+
+    void createSwapchain(int width, int height);
+    bool buildSwapchain();
+    void recreateSwapchain();
+    void releaseRetired(bool all);
+    void destroySwapchain();
+
+    void createRenderPass(VkImageLayout finalLayout);
+    void destroyRenderPass();
+
+    void createFramebuffers();
+    void destroyFramebuffers();
+
+    void createCommandPool();
+    void destroyCommandPool();
+
+    void allocateCommandBuffers();
+    void createSync();
+    void destroySync();
+
+    bool createStaging();
+    void destroyStaging();
+    bool ensureStaging(Staging& s, VkDeviceSize size);
+    void releaseStaging(Staging& s);
+
+    bool createOffscreen();
+    void destroyOffscreen();
+
+    bool createMemory();
+    void destroyMemory();
+    // Frees staging space and buffers whose frames have completed.
+    void retireCompleted();
+
+    uint32_t findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags props) const;
+    bool createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags props,
+                      VkBuffer& buffer, VkDeviceMemory& memory);
+
+    bool ensureTimestampPool();
+    void destroyTimestampPool();
+    void writeTimestamp(VkCommandBuffer cmd, uint32_t index, VkPipelineStageFlagBits stage);
+    // Interval since the previous profiled frame, 0 for the first.
+    float frameInterval(std::chrono::steady_clock::time_point start);
+    // Reads the slot's timestamps and pushes its pending record.
+    void finishFrameRecord(uint32_t slot);
+
+    void record(VkCommandBuffer cmd, VkImage image, VkFramebuffer framebuffer);
+};